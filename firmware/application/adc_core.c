@@ -0,0 +1,483 @@
+/**
+ * @file adc_core.c
+ * @author Stanislav Karpikov
+ * @brief The control core: signal processing and regulators (re-entrant)
+ *
+ * @note The module does not use the peripherals and the global state: all the data is kept in the instance.
+ * The firmware instance and its bindings to the hardware are in the adc_logic module.
+ */
+/** @addtogroup app_adc_core
+ * @{
+ */
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "adc_core.h"
+
+#include "math.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define UMAX_INITIAL_VALUE         (-1000000L) /**< Initial value to calculate the maximum */
+#define UMIN_INITIAL_VALUE         (1000000L)  /**< Initial value to calculate the minimum */
+#define PID_LEAKAGE_COEFFICIENT    (1.0f)      /**< The leakage coefficient for the PIC controller. Can be 0.999f */
+#define GLOBAL_LEAKAGE_COEFFICIENT (0.995f)    /**< The leakage coefficient accumulator variables */
+#define CURRENT_KI                 (0.2f)      /**< The current controller integral coefficient, TODO: test with Ki=0.0003; */
+
+#define K_PHASE_SHIFT (-1.0f) /**< The K coefficient for the frequency and phase shift correction */
+#define K_FILTER_X    (0.5f)  /**< The K coefficient for the ADC signal shape smoothing */
+#define K_FILTER_F    (0.8f)  /**< The K coefficient for the frequency measurement filter */
+#define K_FILTER_P    (0.3f)  /**< The K coefficient for the period measurement filter */
+
+#define PERIOD_REQUIRED     (20000UL) /**< The required period value in [us] */
+#define PERIOD_DRIFT        (1000UL)  /**< The acceptable period drift in [us] */
+#define MAXIMUM_PERIOD_DIFF (10)      /**< The acceptable period difference */
+
+#define SAMPLING_TIMER_CLOCK (200000000.0f / 2.0f) /**< The clock of the sampling timer [Hz] */
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+/** A channel needs the square calculation (e.g. effective value) */
+static const uint8_t needSquare[ADC_CHANNEL_FULL_COUNT] = {
+    0, /*CH10 - ADC_UCAP*/
+    1, /*CH11 - ADC_U_A*/
+    1, /*CH12 - ADC_U_B*/
+    1, /*CH13 - ADC_U_C*/
+    0, /*CH0 - ADC_I_A*/
+    0, /*CH1 - ADC_I_B*/
+    0, /*CH2 - ADC_I_C*/
+    0, /*CH3 - ADC_I_ET*/
+    0, /*CH5 - ADC_I_TEMP1*/
+    0, /*CH6 - ADC_I_TEMP2*/
+    1, /*CH14 - ADC_EDC_A*/
+    1, /*CH15 - ADC_EDC_B*/
+    1, /* - */
+    1, /* - */
+    1, /* - */
+    1, /* - */
+    1  /* - */
+};
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief PID controller
+ *
+ * @param et The curent value of the error
+ * @param et_1 The last value of the error
+ * @param Kp The protortional coefficient
+ * @param Ki The integral coefficient
+ * @param leakage The leakage coefficient for the integral part
+ * @param It_1 Integral value accumulator
+ *
+ * @return Regulated value, return 0 in case of an error
+ */
+static ITCM_CODE float PID(float et, float* et_1, float Kp, float Ki, float leakage, float* It_1)
+{
+    if (!et_1 || !It_1) return 0;
+
+    float Pt = Kp * et;
+    float It = *It_1 + Ki * et;
+    *It_1 = It * leakage;
+    float Ut = Pt + It;
+    *et_1 = et;
+    return Ut;
+};
+
+/**
+ * @brief Calculate autocorellation
+ *
+ * @param in The input buffer
+ *
+ * @return Autocorellation coefficient
+ */
+static __attribute((unused)) float auto_correlation_frequency(const float* in)
+{
+    int order = ADC_VAL_NUM;
+    float sum, max = UMAX_INITIAL_VALUE;
+    int i = 0, j = 0, maxpos = 0;
+    float out[ADC_VAL_NUM] = {0};
+
+    for (i = 0; i < order; i++)
+    {
+        sum = 0;
+        for (j = 0; j < order - i; j++)
+        {
+            sum += in[j] * in[j + i];
+        }
+        out[i] = sum;
+        if (sum > max && i)
+        {
+            max = sum;
+            maxpos = i;
+        }
+    }
+    float dy = 0.5f * (out[maxpos - 1] - out[maxpos + 1]);
+    float d2y = 2.0f * max - out[maxpos - 1] - out[maxpos + 1];
+    float mp = maxpos + dy / d2y;
+    return mp / (float)ADC_VAL_NUM * (float)PERIOD_REQUIRED;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Fill the parameters with the default values (the settings parts are cleared)
+ *
+ * @param[out] params The parameters
+ */
+void adc_core_default_params(adc_core_params_t* params)
+{
+    if (!params) return;
+    memset(params, 0, sizeof(adc_core_params_t));
+    params->ctrl_I_Ki = CURRENT_KI;
+    params->pid_leakage = PID_LEAKAGE_COEFFICIENT;
+    params->global_leakage = GLOBAL_LEAKAGE_COEFFICIENT;
+    params->K_phase_shift = K_PHASE_SHIFT;
+    params->K_filter_x = K_FILTER_X;
+    params->K_filter_F = K_FILTER_F;
+    params->K_filter_P = K_FILTER_P;
+}
+
+/*
+ * @brief Init the control core: clear the buffers and the regulators
+ *
+ * @param core The core instance
+ * @param params The parameters
+ *
+ * @return The status of the operation
+ */
+status_t adc_core_init(adc_core_t* core, const adc_core_params_t* params)
+{
+    ARGUMENT_ASSERT(core);
+    ARGUMENT_ASSERT(params);
+
+    memset(core, 0, sizeof(adc_core_t));
+    core->params = *params;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Apply calibrations to the sample and store it
+ *
+ * @param core The core instance
+ * @param raw Raw ADC codes for all the physical channels
+ */
+ITCM_CODE void adc_core_convert(adc_core_t* core, const uint16_t* raw)
+{
+    const settings_calibrations_t* calibrations = &core->params.calibrations;
+
+    for (int i_isr = 0; i_isr < ADC_CHANNEL_NUMBER; i_isr++)
+    {
+        float value = raw[i_isr];
+        value -= calibrations->offset[i_isr];
+        value *= calibrations->calibration[i_isr];
+
+        core->values[i_isr] = value;
+        core->adc.ch[core->current_buffer][i_isr][core->symbol] = value;
+    }
+}
+
+/*
+ * @brief Run the regulators for the stored sample and move to the next one
+ *
+ * @param core The core instance
+ * @param pwm_on The PWM is enabled (otherwise the regulators are held)
+ *
+ * @return 1 if the PWM compare values have been calculated, 0 otherwise
+ */
+ITCM_CODE uint8_t adc_core_control(adc_core_t* core, uint8_t pwm_on)
+{
+    const adc_core_params_t* params = &core->params;
+    adc_t* adc = &core->adc;
+    const float* values = core->values;
+    uint16_t symbol = core->symbol;
+
+    /* The mathematical channels of the sample: the references of the regulators and the outputs */
+    core->values[ADC_MATH_A] = adc->ch[core->last_buffer][ADC_MATH_A][symbol];
+    core->values[ADC_MATH_B] = adc->ch[core->last_buffer][ADC_MATH_B][symbol];
+    core->values[ADC_MATH_C] = adc->ch[core->last_buffer][ADC_MATH_C][symbol];
+
+    if (!pwm_on)
+    {
+        core->Ia_e_1 = 0 - values[ADC_I_A];
+        core->Ib_e_1 = 0 - values[ADC_I_B];
+        core->Ic_e_1 = 0 - values[ADC_I_C];
+        core->values[ADC_MATH_C_A] = 0;
+        core->values[ADC_MATH_C_B] = 0;
+        core->values[ADC_MATH_C_C] = 0;
+    }
+    else
+    {
+        float VL = PID(
+            params->capacitors.Ucap_nominal - adc->active[ADC_UCAP],
+            &core->VLet_1,
+            params->capacitors.ctrl_Ucap_Kp,
+            params->capacitors.ctrl_Ucap_Ki,
+            params->pid_leakage,
+            &core->VLIt_1);
+
+        float IvlA = VL * adc->ch[core->last_buffer][ADC_MATH_A][symbol] / adc->active[ADC_MATH_A]; /*sin(symbol/128.0*2.0*MATH_PI)*/
+        float IvlB = VL * adc->ch[core->last_buffer][ADC_MATH_B][symbol] / adc->active[ADC_MATH_B]; /*sin(symbol/128.0*2.0*MATH_PI+2.0*MATH_PI/3.0)*/
+        float IvlC = VL * adc->ch[core->last_buffer][ADC_MATH_C][symbol] / adc->active[ADC_MATH_C]; /*sin(symbol/128.0*2.0*MATH_PI+4.0*MATH_PI/3.0)*/
+
+        float va = PID(
+            IvlA - values[ADC_I_A] + adc->active[ADC_I_A],
+            &core->Ia_e_1,
+            0,
+            params->ctrl_I_Ki,
+            params->pid_leakage,
+            &core->Ia_It_1);
+        float vb = PID(
+            IvlB - values[ADC_I_B] + adc->active[ADC_I_B],
+            &core->Ib_e_1,
+            0,
+            params->ctrl_I_Ki,
+            params->pid_leakage,
+            &core->Ib_It_1);
+        float vc = PID(
+            IvlC - values[ADC_I_C] + adc->active[ADC_I_C],
+            &core->Ic_e_1,
+            0,
+            params->ctrl_I_Ki,
+            params->pid_leakage,
+            &core->Ic_It_1);
+
+        core->Ia_It_1 *= params->global_leakage;
+        core->Ib_It_1 *= params->global_leakage;
+        core->Ic_It_1 *= params->global_leakage;
+
+        if (core->Ia_It_1 > (1.0f)) core->Ia_It_1 = 1.0f;
+        if (core->Ib_It_1 > (1.0f)) core->Ib_It_1 = 1.0f;
+        if (core->Ic_It_1 > (1.0f)) core->Ic_It_1 = 1.0f;
+        if (core->Ia_It_1 < (-1.0f)) core->Ia_It_1 = -1.0f;
+        if (core->Ib_It_1 < (-1.0f)) core->Ib_It_1 = -1.0f;
+        if (core->Ic_It_1 < (-1.0f)) core->Ic_It_1 = -1.0f;
+
+        if (va > (1.0f - EPS)) va = 1.0f - EPS;
+        if (vb > (1.0f - EPS)) vb = 1.0f - EPS;
+        if (vc > (1.0f - EPS)) vc = 1.0f - EPS;
+        if (va < (-1.0f + EPS)) va = -1.0f + EPS;
+        if (vb < (-1.0f + EPS)) vb = -1.0f + EPS;
+        if (vc < (-1.0f + EPS)) vc = -1.0f + EPS;
+
+        core->ccr[PFC_ACHAN] = (float)PWM_PERIOD * (-va * 0.5f + 0.5f);
+        core->ccr[PFC_BCHAN] = (float)PWM_PERIOD * (-vb * 0.5f + 0.5f);
+        core->ccr[PFC_CCHAN] = (float)PWM_PERIOD * (-vc * 0.5f + 0.5f);
+
+        adc->ch[core->current_buffer][ADC_MATH_C_A][symbol] = va;
+        adc->ch[core->current_buffer][ADC_MATH_C_B][symbol] = vb;
+        adc->ch[core->current_buffer][ADC_MATH_C_C][symbol] = vc;
+        core->values[ADC_MATH_C_A] = va;
+        core->values[ADC_MATH_C_B] = vb;
+        core->values[ADC_MATH_C_C] = vc;
+    }
+
+    symbol++;
+    if (symbol >= ADC_VAL_NUM)
+    {
+        symbol = 0;
+        core->current_buffer ^= 1;
+        core->last_buffer = !core->current_buffer;
+        core->new_period = 1;
+    }
+    core->symbol = symbol;
+    return pwm_on;
+}
+
+/*
+ * @brief Process the last period: mathematical channels, filters, effective values
+ * @note Should be called when the new_period flag is set
+ *
+ * @param core The core instance
+ */
+void adc_core_process_measurements(adc_core_t* core)
+{
+    adc_t* adc = &core->adc;
+    const settings_filters_t* filters = &core->params.filters;
+    uint8_t last_buffer = core->last_buffer;
+    uint8_t current_buffer = core->current_buffer;
+
+    float K_I = (filters->K_I);
+    float K_U = (filters->K_U);
+    float K_Ucap = (filters->K_Ucap);
+    float K_Iinv = (1 - filters->K_I);
+    float K_Uinv = (1 - filters->K_U);
+    float K_Ucapinv = (1 - filters->K_Ucap);
+
+    float umax[3] = {UMAX_INITIAL_VALUE};
+    float umin[3] = {UMIN_INITIAL_VALUE};
+
+    for (uint32_t i = 0; i < ADC_VAL_NUM; i++)
+    {
+        /* Calculate mathematical channels */
+        float Uab = adc->ch[last_buffer][ADC_EDC_B][i] - adc->ch[last_buffer][ADC_EDC_A][i];
+        float Ubc = adc->ch[last_buffer][ADC_EDC_C][i] - adc->ch[last_buffer][ADC_EDC_B][i];
+
+        float Uan = (2 * Uab + Ubc) / 3;
+        float Ubn = (-Uab + Ubc) / 3;
+        float Ucn = -(Uan + Ubn);
+
+        adc->ch[last_buffer][ADC_MATH_A][i] = Uan;
+        adc->ch[last_buffer][ADC_MATH_B][i] = Ubn;
+        adc->ch[last_buffer][ADC_MATH_C][i] = Ucn;
+
+        for (int i_isr = 0; i_isr < ADC_CHANNEL_NUMBER + ADC_MATH_NUMBER; i_isr++)
+        {
+            if (needSquare[i_isr])
+            {
+                /* Calculate effective value for voltages and currents */
+                adc->sum_raw_sqr[last_buffer][i_isr] += SQUARE_F(adc->ch[last_buffer][i_isr][i]);
+            }
+            else
+            {
+                /* Calculate mean values for steady parameters */
+                adc->sum_raw_sqr[last_buffer][i_isr] += adc->ch[last_buffer][i_isr][i];
+            }
+        }
+
+        /* Apply the filtration fo U and I parameters */
+        for (uint32_t i_isr = 0; i_isr < PFC_NCHAN; i_isr++)
+        {
+            IIR_1ORDER(
+                adc->ch[last_buffer][ADC_EDC_A + i_isr][i],
+                adc->ch[current_buffer][ADC_EDC_A + i_isr][i],
+                adc->ch[last_buffer][ADC_EDC_A + i_isr][i],
+                K_U,
+                K_Uinv);
+
+            IIR_1ORDER(
+                adc->ch[last_buffer][ADC_I_A + i_isr][i],
+                adc->ch[current_buffer][ADC_I_A + i_isr][i],
+                adc->ch[last_buffer][ADC_I_A + i_isr][i],
+                K_I,
+                K_Iinv);
+
+            if (umax[i_isr] < adc->ch[last_buffer][ADC_EDC_A + i_isr][i]) umax[i_isr] = adc->ch[last_buffer][ADC_EDC_A + i_isr][i];
+            if (umin[i_isr] > adc->ch[last_buffer][ADC_EDC_A + i_isr][i]) umin[i_isr] = adc->ch[last_buffer][ADC_EDC_A + i_isr][i];
+        }
+        IIR_1ORDER(
+            adc->ch[last_buffer][ADC_UCAP][i],
+            adc->ch[current_buffer][ADC_UCAP][i],
+            adc->ch[last_buffer][ADC_UCAP][i],
+            K_Ucap,
+            K_Ucapinv);
+    }
+
+    /* Calculate grid parameters */
+    for (int i_isr = 0; i_isr < ADC_CHANNEL_NUMBER + ADC_MATH_NUMBER; i_isr++)
+    {
+        if (needSquare[i_isr])
+        {
+            adc->active[i_isr] = sqrt(adc->sum_raw_sqr[last_buffer][i_isr] / ((float)ADC_VAL_NUM));
+        }
+        else
+        {
+            adc->active[i_isr] = adc->sum_raw_sqr[last_buffer][i_isr] / ((float)ADC_VAL_NUM);
+        }
+        adc->sum_raw_sqr[last_buffer][i_isr] = 0;
+    }
+}
+
+/*
+ * @brief Adjust the period to the grid and clear the new_period flag
+ *
+ * @param core The core instance
+ *
+ * @return The sampling timer period (auto-reload value)
+ */
+uint32_t adc_core_process_period(adc_core_t* core)
+{
+    const adc_core_params_t* params = &core->params;
+    const float* math_a = core->adc.ch[core->last_buffer][ADC_MATH_A];
+
+    /* Adjust the frequency */
+    /*float f=auto_correlation_frequency(math_a);
+				IIR_1ORDER(
+						core->period_fact,
+						f,
+						core->period_fact,
+						(1.0f-params->K_filter_F),
+						params->K_filter_F
+					);
+		  */
+    float x = math_a[PFC_ACHAN];
+    float x_last = x;
+
+    float cntr = 0;  //(umax[PFC_ACHAN]-umin[PFC_ACHAN])/2;
+
+    float P;
+    for (uint32_t j = 0; j < ADC_VAL_NUM; j++)
+    {
+        IIR_1ORDER(
+            x,
+            math_a[j],
+            x,
+            (1.0f - params->K_filter_x),
+            params->K_filter_x);
+
+        if (x_last > cntr && x <= cntr)
+        {
+            P = ((float)j - 1.0f) + ((float)x_last - cntr) / ((float)x_last - (float)x);
+            if ((P - core->P_last) > ((float)ADC_VAL_NUM / 4 * 3))
+            {
+                float last_period = core->period_fact;
+
+                IIR_1ORDER(
+                    core->period_fact,
+                    (P - core->P_last) * (1.0f / (float)ADC_VAL_NUM) * core->period_fact,
+                    core->period_fact,
+                    (1.0f - params->K_filter_F),
+                    params->K_filter_F);
+
+                core->P_last = P;
+
+                IIR_1ORDER(
+                    core->diff,
+                    core->diff,
+                    (P - (float)ADC_VAL_NUM / 2),
+                    (1.0f - params->K_filter_P),
+                    params->K_filter_P);
+                if (core->diff > MAXIMUM_PERIOD_DIFF) core->diff = MAXIMUM_PERIOD_DIFF;
+                if (core->diff < -MAXIMUM_PERIOD_DIFF) core->diff = -MAXIMUM_PERIOD_DIFF;
+                core->period_fact -= core->diff * params->K_phase_shift;
+                core->period_delta = core->period_fact - last_period;
+            }
+        }
+        x_last = x;
+    }
+    core->P_last -= ADC_VAL_NUM;
+
+    if (core->period_fact > (PERIOD_REQUIRED + PERIOD_DRIFT)) core->period_fact = (PERIOD_REQUIRED + PERIOD_DRIFT);
+    if (core->period_fact < (PERIOD_REQUIRED - PERIOD_DRIFT)) core->period_fact = (PERIOD_REQUIRED - PERIOD_DRIFT);
+
+    core->new_period = 0;
+    return (uint32_t)(SAMPLING_TIMER_CLOCK / (float)ADC_VAL_NUM * (core->period_fact / 1000000.0f));
+}
+
+/*
+ * @brief Clear accumulator values
+ *
+ * @param core The core instance
+ */
+void adc_core_clear_accumulators(adc_core_t* core)
+{
+    core->VLet_1 = 0;
+    core->VLIt_1 = 0;
+    core->Ia_e_1 = 0;
+    core->Ib_e_1 = 0;
+    core->Ic_e_1 = 0;
+    core->Ia_It_1 = 0;
+    core->Ib_It_1 = 0;
+    core->Ic_It_1 = 0;
+}
+/** @} */
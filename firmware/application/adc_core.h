@@ -0,0 +1,164 @@
+/**
+ * @file adc_core.h
+ * @author Stanislav Karpikov
+ * @brief The control core: signal processing and regulators (re-entrant, header)
+ */
+
+#ifndef _ADC_CORE_H
+#define _ADC_CORE_H
+
+/** @addtogroup app_adc_core
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "adc_logic.h"
+#include "defines.h"
+#include "settings.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/**
+ * @brief Parameters of the control core
+ *
+ * @note The parameters used on every sample are placed first
+ */
+typedef struct
+{
+    float ctrl_I_Ki;                      /**< The current controller: the integral coefficient */
+    float pid_leakage;                    /**< The leakage coefficient for the PID controller */
+    float global_leakage;                 /**< The leakage coefficient for the current controller accumulators */
+    settings_capacitors_t capacitors;     /**< The capacitors charge PID settings */
+    settings_calibrations_t calibrations; /**< ADC calibrations */
+
+    settings_filters_t filters; /**< Filters for the signals */
+    float K_phase_shift;        /**< The K coefficient for the frequency and phase shift correction */
+    float K_filter_x;           /**< The K coefficient for the ADC signal shape smoothing */
+    float K_filter_F;           /**< The K coefficient for the frequency measurement filter */
+    float K_filter_P;           /**< The K coefficient for the period measurement filter */
+} adc_core_params_t;
+
+/** ADC data structure */
+typedef struct
+{
+    float active[ADC_CHANNEL_FULL_COUNT];    /**< RMS or mean value with correction, instantenous values */
+    uint16_t active_raw[ADC_CHANNEL_NUMBER]; /**< RMS or mean value without correction, instantenous values */
+
+    float sum_raw_sqr[BUF_NUM][ADC_CHANNEL_FULL_COUNT]; /**< Temporary sum for calculate adc active value (squared) */
+    float sum_raw[BUF_NUM][ADC_CHANNEL_FULL_COUNT];     /**< Temporary sum for calculate adc active value */
+
+    /** Double buffers for the measured data */
+    float ch[BUF_NUM][ADC_CHANNEL_FULL_COUNT][ADC_VAL_NUM];
+} adc_t;
+
+/**
+ * @brief The control core instance
+ *
+ * @note The layout is hot-first: the data used by the ADC interrupt on every sample (the position, the regulators,
+ * the sample, the parameters and the effective values) share the first cache lines. The buffers and the period data follow.
+ */
+typedef struct
+{
+    uint16_t symbol;        /**< The current position in the buffer */
+    uint8_t current_buffer; /**< Current buffer ID (for double buffering) */
+    uint8_t last_buffer;    /**< Last buffer ID (for double buffering) */
+    uint8_t new_period;     /**< A new period measurement has been started */
+
+    float VLet_1;  /**< Last value for the VL error */
+    float VLIt_1;  /**< Last value for the VL integral part */
+    float Ia_e_1;  /**< Last value for the Ia error */
+    float Ia_It_1; /**< Last value for the Ia integral part */
+    float Ib_e_1;  /**< Last value for the Ib error */
+    float Ib_It_1; /**< Last value for the Ib integral part */
+    float Ic_e_1;  /**< Last value for the Ic error */
+    float Ic_It_1; /**< Last value for the Ic integral part */
+
+    uint32_t ccr[PFC_NCHAN];                            /**< PWM compare values of the current sample */
+    float values[ADC_CHANNEL_NUMBER + ADC_MATH_NUMBER]; /**< The calibrated values and the mathematical channels of the current sample */
+
+    adc_core_params_t params; /**< Parameters */
+
+    adc_t adc; /**< ADC data: the effective values first, the buffers at the end */
+
+    complex_amp_t U_50Hz[PFC_NCHAN]; /**< ADC data */
+    float period_delta;              /**< The instantenous period error */
+    float period_fact;               /**< The instantenous period value */
+    float U_0Hz[PFC_NCHAN];          /**< The DC part of the U signal waveform */
+    float I_0Hz[PFC_NCHAN];          /**< The DC part of the I signal waveform */
+    float U_phase[PFC_NCHAN];        /**< The phase the U signal waveform */
+    float thdu[PFC_NCHAN];           /**< The total harmonic distortion (on U) */
+    float diff;                      /**< The period difference (between required and measured) */
+    float P_last;                    /**< The position of the last zero crossing */
+} adc_core_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Fill the parameters with the default values (the settings parts are cleared)
+ *
+ * @param[out] params The parameters
+ */
+void adc_core_default_params(adc_core_params_t* params);
+
+/**
+ * @brief Init the control core: clear the buffers and the regulators
+ *
+ * @param core The core instance
+ * @param params The parameters
+ *
+ * @return The status of the operation
+ */
+status_t adc_core_init(adc_core_t* core, const adc_core_params_t* params);
+
+/**
+ * @brief Apply calibrations to the sample and store it
+ *
+ * @param core The core instance
+ * @param raw Raw ADC codes for all the physical channels
+ */
+void adc_core_convert(adc_core_t* core, const uint16_t* raw);
+
+/**
+ * @brief Run the regulators for the stored sample and move to the next one
+ *
+ * @param core The core instance
+ * @param pwm_on The PWM is enabled (otherwise the regulators are held)
+ *
+ * @return 1 if the PWM compare values have been calculated, 0 otherwise
+ */
+uint8_t adc_core_control(adc_core_t* core, uint8_t pwm_on);
+
+/**
+ * @brief Process the last period: mathematical channels, filters, effective values
+ * @note Should be called when the new_period flag is set
+ *
+ * @param core The core instance
+ */
+void adc_core_process_measurements(adc_core_t* core);
+
+/**
+ * @brief Adjust the period to the grid and clear the new_period flag
+ *
+ * @param core The core instance
+ *
+ * @return The sampling timer period (auto-reload value)
+ */
+uint32_t adc_core_process_period(adc_core_t* core);
+
+/**
+ * @brief Clear accumulator values
+ *
+ * @param core The core instance
+ */
+void adc_core_clear_accumulators(adc_core_t* core);
+
+/** @} */
+#endif /* _ADC_CORE_H */
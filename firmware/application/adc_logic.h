@@ -94,8 +94,9 @@ enum
 
 /**
  * @brief Start ADC processing
+ * @note A failed start of the ADC DMA conversion adds an event and puts the PFC to the fault state
  * 
- * @return The status of the operation
+ * @return The status of the operation: the status of the ADC start
  */
 status_t adc_logic_start(void);
 
@@ -122,6 +123,13 @@ void adc_get_active(float* active);
  */
 void adc_get_active_raw(float* active_raw);
 
+/**
+ * @brief Get the number of the periods published (the values of the getters change with it)
+ * 
+ * @return The number of the periods
+ */
+uint32_t adc_get_periods(void);
+
 /**
  * @brief Get the complex amplitude and phase
  * @note NULL pointers can be passed to omit a variable
@@ -158,7 +166,7 @@ float adc_get_temperature(void);
 void adc_set_temperature(float temperature);
 
 /**
- * @brief Run the algorithm
+ * @brief Run the algorithm (the task released at the end of a period)
  */
 void algorithm_process(void);
 
@@ -167,5 +175,19 @@ void algorithm_process(void);
  */
 void adc_clear_accumulators(void);
 
+/**
+ * @brief Get the cycles of the control interrupt (the core cycles counter)
+ * @note NULL pointers can be passed to omit a variable
+ *
+ * @param[out] last The cycles of the last run
+ * @param[out] max The maximum cycles of a run
+ */
+void adc_get_isr_cycles(uint32_t* last, uint32_t* max);
+
+/**
+ * @brief Clear the maximum cycles of the control interrupt
+ */
+void adc_clear_isr_cycles(void);
+
 /** @} */
 #endif /* _ADC_LOGIC_H */
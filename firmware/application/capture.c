@@ -0,0 +1,288 @@
+/**
+ * @file capture.c
+ * @author Stanislav Karpikov
+ * @brief Waveform capture: the pre-trigger and post-trigger samples of all the channels
+ */
+
+/** @addtogroup app_capture
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "capture.h"
+
+#include "BSP/system.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define CAPTURE_TRIGGERS_DEFAULT (CAPTURE_TRIGGER_PROTECTION | CAPTURE_TRIGGER_COMMAND) /**< The triggers of the firmware capture */
+
+/*--------------------------------------------------------------
+                       PRIVATE TYPES
+--------------------------------------------------------------*/
+
+/** The trigger state */
+enum
+{
+    CAPTURE_STATE_WAITING,   /**< Waiting for a trigger (the pre-trigger samples are written) */
+    CAPTURE_STATE_CLAIMED,   /**< A trigger is being accepted */
+    CAPTURE_STATE_TRIGGERED, /**< The post-trigger samples are written */
+};
+
+/** Compile-time check: a capture is kept while the next one is recorded */
+typedef char capture_slots_check_t[(CAPTURE_SLOTS_NUM >= 2) ? 1 : -1];
+
+/** Compile-time check: the sample positions fit the counters */
+typedef char capture_samples_check_t[(CAPTURE_SAMPLES_NUM <= UINT16_MAX) ? 1 : -1];
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static capture_t capture_instance; /**< The capture instance of the firmware */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Finish the capture: freeze the recording slot, continue in the oldest one (the ADC interrupt)
+ *
+ * @param capture The capture instance
+ */
+static void capture_complete(capture_t* capture)
+{
+    uint8_t slot = capture->recording;
+    struct capture_record_s record = capture->pending;
+    record.samples = capture->written;
+    record.pre_samples = capture->written - capture->post_trigger;
+    record.sequence = 0;
+
+    /* The oldest sample is at the write position if the ring has been filled */
+    capture->first[slot] = (capture->written < CAPTURE_SAMPLES_NUM) ? 0 : capture->position;
+    memcpy((void*)&capture->records[slot], &record, sizeof(record));
+    __dmb(0xF);
+    capture->records[slot].sequence = ++capture->sequence;
+
+    uint8_t next = (slot + 1) % CAPTURE_SLOTS_NUM;
+    for (uint8_t i = 0; i < CAPTURE_SLOTS_NUM; i++)
+    {
+        if (capture->records[i].sequence < capture->records[next].sequence) next = i;
+    }
+    /* The slot is cleared before it is written, so the readers see it has been overwritten */
+    capture->records[next].sequence = 0;
+    __dmb(0xF);
+    capture->recording = next;
+    capture->position = 0;
+    capture->written = 0;
+    capture->state = CAPTURE_STATE_WAITING;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Init the capture instance: clear the captures, start the recording
+ *
+ * @param capture The capture instance
+ * @param triggers The enabled triggers (capture_trigger_t mask)
+ * @param post_samples The post-trigger window [samples]
+ *
+ * @return The status of the operation
+ */
+status_t capture_init(capture_t* capture, uint8_t triggers, uint16_t post_samples)
+{
+    ARGUMENT_ASSERT(capture);
+    memset(capture, 0, sizeof(capture_t));
+    return capture_configure(capture, triggers, post_samples);
+}
+
+/*
+ * @brief Set the triggers and the post-trigger window (the next captures)
+ *
+ * @param capture The capture instance
+ * @param triggers The enabled triggers (capture_trigger_t mask)
+ * @param post_samples The post-trigger window [samples], up to CAPTURE_SAMPLES_NUM
+ *
+ * @return The status of the operation
+ */
+status_t capture_configure(capture_t* capture, uint8_t triggers, uint16_t post_samples)
+{
+    ARGUMENT_ASSERT(capture);
+    if (post_samples == 0 || post_samples > CAPTURE_SAMPLES_NUM) return PFC_ERROR_DATA;
+    capture->post_samples = post_samples;
+    capture->triggers = triggers;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Write a sample (the ADC interrupt)
+ *
+ * @param capture The capture instance
+ * @param sample The values of all the channels (CAPTURE_CHANNELS_NUM)
+ */
+ITCM_CODE void capture_write(capture_t* capture, const float* sample)
+{
+    memcpy(capture->slots[capture->recording].samples[capture->position], sample, sizeof(capture->slots[0].samples[0]));
+    if (++capture->position >= CAPTURE_SAMPLES_NUM) capture->position = 0;
+    if (capture->written < CAPTURE_SAMPLES_NUM) capture->written++;
+
+    if (capture->state == CAPTURE_STATE_TRIGGERED && --capture->post_left == 0) capture_complete(capture);
+}
+
+/*
+ * @brief Trigger a capture
+ * @note The trigger is ignored if it is disabled or the post-trigger samples of another one are being recorded
+ *
+ * @param capture The capture instance
+ * @param trigger The trigger
+ * @param type The type of the trigger event
+ * @param info The info of the trigger event
+ * @param time The time of the trigger
+ *
+ * @return PFC_SUCCESS if the capture has been triggered, PFC_NULL if the trigger is ignored
+ */
+ITCM_CODE status_t capture_trigger(capture_t* capture, capture_trigger_t trigger, uint32_t type, uint32_t info, uint64_t time)
+{
+    ARGUMENT_ASSERT(capture);
+    if (!(capture->triggers & trigger)) return PFC_NULL;
+
+    do
+    {
+        if (__ldrex(&capture->state) != CAPTURE_STATE_WAITING) return PFC_NULL;
+    } while (__strex(CAPTURE_STATE_CLAIMED, &capture->state));
+
+    capture->pending.unix_time_s_ms = time;
+    capture->pending.trigger = trigger;
+    capture->pending.type = type;
+    capture->pending.info = info;
+    capture->post_trigger = capture->post_samples;
+    capture->post_left = capture->post_samples;
+    __dmb(0xF);
+    capture->state = CAPTURE_STATE_TRIGGERED;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Get the descriptions of the stored captures (the oldest first)
+ *
+ * @param capture The capture instance
+ * @param num The maximum number of the descriptions
+ * @param[out] records The descriptions
+ *
+ * @return The number of the descriptions written
+ */
+uint8_t capture_get_records(const capture_t* capture, uint8_t num, struct capture_record_s* records)
+{
+    if (!capture || !records) return 0;
+
+    uint8_t count = 0;
+    uint32_t after = 0;
+    while (count < num)
+    {
+        /* The next capture by the number (the slots are reused in turn) */
+        int8_t found = -1;
+        for (uint8_t i = 0; i < CAPTURE_SLOTS_NUM; i++)
+        {
+            uint32_t sequence = capture->records[i].sequence;
+            if (sequence > after && (found < 0 || sequence < capture->records[found].sequence)) found = i;
+        }
+        if (found < 0) break;
+
+        memcpy(&records[count], (const void*)&capture->records[found], sizeof(struct capture_record_s));
+        after = records[count].sequence;
+        /* The slot is being reused: the copy is not consistent */
+        if (after == 0 || capture->records[found].sequence != after) break;
+        count++;
+    }
+    return count;
+}
+
+/*
+ * @brief Read the samples of a channel from a stored capture
+ *
+ * @param capture The capture instance
+ * @param sequence The number of the capture
+ * @param channel The channel
+ * @param offset The first sample (from the start of the capture)
+ * @param num The number of the samples
+ * @param[out] data The samples
+ *
+ * @return The number of the samples written (0 if the capture has been overwritten)
+ */
+uint16_t capture_read(const capture_t* capture, uint32_t sequence, uint8_t channel, uint16_t offset, uint16_t num, float* data)
+{
+    if (!capture || !data || sequence == 0 || channel >= CAPTURE_CHANNELS_NUM) return 0;
+
+    for (uint8_t slot = 0; slot < CAPTURE_SLOTS_NUM; slot++)
+    {
+        if (capture->records[slot].sequence != sequence) continue;
+
+        uint16_t samples = capture->records[slot].samples;
+        if (offset >= samples) return 0;
+        if (num > samples - offset) num = samples - offset;
+
+        uint16_t position = (capture->first[slot] + offset) % CAPTURE_SAMPLES_NUM;
+        for (uint16_t i = 0; i < num; i++)
+        {
+            data[i] = capture->slots[slot].samples[position][channel];
+            if (++position >= CAPTURE_SAMPLES_NUM) position = 0;
+        }
+        __dmb(0xF);
+        /* The slot has been reused while read */
+        if (capture->records[slot].sequence != sequence) return 0;
+        return num;
+    }
+    return 0;
+}
+
+/*
+ * @brief Start the firmware capture (all the triggers except the state changes, a period after the trigger)
+ * @note Should be called before the interrupts are started
+ */
+void capture_start(void)
+{
+    capture_init(&capture_instance, CAPTURE_TRIGGERS_DEFAULT, CAPTURE_POST_DEFAULT);
+}
+
+/*
+ * @brief Write a sample to the firmware capture (the ADC interrupt)
+ *
+ * @param sample The values of all the channels (CAPTURE_CHANNELS_NUM)
+ */
+ITCM_CODE void capture_add_sample(const float* sample)
+{
+    capture_write(&capture_instance, sample);
+}
+
+/*
+ * @brief Trigger the firmware capture
+ *
+ * @param trigger The trigger
+ * @param type The type of the trigger event
+ * @param info The info of the trigger event
+ */
+ITCM_CODE void capture_new_trigger(capture_trigger_t trigger, uint32_t type, uint32_t info)
+{
+    /* The time is read only for the accepted triggers */
+    if (!(capture_instance.triggers & trigger) || capture_instance.state != CAPTURE_STATE_WAITING) return;
+    capture_trigger(&capture_instance, trigger, type, info, system_get_time());
+}
+
+/*
+ * @brief Get the firmware capture instance
+ *
+ * @return The capture instance
+ */
+capture_t* capture_get_instance(void)
+{
+    return &capture_instance;
+}
+/** @} */
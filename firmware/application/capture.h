@@ -0,0 +1,190 @@
+/**
+ * @file capture.h
+ * @author Stanislav Karpikov
+ * @brief Waveform capture: the pre-trigger and post-trigger samples of all the channels (header)
+ */
+
+#ifndef _CAPTURE_H
+#define _CAPTURE_H
+
+/** @addtogroup app_capture
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/bsp.h"
+#include "adc_logic.h"
+#include "defines.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define CAPTURE_CHANNELS_NUM (ADC_CHANNEL_FULL_COUNT)        /**< The channels of a sample: the physical and the mathematical ones */
+#define CAPTURE_SAMPLES_NUM  (CAPTURE_PERIODS * ADC_VAL_NUM) /**< The length of a capture [samples] */
+#define CAPTURE_POST_DEFAULT (ADC_VAL_NUM)                   /**< The default post-trigger window: one period [samples] */
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** Capture triggers (a mask) */
+typedef enum
+{
+    CAPTURE_TRIGGER_PROTECTION = (1U << 0), /**< A protection event */
+    CAPTURE_TRIGGER_STATE = (1U << 1),      /**< A change of the PFC state */
+    CAPTURE_TRIGGER_COMMAND = (1U << 2),    /**< A command from the panel */
+} capture_trigger_t;
+
+/** The description of a capture */
+struct __attribute__((__packed__)) capture_record_s
+{
+    uint32_t sequence;       /**< The number of the capture (from 1), 0 - no capture */
+    uint64_t unix_time_s_ms; /**< The time of the trigger */
+    uint8_t trigger;         /**< The trigger (capture_trigger_t) */
+    uint32_t type;           /**< The type of the trigger event (as in the events), 0 for a command */
+    uint32_t info;           /**< The info of the trigger event */
+    uint16_t pre_samples;    /**< The number of the samples before the trigger */
+    uint16_t samples;        /**< The number of the samples in the capture */
+};
+
+/** The samples of a capture (the ring, a sample holds all the channels) */
+typedef struct
+{
+    float samples[CAPTURE_SAMPLES_NUM][CAPTURE_CHANNELS_NUM]; /**< The samples */
+} capture_slot_t;
+
+/**
+ * @brief The capture instance: the samples are written to a slot as to a ring until a trigger. After the post-trigger
+ * window the slot is frozen and the writing continues to the oldest slot
+ *
+ * @note The samples are written from the ADC interrupt (a copy and an increment per sample), the triggers come
+ * from the interrupts and the main loop (a trigger is claimed with LDREX/STREX). The captures are read by the main loop:
+ * the sequence number of a capture is checked before and after the copy (a slot is cleared before it is reused)
+ */
+typedef struct
+{
+    volatile uint32_t state; /**< The trigger state (waiting, claimed, recording the post-trigger samples) */
+    uint16_t position;       /**< The position to write in the recording slot */
+    uint16_t written;        /**< The number of the samples written to the recording slot (up to CAPTURE_SAMPLES_NUM) */
+    uint16_t post_left;      /**< The number of the post-trigger samples left */
+    uint16_t post_trigger;   /**< The post-trigger window of the capture being recorded [samples] */
+    uint8_t recording;       /**< The slot being recorded */
+    uint8_t triggers;        /**< The enabled triggers (capture_trigger_t mask) */
+    uint16_t post_samples;   /**< The post-trigger window [samples] */
+    uint32_t sequence;       /**< The number of the last capture */
+
+    struct capture_record_s pending;                     /**< The description of the capture being recorded */
+    uint16_t first[CAPTURE_SLOTS_NUM];                   /**< The position of the first sample of the stored captures */
+    volatile struct capture_record_s records[CAPTURE_SLOTS_NUM]; /**< The descriptions of the stored captures */
+    capture_slot_t slots[CAPTURE_SLOTS_NUM];             /**< The samples */
+} capture_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Init the capture instance: clear the captures, start the recording
+ *
+ * @param capture The capture instance
+ * @param triggers The enabled triggers (capture_trigger_t mask)
+ * @param post_samples The post-trigger window [samples]
+ *
+ * @return The status of the operation
+ */
+status_t capture_init(capture_t* capture, uint8_t triggers, uint16_t post_samples);
+
+/**
+ * @brief Set the triggers and the post-trigger window (the next captures)
+ *
+ * @param capture The capture instance
+ * @param triggers The enabled triggers (capture_trigger_t mask)
+ * @param post_samples The post-trigger window [samples], up to CAPTURE_SAMPLES_NUM
+ *
+ * @return The status of the operation
+ */
+status_t capture_configure(capture_t* capture, uint8_t triggers, uint16_t post_samples);
+
+/**
+ * @brief Write a sample (the ADC interrupt)
+ *
+ * @param capture The capture instance
+ * @param sample The values of all the channels (CAPTURE_CHANNELS_NUM)
+ */
+void capture_write(capture_t* capture, const float* sample);
+
+/**
+ * @brief Trigger a capture
+ * @note The trigger is ignored if it is disabled or the post-trigger samples of another one are being recorded
+ *
+ * @param capture The capture instance
+ * @param trigger The trigger
+ * @param type The type of the trigger event
+ * @param info The info of the trigger event
+ * @param time The time of the trigger
+ *
+ * @return PFC_SUCCESS if the capture has been triggered, PFC_NULL if the trigger is ignored
+ */
+status_t capture_trigger(capture_t* capture, capture_trigger_t trigger, uint32_t type, uint32_t info, uint64_t time);
+
+/**
+ * @brief Get the descriptions of the stored captures (the oldest first)
+ *
+ * @param capture The capture instance
+ * @param num The maximum number of the descriptions
+ * @param[out] records The descriptions
+ *
+ * @return The number of the descriptions written
+ */
+uint8_t capture_get_records(const capture_t* capture, uint8_t num, struct capture_record_s* records);
+
+/**
+ * @brief Read the samples of a channel from a stored capture
+ *
+ * @param capture The capture instance
+ * @param sequence The number of the capture
+ * @param channel The channel
+ * @param offset The first sample (from the start of the capture)
+ * @param num The number of the samples
+ * @param[out] data The samples
+ *
+ * @return The number of the samples written (0 if the capture has been overwritten)
+ */
+uint16_t capture_read(const capture_t* capture, uint32_t sequence, uint8_t channel, uint16_t offset, uint16_t num, float* data);
+
+/**
+ * @brief Start the firmware capture (all the triggers except the state changes, a period after the trigger)
+ * @note Should be called before the interrupts are started
+ */
+void capture_start(void);
+
+/**
+ * @brief Write a sample to the firmware capture (the ADC interrupt)
+ *
+ * @param sample The values of all the channels (CAPTURE_CHANNELS_NUM)
+ */
+void capture_add_sample(const float* sample);
+
+/**
+ * @brief Trigger the firmware capture
+ *
+ * @param trigger The trigger
+ * @param type The type of the trigger event
+ * @param info The info of the trigger event
+ */
+void capture_new_trigger(capture_trigger_t trigger, uint32_t type, uint32_t info);
+
+/**
+ * @brief Get the firmware capture instance
+ *
+ * @return The capture instance
+ */
+capture_t* capture_get_instance(void);
+
+/** @} */
+#endif /* _CAPTURE_H */
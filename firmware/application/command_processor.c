@@ -18,11 +18,17 @@
 #include "BSP/debug.h"
 #include "BSP/system.h"
 #include "adc_logic.h"
+#include "capture.h"
 #include "events.h"
 #include "fw_ver.h"
+#include "journal.h"
+#include "oscillog_codec.h"
 #include "pfc_logic.h"
+#include "seqlock.h"
 #include "settings.h"
 #include "string.h"
+#include "tasks.h"
+#include "telemetry.h"
 
 /*--------------------------------------------------------------
                        PRIVATE FUNCTIONS PROTOTYPES
@@ -45,6 +51,15 @@ static void protocol_command_get_settings_filters(void *pc);
 static void protocol_command_get_work_state(void *pc);
 static void protocol_command_get_version_info(void *pc);
 static void protocol_command_get_events(void *pc);
+static void protocol_command_get_state_trace(void *pc);
+static void protocol_command_set_capture(void *pc);
+static void protocol_command_get_captures(void *pc);
+static void protocol_command_get_capture_data(void *pc);
+static void protocol_command_subscribe(void *pc);
+static void protocol_command_telemetry(void *pc);
+static void protocol_command_get_oscillog_bulk(void *pc);
+static void protocol_command_get_bundle(void *pc);
+static void protocol_command_get_scheduler_stats(void *pc);
 
 /*--------------------------------------------------------------
                        PRIVATE TYPES
@@ -73,7 +88,20 @@ static PFC_COMMAND_CALLBACK handlers_array[] =
         protocol_command_get_work_state,
 
         protocol_command_get_version_info,
-        protocol_command_get_events};
+        protocol_command_get_events,
+        protocol_command_get_state_trace,
+
+        protocol_command_set_capture,
+        protocol_command_get_captures,
+        protocol_command_get_capture_data,
+
+        protocol_command_subscribe,
+        protocol_command_telemetry,
+
+        protocol_command_get_oscillog_bulk,
+        protocol_command_get_bundle,
+
+        protocol_command_get_scheduler_stats};
 
 /** Oscillogram channels */
 enum
@@ -91,12 +119,49 @@ enum
     OSC_CHANNEL_NUMBER /**< The number of oscillog channels */
 };
 
+/** The encoded oscillogram channels of a period (the bulk transfer) */
+struct oscillog_snapshot_s
+{
+    uint16_t number;   /**< The number of the snapshot (0 - none) */
+    uint16_t channels; /**< The channels (a mask) */
+    uint16_t size;     /**< The size of the encoded data */
+    uint8_t data[OSC_CHANNEL_NUMBER * OSCILLOG_CODEC_CHANNEL_MAX(OSCILLOG_TRANSFER_SIZE)]; /**< The encoded channels in the order of the mask bits */
+};
+
 /*--------------------------------------------------------------
                        PRIVATE DATA
 --------------------------------------------------------------*/
 
-/** The last save oscillogram data */
-static float OSC_DATA[OSC_CHANNEL_NUMBER][OSCILLOG_TRANSFER_SIZE] = {0};
+/** Compile-time check: all the captures can be listed in a packet */
+typedef char command_captures_check_t[(CAPTURE_SLOTS_NUM <= MAX_NUM_TRANSFERED_CAPTURES) ? 1 : -1];
+
+/** Compile-time check: the oscillogram channels fit the subscription mask */
+typedef char command_oscillogs_check_t[(OSC_CHANNEL_NUMBER <= 16) ? 1 : -1];
+
+/** Compile-time check: the biggest telemetry block fits a push */
+typedef char command_telemetry_check_t[(sizeof(struct answer_telemetry) + sizeof(struct answer_get_oscillog) <= MAX_TELEMETRY_PACKET_SIZE) ? 1 : -1];
+
+/** Compile-time check: a chunk of the bulk transfer fits a record */
+typedef char command_oscillog_bulk_check_t[(sizeof(struct answer_get_oscillog_bulk) <= MAXIMUM_RECORD_DATA_LENGTH) ? 1 : -1];
+
+/** Compile-time check: all the bundle sections fit a packet */
+typedef char command_bundle_check_t[(sizeof(struct answer_get_bundle) + sizeof(struct answer_get_adc_active) + sizeof(struct answer_get_adc_active_raw) +
+                                     sizeof(struct answer_get_net_params) + sizeof(struct answer_get_work_state) <= MAXIMUM_RECORD_DATA_LENGTH) ? 1 : -1];
+
+/** Compile-time check: the encoded snapshot can be addressed by the chunk offsets */
+typedef char command_oscillog_snapshot_check_t[(sizeof(((struct oscillog_snapshot_s *)0)->data) <= UINT16_MAX) ? 1 : -1];
+
+/** The oscillogram data of the last period (the copies of the sequence lock) */
+static float OSC_DATA[2][OSC_CHANNEL_NUMBER][OSCILLOG_TRANSFER_SIZE] = {0};
+
+/** The lock of the oscillogram data: the readers get the channels of the same period */
+static seqlock_t osc_lock;
+
+/** The telemetry subscription of the panel */
+static telemetry_t telemetry;
+
+/** The oscillogram snapshot being transferred */
+static struct oscillog_snapshot_s oscillog_snapshot;
 
 /*--------------------------------------------------------------
                        PRIVATE FUNCTIONS
@@ -148,47 +213,20 @@ static void preprocess_answer(
     pfc_interface_commands_t command)
 {
     *req = (pc->packet_received.data + MINIMUM_PACKET_LENGTH);
-    *answer = (pc->packet_to_send.data + MINIMUM_PACKET_LENGTH);
+    *answer = (pc->packet_to_send->data + MINIMUM_PACKET_LENGTH);
 
-    pc->packet_to_send.fields.len = len;
-    pc->packet_to_send.fields.status.raw = 0;
-    pc->packet_to_send.fields.command = command;
+    pc->packet_to_send->fields.len = len;
+    pc->packet_to_send->fields.status.raw = 0;
+    pc->packet_to_send->fields.command = command;
 }
 
 /**
- * @brief Protocol command: switch ON/OFF
+ * @brief Fill the active values (an answer or a telemetry block)
  * 
- * @param pc A pointer to the protocol context
+ * @param answer The values to fill
  */
-static void protocol_command_switch_on_off(void *pc)
+static void fill_adc_active(struct answer_get_adc_active *answer)
 {
-    struct command_switch_on_off *req = 0;
-    struct answer_switch_on_off *answer = 0;
-
-    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_switch_on_off), PFC_COMMAND_SWITCH_ON_OFF);
-
-    answer->result = 1;
-    if (pfc_apply_command((pfc_commands_t)req->command, req->data) != PFC_SUCCESS)
-    {
-        answer->result = 0;
-    }
-
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_switch_on_off));
-    protocol_send_packet(pc);
-}
-
-/**
- * @brief Protocol command: get instantenous ADC values
- * 
- * @param pc A pointer to the protocol context
- */
-static void protocol_command_get_adc_active(void *pc)
-{
-    struct command_get_adc_active *req = 0;
-    struct answer_get_adc_active *answer = 0;
-
-    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_adc_active), PFC_COMMAND_GET_ADC_ACTIVE);
-
     float active[ADC_CHANNEL_FULL_COUNT] = {0};
     adc_get_active(active);
 
@@ -209,23 +247,41 @@ static void protocol_command_get_adc_active(void *pc)
     answer->ADC_MATH_A = active[ADC_EDC_A];
     answer->ADC_MATH_B = active[ADC_EDC_B];
     answer->ADC_MATH_C = active[ADC_EDC_C];
-
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_adc_active));
-    protocol_send_packet(pc);
 }
 
 /**
- * @brief Protocol command: get network parameters
+ * @brief Fill the active values without the calibrations (an answer or a bundle section)
  * 
- * @param pc A pointer to the protocol context
+ * @param answer The values to fill
  */
-static void protocol_command_get_net_params(void *pc)
+static void fill_adc_active_raw(struct answer_get_adc_active_raw *answer)
 {
-    struct command_get_net_params *req = 0;
-    struct answer_get_net_params *answer = 0;
+    float active_raw[ADC_CHANNEL_NUMBER] = {0};
+    adc_get_active_raw(active_raw);
 
-    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_net_params), PFC_COMMAND_GET_NET_PARAMS);
+    answer->ADC_UCAP = active_raw[ADC_UCAP];
+    answer->ADC_U_A = active_raw[ADC_U_A];
+    answer->ADC_U_B = active_raw[ADC_U_B];
+    answer->ADC_U_C = active_raw[ADC_U_C];
+    answer->ADC_I_A = active_raw[ADC_I_A];
+    answer->ADC_I_B = active_raw[ADC_I_B];
+    answer->ADC_I_C = active_raw[ADC_I_C];
+    answer->ADC_I_ET = active_raw[ADC_I_ET];
+    answer->ADC_I_TEMP1 = active_raw[ADC_I_TEMP1];
+    answer->ADC_I_TEMP2 = active_raw[ADC_I_TEMP2];
+    answer->ADC_EDC_A = active_raw[ADC_EDC_A];
+    answer->ADC_EDC_B = active_raw[ADC_EDC_B];
+    answer->ADC_EDC_C = active_raw[ADC_EDC_C];
+    answer->ADC_EDC_I = active_raw[ADC_EDC_I];
+}
 
+/**
+ * @brief Fill the network parameters (an answer or a telemetry block)
+ * 
+ * @param answer The values to fill
+ */
+static void fill_net_params(struct answer_get_net_params *answer)
+{
     float U_0Hz[PFC_NCHAN] = {0};
     float I_0Hz[PFC_NCHAN] = {0};
     float U_phase[PFC_NCHAN] = {0};
@@ -248,8 +304,240 @@ static void protocol_command_get_net_params(void *pc)
     answer->U_phase_A = U_phase[PFC_ACHAN];
     answer->U_phase_B = U_phase[PFC_BCHAN];
     answer->U_phase_C = U_phase[PFC_CCHAN];
+}
+
+/**
+ * @brief Fill the work state (an answer or a telemetry block)
+ * 
+ * @param answer The values to fill
+ */
+static void fill_work_state(struct answer_get_work_state *answer)
+{
+    answer->state = pfc_get_state();
+
+    settings_pwm_t pwm_settings = settings_get_pwm();
+    answer->active_channels[PFC_ACHAN] = pwm_settings.active_channels[PFC_ACHAN];
+    answer->active_channels[PFC_BCHAN] = pwm_settings.active_channels[PFC_BCHAN];
+    answer->active_channels[PFC_CCHAN] = pwm_settings.active_channels[PFC_CCHAN];
+}
+
+/**
+ * @brief Fill an oscillogram: the values are scaled to the bytes (an answer or a telemetry block)
+ * 
+ * @param channel The oscillogram channel
+ * @param answer The oscillogram to fill
+ */
+static void fill_oscillog(uint8_t channel, struct answer_get_oscillog *answer)
+{
+    answer->ch = channel;
+    answer->len = OSCILLOG_TRANSFER_SIZE;
+
+    float values[OSCILLOG_TRANSFER_SIZE];
+    seqlock_read(&osc_lock, OSC_DATA[0][channel], OSC_DATA[1][channel], values, sizeof(values));
+
+    float oscillog_max = -1e10;
+    float oscillog_min = 1e10;
+    for (int i = 0; i < OSCILLOG_TRANSFER_SIZE; i++)
+    {
+        if (values[i] > oscillog_max) oscillog_max = values[i];
+        if (values[i] < oscillog_min) oscillog_min = values[i];
+    }
+    float astep = 0.0f;
+    if ((oscillog_max - oscillog_min) == 0)
+    {
+        astep = 255.0f;
+    }
+    else
+    {
+        astep = 255.0f / (oscillog_max - oscillog_min);
+    }
+    for (int i = 0; i < OSCILLOG_TRANSFER_SIZE; i++)
+    {
+        answer->data[i] = (values[i] - oscillog_min) * astep;
+    }
+    answer->max = oscillog_max;
+    answer->min = oscillog_min;
+}
+
+/**
+ * @brief Get the size of a telemetry block
+ * 
+ * @param group The group (a single bit of telemetry_group_t)
+ * 
+ * @return The size of the block
+ */
+static uint32_t telemetry_block_size(uint8_t group)
+{
+    switch (group)
+    {
+        case TELEMETRY_GROUP_ADC_ACTIVE:
+            return sizeof(struct answer_get_adc_active);
+        case TELEMETRY_GROUP_NET_PARAMS:
+            return sizeof(struct answer_get_net_params);
+        case TELEMETRY_GROUP_WORK_STATE:
+            return sizeof(struct answer_get_work_state);
+        case TELEMETRY_GROUP_OSCILLOG:
+            return sizeof(struct answer_get_oscillog);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Fill a telemetry block
+ * 
+ * @param group The group (a single bit of telemetry_group_t)
+ * @param block The block in the push packet
+ */
+static void telemetry_fill_block(uint8_t group, uint8_t *block)
+{
+    switch (group)
+    {
+        case TELEMETRY_GROUP_ADC_ACTIVE:
+            fill_adc_active((struct answer_get_adc_active *)block);
+            break;
+        case TELEMETRY_GROUP_NET_PARAMS:
+            fill_net_params((struct answer_get_net_params *)block);
+            break;
+        case TELEMETRY_GROUP_WORK_STATE:
+            fill_work_state((struct answer_get_work_state *)block);
+            break;
+        case TELEMETRY_GROUP_OSCILLOG:
+            fill_oscillog(telemetry_next_oscillog(&telemetry), (struct answer_get_oscillog *)block);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Start a telemetry push packet
+ * 
+ * @return The header of the push in the packet
+ */
+static struct answer_telemetry *telemetry_start_packet(void)
+{
+    packet_t *packet = protocol_get_push_packet();
+    packet->fields.status.raw = 0;
+    packet->fields.command = PFC_COMMAND_TELEMETRY;
+
+    struct answer_telemetry *header = (struct answer_telemetry *)(packet->data + MINIMUM_PACKET_LENGTH);
+    header->sequence = telemetry.sequence + 1;
+    header->groups = 0;
+    return header;
+}
+
+/**
+ * @brief Send the telemetry push packet
+ * 
+ * @param len The size of the data of the packet
+ * 
+ * @return The status of the operation: PFC_NULL if the transmission queue is full
+ */
+static status_t telemetry_send_packet(uint32_t len)
+{
+    packet_set_data_len(protocol_get_push_packet(), len);
+    status_t status = protocol_push_packet();
+    if (status == PFC_SUCCESS)
+    {
+        telemetry.sequence++;
+    }
+    else
+    {
+        telemetry.skipped++;
+    }
+    return status;
+}
+
+/**
+ * @brief Fill the sections of a bundle
+ * 
+ * @param sections The sections (a mask of the known ones)
+ * @param data The sections in the answer
+ * 
+ * @return The size of the sections
+ */
+static uint32_t bundle_fill_sections(uint8_t sections, uint8_t *data)
+{
+    uint32_t len = 0;
+    if (sections & BUNDLE_SECTION_ADC_ACTIVE)
+    {
+        fill_adc_active((struct answer_get_adc_active *)(data + len));
+        len += sizeof(struct answer_get_adc_active);
+    }
+    if (sections & BUNDLE_SECTION_ADC_ACTIVE_RAW)
+    {
+        fill_adc_active_raw((struct answer_get_adc_active_raw *)(data + len));
+        len += sizeof(struct answer_get_adc_active_raw);
+    }
+    if (sections & BUNDLE_SECTION_NET_PARAMS)
+    {
+        fill_net_params((struct answer_get_net_params *)(data + len));
+        len += sizeof(struct answer_get_net_params);
+    }
+    if (sections & BUNDLE_SECTION_WORK_STATE)
+    {
+        fill_work_state((struct answer_get_work_state *)(data + len));
+        len += sizeof(struct answer_get_work_state);
+    }
+    return len;
+}
+
+/**
+ * @brief Protocol command: switch ON/OFF
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_switch_on_off(void *pc)
+{
+    struct command_switch_on_off *req = 0;
+    struct answer_switch_on_off *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_switch_on_off), PFC_COMMAND_SWITCH_ON_OFF);
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_net_params));
+    answer->result = 1;
+    if (pfc_apply_command((pfc_commands_t)req->command, req->data) != PFC_SUCCESS)
+    {
+        answer->result = 0;
+    }
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_switch_on_off));
+    protocol_send_packet(pc);
+}
+
+/**
+ * @brief Protocol command: get instantenous ADC values
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_get_adc_active(void *pc)
+{
+    struct command_get_adc_active *req = 0;
+    struct answer_get_adc_active *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_adc_active), PFC_COMMAND_GET_ADC_ACTIVE);
+
+    fill_adc_active(answer);
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_adc_active));
+    protocol_send_packet(pc);
+}
+
+/**
+ * @brief Protocol command: get network parameters
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_get_net_params(void *pc)
+{
+    struct command_get_net_params *req = 0;
+    struct answer_get_net_params *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_net_params), PFC_COMMAND_GET_NET_PARAMS);
+
+    fill_net_params(answer);
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_net_params));
     protocol_send_packet(pc);
 }
 
@@ -265,25 +553,9 @@ static void protocol_command_get_adc_active_raw(void *pc)
 
     preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_adc_active_raw), PFC_COMMAND_GET_ADC_ACTIVE_RAW);
 
-    float active_raw[ADC_CHANNEL_NUMBER] = {0};
-    adc_get_active_raw(active_raw);
+    fill_adc_active_raw(answer);
 
-    answer->ADC_UCAP = active_raw[ADC_UCAP];
-    answer->ADC_U_A = active_raw[ADC_U_A];
-    answer->ADC_U_B = active_raw[ADC_U_B];
-    answer->ADC_U_C = active_raw[ADC_U_C];
-    answer->ADC_I_A = active_raw[ADC_I_A];
-    answer->ADC_I_B = active_raw[ADC_I_B];
-    answer->ADC_I_C = active_raw[ADC_I_C];
-    answer->ADC_I_ET = active_raw[ADC_I_ET];
-    answer->ADC_I_TEMP1 = active_raw[ADC_I_TEMP1];
-    answer->ADC_I_TEMP2 = active_raw[ADC_I_TEMP2];
-    answer->ADC_EDC_A = active_raw[ADC_EDC_A];
-    answer->ADC_EDC_B = active_raw[ADC_EDC_B];
-    answer->ADC_EDC_C = active_raw[ADC_EDC_C];
-    answer->ADC_EDC_I = active_raw[ADC_EDC_I];
-
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_adc_active_raw));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_adc_active_raw));
     protocol_send_packet(pc);
 }
 
@@ -301,14 +573,9 @@ static void protocol_command_get_work_state(void *pc)
 
     system_set_time(req->currentTime);
 
-    answer->state = pfc_get_state();
+    fill_work_state(answer);
 
-    settings_pwm_t pwm_settings = settings_get_pwm();
-    answer->active_channels[PFC_ACHAN] = pwm_settings.active_channels[PFC_ACHAN];
-    answer->active_channels[PFC_BCHAN] = pwm_settings.active_channels[PFC_BCHAN];
-    answer->active_channels[PFC_CCHAN] = pwm_settings.active_channels[PFC_CCHAN];
-
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_work_state));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_work_state));
     protocol_send_packet(pc);
 }
 
@@ -339,10 +606,27 @@ static void protocol_command_get_version_info(void *pc)
     answer->minute = MN;
     answer->second = SS;
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_version_info));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_version_info));
     protocol_send_packet(pc);
 }
 
+/**
+ * @brief Copy the oscillogram channels of the period
+ * 
+ * @param[out] osc The oscillogram data
+ * @param osc_adc_ch The ADC data of the period
+ */
+static void copy_osc_data(float osc[OSC_CHANNEL_NUMBER][OSCILLOG_TRANSFER_SIZE], float osc_adc_ch[ADC_CHANNEL_FULL_COUNT][ADC_VAL_NUM])
+{
+    for (uint32_t i = 0; i < PFC_NCHAN; i++)
+    {
+        memcpy(osc[OSC_U_A + i], osc_adc_ch[ADC_MATH_A + i], sizeof(osc[OSC_U_A + i]));
+        memcpy(osc[OSC_I_A + i], osc_adc_ch[ADC_I_A + i], sizeof(osc[OSC_I_A + i]));
+        memcpy(osc[OSC_PFC_A + i], osc_adc_ch[ADC_MATH_C_A + i], sizeof(osc[OSC_PFC_A + i]));
+    }
+    memcpy(osc[OSC_UCAP], osc_adc_ch[ADC_UCAP], sizeof(osc[OSC_UCAP]));
+}
+
 /**
  * @brief Protocol command: get oscillogram
  * 
@@ -355,38 +639,14 @@ static void protocol_command_get_oscillog(void *pc)
 
     preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_oscillog), PFC_COMMAND_GET_OSCILLOG);
 
-    if (req->num > OSC_CHANNEL_NUMBER)
+    if (req->num >= OSC_CHANNEL_NUMBER)
     {
         protocol_error_handle(pc, packet_get_command(&(((protocol_context_t *)pc)->packet_received)));
         return;
     }
-    answer->ch = req->num;
-    answer->len = OSCILLOG_TRANSFER_SIZE;
-
-    float oscillog_max = -1e10;
-    float oscillog_min = 1e10;
-    for (int i = 0; i < OSCILLOG_TRANSFER_SIZE; i++)
-    {
-        if (OSC_DATA[req->num][i] > oscillog_max) oscillog_max = OSC_DATA[req->num][i];
-        if (OSC_DATA[req->num][i] < oscillog_min) oscillog_min = OSC_DATA[req->num][i];
-    }
-    float astep = 0.0f;
-    if ((oscillog_max - oscillog_min) == 0)
-    {
-        astep = 255.0f;
-    }
-    else
-    {
-        astep = 255.0f / (oscillog_max - oscillog_min);
-    }
-    for (int i = 0; i < OSCILLOG_TRANSFER_SIZE; i++)
-    {
-        answer->data[i] = (OSC_DATA[req->num][i] - oscillog_min) * astep;
-    }
-    answer->max = oscillog_max;
-    answer->min = oscillog_min;
+    fill_oscillog(req->num, answer);
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_oscillog));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_oscillog));
     protocol_send_packet(pc);
 }
 
@@ -411,7 +671,7 @@ static void protocol_command_get_settings_calibrations(void *pc)
         answer->offset[i] = calibrations.offset[i];
     }
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_settings_calibrations));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_settings_calibrations));
     protocol_send_packet(pc);
 }
 
@@ -438,7 +698,7 @@ static void protocol_command_set_settings_calibrations(void *pc)
 
     settings_set_calibrations(calibrations);
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_set_settings_calibrations));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_set_settings_calibrations));
     protocol_send_packet(pc);
 }
 
@@ -466,7 +726,7 @@ static void protocol_command_get_settings_protection(void *pc)
     answer->I_max_rms = protection.I_max_rms;
     answer->I_max_peak = protection.I_max_peak;
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_settings_protection));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_settings_protection));
     protocol_send_packet(pc);
 }
 
@@ -496,7 +756,7 @@ static void protocol_command_set_settings_protection(void *pc)
 
     settings_set_protection(protection);
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_set_settings_protection));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_set_settings_protection));
     protocol_send_packet(pc);
 }
 
@@ -520,7 +780,7 @@ static void protocol_command_get_settings_capacitors(void *pc)
     answer->Ucap_nominal = capacitors.Ucap_nominal;
     answer->Ucap_precharge = capacitors.Ucap_precharge;
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_settings_capacitors));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_settings_capacitors));
     protocol_send_packet(pc);
 }
 
@@ -546,7 +806,7 @@ static void protocol_command_set_settings_capacitors(void *pc)
 
     settings_set_capacitors(capacitors);
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_set_settings_capacitors));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_set_settings_capacitors));
     protocol_send_packet(pc);
 }
 
@@ -568,7 +828,7 @@ static void protocol_command_get_settings_filters(void *pc)
     answer->K_U = filters.K_U;
     answer->K_Ucap = filters.K_Ucap;
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_settings_filters));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_settings_filters));
     protocol_send_packet(pc);
 }
 
@@ -592,7 +852,7 @@ static void protocol_command_set_settings_filters(void *pc)
 
     settings_set_filters(filters);
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_set_settings_filters));
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_set_settings_filters));
     protocol_send_packet(pc);
 }
 
@@ -608,20 +868,301 @@ static void protocol_command_get_events(void *pc)
 
     preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_events), PFC_COMMAND_GET_EVENTS);
 
-    answer->num = events_get(req->after_index, MAX_NUM_TRANSFERED_EVENTS, answer->events);
+    answer->last_sequence = events_get_last_sequence();
+    answer->num = 0;
+    /* The events overwritten in RAM (or stored before the restart) are read from the journal */
+    if ((int32_t)(req->sequence - events_get_first_sequence()) < 0)
+    {
+        answer->num = journal_get(req->sequence, MAX_NUM_TRANSFERED_EVENTS, answer->events);
+    }
+    if (answer->num == 0) answer->num = events_get(req->sequence, MAX_NUM_TRANSFERED_EVENTS, answer->events);
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_events));
+    protocol_send_packet(pc);
+}
 
-    packet_set_data_len(&(((protocol_context_t *)pc)->packet_to_send), sizeof(struct answer_get_events));
+/**
+ * @brief Protocol command: get the state transitions trace
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_get_state_trace(void *pc)
+{
+    struct command_get_state_trace *req = 0;
+    struct answer_get_state_trace *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_state_trace), PFC_COMMAND_GET_STATE_TRACE);
+
+    uint32_t first_index = 0;
+    answer->num = pfc_get_trace(req->after_index, MAX_NUM_TRANSFERED_TRANSITIONS, answer->transitions, &first_index);
+    answer->first_index = first_index;
+    answer->total = pfc_get_instance()->trace_in;
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_state_trace));
     protocol_send_packet(pc);
 }
 
 /**
- * @brief Protocol command: test command
+ * @brief Protocol command: set the waveform capture triggers, trigger a capture
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_set_capture(void *pc)
+{
+    struct command_set_capture *req = 0;
+    struct answer_set_capture *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_set_capture), PFC_COMMAND_SET_CAPTURE);
+
+    answer->result = 1;
+    if (capture_configure(capture_get_instance(), req->triggers, req->post_samples) != PFC_SUCCESS)
+    {
+        answer->result = 0;
+    }
+    else if (req->trigger)
+    {
+        capture_new_trigger(CAPTURE_TRIGGER_COMMAND, 0, 0);
+    }
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_set_capture));
+    protocol_send_packet(pc);
+}
+
+/**
+ * @brief Protocol command: get the list of the waveform captures
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_get_captures(void *pc)
+{
+    struct command_get_captures *req = 0;
+    struct answer_get_captures *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_captures), PFC_COMMAND_GET_CAPTURES);
+
+    const capture_t *capture = capture_get_instance();
+    answer->triggers = capture->triggers;
+    answer->post_samples = capture->post_samples;
+    answer->max_samples = CAPTURE_SAMPLES_NUM;
+    answer->channels = CAPTURE_CHANNELS_NUM;
+    answer->num = capture_get_records(capture, MAX_NUM_TRANSFERED_CAPTURES, answer->captures);
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_captures));
+    protocol_send_packet(pc);
+}
+
+/**
+ * @brief Protocol command: get the samples of a waveform capture (a chunk of a channel)
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_get_capture_data(void *pc)
+{
+    struct command_get_capture_data *req = 0;
+    struct answer_get_capture_data *answer = 0;
+    float data[MAX_NUM_TRANSFERED_SAMPLES];
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_capture_data), PFC_COMMAND_GET_CAPTURE_DATA);
+
+    if (req->channel >= CAPTURE_CHANNELS_NUM)
+    {
+        protocol_error_handle(pc, packet_get_command(&(((protocol_context_t *)pc)->packet_received)));
+        return;
+    }
+    answer->sequence = req->sequence;
+    answer->channel = req->channel;
+    answer->offset = req->offset;
+    /* The samples are unaligned in the answer (the floating-point stores need the alignment) */
+    answer->num = capture_read(capture_get_instance(), req->sequence, req->channel, req->offset, MAX_NUM_TRANSFERED_SAMPLES, data);
+    memcpy(answer->data, data, sizeof(answer->data));
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_capture_data));
+    protocol_send_packet(pc);
+}
+
+/**
+ * @brief Protocol command: subscribe to the telemetry, renew or cancel the subscription
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_subscribe(void *pc)
+{
+    struct command_subscribe *req = 0;
+    struct answer_subscribe *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_subscribe), PFC_COMMAND_SUBSCRIBE);
+
+    answer->result = 1;
+    if ((req->oscillogs >> OSC_CHANNEL_NUMBER) ||
+        telemetry_subscribe(&telemetry, req->groups, req->oscillogs, req->decimation, req->timeout, system_get_ticks()) != PFC_SUCCESS)
+    {
+        answer->result = 0;
+    }
+    answer->sequence = telemetry.sequence;
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_subscribe));
+    protocol_send_packet(pc);
+}
+
+/**
+ * @brief Protocol command: the telemetry push is not expected from the panel
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_telemetry(void *pc)
+{
+    protocol_error_handle(pc, PFC_COMMAND_TELEMETRY);
+}
+
+/**
+ * @brief Take a new oscillogram snapshot: encode the channels of the last period
+ * @note The channels are encoded again if the oscillogram is written meanwhile, so they are of the same period
+ * 
+ * @param channels The channels (a mask)
+ */
+static void take_oscillog_snapshot(uint16_t channels)
+{
+    uint32_t size;
+    uint32_t sequence;
+    do
+    {
+        sequence = seqlock_read_begin(&osc_lock);
+        float(*osc)[OSCILLOG_TRANSFER_SIZE] = OSC_DATA[seqlock_read_copy(sequence)];
+        size = 0;
+        for (uint8_t channel = 0; channel < OSC_CHANNEL_NUMBER; channel++)
+        {
+            if (!(channels & (1U << channel))) continue;
+            size += oscillog_codec_encode_channel(osc[channel], OSCILLOG_TRANSFER_SIZE,
+                                                  oscillog_snapshot.data + size, sizeof(oscillog_snapshot.data) - size);
+        }
+    } while (seqlock_read_retry(&osc_lock, sequence));
+    /* The number changes with every snapshot, so the chunks of different periods are not mixed */
+    if (++oscillog_snapshot.number == 0) oscillog_snapshot.number = 1;
+    oscillog_snapshot.channels = channels;
+    oscillog_snapshot.size = size;
+}
+
+/**
+ * @brief Protocol command: get the oscillogram channels of a period in the full resolution (a chunk of the snapshot)
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_get_oscillog_bulk(void *pc)
+{
+    struct command_get_oscillog_bulk *req = 0;
+    struct answer_get_oscillog_bulk *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_oscillog_bulk), PFC_COMMAND_GET_OSCILLOG_BULK);
+
+    if (req->snapshot == 0)
+    {
+        if (!req->channels || (req->channels >> OSC_CHANNEL_NUMBER))
+        {
+            protocol_error_handle(pc, PFC_COMMAND_GET_OSCILLOG_BULK);
+            return;
+        }
+        take_oscillog_snapshot(req->channels);
+    }
+
+    answer->snapshot = oscillog_snapshot.number;
+    answer->channels = oscillog_snapshot.channels;
+    answer->samples = OSCILLOG_TRANSFER_SIZE;
+    answer->size = oscillog_snapshot.size;
+    answer->offset = req->offset;
+    answer->len = 0;
+    /* A replaced snapshot is answered with no data: the panel starts again */
+    if ((req->snapshot == 0 || req->snapshot == oscillog_snapshot.number) && req->offset < oscillog_snapshot.size)
+    {
+        uint32_t len = oscillog_snapshot.size - req->offset;
+        answer->len = (len < OSCILLOG_CHUNK_SIZE) ? len : OSCILLOG_CHUNK_SIZE;
+        memcpy(answer->data, oscillog_snapshot.data + req->offset, answer->len);
+    }
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send,
+                        sizeof(struct answer_get_oscillog_bulk) - OSCILLOG_CHUNK_SIZE + answer->len);
+    protocol_send_packet(pc);
+}
+
+/**
+ * @brief Protocol command: get the live values of a period at once
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_get_bundle(void *pc)
+{
+    struct command_get_bundle *req = 0;
+    struct answer_get_bundle *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_bundle), PFC_COMMAND_GET_BUNDLE);
+
+    uint8_t sections = req->sections & BUNDLE_SECTIONS_ALL;
+    if (sections & BUNDLE_SECTION_WORK_STATE) system_set_time(req->currentTime);
+
+    /* The sections are filled again if a period has been published meanwhile, so they are of the same period */
+    uint32_t period;
+    uint32_t len;
+    do
+    {
+        period = adc_get_periods();
+        len = bundle_fill_sections(sections, (uint8_t *)answer + sizeof(struct answer_get_bundle));
+    } while (period != adc_get_periods());
+    answer->period = period;
+    answer->sections = sections;
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_bundle) + len);
+    protocol_send_packet(pc);
+}
+
+/**
+ * @brief Protocol command: get the statistics of the main loop tasks and the control interrupt
+ * 
+ * @param pc A pointer to the protocol context
+ */
+static void protocol_command_get_scheduler_stats(void *pc)
+{
+    struct command_get_scheduler_stats *req = 0;
+    struct answer_get_scheduler_stats *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_get_scheduler_stats), PFC_COMMAND_GET_SCHEDULER_STATS);
+
+    answer->num = TASKS_COUNT;
+    for (uint8_t task = 0; task < TASKS_COUNT; task++)
+    {
+        tasks_get_stats((task_t)task, &answer->tasks[task]);
+    }
+    uint32_t isr_cycles_last, isr_cycles_max;
+    adc_get_isr_cycles(&isr_cycles_last, &isr_cycles_max);
+    answer->isr_cycles_last = isr_cycles_last;
+    answer->isr_cycles_max = isr_cycles_max;
+    if (req->clear)
+    {
+        tasks_clear_stats();
+        adc_clear_isr_cycles();
+    }
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_get_scheduler_stats));
+    protocol_send_packet(pc);
+}
+
+/**
+ * @brief Protocol command: test the connection, tell the supported framing
+ * @note The firmware keeps no state of the panel: the framing of an answer follows the request
  * 
  * @param pc A pointer to the protocol context
  */
 static void protocol_command_test(void *pc)
 {
-    /* TEST */
+    struct command_test *req = 0;
+    struct answer_test *answer = 0;
+
+    preprocess_answer((void **)&req, (void **)&answer, pc, sizeof(struct answer_test), PFC_COMMAND_TEST);
+
+    answer->version = PROTOCOL_VERSION;
+    answer->frame_size = MAXIMUM_FRAME_LENGTH;
+    answer->record_size = MAXIMUM_RECORD_DATA_LENGTH;
+
+    packet_set_data_len(((protocol_context_t *)pc)->packet_to_send, sizeof(struct answer_test));
+    protocol_send_packet(pc);
 }
 
 /*--------------------------------------------------------------
@@ -633,19 +1174,50 @@ static void protocol_command_test(void *pc)
  * 
  * @param osc_adc_ch A pointer to the ADC structure (should be in the specific format)
  */
-status_t protocol_write_osc_data(float osc_adc_ch[PFC_NCHAN][ADC_VAL_NUM])
+status_t protocol_write_osc_data(float osc_adc_ch[ADC_CHANNEL_FULL_COUNT][ADC_VAL_NUM])
+{
+    ARGUMENT_ASSERT(osc_adc_ch);
+
+    /* The readers take the other copy while a copy is written, the writer never waits */
+    seqlock_write_begin(&osc_lock);
+    copy_osc_data(OSC_DATA[0], osc_adc_ch);
+    seqlock_write_switch(&osc_lock);
+    copy_osc_data(OSC_DATA[1], osc_adc_ch);
+    seqlock_write_end(&osc_lock);
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Push the subscribed telemetry to the panel (called at the end of a period)
+ */
+void protocol_push_telemetry(void)
 {
-		ARGUMENT_ASSERT(osc_adc_ch);
-		
-    /* TODO: Add lock protection */
-    for (int i = 0; i < PFC_NCHAN; i++)
+    uint8_t groups = telemetry_period(&telemetry, system_get_ticks());
+    if (!groups) return;
+
+    /* The blocks are packed in the order of the groups, a block which does not fit starts the next packet */
+    struct answer_telemetry *header = 0;
+    uint32_t len = 0;
+    for (uint8_t group = 1; group & TELEMETRY_GROUPS_ALL; group <<= 1)
     {
-        memcpy(OSC_DATA[OSC_U_A + i], osc_adc_ch[ADC_MATH_A + i], sizeof(OSC_DATA[OSC_U_A + i]));
-        memcpy(OSC_DATA[OSC_I_A + i], osc_adc_ch[ADC_I_A + i], sizeof(OSC_DATA[OSC_I_A + i]));
-        memcpy(OSC_DATA[OSC_PFC_A + i], osc_adc_ch[ADC_MATH_C_A + i], sizeof(OSC_DATA[OSC_PFC_A + i]));
+        if (!(groups & group)) continue;
+
+        uint32_t size = telemetry_block_size(group);
+        if (header && len + size > MAX_TELEMETRY_PACKET_SIZE)
+        {
+            if (telemetry_send_packet(len) != PFC_SUCCESS) return;
+            header = 0;
+        }
+        if (!header)
+        {
+            header = telemetry_start_packet();
+            len = sizeof(struct answer_telemetry);
+        }
+        telemetry_fill_block(group, (uint8_t *)header + len);
+        header->groups |= group;
+        len += size;
     }
-    memcpy(OSC_DATA[OSC_UCAP], osc_adc_ch[ADC_UCAP], sizeof(OSC_DATA[OSC_UCAP]));
-    return PFC_SUCCESS;
+    if (header) telemetry_send_packet(len);
 }
 
 /*
@@ -48,6 +48,19 @@ typedef enum
 
     PFC_COMMAND_GET_VERSION_INFO, /**< Get firmware info */
     PFC_COMMAND_GET_EVENTS,       /**< Get events */
+    PFC_COMMAND_GET_STATE_TRACE,  /**< Get the state transitions trace */
+
+    PFC_COMMAND_SET_CAPTURE,      /**< Set the waveform capture triggers, trigger a capture */
+    PFC_COMMAND_GET_CAPTURES,     /**< Get the list of the waveform captures */
+    PFC_COMMAND_GET_CAPTURE_DATA, /**< Get the samples of a waveform capture */
+
+    PFC_COMMAND_SUBSCRIBE, /**< Subscribe to the telemetry */
+    PFC_COMMAND_TELEMETRY, /**< The telemetry push (sent by the firmware only) */
+
+    PFC_COMMAND_GET_OSCILLOG_BULK, /**< Get the oscillogram channels of a period in the full resolution */
+    PFC_COMMAND_GET_BUNDLE,        /**< Get the live values of a period at once (the sections of a mask) */
+
+    PFC_COMMAND_GET_SCHEDULER_STATS, /**< Get the jitter and the overruns of the main loop tasks, the cycles of the control interrupt */
 
     PFC_COMMAND_COUNT /**< The length of the structure */
 } pfc_interface_commands_t;
@@ -70,7 +83,12 @@ status_t command_handlers_init(void);
  *
  * @return The operation status
  */
-status_t protocol_write_osc_data(float osc_adc_ch[PFC_NCHAN][ADC_VAL_NUM]);
+status_t protocol_write_osc_data(float osc_adc_ch[ADC_CHANNEL_FULL_COUNT][ADC_VAL_NUM]);
+
+/**
+ * @brief Push the subscribed telemetry to the panel (called at the end of a period)
+ */
+void protocol_push_telemetry(void);
 
 /** @} */
 #endif /*_COMMAND_PROCESSOR_H */
@@ -23,7 +23,11 @@
 /* Hardware settings (TODO: move to the panel configuration) */
 #define STARTUP_STABILISATION_TIME (100U)  /**< The timeout before start the PFC operation */
 #define SYNC_MINIMUM_PHASE         (0.03f) /**< The minimum phase difference that is considered as synchronisation */
+#define SYNC_MAXIMUM_PERIOD_DELTA  (0.5f)  /**< The maximum period change [us] that is considered as synchronisation */
 #define PRELOAD_STABILISATION_TIME (100U)  /**< The timeout before preload is started */
+#define SYNC_TIMEOUT               (500U)  /**< The maximum time of the synchronisation [periods] */
+#define PRECHARGE_TIMEOUT          (500U)  /**< The maximum time of the precharge [periods] */
+#define CHARGE_PULSE_TIME          (4U)    /**< The charge time after the last charge command [periods] */
 
 #define EPS 0 /**< Epsilon, minimum float value to compare, used in ADC callback processing */
 
@@ -40,6 +44,20 @@
 #define MATH_SQRT2 ((float)1.414213562373095) /**< The value of sqrt(2) */
 #define MATH_PI    ((float)3.141592653589793) /**< The PI value */
 
+/*--------------------------------------------------------------
+											PUBLIC DEFINES::MEMORY
+--------------------------------------------------------------*/
+
+#define TCM_PLACEMENT (1) /**< Set to 0 to run the control interrupt from the flash memory and the AXI SRAM (to compare the cycles) */
+
+#if TCM_PLACEMENT == 1
+#define ITCM_CODE __attribute__((section("itcm_code"))) /**< Place a function of the control interrupt in the ITCM RAM (the scatter file) */
+#define DTCM_DATA __attribute__((section("dtcm_data"))) /**< Place the data of the control interrupt in the DTCM RAM (the scatter file) */
+#else
+#define ITCM_CODE
+#define DTCM_DATA
+#endif
+
 /*--------------------------------------------------------------
 											PUBLIC DEFINES::INTERFACE
 --------------------------------------------------------------*/
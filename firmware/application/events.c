@@ -16,29 +16,39 @@
 #include "events.h"
 
 #include "BSP/system.h"
+#include "capture.h"
 #include "command_processor.h"
 #include "pfc_logic.h"
+#include "rate_limiter.h"
 #include "string.h"
 
 /*--------------------------------------------------------------
                        DEFINES
 --------------------------------------------------------------*/
 
-#define EVENTS_REPEAT_TIME (2000) /**< After this time an event will be repeated */
+#define EVENTS_LIMIT_BURST   (3U)    /**< The number of the protection events passed at once (per subevent and channel) */
+#define EVENTS_LIMIT_PERIOD  (2000U) /**< The time to pass one more protection event after a burst [ms] */
+#define EVENTS_LIMIT_SOURCES (EVENTS_PROTECTION_SUBTYPES_NUM * ADC_CHANNEL_NUMBER) /**< The number of the rate limited sources */
 
 /*--------------------------------------------------------------
                        PRIVATE DATA
 --------------------------------------------------------------*/
 
-/** Events storage */
-static struct event_record_s events[EVENTS_RECORDS_NUM + 1] = {0};
+static events_storage_t storage; /**< The events storage instance of the firmware */
 
-static uint16_t events_in = 0;                                                               /**< The number of events have been written to the storage */
-static uint16_t events_out = 0;                                                              /**< The number of events have been written from the storage */
-static uint32_t lastEventTime[SUB_EVENT_TYPE_PROTECTION_IGBT + 1][ADC_CHANNEL_NUMBER] = {0}; /**< The array of the last timestamps of events */
+static rate_limiter_bucket_t limiter_buckets[EVENTS_LIMIT_SOURCES]; /**< The buckets of the protection events (all are full on the start) */
 
-/** Protection levels for different subevents */
-static const uint16_t protection_levels[] = {
+/** The rate limiter of the protection events (a source is a subevent and a channel) */
+static rate_limiter_t limiter = {EVENTS_LIMIT_PERIOD, EVENTS_LIMIT_BURST * EVENTS_LIMIT_PERIOD, EVENTS_LIMIT_SOURCES, limiter_buckets};
+
+/** Compile-time check: the storage capacity is a power of two (the record index is masked from the sequence number) */
+typedef char events_capacity_check_t[((EVENTS_RECORDS_NUM & (EVENTS_RECORDS_NUM - 1)) == 0) ? 1 : -1];
+
+/** Compile-time check: the storage covers all the protection subevents */
+typedef char events_subtypes_check_t[(EVENTS_PROTECTION_SUBTYPES_NUM == SUB_EVENT_TYPE_PROTECTION_IGBT + 1) ? 1 : -1];
+
+/** Protection levels for different subevents (in the RAM: read by the trip in the control interrupt) */
+static uint16_t protection_levels[EVENTS_PROTECTION_SUBTYPES_NUM] DTCM_DATA = {
     PROTECTION_WARNING_STOP,  //SUB_EVENT_TYPE_PROTECTION_UCAP_MIN
     PROTECTION_ERROR_STOP,    //SUB_EVENT_TYPE_PROTECTION_UCAP_MAX
     PROTECTION_ERROR_STOP,    //SUB_EVENT_TYPE_PROTECTION_TEMPERATURE
@@ -59,19 +69,34 @@ static const uint16_t protection_levels[] = {
 --------------------------------------------------------------*/
 
 /**
- * @brief Lock the events module data
+ * @brief Get the sequence number of the oldest event in the storage
+ *
+ * @param storage The events storage instance
+ * @param last The sequence number of the last event
+ *
+ * @return The sequence number
  */
-static void events_lock(void)
+static uint32_t events_storage_first(const events_storage_t* storage, uint32_t last)
 {
-    ENTER_CRITICAL();
+    if (last - storage->cleared_sequence > EVENTS_RECORDS_NUM) return last - EVENTS_RECORDS_NUM + 1;
+    return storage->cleared_sequence + 1;
 }
 
 /**
- * @brief Lock the events module data
+ * @brief Reserve a record for a new event
+ *
+ * @param storage The events storage instance
+ *
+ * @return The sequence number of the new event
  */
-static void events_unlock(void)
+static ITCM_CODE uint32_t events_reserve(events_storage_t* storage)
 {
-    EXIT_CRITICAL();
+    uint32_t sequence;
+    do
+    {
+        sequence = __ldrex(&storage->sequence) + 1;
+    } while (__strex(sequence, &storage->sequence));
+    return sequence;
 }
 
 /*--------------------------------------------------------------
@@ -80,24 +105,26 @@ static void events_unlock(void)
 
 /**
  * @brief Check an event: apply a protection action if needed
+ * @note The action is applied to every event (the repeated ones too), but not in the fault state
  * 
  * @param subtype Event type
- * @param info Event info
  */
-static void events_check(uint16_t subtype, uint32_t info)
+static ITCM_CODE void events_check(uint16_t subtype)
 {
+    if (subtype >= EVENTS_PROTECTION_SUBTYPES_NUM) return;
+    pfc_state_t state = pfc_get_state();
     switch (protection_levels[subtype])
     {
         case PROTECTION_IGNORE:
             break;
         case PROTECTION_WARNING_STOP:
-            if (pfc_get_state() >= PFC_STATE_SYNC)
+            if (state >= PFC_STATE_SYNC && state != PFC_STATE_FAULTBLOCK)
             {
                 pfc_faultblock();
             }
             break;
         case PROTECTION_ERROR_STOP:
-            if (pfc_get_state() >= PFC_STATE_SYNC)
+            if (state >= PFC_STATE_SYNC && state != PFC_STATE_FAULTBLOCK)
             {
                 pfc_faultblock();
             }
@@ -106,38 +133,18 @@ static void events_check(uint16_t subtype, uint32_t info)
 }
 
 /**
- * @brief Add a new event
- * 
- * @param event The event data
+ * @brief Get the rate limiter source of a protection event
+ *
+ * @param subtype The subevent
+ * @param info The event info (the channel number)
+ *
+ * @return The source number (EVENTS_LIMIT_SOURCES if the event is not limited)
  */
-static void events_add(struct event_record_s* event)
+static ITCM_CODE uint16_t events_limit_source(uint32_t subtype, uint32_t info)
 {
-    if ((event->type & 0xFFFF) == EVENT_TYPE_PROTECTION)
-    {
-        uint16_t subtype = (event->type >> 16) & 0xFFFF;
-        events_check(subtype, event->info);
-        events_lock();
-        if ((system_get_time() - lastEventTime[subtype][event->info]) < EVENTS_REPEAT_TIME)
-        {
-            events_unlock();
-            return;
-        }
-        events_unlock();
-        lastEventTime[subtype][event->info] = system_get_time();
-    }
-
-    events_lock();
-    events[events_in] = *event;
-
-    events_in++;
-    events_in &= EVENTS_RECORDS_NUM;
-
-    if (events_in == events_out)
-    {
-        events_out++;
-        events_out &= EVENTS_RECORDS_NUM;
-    }
-    events_unlock();
+    /* The info of the protection events is the channel number, other values are not limited */
+    if (subtype >= EVENTS_PROTECTION_SUBTYPES_NUM || info >= ADC_CHANNEL_NUMBER) return EVENTS_LIMIT_SOURCES;
+    return subtype * ADC_CHANNEL_NUMBER + info;
 }
 
 /*--------------------------------------------------------------
@@ -146,71 +153,196 @@ static void events_add(struct event_record_s* event)
 
 /*
  * @brief Add a new event (external function)
+ * @note The protection action is applied to every protection event, but the repeated ones are rate limited
+ * per subevent and channel (a burst is stored, then one event per the refill period). The repeat filter is per
+ * source: a protection source is checked by a single context (the control interrupt or the main loop), the storage
+ * record is reserved by LDREX/STREX for any context
  * 
  * @param main The main event type
  * @param sub The sub event type
  * @param info The event info
  * @param value The event data
  */
-void events_new_event(event_type_t main, uint32_t sub, uint32_t info, float value)
+ITCM_CODE void events_new_event(event_type_t main, uint32_t sub, uint32_t info, float value)
 {
+    if (main == EVENT_TYPE_CHANGESTATE)
+    {
+        capture_new_trigger(CAPTURE_TRIGGER_STATE, (main) | (sub << 16), info);
+    }
+    if (main == EVENT_TYPE_PROTECTION)
+    {
+        /* The events in the fault state follow the trip: the capture of the trip is kept */
+        if (pfc_get_state() != PFC_STATE_FAULTBLOCK)
+        {
+            capture_new_trigger(CAPTURE_TRIGGER_PROTECTION, (main) | (sub << 16), info);
+        }
+        events_check(sub);
+        /* The repeated events are counted only, the 64-bit time is not read for them */
+        if (rate_limiter_check(&limiter, events_limit_source(sub, info), system_get_ticks()) == PFC_NULL) return;
+    }
+
     struct event_record_s newevent = {0};
     newevent.unix_time_s_ms = system_get_time();
     newevent.type = (main) | (((uint32_t)sub) << 16);
     newevent.info = info;
     newevent.value = value;
-    events_add(&newevent);
+    events_storage_add(&storage, &newevent);
 }
 
 /*
- * @brief Clear the events storage
+ * @brief Add the summary events for the suppressed protection events (the main loop)
+ * @note A summary is added when the burst of a source has ended (no events during the refill of the bucket)
  */
-void events_clear(void)
+void events_report_suppressed(void)
 {
-    events_lock();
-    int i = 0;
-    for (i = 0; i < EVENTS_RECORDS_NUM; i++)
+    uint32_t now = system_get_ticks();
+    for (uint16_t source = 0; source < EVENTS_LIMIT_SOURCES; source++)
     {
-        events[i].unix_time_s_ms = 0;
+        uint32_t count = rate_limiter_take_suppressed(&limiter, source, now);
+        if (!count) continue;
+
+        uint32_t subtype = source / ADC_CHANNEL_NUMBER;
+        uint32_t channel = source % ADC_CHANNEL_NUMBER;
+        events_new_event(EVENT_TYPE_EVENT, SUB_EVENT_TYPE_EVENT_SUPPRESSED, (subtype << 16) | channel, (float)count);
     }
-    events_in = 0;
-    events_out = 0;
-    memset(lastEventTime, 0, sizeof(lastEventTime));
-    events_unlock();
+}
+
+/*
+ * @brief Clear the events storage
+ */
+void events_clear(void)
+{
+    events_storage_clear(&storage);
 }
 
 /*
  * @brief Get events from the storage
  * 
- * @param after_index The start index in the events storage
+ * @param sequence The sequence number of the first event to write
+ * @param num The number of events to write
+ * @param buf The buffer to write events
+ *
+ * @return The count of events have been written
+ */
+uint16_t events_get(uint32_t sequence, uint16_t num, struct event_record_s* buf)
+{
+    return events_storage_get(&storage, sequence, num, buf);
+}
+
+/*
+ * @brief Get the sequence number of the last event
+ *
+ * @return The sequence number (0 if there were no events)
+ */
+uint32_t events_get_last_sequence(void)
+{
+    return storage.sequence;
+}
+
+/*
+ * @brief Get the sequence number of the oldest event in the storage
+ *
+ * @return The sequence number (the next event if the storage is empty)
+ */
+uint32_t events_get_first_sequence(void)
+{
+    return events_storage_first(&storage, storage.sequence);
+}
+
+/*
+ * @brief Continue the events numbering after the stored events (the events storage is cleared)
+ * @note Should be called before the events are added
+ *
+ * @param sequence The sequence number of the last stored event
+ */
+void events_restore_sequence(uint32_t sequence)
+{
+    storage.sequence = sequence;
+    storage.cleared_sequence = sequence;
+}
+
+/*
+ * @brief Add an event to the storage
+ * @note The function is re-entrant: it can be called from an interrupt while the main loop adds an event
+ *
+ * @param storage The events storage instance
+ * @param event The event data (the sequence number is assigned by the storage)
+ *
+ * @return The status of the operation
+ */
+ITCM_CODE status_t events_storage_add(events_storage_t* storage, const struct event_record_s* event)
+{
+    ARGUMENT_ASSERT(storage);
+    ARGUMENT_ASSERT(event);
+
+    uint32_t sequence = events_reserve(storage);
+    struct event_record_s* record = &storage->events[sequence & (EVENTS_RECORDS_NUM - 1)];
+
+    /* The sequence number of another record marks the record as being written */
+    record->sequence = sequence - 1;
+    __dmb(0xF);
+    record->unix_time_s_ms = event->unix_time_s_ms;
+    record->type = event->type;
+    record->info = event->info;
+    record->value = event->value;
+    __dmb(0xF);
+    record->sequence = sequence;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Clear the events storage
+ *
+ * @param storage The events storage instance
+ */
+void events_storage_clear(events_storage_t* storage)
+{
+    if (!storage) return;
+    storage->cleared_sequence = storage->sequence;
+}
+
+/*
+ * @brief Get events from the storage
+ * @note If the requested events have been overwritten (or the sequence number is from the previous start),
+ * the oldest stored events are written. Lost events are seen as gaps in the sequence numbers
+ *
+ * @param storage The events storage instance
+ * @param sequence The sequence number of the first event to write
  * @param num The number of events to write
  * @param buf The buffer to write events
  *
  * @return The count of events have been written
  */
-uint16_t events_get(uint64_t after_index, uint16_t num, struct event_record_s* buf)
+uint16_t events_storage_get(const events_storage_t* storage, uint32_t sequence, uint16_t num, struct event_record_s* buf)
 {
     uint16_t count = 0;
-    events_lock();
-    uint16_t ev_out = events_out;
-    while (ev_out != events_in)
+    if (!storage || !buf) return 0;
+
+    uint32_t last = storage->sequence;
+    uint32_t first = events_storage_first(storage, last);
+    if ((int32_t)(sequence - first) < 0 || (int32_t)(sequence - last) > 1) sequence = first;
+
+    while ((int32_t)(last - sequence) >= 0 && count < num)
     {
-        if (events[ev_out].unix_time_s_ms >= after_index)
+        const struct event_record_s* record = &storage->events[sequence & (EVENTS_RECORDS_NUM - 1)];
+        uint32_t before = record->sequence;
+        __dmb(0xF);
+        memcpy(&buf[count], record, sizeof(struct event_record_s));
+        __dmb(0xF);
+        uint32_t after = record->sequence;
+
+        if (before == sequence && after == sequence)
         {
-            memcpy(buf, &events[ev_out], sizeof(struct event_record_s));
-            buf++;
-            after_index = events[ev_out].unix_time_s_ms;
             count++;
-            if (count >= num)
-            {
-                events_unlock();
-                return count;
-            }
         }
-        ev_out++;
-        ev_out &= EVENTS_RECORDS_NUM;
+        else if ((int32_t)(after - sequence) <= 0)
+        {
+            /* The event is being written (the writer has been interrupted) */
+            break;
+        }
+        /* Otherwise the event has been overwritten by a newer one */
+        sequence++;
     }
-    events_unlock();
     return count;
 }
 /** @} */
@@ -16,13 +16,15 @@
                        INCLUDE
 --------------------------------------------------------------*/
 
+#include "adc_logic.h"
 #include "stdint.h"
 
 /*--------------------------------------------------------------
                        DEFINES
 --------------------------------------------------------------*/
 
-#define EVENTS_RECORDS_NUM (0x3F) /**< The number of the events storage */
+#define EVENTS_RECORDS_NUM             (256U) /**< The capacity of the events storage (a power of two) */
+#define EVENTS_PROTECTION_SUBTYPES_NUM (13U)  /**< The number of the protection subevents (SUB_EVENT_TYPE_PROTECTION_IGBT + 1) */
 
 /*--------------------------------------------------------------
                        PUBLIC TYPES
@@ -31,6 +33,7 @@
 /** The structure to store an event */
 struct __attribute__((__packed__)) event_record_s
 {
+    uint32_t sequence; /**< The sequence number of the event (from 1), used as the cursor to read the storage */
     uint64_t unix_time_s_ms;
 
     uint32_t type;
@@ -47,12 +50,62 @@ typedef enum
     EVENT_TYPE_EVENT        /**< An other event */
 } event_type_t;
 
+/**
+ * @brief The events storage instance: a ring of the last events, the oldest ones are overwritten
+ *
+ * @note Events are added from the interrupts and the main loop without masking the interrupts: a record is reserved
+ * by the sequence number (LDREX/STREX) and published by writing the sequence number to the record after the data.
+ * The reader (the main loop) checks the record sequence number before and after the copy
+ */
+typedef struct
+{
+    volatile uint32_t sequence;                       /**< The sequence number of the last reserved event */
+    uint32_t cleared_sequence;                        /**< The sequence number of the last event before the storage has been cleared */
+    struct event_record_s events[EVENTS_RECORDS_NUM]; /**< Events storage */
+} events_storage_t;
+
 /*--------------------------------------------------------------
                        PUBLIC FUNCTIONS
 --------------------------------------------------------------*/
 
+/**
+ * @brief Add an event to the storage
+ * @note The function is re-entrant: it can be called from an interrupt while the main loop adds an event
+ *
+ * @param storage The events storage instance
+ * @param event The event data (the sequence number is assigned by the storage)
+ *
+ * @return The status of the operation
+ */
+status_t events_storage_add(events_storage_t* storage, const struct event_record_s* event);
+
+/**
+ * @brief Clear the events storage
+ *
+ * @param storage The events storage instance
+ */
+void events_storage_clear(events_storage_t* storage);
+
+/**
+ * @brief Get events from the storage
+ * @note If the requested events have been overwritten (or the sequence number is from the previous start),
+ * the oldest stored events are written. Lost events are seen as gaps in the sequence numbers
+ *
+ * @param storage The events storage instance
+ * @param sequence The sequence number of the first event to write
+ * @param num The number of events to write
+ * @param buf The buffer to write events
+ *
+ * @return The count of events have been written
+ */
+uint16_t events_storage_get(const events_storage_t* storage, uint32_t sequence, uint16_t num, struct event_record_s* buf);
+
 /**
  * @brief Add a new event (external function)
+ * @note The protection action is applied to every protection event, but the repeated ones are rate limited
+ * per subevent and channel (a burst is stored, then one event per the refill period). The repeat filter is per
+ * source: a protection source is checked by a single context (the control interrupt or the main loop), the storage
+ * record is reserved by LDREX/STREX for any context
  * 
  * @param main The main event type
  * @param sub The sub event type
@@ -61,6 +114,12 @@ typedef enum
  */
 void events_new_event(event_type_t main, uint32_t sub, uint32_t info, float value);
 
+/**
+ * @brief Add the summary events for the suppressed protection events (the main loop)
+ * @note A summary is added when the burst of a source has ended (no events during the refill of the bucket)
+ */
+void events_report_suppressed(void);
+
 /**
  * @brief Clear the events storage
  */
@@ -69,13 +128,35 @@ void events_clear(void);
 /**
  * @brief Get events from the storage
  * 
- * @param after_index The start index in the events storage
+ * @param sequence The sequence number of the first event to write
  * @param num The number of events to write
  * @param buf The buffer to write events
  *
  * @return The count of events have been written
  */
-uint16_t events_get(uint64_t after_index, uint16_t num, struct event_record_s* buf);
+uint16_t events_get(uint32_t sequence, uint16_t num, struct event_record_s* buf);
+
+/**
+ * @brief Get the sequence number of the last event
+ *
+ * @return The sequence number (0 if there were no events)
+ */
+uint32_t events_get_last_sequence(void);
+
+/**
+ * @brief Get the sequence number of the oldest event in the storage
+ *
+ * @return The sequence number (the next event if the storage is empty)
+ */
+uint32_t events_get_first_sequence(void);
+
+/**
+ * @brief Continue the events numbering after the stored events (the events storage is cleared)
+ * @note Should be called before the events are added
+ *
+ * @param sequence The sequence number of the last stored event
+ */
+void events_restore_sequence(uint32_t sequence);
 
 /** @} */
 #endif /* EVENTS_H_ */
@@ -110,7 +110,7 @@ status_t events_check_adc_overload(float *adc_values)
  *
  * @return The status of the operation
  */
-status_t events_check_ud(float Ucap)
+ITCM_CODE status_t events_check_ud(float Ucap)
 {
     static uint16_t ud_ov_ticks = 0;
     if (pfc_get_state() >= PFC_STATE_STOPPING || pfc_get_state() <= PFC_STATE_STOP) return PFC_SUCCESS;
@@ -199,7 +199,7 @@ status_t events_check_rms_voltage(void)
  *
  * @return The status of the operation
  */
-status_t events_check_overvoltage(float *U)
+ITCM_CODE status_t events_check_overvoltage(float *U)
 {
     static int ov_ticks[PFC_NCHAN] = {0, 0, 0};
 
@@ -265,7 +265,7 @@ status_t events_check_rms_overcurrent(void)
  *
  * @return The status of the operation
  */
-status_t events_check_overcurrent(float *I)
+ITCM_CODE status_t events_check_overcurrent(float *I)
 {
     if (pfc_get_state() >= PFC_STATE_STOPPING || pfc_get_state() <= PFC_STATE_STOP) return PFC_SUCCESS;
 
@@ -0,0 +1,465 @@
+/**
+ * @file journal.c
+ * @author Stanislav Karpikov
+ * @brief Events journal: the events history in the flash memory, kept over the restarts
+ */
+
+/** @addtogroup app_journal
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "journal.h"
+
+#include "BSP/flash.h"
+#include "crc.h"
+#include "pfc_logic.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define JOURNAL_MAGIC       (0x4C4E524AU) /**< The mark of a formatted sector ("JRNL") */
+#define JOURNAL_ERASED_BYTE (0xFFU)       /**< The value of the erased flash memory */
+#define JOURNAL_RECORD_WORDS (JOURNAL_RECORD_SIZE / sizeof(uint32_t)) /**< The size of a record slot [words] */
+
+/*--------------------------------------------------------------
+                       PRIVATE TYPES
+--------------------------------------------------------------*/
+
+/** A record in the flash memory */
+struct __attribute__((__packed__)) journal_record_s
+{
+    struct event_record_s event; /**< The event */
+    uint8_t reserved[6];         /**< Reserved (zeros) */
+    uint16_t crc;                /**< CRC16 of the record (without the field) */
+};
+
+/** A sector header in the flash memory (the first record slot) */
+struct __attribute__((__packed__)) journal_header_s
+{
+    uint32_t magic;       /**< JOURNAL_MAGIC */
+    uint32_t generation;  /**< The number of the sector formatting in the journal (from 1) */
+    uint8_t reserved[22]; /**< Reserved (zeros) */
+    uint16_t crc;         /**< CRC16 of the header (without the field) */
+};
+
+/** Compile-time check: a record fills a slot */
+typedef char journal_record_check_t[(sizeof(struct journal_record_s) == JOURNAL_RECORD_SIZE) ? 1 : -1];
+
+/** Compile-time check: a header fills a slot */
+typedef char journal_header_check_t[(sizeof(struct journal_header_s) == JOURNAL_RECORD_SIZE) ? 1 : -1];
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static journal_t journal_instance; /**< The journal instance of the firmware */
+static uint8_t journal_failed = 0; /**< The flash memory has failed, the journal is not written until the restart */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Get the address of a sector (the header)
+ *
+ * @param sector The sector
+ *
+ * @return The address
+ */
+static uint32_t journal_sector_address(uint8_t sector)
+{
+    return JOURNAL_START_ADDRESS + sector * JOURNAL_SECTOR_SIZE;
+}
+
+/**
+ * @brief Get the address of a record slot
+ *
+ * @param sector The sector
+ * @param slot The slot in the sector
+ *
+ * @return The address
+ */
+static uint32_t journal_slot_address(uint8_t sector, uint32_t slot)
+{
+    return journal_sector_address(sector) + (slot + 1) * JOURNAL_RECORD_SIZE;
+}
+
+/**
+ * @brief Check if the data is erased
+ *
+ * @param data The data
+ * @param size The size of the data
+ *
+ * @return 1 if all the bytes are erased, 0 otherwise
+ */
+static uint8_t journal_is_erased(const void* data, uint32_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        if (bytes[i] != JOURNAL_ERASED_BYTE) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Read a record
+ *
+ * @param sector The sector
+ * @param slot The slot in the sector
+ * @param[out] record The record
+ *
+ * @return 1 if the record is correct (CRC), 0 otherwise
+ */
+static uint8_t journal_read_record(uint8_t sector, uint32_t slot, struct journal_record_s* record)
+{
+    if (flash_read(journal_slot_address(sector, slot), record, sizeof(struct journal_record_s)) != PFC_SUCCESS) return 0;
+    return crc16((uint8_t*)record, sizeof(struct journal_record_s) - sizeof(uint16_t)) == record->crc;
+}
+
+/**
+ * @brief Write a record slot
+ *
+ * @param address The address of the slot
+ * @param data The record or the header
+ *
+ * @return The status of the operation
+ */
+static status_t journal_write_slot(uint32_t address, const void* data)
+{
+    uint32_t words[JOURNAL_RECORD_WORDS];
+    memcpy(words, data, JOURNAL_RECORD_SIZE);
+    return flash_program(address, words, JOURNAL_RECORD_WORDS);
+}
+
+/**
+ * @brief Add a record to the index of a sector
+ *
+ * @param state The sector state
+ * @param slot The slot of the record
+ * @param sequence The sequence number of the record
+ */
+static void journal_index_add(journal_sector_t* state, uint32_t slot, uint32_t sequence)
+{
+    uint32_t* entry = &state->index[slot / JOURNAL_INDEX_STEP];
+    if (*entry == 0) *entry = sequence;
+}
+
+/**
+ * @brief Get the sequence number of the first record of a sector
+ *
+ * @param state The sector state
+ *
+ * @return The sequence number (0 - no records)
+ */
+static uint32_t journal_first_sequence(const journal_sector_t* state)
+{
+    for (uint32_t i = 0; i < JOURNAL_INDEX_NUM; i++)
+    {
+        if (state->index[i]) return state->index[i];
+    }
+    return 0;
+}
+
+/**
+ * @brief Find the slot to start the search of a record
+ *
+ * @param state The sector state
+ * @param sequence The sequence number of the record
+ *
+ * @return The slot
+ */
+static uint32_t journal_seek(const journal_sector_t* state, uint32_t sequence)
+{
+    uint32_t slot = 0;
+    for (uint32_t i = 0; i < JOURNAL_INDEX_NUM; i++)
+    {
+        if (state->index[i] == 0) continue;
+        if (state->index[i] > sequence) break;
+        slot = i * JOURNAL_INDEX_STEP;
+    }
+    return slot;
+}
+
+/**
+ * @brief Get the next sector in the order of writing
+ *
+ * @param journal The journal instance
+ * @param generation The generation of the previous sector (0 - get the oldest sector)
+ *
+ * @return The sector, JOURNAL_SECTORS_NUM if there are no more sectors
+ */
+static uint8_t journal_next_sector(const journal_t* journal, uint32_t generation)
+{
+    uint8_t next = JOURNAL_SECTORS_NUM;
+    for (uint8_t sector = 0; sector < JOURNAL_SECTORS_NUM; sector++)
+    {
+        uint32_t sector_generation = journal->sectors[sector].generation;
+        if (sector_generation <= generation) continue;
+        if (next == JOURNAL_SECTORS_NUM || sector_generation < journal->sectors[next].generation) next = sector;
+    }
+    return next;
+}
+
+/**
+ * @brief Restore the state of a sector from the flash memory
+ *
+ * @param journal The journal instance
+ * @param sector The sector
+ */
+static void journal_scan_sector(journal_t* journal, uint8_t sector)
+{
+    journal_sector_t* state = &journal->sectors[sector];
+    struct journal_header_s header;
+    memset(state, 0, sizeof(journal_sector_t));
+
+    if (flash_read(journal_sector_address(sector), &header, sizeof(header)) != PFC_SUCCESS) return;
+    if (header.magic != JOURNAL_MAGIC || header.generation == 0) return;
+    if (crc16((uint8_t*)&header, sizeof(header) - sizeof(uint16_t)) != header.crc) return;
+    state->generation = header.generation;
+
+    /* The records are written one by one, the first erased slot is the end */
+    for (uint32_t slot = 0; slot < JOURNAL_SLOTS_NUM; slot++)
+    {
+        struct journal_record_s record;
+        uint8_t correct = journal_read_record(sector, slot, &record);
+        if (journal_is_erased(&record, sizeof(record))) break;
+        state->used = slot + 1;
+        if (!correct)
+        {
+            /* The record has been broken by a power loss */
+            journal->corrupted++;
+            continue;
+        }
+        journal_index_add(state, slot, record.event.sequence);
+        if (record.event.sequence > journal->last_sequence) journal->last_sequence = record.event.sequence;
+    }
+}
+
+/**
+ * @brief Erase and format the next sector to write: a not formatted one or the oldest one
+ * @note The header is written after the erase: a sector broken by a power loss is not formatted
+ *
+ * @param journal The journal instance
+ *
+ * @return The status of the operation
+ */
+static status_t journal_format(journal_t* journal)
+{
+    uint8_t target = 0;
+    uint32_t generation = 0;
+    for (uint8_t sector = 0; sector < JOURNAL_SECTORS_NUM; sector++)
+    {
+        if (journal->sectors[sector].generation > generation) generation = journal->sectors[sector].generation;
+        if (journal->sectors[sector].generation < journal->sectors[target].generation) target = sector;
+    }
+
+    memset(&journal->sectors[target], 0, sizeof(journal_sector_t));
+    journal->active = JOURNAL_SECTORS_NUM;
+
+    status_t status = flash_erase(journal_sector_address(target));
+    if (status != PFC_SUCCESS) return status;
+
+    struct journal_header_s header;
+    memset(&header, 0, sizeof(header));
+    header.magic = JOURNAL_MAGIC;
+    header.generation = generation + 1;
+    header.crc = crc16((uint8_t*)&header, sizeof(header) - sizeof(uint16_t));
+    status = journal_write_slot(journal_sector_address(target), &header);
+    if (status != PFC_SUCCESS) return status;
+
+    journal->sectors[target].generation = header.generation;
+    journal->active = target;
+    return PFC_SUCCESS;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Restore the journal state from the flash memory (the flash memory is not written)
+ *
+ * @param journal The journal instance
+ *
+ * @return The status of the operation
+ */
+status_t journal_init(journal_t* journal)
+{
+    ARGUMENT_ASSERT(journal);
+    memset(journal, 0, sizeof(journal_t));
+    journal->active = JOURNAL_SECTORS_NUM;
+    for (uint8_t sector = 0; sector < JOURNAL_SECTORS_NUM; sector++)
+    {
+        journal_scan_sector(journal, sector);
+        if (journal->sectors[sector].generation == 0) continue;
+        if (journal->active == JOURNAL_SECTORS_NUM ||
+            journal->sectors[sector].generation > journal->sectors[journal->active].generation)
+        {
+            journal->active = sector;
+        }
+    }
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Write an event to the journal
+ * @note The oldest sector is erased if the active one is full. Should not be called from interrupts
+ *
+ * @param journal The journal instance
+ * @param event The event
+ * @param erase_allowed 1 - a sector erase is allowed (it stalls the code fetch from the flash memory for about a second)
+ *
+ * @return PFC_SUCCESS if the event has been written, PFC_NULL if the event is older than the last one, PFC_WARNING if
+ * the active sector is full and the erase is not allowed (the event is not written), the flash error otherwise
+ */
+status_t journal_append(journal_t* journal, const struct event_record_s* event, uint8_t erase_allowed)
+{
+    ARGUMENT_ASSERT(journal);
+    ARGUMENT_ASSERT(event);
+    if (event->sequence <= journal->last_sequence) return PFC_NULL;
+
+    if (journal->active >= JOURNAL_SECTORS_NUM || journal->sectors[journal->active].used >= JOURNAL_SLOTS_NUM)
+    {
+        if (!erase_allowed) return PFC_WARNING;
+        status_t status = journal_format(journal);
+        if (status != PFC_SUCCESS) return status;
+    }
+
+    struct journal_record_s record;
+    memset(&record, 0, sizeof(record));
+    record.event = *event;
+    record.crc = crc16((uint8_t*)&record, sizeof(record) - sizeof(uint16_t));
+
+    /* The slot is used even if the write fails: it can not be written again without the erase */
+    journal_sector_t* state = &journal->sectors[journal->active];
+    uint32_t slot = state->used++;
+    status_t status = journal_write_slot(journal_slot_address(journal->active, slot), &record);
+    if (status != PFC_SUCCESS)
+    {
+        journal->corrupted++;
+        return status;
+    }
+
+    journal_index_add(state, slot, event->sequence);
+    journal->last_sequence = event->sequence;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Read events from the journal
+ * @note If the requested event is older than the stored ones, the oldest stored events are written
+ *
+ * @param journal The journal instance
+ * @param sequence The sequence number of the first event to write
+ * @param num The number of events to write
+ * @param buf The buffer to write events
+ *
+ * @return The count of events have been written
+ */
+uint16_t journal_read(const journal_t* journal, uint32_t sequence, uint16_t num, struct event_record_s* buf)
+{
+    uint16_t count = 0;
+    if (!journal || !buf) return 0;
+
+    uint32_t generation = 0;
+    uint8_t sector;
+    while (count < num && (sector = journal_next_sector(journal, generation)) < JOURNAL_SECTORS_NUM)
+    {
+        const journal_sector_t* state = &journal->sectors[sector];
+        generation = state->generation;
+
+        uint32_t slot = 0;
+        if (count == 0)
+        {
+            /* Skip the sector if the next one starts before the requested event */
+            uint8_t next = journal_next_sector(journal, generation);
+            if (next < JOURNAL_SECTORS_NUM)
+            {
+                uint32_t next_first = journal_first_sequence(&journal->sectors[next]);
+                if (next_first != 0 && next_first <= sequence) continue;
+            }
+            slot = journal_seek(state, sequence);
+        }
+
+        for (; slot < state->used && count < num; slot++)
+        {
+            struct journal_record_s record;
+            if (!journal_read_record(sector, slot, &record)) continue;
+            if (record.event.sequence < sequence) continue;
+            buf[count++] = record.event;
+        }
+    }
+    return count;
+}
+
+/*
+ * @brief Restore the firmware journal and continue the events numbering after the stored events
+ * @note Should be called before the interrupts are started
+ */
+void journal_start(void)
+{
+    journal_init(&journal_instance);
+    events_restore_sequence(journal_instance.last_sequence);
+}
+
+/*
+ * @brief Write the new events to the firmware journal (the main loop)
+ * @note The flash memory stalls the code fetch while written, so the events are written only while the PWM is off. A
+ * full sector is erased only while the power hardware is switched off (the interrupts are stalled for the whole erase):
+ * the events wait for it in the events storage, the ones overwritten there meanwhile are counted as dropped
+ */
+void journal_process(void)
+{
+    if (journal_failed || pfc_is_pwm_on()) return;
+
+    struct event_record_s events[JOURNAL_BATCH_SIZE];
+    uint16_t num = events_get(journal_instance.last_sequence + 1, JOURNAL_BATCH_SIZE, events);
+    for (uint16_t i = 0; i < num; i++)
+    {
+        uint32_t last_sequence = journal_instance.last_sequence;
+        status_t status = journal_append(&journal_instance, &events[i], pfc_is_power_off());
+        if (status == PFC_WARNING) return;
+        if (status != PFC_SUCCESS && status != PFC_NULL)
+        {
+            journal_failed = 1;
+            return;
+        }
+        /* The events storage has overwritten the events not written */
+        if (status == PFC_SUCCESS && events[i].sequence > last_sequence + 1)
+        {
+            journal_instance.dropped += events[i].sequence - last_sequence - 1;
+        }
+    }
+}
+
+/*
+ * @brief Get events from the firmware journal
+ *
+ * @param sequence The sequence number of the first event to write
+ * @param num The number of events to write
+ * @param buf The buffer to write events
+ *
+ * @return The count of events have been written
+ */
+uint16_t journal_get(uint32_t sequence, uint16_t num, struct event_record_s* buf)
+{
+    return journal_read(&journal_instance, sequence, num, buf);
+}
+
+/*
+ * @brief Get the number of the events dropped by the firmware journal (lost while the erases were not allowed)
+ *
+ * @return The number of the events
+ */
+uint32_t journal_get_dropped(void)
+{
+    return journal_instance.dropped;
+}
+/** @} */
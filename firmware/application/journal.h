@@ -0,0 +1,131 @@
+/**
+ * @file journal.h
+ * @author Stanislav Karpikov
+ * @brief Events journal: the events history in the flash memory, kept over the restarts (header)
+ */
+
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+/** @addtogroup app_journal
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/bsp.h"
+#include "events.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define JOURNAL_RECORD_SIZE (32U) /**< The size of a record slot in the flash memory (the first slot of a sector is the header) */
+#define JOURNAL_SLOTS_NUM   (JOURNAL_SECTOR_SIZE / JOURNAL_RECORD_SIZE - 1) /**< The number of the record slots in a sector */
+#define JOURNAL_INDEX_STEP  (64U) /**< The number of the record slots per an index entry */
+#define JOURNAL_INDEX_NUM   ((JOURNAL_SLOTS_NUM + JOURNAL_INDEX_STEP - 1) / JOURNAL_INDEX_STEP) /**< The index entries per sector */
+#define JOURNAL_BATCH_SIZE  (8U)  /**< The maximum number of the events written per a call of the process function */
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** The state of a journal sector (restored from the flash memory on the start) */
+typedef struct
+{
+    uint32_t generation;               /**< The number of the sector formatting in the journal (0 - the sector is not formatted) */
+    uint32_t used;                     /**< The number of the used record slots (including the corrupted ones) */
+    uint32_t index[JOURNAL_INDEX_NUM]; /**< The sequence number of the first record in every JOURNAL_INDEX_STEP slots (0 - no records) */
+} journal_sector_t;
+
+/**
+ * @brief The journal instance
+ *
+ * @note The sectors are written in turn, the oldest one is erased when the active one is full (the wear is levelled).
+ * A record is a copy of the event with CRC16. A record broken by a power loss is skipped on the start
+ */
+typedef struct
+{
+    uint32_t last_sequence;                        /**< The sequence number of the last stored event */
+    uint32_t corrupted;                            /**< The number of the corrupted records (found on the start or failed to write) */
+    uint32_t dropped;                              /**< The number of the events lost while the erases were not allowed */
+    uint8_t active;                                /**< The active sector (to write), JOURNAL_SECTORS_NUM - none */
+    journal_sector_t sectors[JOURNAL_SECTORS_NUM]; /**< The sectors */
+} journal_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Restore the journal state from the flash memory (the flash memory is not written)
+ *
+ * @param journal The journal instance
+ *
+ * @return The status of the operation
+ */
+status_t journal_init(journal_t* journal);
+
+/**
+ * @brief Write an event to the journal
+ * @note The oldest sector is erased if the active one is full. Should not be called from interrupts
+ *
+ * @param journal The journal instance
+ * @param event The event
+ * @param erase_allowed 1 - a sector erase is allowed (it stalls the code fetch from the flash memory for about a second)
+ *
+ * @return PFC_SUCCESS if the event has been written, PFC_NULL if the event is older than the last one, PFC_WARNING if
+ * the active sector is full and the erase is not allowed (the event is not written), the flash error otherwise
+ */
+status_t journal_append(journal_t* journal, const struct event_record_s* event, uint8_t erase_allowed);
+
+/**
+ * @brief Read events from the journal
+ * @note If the requested event is older than the stored ones, the oldest stored events are written
+ *
+ * @param journal The journal instance
+ * @param sequence The sequence number of the first event to write
+ * @param num The number of events to write
+ * @param buf The buffer to write events
+ *
+ * @return The count of events have been written
+ */
+uint16_t journal_read(const journal_t* journal, uint32_t sequence, uint16_t num, struct event_record_s* buf);
+
+/**
+ * @brief Restore the firmware journal and continue the events numbering after the stored events
+ * @note Should be called before the interrupts are started
+ */
+void journal_start(void);
+
+/**
+ * @brief Write the new events to the firmware journal (the main loop)
+ * @note The flash memory stalls the code fetch while written, so the events are written only while the PWM is off. A
+ * full sector is erased only while the power hardware is switched off (the interrupts are stalled for the whole erase):
+ * the events wait for it in the events storage, the ones overwritten there meanwhile are counted as dropped
+ */
+void journal_process(void);
+
+/**
+ * @brief Get events from the firmware journal
+ *
+ * @param sequence The sequence number of the first event to write
+ * @param num The number of events to write
+ * @param buf The buffer to write events
+ *
+ * @return The count of events have been written
+ */
+uint16_t journal_get(uint32_t sequence, uint16_t num, struct event_record_s* buf);
+
+/**
+ * @brief Get the number of the events dropped by the firmware journal (lost while the erases were not allowed)
+ *
+ * @return The number of the events
+ */
+uint32_t journal_get_dropped(void);
+
+/** @} */
+#endif /* _JOURNAL_H */
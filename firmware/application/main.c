@@ -26,10 +26,13 @@
 #include "eeprom_emulation.h"
 #include "command_processor.h"
 #include "events_process.h"
+#include "journal.h"
 #include "pfc_logic.h"
 #include "settings.h"
 /* app */
 #include "adc_logic.h"
+#include "capture.h"
+#include "tasks.h"
 /* settings */
 #include "defines.h"
 #include "string.h"
@@ -56,8 +59,16 @@ int main(void)
     uart_init();
     iwdg_init();
 
+    capture_start();
+    journal_start();
+
+    pfc_init();
+
     system_delay_ticks(STARTUP_TIMEOUT);
 
+    /* The ADC interrupt releases the processing of the periods */
+    tasks_init();
+
     adc_logic_start();
 
     protocol_hw_init();
@@ -66,12 +77,7 @@ int main(void)
 
     while (1)
     {
-        protocol_work();
-
-        algorithm_process();
-
-        adc_set_temperature(28);  //TODO: Add temperature sensor measurement
-        events_check_temperature();
+        tasks_run();
     }
 }
 
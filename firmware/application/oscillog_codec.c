@@ -0,0 +1,185 @@
+/**
+ * @file oscillog_codec.c
+ * @author Stanislav Karpikov
+ * @brief Oscillogram codec: 16-bit fixed point samples, the second order prediction, zig-zag varint residuals
+ */
+
+/** @addtogroup app_oscillog_codec
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "oscillog_codec.h"
+
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define OSCILLOG_CODEC_FULL_SCALE (32767) /**< The fixed point value of the maximum absolute value */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Predict a sample by the previous two (a line through them)
+ *
+ * @param samples The samples
+ * @param index The index of the sample
+ *
+ * @return The predicted value
+ */
+static int32_t oscillog_codec_predict(const int16_t* samples, uint16_t index)
+{
+    if (index == 0) return 0;
+    if (index == 1) return samples[0];
+    return 2 * (int32_t)samples[index - 1] - samples[index - 2];
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Convert the values to the 16-bit fixed point: the full scale is the maximum absolute value
+ *
+ * @param values The values
+ * @param num The number of the values
+ * @param[out] samples The samples (value = sample * scale)
+ *
+ * @return The scale
+ */
+float oscillog_codec_quantize(const float* values, uint16_t num, int16_t* samples)
+{
+    float peak = 0;
+    for (uint16_t i = 0; i < num; i++)
+    {
+        float magnitude = (values[i] < 0) ? -values[i] : values[i];
+        if (magnitude > peak) peak = magnitude;
+    }
+    /* A zero channel is kept as zeros with any scale */
+    float scale = (peak > 0) ? peak / OSCILLOG_CODEC_FULL_SCALE : 1.0f;
+    float inverse = 1.0f / scale;
+
+    for (uint16_t i = 0; i < num; i++)
+    {
+        float sample = values[i] * inverse;
+        int32_t rounded = (int32_t)((sample < 0) ? sample - 0.5f : sample + 0.5f);
+        if (rounded > OSCILLOG_CODEC_FULL_SCALE) rounded = OSCILLOG_CODEC_FULL_SCALE;
+        if (rounded < -OSCILLOG_CODEC_FULL_SCALE) rounded = -OSCILLOG_CODEC_FULL_SCALE;
+        samples[i] = (int16_t)rounded;
+    }
+    return scale;
+}
+
+/*
+ * @brief Encode the samples: the residuals of the second order prediction as the zig-zag varints (lossless)
+ *
+ * @param samples The samples
+ * @param num The number of the samples
+ * @param[out] data The encoded data
+ * @param size The size of the buffer
+ *
+ * @return The size of the encoded data, 0 if the buffer is too small
+ */
+uint32_t oscillog_codec_encode(const int16_t* samples, uint16_t num, uint8_t* data, uint32_t size)
+{
+    uint32_t length = 0;
+    for (uint16_t i = 0; i < num; i++)
+    {
+        int32_t residual = samples[i] - oscillog_codec_predict(samples, i);
+        /* The zig-zag: the small residuals of both signs are small numbers */
+        uint32_t value = ((uint32_t)residual << 1) ^ (uint32_t)(residual >> 31);
+        do
+        {
+            if (length >= size) return 0;
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            data[length++] = value ? (byte | 0x80) : byte;
+        } while (value);
+    }
+    return length;
+}
+
+/*
+ * @brief Decode the samples
+ *
+ * @param data The encoded data
+ * @param size The size of the encoded data
+ * @param[out] samples The samples
+ * @param num The number of the samples
+ *
+ * @return The number of the bytes decoded, 0 if the data is malformed
+ */
+uint32_t oscillog_codec_decode(const uint8_t* data, uint32_t size, int16_t* samples, uint16_t num)
+{
+    uint32_t length = 0;
+    for (uint16_t i = 0; i < num; i++)
+    {
+        uint32_t value = 0;
+        uint8_t byte;
+        uint8_t count = 0;
+        do
+        {
+            if (length >= size || count >= OSCILLOG_CODEC_RESIDUAL_MAX) return 0;
+            byte = data[length++];
+            value |= (uint32_t)(byte & 0x7F) << (7 * count++);
+        } while (byte & 0x80);
+
+        int32_t residual = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+        int32_t sample = oscillog_codec_predict(samples, i) + residual;
+        if (sample > INT16_MAX || sample < INT16_MIN) return 0;
+        samples[i] = (int16_t)sample;
+    }
+    return length;
+}
+
+/*
+ * @brief Encode a channel: the scale (float), then the encoded samples
+ *
+ * @param values The values
+ * @param num The number of the values
+ * @param[out] data The encoded data
+ * @param size The size of the buffer (OSCILLOG_CODEC_CHANNEL_MAX is always enough)
+ *
+ * @return The size of the encoded data, 0 if the buffer is too small or the number is above OSCILLOG_CODEC_SAMPLES_MAX
+ */
+uint32_t oscillog_codec_encode_channel(const float* values, uint16_t num, uint8_t* data, uint32_t size)
+{
+    int16_t samples[OSCILLOG_CODEC_SAMPLES_MAX];
+    if (size < sizeof(float) || num > OSCILLOG_CODEC_SAMPLES_MAX) return 0;
+
+    float scale = oscillog_codec_quantize(values, num, samples);
+    memcpy(data, &scale, sizeof(scale));
+    uint32_t length = oscillog_codec_encode(samples, num, data + sizeof(scale), size - sizeof(scale));
+    return length ? length + sizeof(scale) : 0;
+}
+
+/*
+ * @brief Decode a channel
+ *
+ * @param data The encoded data
+ * @param size The size of the encoded data
+ * @param[out] values The values
+ * @param num The number of the values
+ *
+ * @return The number of the bytes decoded, 0 if the data is malformed or the number is above OSCILLOG_CODEC_SAMPLES_MAX
+ */
+uint32_t oscillog_codec_decode_channel(const uint8_t* data, uint32_t size, float* values, uint16_t num)
+{
+    int16_t samples[OSCILLOG_CODEC_SAMPLES_MAX];
+    float scale;
+    if (size < sizeof(scale) || num > OSCILLOG_CODEC_SAMPLES_MAX) return 0;
+
+    memcpy(&scale, data, sizeof(scale));
+    uint32_t length = oscillog_codec_decode(data + sizeof(scale), size - sizeof(scale), samples, num);
+    if (!length) return 0;
+    for (uint16_t i = 0; i < num; i++) values[i] = samples[i] * scale;
+    return length + sizeof(scale);
+}
+/** @} */
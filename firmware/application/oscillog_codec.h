@@ -0,0 +1,95 @@
+/**
+ * @file oscillog_codec.h
+ * @author Stanislav Karpikov
+ * @brief Oscillogram codec: 16-bit fixed point samples, the second order prediction, zig-zag varint residuals (header)
+ */
+
+#ifndef _OSCILLOG_CODEC_H
+#define _OSCILLOG_CODEC_H
+
+/** @addtogroup app_oscillog_codec
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/bsp.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define OSCILLOG_CODEC_RESIDUAL_MAX (3U)   /**< The maximum size of a residual: 19 bits with the sign, 7 bits per byte */
+#define OSCILLOG_CODEC_SAMPLES_MAX  (256U) /**< The maximum number of the samples of a channel (the values are converted on the stack) */
+
+/** The maximum size of an encoded channel: the scale and the residuals */
+#define OSCILLOG_CODEC_CHANNEL_MAX(num) (sizeof(float) + (num) * OSCILLOG_CODEC_RESIDUAL_MAX)
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Convert the values to the 16-bit fixed point: the full scale is the maximum absolute value
+ *
+ * @param values The values
+ * @param num The number of the values
+ * @param[out] samples The samples (value = sample * scale)
+ *
+ * @return The scale
+ */
+float oscillog_codec_quantize(const float* values, uint16_t num, int16_t* samples);
+
+/**
+ * @brief Encode the samples: the residuals of the second order prediction as the zig-zag varints (lossless)
+ *
+ * @param samples The samples
+ * @param num The number of the samples
+ * @param[out] data The encoded data
+ * @param size The size of the buffer
+ *
+ * @return The size of the encoded data, 0 if the buffer is too small
+ */
+uint32_t oscillog_codec_encode(const int16_t* samples, uint16_t num, uint8_t* data, uint32_t size);
+
+/**
+ * @brief Decode the samples
+ *
+ * @param data The encoded data
+ * @param size The size of the encoded data
+ * @param[out] samples The samples
+ * @param num The number of the samples
+ *
+ * @return The number of the bytes decoded, 0 if the data is malformed
+ */
+uint32_t oscillog_codec_decode(const uint8_t* data, uint32_t size, int16_t* samples, uint16_t num);
+
+/**
+ * @brief Encode a channel: the scale (float), then the encoded samples
+ *
+ * @param values The values
+ * @param num The number of the values
+ * @param[out] data The encoded data
+ * @param size The size of the buffer (OSCILLOG_CODEC_CHANNEL_MAX is always enough)
+ *
+ * @return The size of the encoded data, 0 if the buffer is too small or the number is above OSCILLOG_CODEC_SAMPLES_MAX
+ */
+uint32_t oscillog_codec_encode_channel(const float* values, uint16_t num, uint8_t* data, uint32_t size);
+
+/**
+ * @brief Decode a channel
+ *
+ * @param data The encoded data
+ * @param size The size of the encoded data
+ * @param[out] values The values
+ * @param num The number of the values
+ *
+ * @return The number of the bytes decoded, 0 if the data is malformed or the number is above OSCILLOG_CODEC_SAMPLES_MAX
+ */
+uint32_t oscillog_codec_decode_channel(const uint8_t* data, uint32_t size, float* values, uint16_t num);
+
+/** @} */
+#endif /* _OSCILLOG_CODEC_H */
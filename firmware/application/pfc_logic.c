@@ -23,381 +23,318 @@
 #include "events.h"
 #include "math.h"
 #include "settings.h"
+#include "string.h"
 
 /*--------------------------------------------------------------
-                       PRIVATE FUNCTIONS PROTOTYPES
+                       PRIVATE TYPES
 --------------------------------------------------------------*/
 
-static void pfc_set_state(pfc_state_t state);
-
-static void pfc_init_process(void);
-static void pfc_stop_process(void);
-static void pfc_sync_process(void);
-static void pfc_precharge_prepare_process(void);
-static void pfc_precharge_process(void);
-static void pfc_main_process(void);
-static void pfc_precharge_disable_process(void);
-static void pfc_work_process(void);
-static void pfc_charge_process(void);
-static void pfc_test_process(void);
-static void pfc_stopping_process(void);
-static void pfc_faultblock_process(void);
+typedef void (*FSM_ACTION_CALLBACK)(pfc_logic_t* pfc); /**< State machine action callback (entry, exit) */
+typedef bool (*FSM_GUARD_CALLBACK)(pfc_logic_t* pfc);  /**< State machine guard condition callback */
+
+/** The description of a state */
+typedef struct
+{
+    FSM_ACTION_CALLBACK entry; /**< The action on the state entry (can be NULL) */
+    FSM_ACTION_CALLBACK exit;  /**< The action on the state exit (can be NULL) */
+    uint32_t timeout;          /**< The maximum time in the state [periods], 0 - no timeout */
+    pfc_state_t timeout_state; /**< The state to go after the timeout */
+} fsm_state_t;
+
+/** A transition of the state machine */
+typedef struct
+{
+    pfc_state_t from;         /**< The source state (PFC_STATE_COUNT - any state) */
+    pfc_state_t to;           /**< The destination state (the same as the source - restart the state timeout) */
+    uint8_t command;          /**< The command to trigger the transition (pfc_commands_t), 0 - checked every period */
+    FSM_GUARD_CALLBACK guard; /**< The guard condition (can be NULL) */
+} fsm_transition_t;
 
 /*--------------------------------------------------------------
-                       PRIVATE DATA
+                       PRIVATE FUNCTIONS PROTOTYPES
 --------------------------------------------------------------*/
 
-static pfc_state_t last_status = PFC_STATE_INIT; /**< The last state of the PFC */
-static uint32_t period_counter = 0;              /**< The number of periods since start */
-static uint8_t main_started = 0;                 /**< The main connector is switched on */
-static uint8_t preload_started = 0;              /**< The preload connector is switched on */
-static uint32_t main_start_period = 0;           /**< The period count when the main connector was switched on */
+static void pfc_power_off(pfc_logic_t* pfc);
+static void pfc_preload_on(pfc_logic_t* pfc);
+static void pfc_preload_off(pfc_logic_t* pfc);
+static void pfc_main_on(pfc_logic_t* pfc);
+static void pfc_disable_pwm(pfc_logic_t* pfc);
+static void pfc_restore_pwm(pfc_logic_t* pfc);
 
-static uint8_t pwm_on = 0; /**< PWM is switched on */
-
-static pfc_state_t current_state = PFC_STATE_INIT; /**< The current state of the PFC */
+static bool pfc_is_synchronised(pfc_logic_t* pfc);
+static bool pfc_is_voltage_ready(pfc_logic_t* pfc);
 
 /*--------------------------------------------------------------
-                       PRIVATE TYPES
+                       PRIVATE DATA
 --------------------------------------------------------------*/
 
-typedef void (*FSM_PROCESS_CALLBACK)(void); /**< State machine state callback */
-
-/** State table array */
-static FSM_PROCESS_CALLBACK state_table[PFC_STATE_COUNT] = {
-    pfc_init_process,              /**< Initial state */
-    pfc_stop_process,              /**< Stop state (power hardware is switched off) */
-    pfc_sync_process,              /**< Syncronisation with the network */
-    pfc_precharge_prepare_process, /**< Prepare precharge */
-    pfc_precharge_process,         /**< Precharge (connector is in on state) */
-    pfc_main_process,              /**< Main state. Precharge is finished */
-    pfc_precharge_disable_process, /**< Precharge is switching off */
-    pfc_work_process,              /**< Ready state */
-    pfc_charge_process,            /**< Main capacitors charge is ongoing */
-    pfc_test_process,              /**< Test state */
-    pfc_stopping_process,          /**< Stoping work: disable sensitive and power peripheral */
-    pfc_faultblock_process,        /**< Fault state */
+static pfc_logic_t pfc_instance; /**< The PFC logic instance of the firmware */
+
+/** State table array: actions and timeouts */
+static const fsm_state_t state_table[PFC_STATE_COUNT] = {
+    {pfc_power_off, NULL, STARTUP_STABILISATION_TIME, PFC_STATE_STOP},            /**< Initial state */
+    {pfc_power_off, NULL, 0, PFC_STATE_STOP},                                     /**< Stop state (power hardware is switched off) */
+    {NULL, NULL, SYNC_TIMEOUT, PFC_STATE_FAULTBLOCK},                             /**< Syncronisation with the network */
+    {NULL, NULL, 0, PFC_STATE_PRECHARGE_PREPARE},                                 /**< Prepare precharge */
+    {pfc_preload_on, NULL, PRECHARGE_TIMEOUT, PFC_STATE_FAULTBLOCK},              /**< Precharge (connector is in on state) */
+    {pfc_main_on, NULL, PRELOAD_STABILISATION_TIME, PFC_STATE_PRECHARGE_DISABLE}, /**< Main state. Precharge is finished */
+    {pfc_preload_off, NULL, 0, PFC_STATE_PRECHARGE_DISABLE},                      /**< Precharge is switching off */
+    {NULL, NULL, 0, PFC_STATE_WORK},                                              /**< Ready state */
+    {pfc_restore_pwm, pfc_disable_pwm, CHARGE_PULSE_TIME, PFC_STATE_WORK},        /**< Main capacitors charge is ongoing */
+    {NULL, NULL, 0, PFC_STATE_TEST},                                              /**< Test state */
+    {pfc_power_off, NULL, 0, PFC_STATE_STOPPING},                                 /**< Stoping work: disable sensitive and power peripheral */
+    {pfc_power_off, NULL, 0, PFC_STATE_FAULTBLOCK},                               /**< Fault state */
+};
+
+/** Transition table array: checked in the order */
+static const fsm_transition_t transition_table[] = {
+    {PFC_STATE_SYNC, PFC_STATE_PRECHARGE_PREPARE, 0, pfc_is_synchronised},
+    {PFC_STATE_PRECHARGE_PREPARE, PFC_STATE_PRECHARGE, 0, NULL},
+    {PFC_STATE_PRECHARGE, PFC_STATE_MAIN, 0, pfc_is_voltage_ready},
+    {PFC_STATE_PRECHARGE_DISABLE, PFC_STATE_WORK, 0, NULL},
+    {PFC_STATE_STOPPING, PFC_STATE_STOP, 0, NULL},
+
+    {PFC_STATE_STOP, PFC_STATE_SYNC, COMMAND_WORK_ON, NULL},
+    {PFC_STATE_COUNT, PFC_STATE_STOPPING, COMMAND_WORK_OFF, NULL},
+    {PFC_STATE_WORK, PFC_STATE_CHARGE, COMMAND_CHARGE_ON, NULL},
+    {PFC_STATE_CHARGE, PFC_STATE_CHARGE, COMMAND_CHARGE_ON, NULL},
+    {PFC_STATE_CHARGE, PFC_STATE_WORK, COMMAND_CHARGE_OFF, NULL},
 };
 
 /*--------------------------------------------------------------
                        PRIVATE FUNCTIONS
 --------------------------------------------------------------*/
 
-/**
- * @brief Switch on the PFC
- */
-static void pfc_switch_on(void)
-{
-    if (pfc_get_state() == PFC_STATE_STOP)
-    {
-        pfc_set_state(PFC_STATE_SYNC);
-    }
-    else if (pfc_get_state() == PFC_STATE_FAULTBLOCK)
-    {
-        pfc_set_state(PFC_STATE_SYNC);
-    }
-}
-
-/**
- * @brief Switch off the PFC
- */
-static void pfc_switch_off(void)
-{
-    pfc_set_state(PFC_STATE_STOPPING);
-}
-
 /**
  * @brief Disable PWM channels
+ *
+ * @param pfc The PFC logic instance
  */
-static void pfc_disable_pwm(void)
+static void pfc_disable_pwm(pfc_logic_t* pfc)
 {
-    int i;
-    for (i = 0; i < PFC_NCHAN; i++)
-    {
-        //epwm_disable(i);
-    }
-
     timer_disable_pwm();
 
-    pwm_on = 0;
+    pfc->pwm_on = 0;
 }
 
 /**
  * @brief Re-enable PWM channels after switching off
+ *
+ * @param pfc The PFC logic instance
  */
-static void pfc_restore_pwm(void)
+static void pfc_restore_pwm(pfc_logic_t* pfc)
 {
-    //et_1=0;//Last Ucap error value
-    //It_1=0;//Last Ucap integral accumulator value
-
-    if (!pwm_on)
+    if (!pfc->pwm_on)
     {
         adc_clear_accumulators();
-        timer_restore_pwm();
 
-        pwm_on = 1;
+        /* A trip from the interrupt can come after the check of the fault request: the outputs are enabled only in the
+         * section and not at all if a fault is requested, so the trip is never overwritten */
+        ENTER_CRITICAL();
+        if (!pfc->fault_request)
+        {
+            timer_restore_pwm();
+            pfc->pwm_on = 1;
+        }
+        EXIT_CRITICAL();
     }
 }
 
 /**
- * @brief Returns the readiness of the voltage on capacitors
+ * @brief State action: switch off the power hardware (relays, ventilators, PWM)
  *
- * @return true if the voltage is ready, false if not ready
- */
-static bool is_voltage_ready(void)
-{
-    settings_capacitors_t capacitors = settings_get_capacitors();
-    if (adc_get_cap_voltage() > capacitors.Ucap_precharge)
-    {
-        return true;
-    }
-    else
-    {
-        return false;
-    }
-}
-
-/**
- * @brief Process the state callback: init
+ * @param pfc The PFC logic instance
  */
-static void pfc_init_process(void)
+static void pfc_power_off(pfc_logic_t* pfc)
 {
     gpio_main_relay_switch_off();
     gpio_preload_relay_switch_off();
     gpio_ventilators_switch_off();
 
-    main_started = 0;
-    preload_started = 0;
-
-    pfc_disable_pwm();
-
-    /* Wait for transition processes to end */
-    if (period_counter > STARTUP_STABILISATION_TIME)
-    {
-        pfc_set_state(PFC_STATE_STOP);
-    }
+    pfc_disable_pwm(pfc);
 }
 
 /**
- * @brief Process the state callback: stop
+ * @brief State action: switch on the preload relay
+ *
+ * @param pfc The PFC logic instance
  */
-static void pfc_stop_process(void)
+static void pfc_preload_on(pfc_logic_t* pfc)
 {
-    gpio_main_relay_switch_off();
-    gpio_preload_relay_switch_off();
-    gpio_ventilators_switch_off();
-
-    main_started = 0;
-    preload_started = 0;
-
-    pfc_disable_pwm();
-
-    /* TODO: Run PFC autotically. Currently the device wait for a command from the panel */
+    (void)pfc;
+    gpio_preload_relay_switch_on();
 }
 
 /**
- * @brief Process the state callback: synd
+ * @brief State action: switch off the preload relay
+ *
+ * @param pfc The PFC logic instance
  */
-static void pfc_sync_process(void)
+static void pfc_preload_off(pfc_logic_t* pfc)
 {
-    pfc_disable_pwm();
-    complex_amp_t U_50Hz[PFC_NCHAN] = {0};
-    float period_delta = 0;
-    adc_get_complex_phase(U_50Hz, &period_delta);
-    /* Wait for a phase stabilisation */
-    /* TODO: Check for float comparison */
-    if (period_delta == 0 && fabs(U_50Hz[PFC_ACHAN].phase) < SYNC_MINIMUM_PHASE)
-    {
-        pfc_set_state(PFC_STATE_PRECHARGE_PREPARE);
-    }
+    (void)pfc;
+    gpio_preload_relay_switch_off();
 }
 
 /**
- * @brief Process the state callback: precharge prepare
+ * @brief State action: switch on the main relay and ventilators
+ *
+ * @param pfc The PFC logic instance
  */
-static void pfc_precharge_prepare_process(void)
+static void pfc_main_on(pfc_logic_t* pfc)
 {
-    pfc_disable_pwm();
-    preload_started = 0;
-    pfc_set_state(PFC_STATE_PRECHARGE);
+    (void)pfc;
+    gpio_main_relay_switch_on();
+    gpio_ventilators_switch_on();
 }
 
 /**
- * @brief Process the state callback: precharge process
+ * @brief Guard condition: the phase is synchronised with the network
+ *
+ * @param pfc The PFC logic instance
+ *
+ * @return true if synchronised
  */
-static void pfc_precharge_process(void)
+static bool pfc_is_synchronised(pfc_logic_t* pfc)
 {
-    pfc_disable_pwm();
-    if (is_voltage_ready())
-    {
-        pfc_set_state(PFC_STATE_MAIN);
-        return;
-    }
-    if (!preload_started)
-    {
-        gpio_preload_relay_switch_on();
-        //events_preload_start();
-        preload_started = 1;
-    }
+    (void)pfc;
+    complex_amp_t U_50Hz[PFC_NCHAN] = {0};
+    float period_delta = 0;
+    adc_get_complex_phase(U_50Hz, &period_delta);
+    return (fabs(period_delta) < SYNC_MAXIMUM_PERIOD_DELTA && fabs(U_50Hz[PFC_ACHAN].phase) < SYNC_MINIMUM_PHASE);
 }
 
 /**
- * @brief Process the state callback: main
+ * @brief Guard condition: the voltage on capacitors is ready
+ *
+ * @param pfc The PFC logic instance
+ *
+ * @return true if the voltage is ready, false if not ready
  */
-static void pfc_main_process(void)
+static bool pfc_is_voltage_ready(pfc_logic_t* pfc)
 {
-    pfc_disable_pwm();
-    if (!main_started)
-    {
-        gpio_main_relay_switch_on();
-        gpio_ventilators_switch_on();
-        main_started = 1;
-        main_start_period = period_counter;
-    }
-    uint32_t period_delta = period_counter - main_start_period;
-
-    /* Wait for transition processes to end */
-    if (period_delta > PRELOAD_STABILISATION_TIME)
-    {
-        pfc_set_state(PFC_STATE_PRECHARGE_DISABLE);
-    }
+    (void)pfc;
+    settings_capacitors_t capacitors = settings_get_capacitors();
+    return (adc_get_cap_voltage() > capacitors.Ucap_precharge);
 }
 
 /**
- * @brief Process the state callback: precharge disable
+ * @brief Change the state of the PFC: run the exit and entry actions, write the trace and the event
+ *
+ * @param pfc The PFC logic instance
+ * @param state A new state of the PFC
+ * @param cause The cause of the transition
  */
-static void pfc_precharge_disable_process(void)
+static void pfc_set_state(pfc_logic_t* pfc, pfc_state_t state, pfc_transition_cause_t cause)
 {
-    gpio_preload_relay_switch_off();
-    preload_started = 0;
-    pfc_set_state(PFC_STATE_WORK);
-}
+    pfc_state_t from = pfc->current_state;
 
-/**
- * @brief Process the state callback: work
- */
-static void pfc_work_process(void)
-{
-    pfc_disable_pwm();
-}
+    if (state_table[from].exit) state_table[from].exit(pfc);
 
-/**
- * @brief Process the state callback: charge
- */
-static void pfc_charge_process(void)
-{
-    static uint8_t pulse = 0;
-    pfc_restore_pwm();
+    struct pfc_transition_record_s* record = &pfc->trace[pfc->trace_in & (PFC_TRACE_RECORDS_NUM - 1)];
+    record->period = pfc->period_counter;
+    record->duration = pfc->period_counter - pfc->state_entry_period;
+    record->from = from;
+    record->to = state;
+    record->cause = cause;
+    record->reserved = 0;
+    pfc->trace_in++;
 
-    pulse++;
-    if (pulse >= 4)
-    {
-        pulse = 0;
-        pfc_set_state(PFC_STATE_WORK);
-    }
+    pfc->current_state = state;
+    pfc->state_entry_period = pfc->period_counter;
+    pfc->timeout_counter = 0;
 
-    /*
-	TODO: Check the charge
-	if (adc_get_cap_voltage() < (PFC.settings.capacitors.Ucap_precharge*0.8)){//TODO:
-		events_new_event(
-				EVENT_TYPE_PROTECTION,
-				SUB_EVENT_TYPE_PROTECTION_UCAP_MIN,
-				0,
-				adc_get_cap_voltage()
-			);
-	}
-	*/
-}
+    if (state_table[state].entry) state_table[state].entry(pfc);
 
-/**
- * @brief Process the state callback: test
- */
-static void pfc_test_process(void)
-{
-    /* NOTE: Test state can be added */
+    events_new_event(EVENT_TYPE_CHANGESTATE, state, from, cause);
 }
 
 /**
- * @brief Process the state callback: stopping
+ * @brief Find a transition for the current state and run it
+ *
+ * @param pfc The PFC logic instance
+ * @param command The command (0 - the transitions checked every period)
+ *
+ * @return true if a transition has been found
  */
-static void pfc_stopping_process(void)
+static bool pfc_run_transition(pfc_logic_t* pfc, uint8_t command)
 {
-    gpio_main_relay_switch_off();
-    gpio_preload_relay_switch_off();
-    gpio_ventilators_switch_off();
-    //events_preload_stop();
-    pfc_set_state(PFC_STATE_STOP);
+    for (uint32_t i = 0; i < sizeof(transition_table) / sizeof(transition_table[0]); i++)
+    {
+        const fsm_transition_t* transition = &transition_table[i];
+        if (transition->command != command) continue;
+        if (transition->from != PFC_STATE_COUNT && transition->from != pfc->current_state) continue;
+        if (transition->guard && !transition->guard(pfc)) continue;
+
+        if (transition->to == pfc->current_state)
+        {
+            /* An internal transition: restart the state timeout */
+            pfc->timeout_counter = 0;
+        }
+        else
+        {
+            pfc_set_state(pfc, transition->to, command ? PFC_TRANSITION_COMMAND : PFC_TRANSITION_GUARD);
+        }
+        return true;
+    }
+    return false;
 }
 
-/**
- * @brief Process the state callback: faultblock
- */
-static void pfc_faultblock_process(void)
-{
-    gpio_main_relay_switch_off();
-    gpio_preload_relay_switch_off();
-    gpio_ventilators_switch_off();
-    pfc_disable_pwm();
-}
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
 
-/**
- * @brief Set state of the PFC
+/*
+ * @brief Init the PFC logic instance (the initial state)
  *
- * @param state A new state of the PFC
+ * @param pfc The PFC logic instance
  */
-static void pfc_set_state(pfc_state_t state)
+void pfc_logic_init(pfc_logic_t* pfc)
 {
-    current_state = state;
+    if (!pfc) return;
+    memset(pfc, 0, sizeof(pfc_logic_t));
+    pfc->current_state = PFC_STATE_INIT;
+    pfc_power_off(pfc);
 }
 
-/*--------------------------------------------------------------
-                       PUBLIC FUNCTIONS
---------------------------------------------------------------*/
-
 /*
- * @brief Block the PFC in case of a fault event
+ * @brief Switch off PWM and request the fault state in case of a fault event
+ * @note Can be called from interrupts: the transition is done in the next pfc_logic_process call
+ *
+ * @param pfc The PFC logic instance
  */
-void pfc_faultblock(void)
+ITCM_CODE void pfc_logic_faultblock(pfc_logic_t* pfc)
 {
-    pfc_set_state(PFC_STATE_FAULTBLOCK);
+    /* The fast path: the outputs are switched off here, the relays and the state are processed by pfc_logic_process */
+    timer_trip_pwm();
+    pfc->pwm_on = 0;
+    pfc->fault_request = 1;
 }
 
 /*
  * @brief Execute a command from the panel
  *
+ * @param pfc The PFC logic instance
  * @param command The command to execute
  * @param data Command data
- * 
+ *
  * @return Status of the operation
  */
-status_t pfc_apply_command(pfc_commands_t command, uint32_t data)
+status_t pfc_logic_apply_command(pfc_logic_t* pfc, pfc_commands_t command, uint32_t data)
 {
+    ARGUMENT_ASSERT(pfc);
     settings_pwm_t pwm_settings = settings_get_pwm();
     switch (command)
     {
         case COMMAND_WORK_ON:
-            if (pfc_get_state() == PFC_STATE_STOP)
-            {
-                pfc_switch_on();
-            }
-            break;
         case COMMAND_WORK_OFF:
-            pfc_switch_off();
-            break;
         case COMMAND_CHARGE_ON:
-            if (pfc_get_state() == PFC_STATE_WORK)
-            {
-                pfc_set_state(PFC_STATE_CHARGE);
-            }
-            break;
         case COMMAND_CHARGE_OFF:
-            if (pfc_get_state() == PFC_STATE_CHARGE)
-            {
-                pfc_set_state(PFC_STATE_WORK);
-            }
+            /* The command is ignored if there is no transition from the current state */
+            pfc_run_transition(pfc, command);
             break;
         case COMMAND_SETTINGS_SAVE:
-            if (pfc_get_state() == PFC_STATE_STOP)
+            if (pfc->current_state == PFC_STATE_STOP)
             {
                 settings_save();
             }
@@ -422,21 +359,127 @@ status_t pfc_apply_command(pfc_commands_t command, uint32_t data)
 
 /*
  * @brief Process the current PFC state (called in a cycle)
+ *
+ * @param pfc The PFC logic instance
  */
-void pfc_process(void)
+void pfc_logic_process(pfc_logic_t* pfc)
+{
+    pfc->period_counter++;
+    pfc->timeout_counter++;
+
+    if (pfc->fault_request)
+    {
+        pfc->fault_request = 0;
+        if (pfc->current_state != PFC_STATE_FAULTBLOCK)
+        {
+            pfc_set_state(pfc, PFC_STATE_FAULTBLOCK, PFC_TRANSITION_FAULT);
+        }
+        return;
+    }
+
+    if (pfc_run_transition(pfc, 0)) return;
+
+    const fsm_state_t* state = &state_table[pfc->current_state];
+    if (state->timeout && pfc->timeout_counter >= state->timeout)
+    {
+        pfc_set_state(pfc, state->timeout_state, PFC_TRANSITION_TIMEOUT);
+    }
+}
+
+/*
+ * @brief Get state transitions from the trace
+ *
+ * @param pfc The PFC logic instance
+ * @param after_index The index (the transition number since start) of the first transition to get
+ * @param num The maximum number of transitions to write
+ * @param buf The buffer to write transitions
+ * @param[out] first_index The index of the first written transition (transitions can be overwritten in the trace)
+ *
+ * @return The count of transitions have been written
+ */
+uint16_t pfc_logic_get_trace(const pfc_logic_t* pfc, uint32_t after_index, uint16_t num,
+                             struct pfc_transition_record_s* buf, uint32_t* first_index)
 {
-    FSM_PROCESS_CALLBACK handler = state_table[pfc_get_state()];
-    if (handler)
+    if (!pfc || !buf || !first_index) return 0;
+
+    uint32_t index = after_index;
+    if (pfc->trace_in - index > PFC_TRACE_RECORDS_NUM || index > pfc->trace_in)
     {
-        handler();
+        /* The requested transitions have been overwritten (or the index is from the previous start) */
+        index = (pfc->trace_in > PFC_TRACE_RECORDS_NUM) ? pfc->trace_in - PFC_TRACE_RECORDS_NUM : 0;
     }
+    *first_index = index;
 
-    if (pfc_get_state() != last_status)
+    uint16_t count = 0;
+    while (index != pfc->trace_in && count < num)
     {
-        events_new_event(EVENT_TYPE_CHANGESTATE, pfc_get_state(), 0, 0);
+        buf[count++] = pfc->trace[index & (PFC_TRACE_RECORDS_NUM - 1)];
+        index++;
     }
-    last_status = pfc_get_state();
-    period_counter++;
+    return count;
+}
+
+/*
+ * @brief Get the firmware PFC logic instance
+ *
+ * @return The instance
+ */
+pfc_logic_t* pfc_get_instance(void)
+{
+    return &pfc_instance;
+}
+
+/*
+ * @brief Init the firmware PFC logic: the initial state, the power hardware is switched off
+ */
+void pfc_init(void)
+{
+    pfc_logic_init(&pfc_instance);
+}
+
+/*
+ * @brief Block the PFC in case of a fault event: PWM is switched off at once
+ * @note Can be called from interrupts: the transition is done in the next pfc_process call
+ */
+ITCM_CODE void pfc_faultblock(void)
+{
+    pfc_logic_faultblock(&pfc_instance);
+}
+
+/*
+ * @brief Execute a command from the panel
+ *
+ * @param command The command to execute
+ * @param data Command data
+ * 
+ * @return Status of the operation
+ */
+status_t pfc_apply_command(pfc_commands_t command, uint32_t data)
+{
+    return pfc_logic_apply_command(&pfc_instance, command, data);
+}
+
+/*
+ * @brief Process the current PFC state (called in a cycle)
+ */
+void pfc_process(void)
+{
+    pfc_logic_process(&pfc_instance);
+}
+
+/*
+ * @brief Get state transitions from the trace
+ *
+ * @param after_index The index (the transition number since start) of the first transition to get
+ * @param num The maximum number of transitions to write
+ * @param buf The buffer to write transitions
+ * @param[out] first_index The index of the first written transition
+ *
+ * @return The count of transitions have been written
+ */
+uint16_t pfc_get_trace(uint32_t after_index, uint16_t num, struct pfc_transition_record_s* buf, uint32_t* first_index)
+{
+    return pfc_logic_get_trace(&pfc_instance, after_index, num, buf, first_index);
 }
 
 /*
@@ -444,9 +487,9 @@ void pfc_process(void)
  *
  * @return The PFC state
  */
-pfc_state_t pfc_get_state(void)
+ITCM_CODE pfc_state_t pfc_get_state(void)
 {
-    return current_state;
+    return pfc_instance.current_state;
 }
 
 /*
@@ -454,8 +497,29 @@ pfc_state_t pfc_get_state(void)
  *
  * @return The PWM state
  */
-uint8_t pfc_is_pwm_on(void)
+ITCM_CODE uint8_t pfc_is_pwm_on(void)
+{
+    return pfc_instance.pwm_on;
+}
+
+/*
+ * @brief Check if the power hardware is switched off: the relays are open and the PWM is off (the stop, the fault and
+ * the initial states)
+ * @note The flash memory erases stall the interrupts for the whole erase, they are made only in these states
+ *
+ * @return 1 if the power hardware is switched off
+ */
+uint8_t pfc_is_power_off(void)
 {
-    return pwm_on;
+    switch (pfc_instance.current_state)
+    {
+        case PFC_STATE_INIT:
+        case PFC_STATE_STOP:
+        case PFC_STATE_STOPPING:
+        case PFC_STATE_FAULTBLOCK:
+            return !pfc_instance.pwm_on;
+        default:
+            return 0;
+    }
 }
 /** @} */
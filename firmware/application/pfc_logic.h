@@ -20,6 +20,12 @@
 #include "defines.h"
 #include "settings.h"
 
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define PFC_TRACE_RECORDS_NUM (16U) /**< The number of the state transitions in the trace (a power of 2) */
+
 /*--------------------------------------------------------------
                        PUBLIC TYPES
 --------------------------------------------------------------*/
@@ -55,10 +61,108 @@ typedef enum
     COMMAND_SETTINGS_SAVE  /**< Save settings */
 } pfc_commands_t;
 
+/** The cause of a state transition */
+typedef enum
+{
+    PFC_TRANSITION_GUARD,   /**< The guard condition of the state is met */
+    PFC_TRANSITION_COMMAND, /**< A command from the panel */
+    PFC_TRANSITION_TIMEOUT, /**< The state timeout has expired */
+    PFC_TRANSITION_FAULT,   /**< A protection event */
+} pfc_transition_cause_t;
+
+/** The structure to store a state transition */
+struct __attribute__((__packed__)) pfc_transition_record_s
+{
+    uint32_t period;   /**< The period counter at the transition */
+    uint32_t duration; /**< The number of periods spent in the previous state */
+    uint8_t from;      /**< The previous state */
+    uint8_t to;        /**< The new state */
+    uint8_t cause;     /**< The cause of the transition (pfc_transition_cause_t) */
+    uint8_t reserved;  /**< Reserved (alignment) */
+};
+
+/**
+ * @brief The PFC logic instance
+ *
+ * @note The fields read by the ADC interrupt (state, PWM) are placed first
+ */
+typedef struct
+{
+    pfc_state_t current_state;      /**< The current state of the PFC */
+    volatile uint8_t pwm_on;        /**< PWM is switched on (cleared from interrupts by a trip) */
+    volatile uint8_t fault_request; /**< A protection event has requested the fault state (set from interrupts) */
+
+    uint32_t period_counter;     /**< The number of periods since start */
+    uint32_t state_entry_period; /**< The period counter at the entry to the current state */
+    uint32_t timeout_counter;    /**< The number of periods since the entry or the last restart of the state timeout */
+
+    uint32_t trace_in;                                           /**< The number of transitions have been written to the trace */
+    struct pfc_transition_record_s trace[PFC_TRACE_RECORDS_NUM]; /**< The trace of the last state transitions */
+} pfc_logic_t;
+
 /*--------------------------------------------------------------
                        PUBLIC FUNCTIONS
 --------------------------------------------------------------*/
 
+/**
+ * @brief Init the PFC logic instance (the initial state)
+ *
+ * @param pfc The PFC logic instance
+ */
+void pfc_logic_init(pfc_logic_t* pfc);
+
+/**
+ * @brief Execute a command from the panel
+ *
+ * @param pfc The PFC logic instance
+ * @param command The command to execute
+ * @param data Command data
+ *
+ * @return Status of the operation
+ */
+status_t pfc_logic_apply_command(pfc_logic_t* pfc, pfc_commands_t command, uint32_t data);
+
+/**
+ * @brief Process the current PFC state (called in a cycle)
+ *
+ * @param pfc The PFC logic instance
+ */
+void pfc_logic_process(pfc_logic_t* pfc);
+
+/**
+ * @brief Switch off PWM and request the fault state in case of a fault event
+ * @note Can be called from interrupts: the transition is done in the next pfc_logic_process call
+ *
+ * @param pfc The PFC logic instance
+ */
+void pfc_logic_faultblock(pfc_logic_t* pfc);
+
+/**
+ * @brief Get state transitions from the trace
+ *
+ * @param pfc The PFC logic instance
+ * @param after_index The index (the transition number since start) of the first transition to get
+ * @param num The maximum number of transitions to write
+ * @param buf The buffer to write transitions
+ * @param[out] first_index The index of the first written transition (transitions can be overwritten in the trace)
+ *
+ * @return The count of transitions have been written
+ */
+uint16_t pfc_logic_get_trace(const pfc_logic_t* pfc, uint32_t after_index, uint16_t num,
+                             struct pfc_transition_record_s* buf, uint32_t* first_index);
+
+/**
+ * @brief Get the firmware PFC logic instance
+ *
+ * @return The instance
+ */
+pfc_logic_t* pfc_get_instance(void);
+
+/**
+ * @brief Init the firmware PFC logic: the initial state, the power hardware is switched off
+ */
+void pfc_init(void);
+
 /**
  * @brief Execute a command from the panel
  *
@@ -82,10 +186,23 @@ void pfc_process(void);
 pfc_state_t pfc_get_state(void);
 
 /**
- * @brief Block the PFC in case of a fault event
+ * @brief Block the PFC in case of a fault event: PWM is switched off at once
+ * @note Can be called from interrupts: the transition is done in the next pfc_process call
  */
 void pfc_faultblock(void);
 
+/**
+ * @brief Get state transitions from the trace
+ *
+ * @param after_index The index (the transition number since start) of the first transition to get
+ * @param num The maximum number of transitions to write
+ * @param buf The buffer to write transitions
+ * @param[out] first_index The index of the first written transition
+ *
+ * @return The count of transitions have been written
+ */
+uint16_t pfc_get_trace(uint32_t after_index, uint16_t num, struct pfc_transition_record_s* buf, uint32_t* first_index);
+
 /**
  * @brief Get the current PWM state
  *
@@ -93,5 +210,14 @@ void pfc_faultblock(void);
  */
 uint8_t pfc_is_pwm_on(void);
 
+/**
+ * @brief Check if the power hardware is switched off: the relays are open and the PWM is off (the stop, the fault and
+ * the initial states)
+ * @note The flash memory erases stall the interrupts for the whole erase, they are made only in these states
+ *
+ * @return 1 if the power hardware is switched off
+ */
+uint8_t pfc_is_power_off(void);
+
 /** @} */
 #endif /* _PFC_LOGIC_H */
@@ -0,0 +1,124 @@
+/**
+ * @file rate_limiter.c
+ * @author Stanislav Karpikov
+ * @brief Rate limiter: token buckets for the repeated events
+ */
+
+/** @addtogroup app_rate_limiter
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "rate_limiter.h"
+
+#include "defines.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define RATE_LIMITER_TIME_MAX (0x7FFFFFFFU) /**< The maximum refill time of a bucket (an older time is in the past) [ms] */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Get the time to refill a bucket
+ *
+ * @param limiter The rate limiter instance
+ * @param bucket The bucket
+ * @param now The current time [ms]
+ *
+ * @return The time left to the full bucket [ms] (0 if the bucket is full)
+ */
+static ITCM_CODE uint32_t rate_limiter_refill_time(const rate_limiter_t* limiter, const rate_limiter_bucket_t* bucket, uint32_t now)
+{
+    uint32_t rest = bucket->full_time - now;
+    /* The full time in the past is seen as a big number (a bucket not used for 49 days can be seen as not full once) */
+    return (rest > limiter->burst_time) ? 0 : rest;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Init the rate limiter: all the buckets are full
+ *
+ * @param limiter The rate limiter instance
+ * @param buckets The buckets of the sources
+ * @param num The number of the sources
+ * @param burst The burst size: the number of the events passed at once
+ * @param period The refill period: the time to get a token [ms]
+ *
+ * @return The status of the operation
+ */
+status_t rate_limiter_init(rate_limiter_t* limiter, rate_limiter_bucket_t* buckets, uint16_t num, uint16_t burst, uint32_t period)
+{
+    ARGUMENT_ASSERT(limiter);
+    ARGUMENT_ASSERT(buckets);
+    if (burst == 0 || period == 0 || period > RATE_LIMITER_TIME_MAX / burst) return PFC_ERROR_DATA;
+
+    memset(buckets, 0, num * sizeof(rate_limiter_bucket_t));
+    limiter->period = period;
+    limiter->burst_time = burst * period;
+    limiter->num = num;
+    limiter->buckets = buckets;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Check an event of a source: take a token from the bucket
+ * @note Can be called from interrupts (the events of a source should be added from a single context)
+ *
+ * @param limiter The rate limiter instance
+ * @param source The source of the event
+ * @param now The current time [ms], 32 bits
+ *
+ * @return PFC_SUCCESS if the event is passed, PFC_NULL if it is suppressed, PFC_ERROR_DATA if the source is wrong
+ */
+ITCM_CODE status_t rate_limiter_check(rate_limiter_t* limiter, uint16_t source, uint32_t now)
+{
+    ARGUMENT_ASSERT(limiter);
+    if (source >= limiter->num) return PFC_ERROR_DATA;
+
+    rate_limiter_bucket_t* bucket = &limiter->buckets[source];
+    uint32_t rest = rate_limiter_refill_time(limiter, bucket, now);
+    if (rest + limiter->period > limiter->burst_time)
+    {
+        /* No tokens left */
+        bucket->suppressed++;
+        return PFC_NULL;
+    }
+    bucket->full_time = now + rest + limiter->period;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Take the number of the suppressed events of a source when the burst has ended (the bucket is full again)
+ * @note Should be called from a single context (the main loop)
+ *
+ * @param limiter The rate limiter instance
+ * @param source The source of the events
+ * @param now The current time [ms], 32 bits
+ *
+ * @return The number of the suppressed events not reported yet (0 if the burst is not over)
+ */
+uint32_t rate_limiter_take_suppressed(rate_limiter_t* limiter, uint16_t source, uint32_t now)
+{
+    if (!limiter || source >= limiter->num) return 0;
+
+    rate_limiter_bucket_t* bucket = &limiter->buckets[source];
+    uint32_t suppressed = bucket->suppressed;
+    if (suppressed == bucket->reported || rate_limiter_refill_time(limiter, bucket, now) != 0) return 0;
+
+    uint32_t count = suppressed - bucket->reported;
+    bucket->reported = suppressed;
+    return count;
+}
+/** @} */
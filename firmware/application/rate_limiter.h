@@ -0,0 +1,91 @@
+/**
+ * @file rate_limiter.h
+ * @author Stanislav Karpikov
+ * @brief Rate limiter: token buckets for the repeated events (header)
+ */
+
+#ifndef _RATE_LIMITER_H
+#define _RATE_LIMITER_H
+
+/** @addtogroup app_rate_limiter
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/bsp.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/**
+ * @brief The token bucket of a source
+ *
+ * @note The bucket is kept as the time when it is full again (the virtual scheduling form of the token bucket):
+ * a passed event moves the time by the refill period, so no division and no 64-bit time is needed.
+ * The bucket is written by the context which adds the events of the source, the suppressed events
+ * are reported by the main loop (the counters are written by different contexts)
+ */
+typedef struct
+{
+    volatile uint32_t full_time;  /**< The time when the bucket is full again [ms] */
+    volatile uint32_t suppressed; /**< The number of the suppressed events */
+    uint32_t reported;            /**< The number of the suppressed events reported */
+} rate_limiter_bucket_t;
+
+/** The rate limiter instance */
+typedef struct
+{
+    uint32_t period;                /**< The refill period: the time to get a token [ms] */
+    uint32_t burst_time;            /**< The time to refill the whole bucket (the burst size * the period) [ms] */
+    uint16_t num;                   /**< The number of the sources */
+    rate_limiter_bucket_t* buckets; /**< The buckets of the sources */
+} rate_limiter_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Init the rate limiter: all the buckets are full
+ *
+ * @param limiter The rate limiter instance
+ * @param buckets The buckets of the sources
+ * @param num The number of the sources
+ * @param burst The burst size: the number of the events passed at once
+ * @param period The refill period: the time to get a token [ms]
+ *
+ * @return The status of the operation
+ */
+status_t rate_limiter_init(rate_limiter_t* limiter, rate_limiter_bucket_t* buckets, uint16_t num, uint16_t burst, uint32_t period);
+
+/**
+ * @brief Check an event of a source: take a token from the bucket
+ * @note Can be called from interrupts (the events of a source should be added from a single context)
+ *
+ * @param limiter The rate limiter instance
+ * @param source The source of the event
+ * @param now The current time [ms], 32 bits
+ *
+ * @return PFC_SUCCESS if the event is passed, PFC_NULL if it is suppressed, PFC_ERROR_DATA if the source is wrong
+ */
+status_t rate_limiter_check(rate_limiter_t* limiter, uint16_t source, uint32_t now);
+
+/**
+ * @brief Take the number of the suppressed events of a source when the burst has ended (the bucket is full again)
+ * @note Should be called from a single context (the main loop)
+ *
+ * @param limiter The rate limiter instance
+ * @param source The source of the events
+ * @param now The current time [ms], 32 bits
+ *
+ * @return The number of the suppressed events not reported yet (0 if the burst is not over)
+ */
+uint32_t rate_limiter_take_suppressed(rate_limiter_t* limiter, uint16_t source, uint32_t now);
+
+/** @} */
+#endif /* _RATE_LIMITER_H */
@@ -0,0 +1,243 @@
+/**
+ * @file scheduler.c
+ * @author Stanislav Karpikov
+ * @brief Cooperative scheduler: the run-to-completion tasks with the priorities, the periods and the deadlines
+ */
+
+/** @addtogroup app_scheduler
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "scheduler.h"
+
+#include "defines.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Check if a task is released
+ *
+ * @param task The task
+ * @param now The current time [cycles]
+ *
+ * @return 1 if the task is released
+ */
+static uint8_t scheduler_is_released(const scheduler_task_t* task, uint32_t now)
+{
+    switch (task->config->type)
+    {
+        case SCHEDULER_TASK_PERIODIC:
+            return (int32_t)(now - task->next_release) >= 0;
+        case SCHEDULER_TASK_EVENT:
+            return task->releases != task->taken;
+        default:
+            return 1;
+    }
+}
+
+/**
+ * @brief Take the release of a task before the run
+ *
+ * @param scheduler The scheduler instance
+ * @param task The task
+ * @param now The current time [cycles]
+ *
+ * @return The time of the release [cycles]
+ */
+static uint32_t scheduler_take_release(const scheduler_t* scheduler, scheduler_task_t* task, uint32_t now)
+{
+    uint32_t release = now;
+    if (task->config->type == SCHEDULER_TASK_PERIODIC)
+    {
+        uint32_t period = task->config->period * scheduler->cycles_us;
+        release = task->next_release;
+        task->next_release += period;
+        /* The periods passed while the task has been waiting are lost, the releases keep the phase */
+        while ((int32_t)(now - task->next_release) >= 0)
+        {
+            task->next_release += period;
+            task->stats.missed++;
+        }
+    }
+    else if (task->config->type == SCHEDULER_TASK_EVENT)
+    {
+        /* The time is written before the number: it is of this release or of a later one */
+        uint32_t releases = task->releases;
+        __dmb(0xF);
+        release = task->release_time;
+        task->stats.missed += releases - task->taken - 1;
+        task->taken = releases;
+    }
+    return release;
+}
+
+/**
+ * @brief Run a task and update its statistics
+ *
+ * @param scheduler The scheduler instance
+ * @param task The task
+ * @param now The current time [cycles]
+ */
+static void scheduler_dispatch(const scheduler_t* scheduler, scheduler_task_t* task, uint32_t now)
+{
+    uint32_t release = scheduler_take_release(scheduler, task, now);
+
+    uint32_t start = scheduler->clock();
+    task->config->run();
+    uint32_t end = scheduler->clock();
+
+    struct scheduler_stats_s* stats = &task->stats;
+    uint32_t jitter = (start - release) / scheduler->cycles_us;
+    stats->exec_last = (end - start) / scheduler->cycles_us;
+    if (stats->exec_last > stats->exec_max) stats->exec_max = stats->exec_last;
+    if (jitter > stats->jitter_max) stats->jitter_max = jitter;
+    if (task->config->deadline && (end - release) / scheduler->cycles_us > task->config->deadline) stats->overruns++;
+    stats->runs++;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Init the scheduler without the tasks
+ *
+ * @param scheduler The scheduler instance
+ * @param clock The clock (the firmware uses the core cycle counter, the host port - the model time)
+ * @param frequency The frequency of the clock [Hz], from 1 MHz
+ *
+ * @return The status of the operation
+ */
+status_t scheduler_init(scheduler_t* scheduler, scheduler_clock_t clock, uint32_t frequency)
+{
+    ARGUMENT_ASSERT(scheduler);
+    ARGUMENT_ASSERT(clock);
+    if (frequency < 1000000U) return PFC_ERROR_DATA;
+
+    memset(scheduler, 0, sizeof(scheduler_t));
+    scheduler->clock = clock;
+    scheduler->cycles_us = frequency / 1000000U;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Add a task (the index of the task is the number of the tasks added before)
+ *
+ * @param scheduler The scheduler instance
+ * @param config The configuration of the task (kept by the scheduler)
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if there are too many tasks or the configuration is wrong
+ */
+status_t scheduler_add(scheduler_t* scheduler, const scheduler_task_config_t* config)
+{
+    ARGUMENT_ASSERT(scheduler);
+    ARGUMENT_ASSERT(config);
+    if (scheduler->num >= SCHEDULER_TASKS_MAX || !config->run) return PFC_ERROR_DATA;
+    /* The period in the cycles should be below the half of the clock range (the wraps) */
+    if (config->type == SCHEDULER_TASK_PERIODIC &&
+        (config->period == 0 || config->period > (UINT32_MAX / 2) / scheduler->cycles_us))
+    {
+        return PFC_ERROR_DATA;
+    }
+
+    scheduler_task_t* task = &scheduler->tasks[scheduler->num];
+    memset(task, 0, sizeof(scheduler_task_t));
+    task->config = config;
+    task->next_release = scheduler->clock() + config->period * scheduler->cycles_us;
+    scheduler->num++;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Release an event task (called from the interrupts)
+ *
+ * @param scheduler The scheduler instance
+ * @param index The index of the task
+ */
+ITCM_CODE void scheduler_release(scheduler_t* scheduler, uint8_t index)
+{
+    if (!scheduler || index >= scheduler->num) return;
+
+    scheduler_task_t* task = &scheduler->tasks[index];
+    task->release_time = scheduler->clock();
+    __dmb(0xF);
+    task->releases++;
+}
+
+/*
+ * @brief Run a pass: the released tasks by the priority (the order of adding for the equal ones), every task once.
+ * The releases are checked again after every task, so a task released meanwhile runs before the lower priority ones
+ *
+ * @param scheduler The scheduler instance
+ *
+ * @return The number of the tasks run
+ */
+uint8_t scheduler_run(scheduler_t* scheduler)
+{
+    if (!scheduler) return 0;
+
+    uint32_t done = 0;
+    uint8_t count = 0;
+    while (1)
+    {
+        uint32_t now = scheduler->clock();
+        scheduler_task_t* next = 0;
+        uint8_t next_index = 0;
+        for (uint8_t i = 0; i < scheduler->num; i++)
+        {
+            scheduler_task_t* task = &scheduler->tasks[i];
+            if ((done & (1U << i)) || !scheduler_is_released(task, now)) continue;
+            if (!next || task->config->priority < next->config->priority)
+            {
+                next = task;
+                next_index = i;
+            }
+        }
+        if (!next) return count;
+
+        scheduler_dispatch(scheduler, next, now);
+        done |= 1U << next_index;
+        count++;
+    }
+}
+
+/*
+ * @brief Get the statistics of a task
+ *
+ * @param scheduler The scheduler instance
+ * @param index The index of the task
+ * @param[out] stats The statistics
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if there is no such task
+ */
+status_t scheduler_get_stats(const scheduler_t* scheduler, uint8_t index, struct scheduler_stats_s* stats)
+{
+    ARGUMENT_ASSERT(scheduler);
+    ARGUMENT_ASSERT(stats);
+    if (index >= scheduler->num) return PFC_ERROR_DATA;
+
+    memcpy(stats, &scheduler->tasks[index].stats, sizeof(struct scheduler_stats_s));
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Clear the statistics of all the tasks
+ *
+ * @param scheduler The scheduler instance
+ */
+void scheduler_clear_stats(scheduler_t* scheduler)
+{
+    if (!scheduler) return;
+    for (uint8_t i = 0; i < scheduler->num; i++)
+    {
+        memset(&scheduler->tasks[i].stats, 0, sizeof(struct scheduler_stats_s));
+    }
+}
+/** @} */
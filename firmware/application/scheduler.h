@@ -0,0 +1,153 @@
+/**
+ * @file scheduler.h
+ * @author Stanislav Karpikov
+ * @brief Cooperative scheduler: the run-to-completion tasks with the priorities, the periods and the deadlines (header)
+ */
+
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+/** @addtogroup app_scheduler
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/bsp.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define SCHEDULER_TASKS_MAX (8U) /**< The maximum number of the tasks (the bits of the pass mask) */
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** The release of a task */
+typedef enum
+{
+    SCHEDULER_TASK_BACKGROUND, /**< Run once in every pass of the scheduler */
+    SCHEDULER_TASK_PERIODIC,   /**< Released every period */
+    SCHEDULER_TASK_EVENT,      /**< Released by scheduler_release (an interrupt) */
+} scheduler_task_type_t;
+
+/**
+ * @brief The clock of the scheduler
+ *
+ * @return The counter value [cycles], wraps at 32 bits
+ */
+typedef uint32_t (*scheduler_clock_t)(void);
+
+/** The configuration of a task */
+typedef struct
+{
+    void (*run)(void);          /**< The task function (runs to the completion) */
+    scheduler_task_type_t type; /**< The release of the task */
+    uint8_t priority;           /**< The priority: 0 - the highest */
+    uint32_t period;            /**< The period of a periodic task [us] */
+    uint32_t deadline;          /**< The time from the release to the end of the run [us], 0 - no deadline */
+} scheduler_task_config_t;
+
+/** The statistics of a task (all the times are in us) */
+struct __attribute__((__packed__)) scheduler_stats_s
+{
+    uint32_t runs;       /**< The number of the runs */
+    uint32_t overruns;   /**< The number of the runs ended after the deadline */
+    uint32_t missed;     /**< The number of the releases lost: the task has not run before the next release */
+    uint32_t exec_last;  /**< The execution time of the last run */
+    uint32_t exec_max;   /**< The maximum execution time */
+    uint32_t jitter_max; /**< The maximum delay from the release to the start */
+};
+
+/** The state of a task */
+typedef struct
+{
+    const scheduler_task_config_t* config; /**< The configuration */
+    volatile uint32_t releases;            /**< The number of the releases by the interrupts (an event task) */
+    volatile uint32_t release_time;        /**< The time of the last release by an interrupt [cycles] */
+    uint32_t taken;                        /**< The number of the releases taken by the scheduler (an event task) */
+    uint32_t next_release;                 /**< The time of the next release of a periodic task [cycles] */
+    struct scheduler_stats_s stats;        /**< The statistics */
+} scheduler_task_t;
+
+/**
+ * @brief The scheduler instance
+ *
+ * @note The tasks are run by the main loop only, the event tasks are released by the interrupts
+ */
+typedef struct
+{
+    scheduler_task_t tasks[SCHEDULER_TASKS_MAX]; /**< The tasks */
+    uint8_t num;                                 /**< The number of the tasks */
+    scheduler_clock_t clock;                     /**< The clock */
+    uint32_t cycles_us;                          /**< The clock cycles in a microsecond */
+} scheduler_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Init the scheduler without the tasks
+ *
+ * @param scheduler The scheduler instance
+ * @param clock The clock (the firmware uses the core cycle counter, the host port - the model time)
+ * @param frequency The frequency of the clock [Hz], from 1 MHz
+ *
+ * @return The status of the operation
+ */
+status_t scheduler_init(scheduler_t* scheduler, scheduler_clock_t clock, uint32_t frequency);
+
+/**
+ * @brief Add a task (the index of the task is the number of the tasks added before)
+ *
+ * @param scheduler The scheduler instance
+ * @param config The configuration of the task (kept by the scheduler)
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if there are too many tasks or the configuration is wrong
+ */
+status_t scheduler_add(scheduler_t* scheduler, const scheduler_task_config_t* config);
+
+/**
+ * @brief Release an event task (called from the interrupts)
+ *
+ * @param scheduler The scheduler instance
+ * @param index The index of the task
+ */
+void scheduler_release(scheduler_t* scheduler, uint8_t index);
+
+/**
+ * @brief Run a pass: the released tasks by the priority (the order of adding for the equal ones), every task once.
+ * The releases are checked again after every task, so a task released meanwhile runs before the lower priority ones
+ *
+ * @param scheduler The scheduler instance
+ *
+ * @return The number of the tasks run
+ */
+uint8_t scheduler_run(scheduler_t* scheduler);
+
+/**
+ * @brief Get the statistics of a task
+ *
+ * @param scheduler The scheduler instance
+ * @param index The index of the task
+ * @param[out] stats The statistics
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if there is no such task
+ */
+status_t scheduler_get_stats(const scheduler_t* scheduler, uint8_t index, struct scheduler_stats_s* stats);
+
+/**
+ * @brief Clear the statistics of all the tasks
+ *
+ * @param scheduler The scheduler instance
+ */
+void scheduler_clear_stats(scheduler_t* scheduler);
+
+/** @} */
+#endif /* _SCHEDULER_H */
@@ -0,0 +1,135 @@
+/**
+ * @file seqlock.c
+ * @author Stanislav Karpikov
+ * @brief Sequence lock: the data is published in two copies, the readers never wait for the writer
+ */
+
+/** @addtogroup app_seqlock
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "seqlock.h"
+
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Start a write: the first copy is written
+ *
+ * @param lock The lock
+ */
+void seqlock_write_begin(seqlock_t* lock)
+{
+    lock->sequence++;
+    __dmb(0xF);
+}
+
+/*
+ * @brief Publish the first copy: the second copy is written
+ *
+ * @param lock The lock
+ */
+void seqlock_write_switch(seqlock_t* lock)
+{
+    __dmb(0xF);
+    lock->sequence++;
+    __dmb(0xF);
+}
+
+/*
+ * @brief Finish a write: both copies are published
+ *
+ * @param lock The lock
+ */
+void seqlock_write_end(seqlock_t* lock)
+{
+    (void)lock;
+    /* The second copy is complete before the next write starts on the first one */
+    __dmb(0xF);
+}
+
+/*
+ * @brief Start a read
+ *
+ * @param lock The lock
+ *
+ * @return The sequence number (for seqlock_read_copy and seqlock_read_retry)
+ */
+uint32_t seqlock_read_begin(const seqlock_t* lock)
+{
+    uint32_t sequence = lock->sequence;
+    __dmb(0xF);
+    return sequence;
+}
+
+/*
+ * @brief Get the copy to read
+ *
+ * @param sequence The sequence number of the read
+ *
+ * @return The index of the copy (0 - the first one)
+ */
+uint8_t seqlock_read_copy(uint32_t sequence)
+{
+    /* The first copy is being written while the number is odd */
+    return sequence & 1;
+}
+
+/*
+ * @brief Check if the copy has been written during the read
+ *
+ * @param lock The lock
+ * @param sequence The sequence number of the read
+ *
+ * @return 1 if the data should be read again
+ */
+int seqlock_read_retry(const seqlock_t* lock, uint32_t sequence)
+{
+    __dmb(0xF);
+    return lock->sequence != sequence;
+}
+
+/*
+ * @brief Write the data to both copies
+ *
+ * @param lock The lock
+ * @param first The first copy
+ * @param second The second copy
+ * @param data The data
+ * @param size The size of the data
+ */
+void seqlock_write(seqlock_t* lock, void* first, void* second, const void* data, uint32_t size)
+{
+    seqlock_write_begin(lock);
+    memcpy(first, data, size);
+    seqlock_write_switch(lock);
+    memcpy(second, data, size);
+    seqlock_write_end(lock);
+}
+
+/*
+ * @brief Read the data coherently
+ *
+ * @param lock The lock
+ * @param first The first copy
+ * @param second The second copy
+ * @param[out] data The data
+ * @param size The size of the data
+ */
+void seqlock_read(const seqlock_t* lock, const void* first, const void* second, void* data, uint32_t size)
+{
+    uint32_t sequence;
+    do
+    {
+        sequence = seqlock_read_begin(lock);
+        memcpy(data, seqlock_read_copy(sequence) ? second : first, size);
+    } while (seqlock_read_retry(lock, sequence));
+}
+/** @} */
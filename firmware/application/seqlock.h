@@ -0,0 +1,111 @@
+/**
+ * @file seqlock.h
+ * @author Stanislav Karpikov
+ * @brief Sequence lock: the data is published in two copies, the readers never wait for the writer (header)
+ */
+
+#ifndef _SEQLOCK_H
+#define _SEQLOCK_H
+
+/** @addtogroup app_seqlock
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/bsp.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/**
+ * @brief The sequence lock of the data kept in two copies
+ * @note The writer updates the first copy (the readers take the second one), then the second copy (the readers take the first one).
+ * A reader which interrupts the writer reads the copy not being written, a reader interrupted by the writer reads again
+ */
+typedef struct
+{
+    volatile uint32_t sequence; /**< The number of the writes: odd - the first copy is being written */
+} seqlock_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Start a write: the first copy is written
+ *
+ * @param lock The lock
+ */
+void seqlock_write_begin(seqlock_t* lock);
+
+/**
+ * @brief Publish the first copy: the second copy is written
+ *
+ * @param lock The lock
+ */
+void seqlock_write_switch(seqlock_t* lock);
+
+/**
+ * @brief Finish a write: both copies are published
+ *
+ * @param lock The lock
+ */
+void seqlock_write_end(seqlock_t* lock);
+
+/**
+ * @brief Start a read
+ *
+ * @param lock The lock
+ *
+ * @return The sequence number (for seqlock_read_copy and seqlock_read_retry)
+ */
+uint32_t seqlock_read_begin(const seqlock_t* lock);
+
+/**
+ * @brief Get the copy to read
+ *
+ * @param sequence The sequence number of the read
+ *
+ * @return The index of the copy (0 - the first one)
+ */
+uint8_t seqlock_read_copy(uint32_t sequence);
+
+/**
+ * @brief Check if the copy has been written during the read
+ *
+ * @param lock The lock
+ * @param sequence The sequence number of the read
+ *
+ * @return 1 if the data should be read again
+ */
+int seqlock_read_retry(const seqlock_t* lock, uint32_t sequence);
+
+/**
+ * @brief Write the data to both copies
+ *
+ * @param lock The lock
+ * @param first The first copy
+ * @param second The second copy
+ * @param data The data
+ * @param size The size of the data
+ */
+void seqlock_write(seqlock_t* lock, void* first, void* second, const void* data, uint32_t size);
+
+/**
+ * @brief Read the data coherently
+ *
+ * @param lock The lock
+ * @param first The first copy
+ * @param second The second copy
+ * @param[out] data The data
+ * @param size The size of the data
+ */
+void seqlock_read(const seqlock_t* lock, const void* first, const void* second, void* data, uint32_t size);
+
+/** @} */
+#endif /* _SEQLOCK_H */
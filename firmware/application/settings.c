@@ -15,7 +15,12 @@
 
 #include "settings.h"
 
-#include "EEPROM_emulation.h"
+#include "BSP/system.h"
+#include "crc.h"
+#include "eeprom_emulation.h"
+#include "events.h"
+#include "protocol.h"
+#include "stddef.h"
 #include "string.h"
 
 
@@ -23,7 +28,26 @@
                        DEFINES
 --------------------------------------------------------------*/
 
-#define MAGIC_WORD (0x55AB) /**< A word that is used to check the storage */
+#define SETTINGS_RECORDS_BASE    (128U) /**< The first virtual address of the records (the former storage is below) */
+#define SETTINGS_WRITE_HALFWORDS (4U)   /**< The number of the variables written by a run of the writer */
+#define SETTINGS_COPIES_NUM      (2U)   /**< The copies of a record: the newer correct one is loaded, the other is written */
+#define SETTINGS_SAVE_DEADLINE   (10000U) /**< The time a save waits for a page transfer of the EEPROM (the PWM off), then fails [ms] */
+
+#define SETTINGS_CAPACITY_CALIBRATIONS (128U) /**< The space of the calibrations in a record [bytes] */
+#define SETTINGS_CAPACITY_FILTERS      (32U)  /**< The space of the filters in a record [bytes] */
+#define SETTINGS_CAPACITY_PWM          (32U)  /**< The space of the PWM settings in a record [bytes] */
+#define SETTINGS_CAPACITY_PROTECTION   (64U)  /**< The space of the protection settings in a record [bytes] */
+#define SETTINGS_CAPACITY_CAPACITORS   (32U)  /**< The space of the capacitors settings in a record [bytes] */
+#define SETTINGS_CAPACITY_MAX          (SETTINGS_CAPACITY_CALIBRATIONS) /**< The biggest space of a section [bytes] */
+
+#define SETTINGS_VERSION_CALIBRATIONS (1U) /**< The schema version of the calibrations */
+#define SETTINGS_VERSION_FILTERS      (1U) /**< The schema version of the filters settings */
+#define SETTINGS_VERSION_PWM          (1U) /**< The schema version of the PWM settings */
+#define SETTINGS_VERSION_PROTECTION   (1U) /**< The schema version of the protection settings */
+#define SETTINGS_VERSION_CAPACITORS   (1U) /**< The schema version of the capacitors settings */
+
+#define SETTINGS_LEGACY_MAGIC         (0x55AB) /**< The former storage: the word that is used to check the storage */
+#define SETTINGS_LEGACY_MAGIC_ADDRESS (98U)    /**< The former storage: the variable of the magic word (after the settings) */
 
 #define DEFAULT_UCAP_MIN       (200U)      /**< Default settings: minimum capacitor voltage */
 #define DEFAULT_UCAP_MAX       (800U)      /**< Default settings: maximum capacitor voltage */
@@ -37,33 +61,244 @@
 #define DEFAULT_UCAP_NOMINAL   (750)       /**< Default settings: nominal capacitor voltage */
 #define DEFAULT_UCAP_PRECHARGE (250)       /**< Default settings: precharge level for capacitor voltage */
 
+/*--------------------------------------------------------------
+                       PRIVATE TYPES
+--------------------------------------------------------------*/
+
+/** The sections of the settings: a section is stored as a record */
+typedef enum
+{
+    SETTINGS_SECTION_CALIBRATIONS, /**< The calibrations settings */
+    SETTINGS_SECTION_FILTERS,      /**< The filters settings */
+    SETTINGS_SECTION_PWM,          /**< The PWM settings */
+    SETTINGS_SECTION_PROTECTION,   /**< The protection settings */
+    SETTINGS_SECTION_CAPACITORS,   /**< The capacitors settings */
+    SETTINGS_SECTIONS_NUM          /**< The number of the sections */
+} settings_section_id_t;
+
+/** The result of a section load */
+typedef enum
+{
+    SETTINGS_LOAD_NONE,     /**< No correct record (or a record of a newer schema): the defaults are kept */
+    SETTINGS_LOAD_CURRENT,  /**< The record of the current schema is loaded */
+    SETTINGS_LOAD_MIGRATED, /**< The record of an older schema is loaded and migrated (should be written again) */
+} settings_load_t;
+
+/**
+ * @brief A migration of a section data to the next schema version
+ *
+ * @param[in,out] data The data (the buffer has the capacity of the section)
+ * @param[in,out] length The size of the data [bytes]
+ */
+typedef void (*settings_migration_t)(uint8_t* data, uint16_t* length);
+
+/** A section of the settings */
+typedef struct
+{
+    uint16_t offset;                        /**< The offset of the section in settings_t */
+    uint16_t size;                          /**< The size of the section [bytes] */
+    uint16_t capacity;                      /**< The space of the section in a record (the fields can be appended) [bytes] */
+    uint8_t version;                        /**< The schema version */
+    const settings_migration_t* migrations; /**< The migrations from the version (index + 1) to the next one, NULL - none */
+} settings_section_t;
+
+/** The header of a record (the variables before the data) */
+struct __attribute__((__packed__)) settings_record_header_s
+{
+    uint32_t crc;      /**< CRC32 of the record after the field (the header and the data), written the last */
+    uint16_t length;   /**< The size of the data [bytes] */
+    uint8_t section;   /**< The section (settings_section_id_t) */
+    uint8_t version;   /**< The schema version of the data */
+    uint16_t sequence; /**< The number of the record of the section (the newer copy is loaded) */
+};
+
+#define SETTINGS_HEADER_HALFWORDS  (sizeof(struct settings_record_header_s) / 2)         /**< The variables of a record header */
+#define SETTINGS_CRC_HALFWORDS     (sizeof(uint32_t) / 2)                                /**< The variables of the record CRC */
+#define SETTINGS_RECORD_HALFWORDS  (SETTINGS_HEADER_HALFWORDS + SETTINGS_CAPACITY_MAX / 2) /**< The variables of the biggest record */
+#define SETTINGS_RECORDS_HALFWORDS                                                                                        \
+    (SETTINGS_COPIES_NUM * (SETTINGS_SECTIONS_NUM * SETTINGS_HEADER_HALFWORDS +                                           \
+                            (SETTINGS_CAPACITY_CALIBRATIONS + SETTINGS_CAPACITY_FILTERS + SETTINGS_CAPACITY_PWM +        \
+                             SETTINGS_CAPACITY_PROTECTION + SETTINGS_CAPACITY_CAPACITORS) / 2)) /**< The variables of all the records */
+
+/** Compile-time check: the records fit the RAM index of the EEPROM emulation */
+typedef char settings_records_check_t[(SETTINGS_RECORDS_BASE + SETTINGS_RECORDS_HALFWORDS <= EEPROM_VARIABLES_NUM) ? 1 : -1];
+
+/** Compile-time check: the records are above the former storage */
+typedef char settings_legacy_area_check_t[(SETTINGS_LEGACY_MAGIC_ADDRESS < SETTINGS_RECORDS_BASE) ? 1 : -1];
+
+/** Compile-time check: the former storage held this layout of the settings (freeze a copy for the import before a change) */
+typedef char settings_legacy_check_t[(sizeof(settings_t) == SETTINGS_LEGACY_MAGIC_ADDRESS * 2) ? 1 : -1];
+
+/** Compile-time check: the sections fit the records */
+typedef char settings_capacity_check_t[(sizeof(settings_calibrations_t) <= SETTINGS_CAPACITY_CALIBRATIONS &&
+                                        sizeof(settings_filters_t) <= SETTINGS_CAPACITY_FILTERS &&
+                                        sizeof(settings_pwm_t) <= SETTINGS_CAPACITY_PWM &&
+                                        sizeof(settings_protection_t) <= SETTINGS_CAPACITY_PROTECTION &&
+                                        sizeof(settings_capacitors_t) <= SETTINGS_CAPACITY_CAPACITORS)
+                                           ? 1
+                                           : -1];
+
 /*--------------------------------------------------------------
                        PRIVATE DATA
 --------------------------------------------------------------*/
 
 static settings_t settings = {0}; /**< The internal settings storage in RAM */
 
+/** The sections of the settings (in the order of settings_section_id_t) */
+static const settings_section_t sections[SETTINGS_SECTIONS_NUM] = {
+    {offsetof(settings_t, calibrations), sizeof(settings_calibrations_t), SETTINGS_CAPACITY_CALIBRATIONS, SETTINGS_VERSION_CALIBRATIONS, NULL},
+    {offsetof(settings_t, filters), sizeof(settings_filters_t), SETTINGS_CAPACITY_FILTERS, SETTINGS_VERSION_FILTERS, NULL},
+    {offsetof(settings_t, pwm), sizeof(settings_pwm_t), SETTINGS_CAPACITY_PWM, SETTINGS_VERSION_PWM, NULL},
+    {offsetof(settings_t, protection), sizeof(settings_protection_t), SETTINGS_CAPACITY_PROTECTION, SETTINGS_VERSION_PROTECTION, NULL},
+    {offsetof(settings_t, capacitors), sizeof(settings_capacitors_t), SETTINGS_CAPACITY_CAPACITORS, SETTINGS_VERSION_CAPACITORS, NULL},
+};
+
+static settings_t stored;                                /**< The settings in the records (the sections marked as stored) */
+static uint8_t record_stored[SETTINGS_SECTIONS_NUM];     /**< The section has a correct record of the current schema */
+static uint8_t record_copy[SETTINGS_SECTIONS_NUM];       /**< The copy of the record loaded (the other one is written) */
+static uint16_t record_sequence[SETTINGS_SECTIONS_NUM];  /**< The sequence number of the record loaded */
+
+static settings_t staged;                      /**< The copy of the settings to write (taken by settings_save) */
+static uint16_t record[SETTINGS_RECORD_HALFWORDS]; /**< The record being written */
+static uint8_t write_section = 0;              /**< The section being written */
+static uint16_t write_halfwords = 0;           /**< The size of the record being written, 0 - not prepared */
+static uint16_t write_index = 0;               /**< The next variable to write (the CRC is written the last) */
+static uint32_t save_requested = 0;            /**< The number of the save requests */
+static uint32_t save_done = 0;                 /**< The number of the last request written (or failed) */
+static uint32_t save_ticks = 0;                /**< The time of the last request [ticks] */
+
 /*--------------------------------------------------------------
                        PRIVATE FUNCTIONS
 --------------------------------------------------------------*/
 
 /**
- * @brief Read settings data from the EEPROM memory
- * 
+ * @brief Get the number of the variables of a record
+ *
+ * @param section The section
+ *
+ * @return The number of the variables
+ */
+static uint16_t settings_record_halfwords(uint8_t section)
+{
+    return SETTINGS_HEADER_HALFWORDS + sections[section].capacity / 2;
+}
+
+/**
+ * @brief Get the virtual address of a record copy (the copies of the sections follow each other)
+ *
+ * @param section The section
+ * @param copy The copy
+ *
+ * @return The virtual address of the first variable
+ */
+static uint16_t settings_record_address(uint8_t section, uint8_t copy)
+{
+    uint16_t address = SETTINGS_RECORDS_BASE;
+    for (uint8_t i = 0; i < section; i++)
+    {
+        address += SETTINGS_COPIES_NUM * settings_record_halfwords(i);
+    }
+    return address + copy * settings_record_halfwords(section);
+}
+
+/**
+ * @brief Calculate the CRC of a record
+ *
+ * @param buffer The record (the header and the data)
+ * @param length The size of the data [bytes]
+ *
+ * @return The CRC
+ */
+static uint32_t settings_record_crc(const uint16_t* buffer, uint16_t length)
+{
+    return crc32((const uint8_t*)buffer + sizeof(uint32_t), sizeof(struct settings_record_header_s) - sizeof(uint32_t) + length);
+}
+
+/**
+ * @brief Read a record copy and check it
+ *
+ * @param section The section
+ * @param copy The copy
+ * @param[out] buffer The record (the header and the data)
+ * @param[out] header The header
+ *
+ * @return 1 if the record is correct, 0 otherwise
+ */
+static uint8_t settings_record_read(uint8_t section, uint8_t copy, uint16_t* buffer, struct settings_record_header_s* header)
+{
+    uint16_t address = settings_record_address(section, copy);
+    for (uint16_t i = 0; i < SETTINGS_HEADER_HALFWORDS; i++)
+    {
+        if (eeprom_read_variable(address + i, &buffer[i]) != EEPROM_OK) return 0;
+    }
+    memcpy(header, buffer, sizeof(struct settings_record_header_s));
+    if (header->section != section || header->version == 0 || header->length > sections[section].capacity) return 0;
+
+    for (uint16_t i = SETTINGS_HEADER_HALFWORDS; i < SETTINGS_HEADER_HALFWORDS + (header->length + 1) / 2; i++)
+    {
+        if (eeprom_read_variable(address + i, &buffer[i]) != EEPROM_OK) return 0;
+    }
+    return settings_record_crc(buffer, header->length) == header->crc;
+}
+
+/**
+ * @brief Load a section from the newer correct copy of the record, migrate the data to the current schema
+ * @note The fields appended to the section after the record was written keep the defaults
+ *
+ * @param section The section
+ * @param[in,out] settings The settings (only the section is loaded)
+ * @param[out] copy The copy loaded
+ * @param[out] sequence The sequence number of the copy loaded
+ *
+ * @return The result of the load
+ */
+static settings_load_t settings_section_load(uint8_t section, settings_t* settings, uint8_t* copy, uint16_t* sequence)
+{
+    const settings_section_t* descriptor = &sections[section];
+    uint16_t buffers[SETTINGS_COPIES_NUM][SETTINGS_RECORD_HALFWORDS];
+    struct settings_record_header_s headers[SETTINGS_COPIES_NUM];
+    uint8_t valid[SETTINGS_COPIES_NUM];
+    for (uint8_t i = 0; i < SETTINGS_COPIES_NUM; i++)
+    {
+        valid[i] = settings_record_read(section, i, buffers[i], &headers[i]);
+    }
+
+    /* The copies are written in turn: the newer one is loaded (the sequence numbers wrap around) */
+    if (!valid[0] && !valid[1]) return SETTINGS_LOAD_NONE;
+    uint8_t loaded = (valid[0] && valid[1]) ? ((int16_t)(headers[1].sequence - headers[0].sequence) > 0) : valid[1];
+    *copy = loaded;
+    *sequence = headers[loaded].sequence;
+
+    struct settings_record_header_s* header = &headers[loaded];
+    uint8_t* data = (uint8_t*)&buffers[loaded][SETTINGS_HEADER_HALFWORDS];
+    uint16_t length = header->length;
+    if (header->version > descriptor->version) return SETTINGS_LOAD_NONE;
+    for (uint8_t version = header->version; version < descriptor->version; version++)
+    {
+        if (descriptor->migrations && descriptor->migrations[version - 1]) descriptor->migrations[version - 1](data, &length);
+    }
+    memcpy((uint8_t*)settings + descriptor->offset, data, (length < descriptor->size) ? length : descriptor->size);
+
+    return (header->version == descriptor->version && length == descriptor->size) ? SETTINGS_LOAD_CURRENT : SETTINGS_LOAD_MIGRATED;
+}
+
+/**
+ * @brief Read the settings of the former storage (the variables from 0 up to the magic word)
+ *
  * @param[out] settings A pointer to the settings structure
- * 
+ *
  * @return The status of the operation
  */
-static status_t eeprom_settings_read(settings_t *settings)
+static status_t settings_legacy_read(settings_t* settings)
 {
-    uint16_t mem[sizeof(settings_t) / 2];
+    uint16_t mem[SETTINGS_LEGACY_MAGIC_ADDRESS + 1];
 
-    for (int address = 0; address < sizeof(settings_t) / 2; address++)
+    for (uint16_t address = 0; address <= SETTINGS_LEGACY_MAGIC_ADDRESS; address++)
     {
         if (EEPROM_OK != eeprom_read_variable(address, &mem[address])) return PFC_ERROR_GENERIC;
     }
+    if (mem[SETTINGS_LEGACY_MAGIC_ADDRESS] != SETTINGS_LEGACY_MAGIC) return PFC_ERROR_GENERIC;
     memcpy(settings, mem, sizeof(settings_t));
-    if (settings->magic != MAGIC_WORD) return PFC_ERROR_GENERIC;
 
     return PFC_SUCCESS;
 }
@@ -99,25 +334,74 @@ static void settings_fill_defaults(settings_t *settings)
 }
 
 /**
- * @brief Write settings to the EEPROM memory
- * 
- * @param[in] settings A pointer to the settings structure
+ * @brief Prepare the record of the next changed section to write (the sections stored unchanged are skipped)
  *
- * @return The status of the operation
+ * @return 1 if a record is prepared, 0 if all the sections are stored
  */
-static status_t eeprom_settings_write(settings_t *settings)
+static uint8_t settings_record_prepare(void)
 {
-    uint16_t data;
-    uint16_t mem[sizeof(settings_t) / 2];
+    while (write_section < SETTINGS_SECTIONS_NUM)
+    {
+        const settings_section_t* descriptor = &sections[write_section];
+        const uint8_t* data = (const uint8_t*)&staged + descriptor->offset;
+        if (!record_stored[write_section] || memcmp(data, (const uint8_t*)&stored + descriptor->offset, descriptor->size)) break;
+        write_section++;
+    }
+    if (write_section >= SETTINGS_SECTIONS_NUM) return 0;
+
+    const settings_section_t* descriptor = &sections[write_section];
+    struct settings_record_header_s header;
+    header.length = descriptor->size;
+    header.section = write_section;
+    header.version = descriptor->version;
+    header.sequence = record_sequence[write_section] + 1;
+
+    memset(record, 0, sizeof(record));
+    memcpy(record, &header, sizeof(header));
+    memcpy(&record[SETTINGS_HEADER_HALFWORDS], (const uint8_t*)&staged + descriptor->offset, descriptor->size);
+    header.crc = settings_record_crc(record, header.length);
+    memcpy(record, &header, sizeof(header));
+
+    write_halfwords = SETTINGS_HEADER_HALFWORDS + (descriptor->size + 1) / 2;
+    write_index = 0;
+    return 1;
+}
 
-    settings->magic = MAGIC_WORD;
-    memcpy(mem, settings, sizeof(settings_t));
-    for (int address = 0; address < sizeof(settings_t) / 2; address++)
+/**
+ * @brief Finish the record written: the copy written becomes the loaded one
+ */
+static void settings_record_commit(void)
+{
+    const settings_section_t* descriptor = &sections[write_section];
+    memcpy((uint8_t*)&stored + descriptor->offset, (const uint8_t*)&staged + descriptor->offset, descriptor->size);
+    record_stored[write_section] = 1;
+    record_copy[write_section] ^= 1;
+    record_sequence[write_section]++;
+
+    write_section++;
+    write_halfwords = 0;
+}
+
+/**
+ * @brief Finish the save: report the result to the panel (an event)
+ *
+ * @param status The status of the save (PFC_WARNING: the page transfer has not been allowed until the deadline)
+ */
+static void settings_save_done(status_t status)
+{
+    save_done = save_requested;
+    if (status == PFC_SUCCESS)
     {
-        data = mem[address];
-        if (EEPROM_OK != eeprom_update_variable(address, data)) return PFC_ERROR_GENERIC;
+        events_new_event(EVENT_TYPE_EVENT, SUB_EVENT_TYPE_EVENT_SETTINGS_SAVED, save_done, (float)(system_get_ticks() - save_ticks));
+    }
+    else if (status == PFC_WARNING)
+    {
+        events_new_event(EVENT_TYPE_EVENT, SUB_EVENT_TYPE_EVENT_SETTINGS_DEFERRED, save_done, (float)(system_get_ticks() - save_ticks));
+    }
+    else
+    {
+        events_new_event(EVENT_TYPE_EVENT, SUB_EVENT_TYPE_EVENT_SETTINGS_FAILED, save_done, 0);
     }
-    return PFC_SUCCESS;
 }
 
 /**
@@ -140,37 +424,127 @@ static void settings_unlock(void)
                        PUBLIC FUNCTIONS
 --------------------------------------------------------------*/
 
-/**
- * @brief Save the current settings to the non-volatile memory
+/*
+ * @brief Save the current settings to the non-volatile memory: the settings are copied and written in the background
+ * by settings_process, the result is reported by an event. A new save restarts the writing (the unchanged
+ * sections are not written again)
  *
  * @return The status of the structure
  */
 status_t settings_save(void)
 {
-    if (eeprom_settings_write(&settings) != PFC_SUCCESS)
+    settings_lock();
+    memcpy(&staged, &settings, sizeof(settings_t));
+    settings_unlock();
+
+    save_requested++;
+    save_ticks = system_get_ticks();
+    write_section = 0;
+    write_halfwords = 0;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Write a part of the saved settings (the main loop). A changed section is written as a record to the older
+ * copy, the CRC is written the last: a record cut by a reset fails the check, and the other copy is loaded
+ *
+ * @param erase_allowed 1 - a page transfer of the EEPROM (a sector erase) is allowed, the writing waits for it otherwise
+ * (the save fails after SETTINGS_SAVE_DEADLINE)
+ */
+void settings_process(uint8_t erase_allowed)
+{
+    if (save_done == save_requested) return;
+
+    eeprom_allow_erase(erase_allowed);
+    for (uint8_t i = 0; i < SETTINGS_WRITE_HALFWORDS; i++)
     {
-        //ERROR(ERROR_LOG("EEPROM Write Settings FAILED!\n"));
-        return PFC_ERROR_GENERIC;
+        if (!write_halfwords && !settings_record_prepare()) break;
+
+        /* The header and the data after the CRC, then the CRC */
+        uint16_t offset = (write_index + SETTINGS_CRC_HALFWORDS) % write_halfwords;
+        uint16_t address = settings_record_address(write_section, record_copy[write_section] ^ 1) + offset;
+        eeprom_status_t status = eeprom_update_variable(address, record[offset]);
+        if (status == EEPROM_PAGE_FULL)
+        {
+            /* The page transfer is not allowed with the power hardware on: the save is not kept waiting forever */
+            if (system_get_ticks() - save_ticks > SETTINGS_SAVE_DEADLINE) settings_save_done(PFC_WARNING);
+            break;
+        }
+        if (status != EEPROM_OK)
+        {
+            //ERROR(ERROR_LOG("EEPROM Write Settings FAILED!\n"));
+            settings_save_done(PFC_ERROR_GENERIC);
+            break;
+        }
+        if (++write_index == write_halfwords) settings_record_commit();
     }
-    return PFC_SUCCESS;
+    eeprom_allow_erase(1);
+
+    if (save_done != save_requested && !write_halfwords && !settings_record_prepare()) settings_save_done(PFC_SUCCESS);
 }
 
-/**
- * @brief Read the current settings from the non-volatile memory
+/*
+ * @brief Check if a save is being written (the result is not reported yet)
+ *
+ * @return 1 if a save is being written, 0 otherwise
+ */
+uint8_t settings_is_saving(void)
+{
+    return save_done != save_requested;
+}
+
+/*
+ * @brief Read the current settings from the non-volatile memory: every section from its record (migrated to the
+ * current schema), the settings of the former storage if there are no records. The missing sections are set to
+ * the defaults, and the settings are saved if any section is not stored in the current schema
  *
  * @return The status of the structure
  */
 status_t settings_read(void)
 {
-    if (eeprom_settings_read(&settings) != PFC_SUCCESS)
+    uint8_t loaded = 0;
+    uint8_t complete = 1;
+
+    settings_fill_defaults(&settings);
+    for (uint8_t section = 0; section < SETTINGS_SECTIONS_NUM; section++)
     {
-        //WARNING(DEF_LOG("EEPROM Read Settings FAILED! May be corrupted or first time running\n"));
-        settings_fill_defaults(&settings);
-        settings_save();
+        record_copy[section] = SETTINGS_COPIES_NUM - 1;
+        record_sequence[section] = 0;
+        settings_load_t load = settings_section_load(section, &settings, &record_copy[section], &record_sequence[section]);
+        record_stored[section] = (load == SETTINGS_LOAD_CURRENT);
+        if (load != SETTINGS_LOAD_NONE) loaded = 1;
+        if (load != SETTINGS_LOAD_CURRENT) complete = 0;
     }
+    /* The former storage is imported if there are no records (the first start after the update) */
+    if (!loaded) settings_legacy_read(&settings);
+    memcpy(&stored, &settings, sizeof(settings_t));
+
+    if (!complete) settings_save();
     return PFC_SUCCESS;
 }
 
+/*
+ * @brief Read the settings stored in the non-volatile memory (the records) without applying them
+ *
+ * @param[out] settings The stored settings (the sections without a record are set to the defaults)
+ *
+ * @return The status of the operation
+ * @retval PFC_SUCCESS All the sections are stored in the current schema
+ */
+status_t settings_read_stored(settings_t* settings)
+{
+    ARGUMENT_ASSERT(settings);
+    status_t status = PFC_SUCCESS;
+    settings_fill_defaults(settings);
+    for (uint8_t section = 0; section < SETTINGS_SECTIONS_NUM; section++)
+    {
+        uint8_t copy;
+        uint16_t sequence;
+        if (settings_section_load(section, settings, &copy, &sequence) != SETTINGS_LOAD_CURRENT) status = PFC_ERROR_DATA;
+    }
+    return status;
+}
+
 /*
  * @brief Write the PWM settings to the current settings storage
  *
@@ -298,7 +672,7 @@ settings_calibrations_t settings_get_calibrations(void)
  * 
  * @return The protection settings structure
  */
-settings_protection_t settings_get_protection(void)
+ITCM_CODE settings_protection_t settings_get_protection(void)
 {
     settings_protection_t retval;
     settings_lock();
@@ -77,7 +77,6 @@ typedef struct
     settings_pwm_t pwm;                   /**< The PWM settings */
     settings_protection_t protection;     /**< The protection settings */
     settings_capacitors_t capacitors;     /**< The capacitors settings */
-    uint16_t magic;                       /**< The maic word */
 } settings_t;
 
 /*--------------------------------------------------------------
@@ -165,18 +164,48 @@ status_t settings_set_protection(settings_protection_t protection);
 status_t settings_set_capacitors(settings_capacitors_t capacitors);
 
 /*
- * @brief Save the current settings to the non-volatile memory
+ * @brief Save the current settings to the non-volatile memory: the settings are copied and written in the background
+ * by settings_process, the result is reported by an event. A new save restarts the writing (the unchanged
+ * sections are not written again)
  *
  * @return The status of the structure
  */
 status_t settings_save(void);
 
+/**
+ * @brief Write a part of the saved settings (the main loop). A changed section is written as a record to the older
+ * copy, the CRC is written the last: a record cut by a reset fails the check, and the other copy is loaded
+ *
+ * @param erase_allowed 1 - a page transfer of the EEPROM (a sector erase) is allowed, the writing waits for it otherwise
+ * (the save fails after SETTINGS_SAVE_DEADLINE)
+ */
+void settings_process(uint8_t erase_allowed);
+
+/**
+ * @brief Check if a save is being written (the result is not reported yet)
+ *
+ * @return 1 if a save is being written, 0 otherwise
+ */
+uint8_t settings_is_saving(void);
+
 /*
- * @brief Read the current settings from the non-volatile memory
+ * @brief Read the current settings from the non-volatile memory: every section from its record (migrated to the
+ * current schema), the settings of the former storage if there are no records. The missing sections are set to
+ * the defaults, and the settings are saved if any section is not stored in the current schema
  *
  * @return The status of the structure
  */
 status_t settings_read(void);
 
+/**
+ * @brief Read the settings stored in the non-volatile memory (the records) without applying them
+ *
+ * @param[out] settings The stored settings (the sections without a record are set to the defaults)
+ *
+ * @return The status of the operation
+ * @retval PFC_SUCCESS All the sections are stored in the current schema
+ */
+status_t settings_read_stored(settings_t* settings);
+
 /** @} */
 #endif /* _SETTINGS_H */
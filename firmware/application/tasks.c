@@ -0,0 +1,141 @@
+/**
+ * @file tasks.c
+ * @author Stanislav Karpikov
+ * @brief The tasks of the firmware main loop: the period processing, the protocol, the housekeeping, the settings
+ */
+
+/** @addtogroup app_tasks
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "tasks.h"
+
+#include "BSP/system.h"
+#include "adc_logic.h"
+#include "defines.h"
+#include "events.h"
+#include "events_process.h"
+#include "journal.h"
+#include "pfc_logic.h"
+#include "protocol.h"
+#include "settings.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define TASKS_PERIOD_DEADLINE       (2000U)  /**< The processing of a period: 10 % of the grid period [us] */
+#define TASKS_PROTOCOL_DEADLINE     (5000U)  /**< The handling of the received requests [us] */
+#define TASKS_HOUSEKEEPING_DEADLINE (10000U) /**< The events and the journal [us] */
+#define TASKS_SETTINGS_PERIOD       (1000U)  /**< The writing of the settings: a few variables per period [us] */
+#define TASKS_SETTINGS_DEADLINE     (1000U)  /**< The writing of the settings [us] */
+
+#define TASKS_DEVICE_TEMPERATURE (28) /**< The temperature of the unit */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Task: the panel interface
+ */
+static void tasks_protocol(void)
+{
+    protocol_work();
+}
+
+/**
+ * @brief Task: the events, the journal, the temperature
+ */
+static void tasks_housekeeping(void)
+{
+    events_report_suppressed();
+    journal_process();
+
+    adc_set_temperature(TASKS_DEVICE_TEMPERATURE); //TODO: Add temperature sensor measurement
+    events_check_temperature();
+}
+
+/**
+ * @brief Task: the writing of the saved settings (the sectors are erased only with the relays open and the PWM off: an
+ * erase stalls all the interrupts)
+ */
+static void tasks_settings(void)
+{
+    settings_process(pfc_is_power_off());
+}
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+/** The configuration of the tasks (in the order of task_t) */
+static const scheduler_task_config_t tasks_config[TASKS_COUNT] = {
+    {algorithm_process, SCHEDULER_TASK_EVENT, 0, 0, TASKS_PERIOD_DEADLINE},
+    {tasks_protocol, SCHEDULER_TASK_BACKGROUND, 1, 0, TASKS_PROTOCOL_DEADLINE},
+    {tasks_housekeeping, SCHEDULER_TASK_BACKGROUND, 2, 0, TASKS_HOUSEKEEPING_DEADLINE},
+    {tasks_settings, SCHEDULER_TASK_PERIODIC, 3, TASKS_SETTINGS_PERIOD, TASKS_SETTINGS_DEADLINE},
+};
+
+static scheduler_t scheduler; /**< The scheduler of the main loop */
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Init the scheduler with the tasks
+ *
+ * @return The status of the operation
+ */
+status_t tasks_init(void)
+{
+    status_t status = scheduler_init(&scheduler, system_get_cycles, system_get_cycles_frequency());
+    for (uint8_t i = 0; i < TASKS_COUNT && status == PFC_SUCCESS; i++)
+    {
+        status = scheduler_add(&scheduler, &tasks_config[i]);
+    }
+    return status;
+}
+
+/*
+ * @brief Run a pass of the tasks (the main loop)
+ */
+void tasks_run(void)
+{
+    scheduler_run(&scheduler);
+}
+
+/*
+ * @brief Release the processing of a period (called from the ADC interrupt)
+ */
+ITCM_CODE void tasks_release_period(void)
+{
+    scheduler_release(&scheduler, TASK_PERIOD);
+}
+
+/*
+ * @brief Get the statistics of a task
+ *
+ * @param task The task
+ * @param[out] stats The statistics
+ *
+ * @return The status of the operation
+ */
+status_t tasks_get_stats(task_t task, struct scheduler_stats_s* stats)
+{
+    return scheduler_get_stats(&scheduler, task, stats);
+}
+
+/*
+ * @brief Clear the statistics of the tasks
+ */
+void tasks_clear_stats(void)
+{
+    scheduler_clear_stats(&scheduler);
+}
+/** @} */
@@ -0,0 +1,71 @@
+/**
+ * @file tasks.h
+ * @author Stanislav Karpikov
+ * @brief The tasks of the firmware main loop: the period processing, the protocol, the housekeeping, the settings (header)
+ */
+
+#ifndef _TASKS_H
+#define _TASKS_H
+
+/** @addtogroup app_tasks
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "scheduler.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** The tasks (by the priority) */
+typedef enum
+{
+    TASK_PERIOD,       /**< The processing of a period (released by the ADC interrupt at the end of a period) */
+    TASK_PROTOCOL,     /**< The panel interface (the background) */
+    TASK_HOUSEKEEPING, /**< The events, the journal, the temperature (the background) */
+    TASK_SETTINGS,     /**< The writing of the saved settings (periodic) */
+    TASKS_COUNT        /**< The number of the tasks */
+} task_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Init the scheduler with the tasks
+ *
+ * @return The status of the operation
+ */
+status_t tasks_init(void);
+
+/**
+ * @brief Run a pass of the tasks (the main loop)
+ */
+void tasks_run(void);
+
+/**
+ * @brief Release the processing of a period (called from the ADC interrupt)
+ */
+void tasks_release_period(void);
+
+/**
+ * @brief Get the statistics of a task
+ *
+ * @param task The task
+ * @param[out] stats The statistics
+ *
+ * @return The status of the operation
+ */
+status_t tasks_get_stats(task_t task, struct scheduler_stats_s* stats);
+
+/**
+ * @brief Clear the statistics of the tasks
+ */
+void tasks_clear_stats(void);
+
+/** @} */
+#endif /* _TASKS_H */
@@ -0,0 +1,116 @@
+/**
+ * @file telemetry.c
+ * @author Stanislav Karpikov
+ * @brief Telemetry subscription: the groups of the values pushed to the panel every few periods
+ */
+
+/** @addtogroup app_telemetry
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "telemetry.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define TELEMETRY_OSCILLOGS_NUM (16U) /**< The maximum number of the oscillogram channels (the bits of the mask) */
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Subscribe to the telemetry or renew the subscription (the numbering of the pushes is continued)
+ *
+ * @param telemetry The telemetry instance
+ * @param groups The groups (telemetry_group_t mask), 0 - unsubscribe
+ * @param oscillogs The oscillogram channels (a mask), used with TELEMETRY_GROUP_OSCILLOG
+ * @param decimation The push is made every decimation periods (from 1)
+ * @param timeout The subscription time without a renewal [ms], 0 - TELEMETRY_TIMEOUT_DEFAULT
+ * @param now The current time [ms], 32 bits
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if the parameters are wrong
+ */
+status_t telemetry_subscribe(telemetry_t* telemetry, uint8_t groups, uint16_t oscillogs, uint8_t decimation, uint32_t timeout,
+                             uint32_t now)
+{
+    ARGUMENT_ASSERT(telemetry);
+    if (groups == 0)
+    {
+        telemetry_unsubscribe(telemetry);
+        return PFC_SUCCESS;
+    }
+    if ((groups & ~TELEMETRY_GROUPS_ALL) || decimation == 0 || timeout > TELEMETRY_TIMEOUT_MAX) return PFC_ERROR_DATA;
+    if ((groups & TELEMETRY_GROUP_OSCILLOG) && oscillogs == 0) return PFC_ERROR_DATA;
+
+    /* A renewal with the same decimation keeps the phase of the pushes */
+    if (telemetry->groups == 0 || telemetry->decimation != decimation) telemetry->countdown = decimation;
+    telemetry->groups = groups;
+    telemetry->oscillogs = oscillogs;
+    telemetry->decimation = decimation;
+    telemetry->timeout = timeout ? timeout : TELEMETRY_TIMEOUT_DEFAULT;
+    telemetry->renewed = now;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Cancel the subscription
+ *
+ * @param telemetry The telemetry instance
+ */
+void telemetry_unsubscribe(telemetry_t* telemetry)
+{
+    if (!telemetry) return;
+    telemetry->groups = 0;
+    telemetry->oscillogs = 0;
+}
+
+/*
+ * @brief Count a period: get the groups to push now. The subscription is cancelled if it has not been renewed in time
+ *
+ * @param telemetry The telemetry instance
+ * @param now The current time [ms], 32 bits
+ *
+ * @return The groups to push (telemetry_group_t mask), 0 - no push in this period
+ */
+uint8_t telemetry_period(telemetry_t* telemetry, uint32_t now)
+{
+    if (!telemetry || telemetry->groups == 0) return 0;
+
+    /* The link is lost (or the panel is closed without the cancel) */
+    if (now - telemetry->renewed > telemetry->timeout)
+    {
+        telemetry_unsubscribe(telemetry);
+        return 0;
+    }
+
+    if (--telemetry->countdown > 0) return 0;
+    telemetry->countdown = telemetry->decimation;
+    return telemetry->groups;
+}
+
+/*
+ * @brief Get the next oscillogram channel to push (the subscribed channels in turn)
+ *
+ * @param telemetry The telemetry instance
+ *
+ * @return The channel
+ */
+uint8_t telemetry_next_oscillog(telemetry_t* telemetry)
+{
+    if (!telemetry || telemetry->oscillogs == 0) return 0;
+
+    uint8_t channel = telemetry->oscillog;
+    do
+    {
+        channel = (channel + 1) % TELEMETRY_OSCILLOGS_NUM;
+    } while (!(telemetry->oscillogs & (1U << channel)));
+    telemetry->oscillog = channel;
+    return channel;
+}
+/** @} */
@@ -0,0 +1,107 @@
+/**
+ * @file telemetry.h
+ * @author Stanislav Karpikov
+ * @brief Telemetry subscription: the groups of the values pushed to the panel every few periods (header)
+ */
+
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+/** @addtogroup app_telemetry
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/bsp.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define TELEMETRY_TIMEOUT_DEFAULT (3000U) /**< The subscription time without a renewal if the panel has not set it [ms] */
+#define TELEMETRY_TIMEOUT_MAX     (60000U) /**< The maximum subscription time without a renewal [ms] */
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** Telemetry groups (a mask): the blocks of a push are in the order of the bits */
+typedef enum
+{
+    TELEMETRY_GROUP_ADC_ACTIVE = (1U << 0), /**< The active values (as answer_get_adc_active) */
+    TELEMETRY_GROUP_NET_PARAMS = (1U << 1), /**< The network parameters (as answer_get_net_params) */
+    TELEMETRY_GROUP_WORK_STATE = (1U << 2), /**< The work state (as answer_get_work_state) */
+    TELEMETRY_GROUP_OSCILLOG = (1U << 3),   /**< An oscillogram: the subscribed channels in turn (as answer_get_oscillog) */
+    TELEMETRY_GROUPS_ALL = 0x0F,            /**< All the groups */
+} telemetry_group_t;
+
+/**
+ * @brief The telemetry subscription instance
+ *
+ * @note The instance is used by the main loop only: the subscription is changed by the panel commands,
+ * the pushes are made at the end of the periods
+ */
+typedef struct
+{
+    uint8_t groups;     /**< The subscribed groups (telemetry_group_t mask), 0 - no subscription */
+    uint16_t oscillogs; /**< The subscribed oscillogram channels (a mask) */
+    uint8_t decimation; /**< The push is made every decimation periods */
+    uint8_t countdown;  /**< The number of the periods left to the push */
+    uint8_t oscillog;   /**< The last oscillogram channel pushed */
+    uint32_t timeout;   /**< The subscription time without a renewal [ms] */
+    uint32_t renewed;   /**< The time of the last renewal [ms] */
+    uint32_t sequence;  /**< The number of the last push packet */
+    uint32_t skipped;   /**< The number of the pushes skipped (the transmission queue is full) */
+} telemetry_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Subscribe to the telemetry or renew the subscription (the numbering of the pushes is continued)
+ *
+ * @param telemetry The telemetry instance
+ * @param groups The groups (telemetry_group_t mask), 0 - unsubscribe
+ * @param oscillogs The oscillogram channels (a mask), used with TELEMETRY_GROUP_OSCILLOG
+ * @param decimation The push is made every decimation periods (from 1)
+ * @param timeout The subscription time without a renewal [ms], 0 - TELEMETRY_TIMEOUT_DEFAULT
+ * @param now The current time [ms], 32 bits
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if the parameters are wrong
+ */
+status_t telemetry_subscribe(telemetry_t* telemetry, uint8_t groups, uint16_t oscillogs, uint8_t decimation, uint32_t timeout,
+                             uint32_t now);
+
+/**
+ * @brief Cancel the subscription
+ *
+ * @param telemetry The telemetry instance
+ */
+void telemetry_unsubscribe(telemetry_t* telemetry);
+
+/**
+ * @brief Count a period: get the groups to push now. The subscription is cancelled if it has not been renewed in time
+ *
+ * @param telemetry The telemetry instance
+ * @param now The current time [ms], 32 bits
+ *
+ * @return The groups to push (telemetry_group_t mask), 0 - no push in this period
+ */
+uint8_t telemetry_period(telemetry_t* telemetry, uint32_t now);
+
+/**
+ * @brief Get the next oscillogram channel to push (the subscribed channels in turn)
+ *
+ * @param telemetry The telemetry instance
+ *
+ * @return The channel
+ */
+uint8_t telemetry_next_oscillog(telemetry_t* telemetry);
+
+/** @} */
+#endif /* _TELEMETRY_H */
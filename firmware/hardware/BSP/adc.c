@@ -15,6 +15,7 @@
 #include "BSP/adc.h"
 #include "BSP/debug.h"
 #include "BSP/bsp.h"
+#include "BSP/dma.h"
 #include "BSP/timer.h"
 #include "defines.h"
 #include "stm32f7xx_hal.h"
@@ -40,6 +41,9 @@ static DMA_HandleTypeDef hdma_adc = {0}; /**< ADC DMA hardware handle */
 static ADC_TRANSFER_CALLBACK adc_cplt_callback = 0;      /**< ADC DMA full complete callback */
 static ADC_TRANSFER_CALLBACK adc_half_cplt_callback = 0; /**< ADC DMA half complete callback */
 
+static uint32_t* adc_buffer = 0;     /**< The buffer of the DMA conversion (checked by adc_start) */
+static uint32_t adc_buffer_size = 0; /**< The size of the buffer of the DMA conversion */
+
 #ifdef ADC_MOCKING
 static uint16_t* mocking_buffer = 0; /**< ADC buffer to mock data */
 
@@ -111,7 +115,7 @@ status_t adc_register_callbacks(ADC_TRANSFER_CALLBACK cptl_callback, ADC_TRANSFE
  *
  * @param hadc ADC hardware handle
  */
-void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
+ITCM_CODE void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
 {
     if (adc_cplt_callback) adc_cplt_callback();
 }
@@ -121,7 +125,7 @@ void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
  *
  * @param hadc ADC hardware handle
  */
-void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc)
+ITCM_CODE void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc)
 {
     if (adc_half_cplt_callback) adc_half_cplt_callback();
 }
@@ -129,18 +133,35 @@ void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc)
 /*
  * @brief Start the ADC DMA conversion 
  *
- * @param buffer A buffer for the data
+ * @param buffer A buffer for the data (in the DMA region, DMA_BUFFER)
  * @param buffer_size The buffer size
  *
- * @return The status of the operation
+ * @return The status of the operation: PFC_ERROR_DATA if the buffer is not in the DMA region
  */
 status_t adc_start(uint32_t* buffer, uint32_t buffer_size)
 {
+    /* The core reads the data written by the DMA: the buffer should not be cached */
+    if (!dma_is_buffer(buffer, buffer_size)) return PFC_ERROR_DATA;
+
+    adc_buffer = buffer;
+    adc_buffer_size = buffer_size;
+    return adc_restart();
+}
+
+/*
+ * @brief Restart the ADC DMA conversion with the buffer of adc_start (the control interrupt: the buffer is not checked again)
+ *
+ * @return The status of the operation: PFC_ERROR_GENERIC if the conversion has not been started before
+ */
+ITCM_CODE status_t adc_restart(void)
+{
+    if (!adc_buffer) return PFC_ERROR_GENERIC;
+
 #ifndef ADC_MOCKING
-    HAL_ADC_Start(&hadc);
-    HAL_ADC_Start_DMA(&hadc, (uint32_t*)buffer, buffer_size);
+    if (HAL_ADC_Start(&hadc) != HAL_OK) return PFC_ERROR_HAL;
+    if (HAL_ADC_Start_DMA(&hadc, adc_buffer, adc_buffer_size) != HAL_OK) return PFC_ERROR_HAL;
 #else
-		mocking_buffer = (uint16_t*)buffer;
+		mocking_buffer = (uint16_t*)adc_buffer;
 #endif
     return PFC_SUCCESS;
 }
@@ -150,7 +171,7 @@ status_t adc_start(uint32_t* buffer, uint32_t buffer_size)
  *
  * @return The status of the operation
  */
-status_t adc_stop(void)
+ITCM_CODE status_t adc_stop(void)
 {
 #ifndef ADC_MOCKING
     HAL_ADC_Stop_DMA(&hadc);
@@ -425,7 +446,7 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 /**
   * @brief This function handles DMA global interrupt
   */
-void ADC_DMA_IRQ(void)
+ITCM_CODE void ADC_DMA_IRQ(void)
 {
 #ifndef ADC_MOCKING
     HAL_DMA_IRQHandler(&hdma_adc);
@@ -51,13 +51,20 @@ status_t adc_register_callbacks(ADC_TRANSFER_CALLBACK cptl_callback, ADC_TRANSFE
 /**
  * @brief Start the ADC DMA conversion 
  *
- * @param buffer A buffer for the data
+ * @param buffer A buffer for the data (in the DMA region, DMA_BUFFER)
  * @param buffer_size The buffer size
  *
- * @return The status of the operation
+ * @return The status of the operation: PFC_ERROR_DATA if the buffer is not in the DMA region
  */
 status_t adc_start(uint32_t* buffer, uint32_t buffer_size);
 
+/**
+ * @brief Restart the ADC DMA conversion with the buffer of adc_start (the control interrupt: the buffer is not checked again)
+ *
+ * @return The status of the operation: PFC_ERROR_GENERIC if the conversion has not been started before
+ */
+status_t adc_restart(void);
+
 /**
  * @brief Stop the ADC DMA conversion
  *
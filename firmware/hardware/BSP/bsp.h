@@ -16,9 +16,7 @@
 --------------------------------------------------------------*/
 
 #include "BSP/debug.h"
-
-#undef BOARD_STM32F767_MAIN /**< Define to use the main production board */
-#define BOARD_STM32F723_DISCO /**< Define to use the STM32F723E-DISCO development board */
+#include "board/board.h"
 
 #if defined(BOARD_STM32F767_MAIN)
 #include "board/board_stm32f767_main_v0_2.h"
@@ -58,4 +58,18 @@ status_t dma_init(void)
 
     return PFC_SUCCESS;
 }
+
+/*
+ * @brief Check if a buffer is in the DMA region (the DMA and the core see the same data without the cache maintenance)
+ *
+ * @param data The buffer
+ * @param size The size of the buffer
+ *
+ * @return 1 if the buffer is in the DMA region
+ */
+uint8_t dma_is_buffer(const void* data, uint32_t size)
+{
+    uint32_t address = (uint32_t)data;
+    return address >= DMA_REGION_ADDRESS && size <= DMA_REGION_SIZE && address - DMA_REGION_ADDRESS <= DMA_REGION_SIZE - size;
+}
 /** @} */
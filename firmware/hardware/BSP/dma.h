@@ -16,6 +16,14 @@
 --------------------------------------------------------------*/
 
 #include "BSP/debug.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC DEFINES
+--------------------------------------------------------------*/
+
+/** Place a buffer accessed by the DMA in the DMA region (not cached: the MPU, the scatter file) */
+#define DMA_BUFFER __attribute__((section("dma_buffers")))
 
 /*--------------------------------------------------------------
                        PUBLIC FUNCTIONS
@@ -28,5 +36,15 @@
  */
 status_t dma_init(void);
 
+/**
+ * @brief Check if a buffer is in the DMA region (the DMA and the core see the same data without the cache maintenance)
+ *
+ * @param data The buffer
+ * @param size The size of the buffer
+ *
+ * @return 1 if the buffer is in the DMA region
+ */
+uint8_t dma_is_buffer(const void* data, uint32_t size);
+
 /** @} */
 #endif /* _DMA_H */
@@ -0,0 +1,148 @@
+/**
+ * @file flash.c
+ * @author Stanislav Karpikov
+ * @brief Board support package: internal flash memory
+ */
+
+/** @addtogroup hdw_bsp_flash
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/flash.h"
+#include "BSP/debug.h"
+#include "stm32f7xx_hal.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define FLASH_BANK_BYTES         (0x100000U) /**< The size of a bank (STM32F76x/77x in the dual bank mode) */
+#define FLASH_BANK2_FIRST_SECTOR (12U)       /**< The ID of the first sector of the second bank */
+#define FLASH_SMALL_SECTORS_NUM  (4U)        /**< The number of the small sectors at the start of a bank */
+#define FLASH_SMALL_SECTOR_SIZE  (0x4000U)   /**< The size of the small sectors: 16 Kbytes */
+#define FLASH_MEDIUM_SECTOR_SIZE (0x10000U)  /**< The size of the sector after the small ones: 64 Kbytes */
+#define FLASH_LARGE_SECTOR_SIZE  (0x20000U)  /**< The size of the other sectors: 128 Kbytes */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Get the ID of the sector that contains the address
+ * @note The layout of STM32F72x/73x and of a bank of STM32F76x/77x (the dual bank mode): 4 x 16, 64, 128 Kbytes...
+ *
+ * @param address The address
+ *
+ * @return The sector ID
+ */
+static uint32_t flash_get_sector(uint32_t address)
+{
+    uint32_t offset = address - FLASH_BASE;
+    uint32_t sector = 0;
+    if (offset >= FLASH_BANK_BYTES)
+    {
+        sector = FLASH_BANK2_FIRST_SECTOR;
+        offset -= FLASH_BANK_BYTES;
+    }
+    if (offset < FLASH_SMALL_SECTORS_NUM * FLASH_SMALL_SECTOR_SIZE) return sector + offset / FLASH_SMALL_SECTOR_SIZE;
+    offset -= FLASH_SMALL_SECTORS_NUM * FLASH_SMALL_SECTOR_SIZE;
+    if (offset < FLASH_MEDIUM_SECTOR_SIZE) return sector + FLASH_SMALL_SECTORS_NUM;
+    offset -= FLASH_MEDIUM_SECTOR_SIZE;
+    return sector + FLASH_SMALL_SECTORS_NUM + 1 + offset / FLASH_LARGE_SECTOR_SIZE;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Erase a flash sector
+ * @note The code fetch from the flash bank is stalled until the sector is erased (up to 2 s for 128 Kbytes).
+ * Should not be called from interrupts or while the PWM is on
+ *
+ * @param address The start address of the sector
+ *
+ * @return The status of the operation
+ */
+status_t flash_erase(uint32_t address)
+{
+    FLASH_EraseInitTypeDef erase;
+    uint32_t sector_error = 0;
+    erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase.Sector = flash_get_sector(address);
+    erase.NbSectors = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &sector_error);
+    HAL_FLASH_Lock();
+    return (status == HAL_OK) ? PFC_SUCCESS : PFC_ERROR_HAL;
+}
+
+/*
+ * @brief Program words to the erased flash memory
+ * @note The code fetch from the flash bank is stalled while a word is programmed.
+ * Should not be called from interrupts or while the PWM is on
+ *
+ * @param address The address (aligned to a word)
+ * @param data The data
+ * @param words The number of the words
+ *
+ * @return The status of the operation
+ */
+status_t flash_program(uint32_t address, const uint32_t* data, uint32_t words)
+{
+    ARGUMENT_ASSERT(data);
+    HAL_StatusTypeDef status = HAL_OK;
+
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+    for (uint32_t i = 0; i < words && status == HAL_OK; i++)
+    {
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + i * sizeof(uint32_t), data[i]);
+    }
+    HAL_FLASH_Lock();
+    return (status == HAL_OK) ? PFC_SUCCESS : PFC_ERROR_HAL;
+}
+
+/*
+ * @brief Program a half word to the erased flash memory (the bits can be only cleared)
+ * @note The code fetch from the flash bank is stalled while the half word is programmed.
+ * Should not be called from interrupts
+ *
+ * @param address The address (aligned to a half word)
+ * @param data The data
+ *
+ * @return The status of the operation
+ */
+status_t flash_program_halfword(uint32_t address, uint16_t data)
+{
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+    HAL_StatusTypeDef status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address, data);
+    HAL_FLASH_Lock();
+    return (status == HAL_OK) ? PFC_SUCCESS : PFC_ERROR_HAL;
+}
+
+/*
+ * @brief Read the flash memory
+ *
+ * @param address The address
+ * @param[out] data The buffer
+ * @param size The size of the data [bytes]
+ *
+ * @return The status of the operation
+ */
+status_t flash_read(uint32_t address, void* data, uint32_t size)
+{
+    ARGUMENT_ASSERT(data);
+    memcpy(data, (const void*)address, size);
+    return PFC_SUCCESS;
+}
+/** @} */
@@ -0,0 +1,73 @@
+/**
+ * @file flash.h
+ * @author Stanislav Karpikov
+ * @brief Board support package: internal flash memory (header)
+ */
+
+#ifndef _FLASH_H
+#define _FLASH_H
+
+/** @addtogroup hdw_bsp_flash
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/debug.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Erase a flash sector
+ * @note The code fetch from the flash bank is stalled until the sector is erased (up to 2 s for 128 Kbytes).
+ * Should not be called from interrupts or while the PWM is on
+ *
+ * @param address The start address of the sector
+ *
+ * @return The status of the operation
+ */
+status_t flash_erase(uint32_t address);
+
+/**
+ * @brief Program words to the erased flash memory
+ * @note The code fetch from the flash bank is stalled while a word is programmed.
+ * Should not be called from interrupts or while the PWM is on
+ *
+ * @param address The address (aligned to a word)
+ * @param data The data
+ * @param words The number of the words
+ *
+ * @return The status of the operation
+ */
+status_t flash_program(uint32_t address, const uint32_t* data, uint32_t words);
+
+/**
+ * @brief Program a half word to the erased flash memory (the bits can be only cleared)
+ * @note The code fetch from the flash bank is stalled while the half word is programmed.
+ * Should not be called from interrupts
+ *
+ * @param address The address (aligned to a half word)
+ * @param data The data
+ *
+ * @return The status of the operation
+ */
+status_t flash_program_halfword(uint32_t address, uint16_t data);
+
+/**
+ * @brief Read the flash memory
+ *
+ * @param address The address
+ * @param[out] data The buffer
+ * @param size The size of the data [bytes]
+ *
+ * @return The status of the operation
+ */
+status_t flash_read(uint32_t address, void* data, uint32_t size);
+
+/** @} */
+#endif /* _FLASH_H */
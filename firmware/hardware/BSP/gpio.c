@@ -15,6 +15,7 @@
 #include "BSP/gpio.h"
 #include "BSP/bsp.h"
 #include "BSP/debug.h"
+#include "defines.h"
 #include "stm32f7xx_hal.h"
 
 /*--------------------------------------------------------------
@@ -92,7 +93,7 @@ status_t gpio_ventilators_switch_off(void)
  * 
  * @return The status of the operation
  */
-status_t gpio_pwm_test_on(void)
+ITCM_CODE status_t gpio_pwm_test_on(void)
 {
     /* TODO: Test pin can be added to measure PWM set time */
     return PFC_SUCCESS;
@@ -103,7 +104,7 @@ status_t gpio_pwm_test_on(void)
  * 
  * @return The status of the operation
  */
-status_t gpio_pwm_test_off(void)
+ITCM_CODE status_t gpio_pwm_test_off(void)
 {
     /* TODO: Test pin can be added to measure PWM set time */
     return PFC_SUCCESS;
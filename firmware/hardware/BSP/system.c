@@ -14,13 +14,16 @@
 
 #include "BSP/bsp.h"
 #include "BSP/system.h"
+#include "defines.h"
 #include "stm32f7xx_hal.h"
+#include "string.h"
 
 /*--------------------------------------------------------------
                        PRIVATE DEFINES
 --------------------------------------------------------------*/
 
-#define TIME_MAX_VALUE (4133894400000ULL) /**< Maximum time constant (used to exclude wrong packets) */
+#define TIME_MAX_VALUE     (4133894400000ULL) /**< Maximum time constant (used to exclude wrong packets) */
+#define SYSTEM_VECTORS_NUM (128U)              /**< The vector table in the RAM: the exceptions and the interrupts (up to 126), a power of 2 (the VTOR alignment) */
 
 /*--------------------------------------------------------------
                        PRIVATE DATA
@@ -28,6 +31,63 @@
 
 static uint64_t current_time = 0; /**< Time accumulator variable, 64-bit Unix timestamp (with us) */
 
+/** The vector table in the RAM: the interrupts do not fetch the vectors from the flash memory (stalled by an erase) */
+static uint32_t system_vectors[SYSTEM_VECTORS_NUM] DTCM_DATA __attribute__((aligned(SYSTEM_VECTORS_NUM * 4)));
+
+extern const uint32_t __Vectors[];      /**< The vector table in the flash memory (the startup file) */
+extern const uint32_t __Vectors_Size[]; /**< The size of the vector table: the address of the symbol [bytes] */
+extern __IO uint32_t uwTick;            /**< The milliseconds counter of the HAL (not declared by the HAL header) */
+
+/** Compile-time check: the DMA region is an MPU region (the size is a power of 2, the address is aligned to the size) */
+typedef char system_dma_region_check_t[(DMA_REGION_SIZE == (2UL << DMA_REGION_MPU_SIZE) && (DMA_REGION_ADDRESS & (DMA_REGION_SIZE - 1)) == 0) ? 1 : -1];
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Configure the MPU: the DMA region is not cached (the buffers are read and written by the DMA), the rest of
+ * the memory keeps the default map
+ */
+static void system_mpu_init(void)
+{
+    MPU_Region_InitTypeDef region = {0};
+
+    HAL_MPU_Disable();
+
+    region.Enable = MPU_REGION_ENABLE;
+    region.Number = MPU_REGION_NUMBER0;
+    region.BaseAddress = DMA_REGION_ADDRESS;
+    region.Size = DMA_REGION_MPU_SIZE;
+    region.SubRegionDisable = 0x00;
+    region.TypeExtField = MPU_TEX_LEVEL1; /* Normal memory, not cacheable */
+    region.AccessPermission = MPU_REGION_FULL_ACCESS;
+    region.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+    region.IsShareable = MPU_ACCESS_SHAREABLE;
+    region.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+    region.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&region);
+
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+}
+
+/**
+ * @brief Copy the vector table to the RAM and switch the core to it
+ */
+static void system_vectors_init(void)
+{
+    uint32_t size = (uint32_t)__Vectors_Size;
+    if (size > sizeof(system_vectors))
+    {
+        error_handler();
+    }
+    memcpy(system_vectors, __Vectors, size);
+    __DMB();
+    SCB->VTOR = (uint32_t)system_vectors;
+    __DSB();
+    __ISB();
+}
+
 /*--------------------------------------------------------------
                        PUBLIC FUNCTIONS
 --------------------------------------------------------------*/
@@ -75,7 +135,7 @@ void system_set_time(uint64_t time)
  *
  * @return 64-bit Unix timestamp (with us)
  */
-uint64_t system_get_time(void)
+ITCM_CODE uint64_t system_get_time(void)
 {
     ENTER_CRITICAL();
     uint64_t time = current_time;
@@ -83,6 +143,39 @@ uint64_t system_get_time(void)
     return time;
 }
 
+/*
+ * @brief Get the milliseconds counter (wraps in 49 days)
+ * @note The counter is read at once (no critical section), so it is used in the interrupts
+ *
+ * @return The counter value [ms]
+ */
+ITCM_CODE uint32_t system_get_ticks(void)
+{
+    /* The counter of HAL_GetTick: the HAL function is in the flash memory */
+    return uwTick;
+}
+
+/*
+ * @brief Get the cycles counter of the core (wraps in 19 s at 216 MHz)
+ * @note The counter is read at once (no critical section), so it is used in the interrupts
+ *
+ * @return The counter value [cycles]
+ */
+ITCM_CODE uint32_t system_get_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+/*
+ * @brief Get the frequency of the cycles counter
+ *
+ * @return The frequency [Hz]
+ */
+uint32_t system_get_cycles_frequency(void)
+{
+    return SystemCoreClock;
+}
+
 /*
  * @brief Wait for a delay (hard waiting)
  *
@@ -206,10 +299,20 @@ void SystemClock_Config(void)
  */
 status_t system_init(void)
 {
+    /* The vectors are read from the RAM before any interrupt is enabled */
+    system_vectors_init();
+    /* The MPU is configured before the cache is enabled */
+    system_mpu_init();
     HAL_Init();
     SystemClock_Config();
 		SCB_EnableDCache();
 		SCB_DisableDCache();
+
+    /* The cycles counter (the DWT is locked on the Cortex-M7) */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
     return PFC_SUCCESS;
 }
 
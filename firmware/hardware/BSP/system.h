@@ -45,6 +45,29 @@ status_t system_delay_ticks(uint32_t delay_ticks);
  */
 uint64_t system_get_time(void);
 
+/**
+ * @brief Get the milliseconds counter (wraps in 49 days)
+ * @note The counter is read at once (no critical section), so it is used in the interrupts
+ *
+ * @return The counter value [ms]
+ */
+uint32_t system_get_ticks(void);
+
+/**
+ * @brief Get the cycles counter of the core (wraps in 19 s at 216 MHz)
+ * @note The counter is read at once (no critical section), so it is used in the interrupts
+ *
+ * @return The counter value [cycles]
+ */
+uint32_t system_get_cycles(void);
+
+/**
+ * @brief Get the frequency of the cycles counter
+ *
+ * @return The frequency [Hz]
+ */
+uint32_t system_get_cycles_frequency(void);
+
 /**
  * @brief Increment the time tick
  */
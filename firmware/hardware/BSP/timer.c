@@ -553,7 +553,7 @@ void HAL_TIM_PWM_MspDeInit(TIM_HandleTypeDef* htim)
  *
  * @return The status of the operation
  */
-status_t timer_write_pwm(uint32_t ccr1, uint32_t ccr2, uint32_t ccr3)
+ITCM_CODE status_t timer_write_pwm(uint32_t ccr1, uint32_t ccr2, uint32_t ccr3)
 {
 #ifndef PWM_MOCKING
     TIMER_PWM->CCR1 = ccr1;
@@ -621,6 +621,21 @@ status_t timer_disable_pwm(void)
     return PFC_SUCCESS;
 }
 
+/*
+ * @brief Force the PWM outputs to the inactive state immediately (the software break event)
+ * @note Used in interrupts for the fault shutdown. The outputs are enabled by timer_restore_pwm
+ *
+ * @return The status of the operation
+ */
+ITCM_CODE status_t timer_trip_pwm(void)
+{
+#ifndef PWM_MOCKING
+    /* MOE is cleared by the hardware: the outputs go to the idle state (OSSI) at once */
+    TIMER_PWM->EGR = TIM_EGR_BG;
+#endif
+    return PFC_SUCCESS;
+}
+
 /*
  * @brief Start timer for the ADC module
  *
@@ -43,6 +43,14 @@ status_t timer_start_adc_timer(void);
  */
 status_t timer_disable_pwm(void);
 
+/**
+ * @brief Force the PWM outputs to the inactive state immediately (the software break event)
+ * @note Used in interrupts for the fault shutdown. The outputs are enabled by timer_restore_pwm
+ *
+ * @return The status of the operation
+ */
+status_t timer_trip_pwm(void);
+
 /**
  * @brief Enable PWM (after disabling)
  *
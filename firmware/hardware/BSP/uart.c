@@ -16,6 +16,7 @@
 
 #include "BSP/bsp.h"
 #include "BSP/debug.h"
+#include "BSP/dma.h"
 #include "defines.h"
 #include "stm32f7xx_hal.h"
 #include "string.h"
@@ -25,27 +26,39 @@
 --------------------------------------------------------------*/
 
 #define UART_INTERFACE_TIMEOUT               (2000)  /**< Timeout [ms] while writing to the interface output */
+#define UART_INTERFACE_TX_DMA                (1)     /**< Set to 0 to transmit with the blocking calls (the main loop waits for the end) */
 #define UART_DEBUG_TIMEOUT                   (2000)  /**< Timeout [ms] while writing to the debug output */
 #define USE_INTERFACE_AS_DEBUG               (0)     /**< Set to 1 to use the interface output as a debug output */
-#define UART_INTERFACE_BUFFER_DEFAULT_FILLER (0xFF)  /**< The default value to fill the buffer */
-#define RX_BUFFER_SIZE                       (0x3FF) /**< The size of the receive buffer, 0x3FF by default */
-#define TX_BUFFER_SIZE                       (0x3FF) /**< The size of the transmit buffer, 0x3FF by default */
+#define RX_BUFFER_SIZE                       (0x400) /**< The size of the receive buffer (should be a power of 2) */
 
 /*--------------------------------------------------------------
                        PRIVATE TYPES
 --------------------------------------------------------------*/
 
+/** A data block queued to transmit */
+typedef struct
+{
+    uint8_t* data;   /**< The data (read by the DMA, should not be changed until the block is transmitted) */
+    uint16_t length; /**< The size of the data */
+} uart_tx_block_t;
+
+/** Compile-time check: the queue positions are free-running counters */
+typedef char uart_tx_queue_check_t[((UART_INTERFACE_TX_QUEUE_SIZE & (UART_INTERFACE_TX_QUEUE_SIZE - 1)) == 0) ? 1 : -1];
+
+/** Compile-time check: the received bytes counter is free-running, the buffer fits the DMA region */
+typedef char uart_rx_buffer_check_t[((RX_BUFFER_SIZE & (RX_BUFFER_SIZE - 1)) == 0 && RX_BUFFER_SIZE <= DMA_REGION_SIZE) ? 1 : -1];
+
 /** UART port structure */
 typedef struct
 {
-    uint8_t tx_buffer[TX_BUFFER_SIZE]; /**< Transmit buffer */
-    uint8_t tx_index;                  /**< The next read position */
-    uint8_t tx_end;                    /**< The end position in the transmit buffer */
-
-    uint16_t rx_buffer[RX_BUFFER_SIZE]; /**< Receive buffer */
-    int rx_index;                       /**< The next write position */
-    int rx_readed;                      /**< The next read position */
-    uint8_t rx_overflow;                /**< 0 - normal, 1 - rx buffer overflow */
+    uart_tx_block_t tx_queue[UART_INTERFACE_TX_QUEUE_SIZE]; /**< The blocks to transmit */
+    volatile uint32_t tx_head;                              /**< The number of the blocks queued (the main loop) */
+    volatile uint32_t tx_tail;                              /**< The number of the blocks transmitted (the interrupt) */
+    volatile uint8_t tx_busy;                               /**< A DMA transfer is running */
+    volatile uint32_t tx_start_time;                        /**< The start time of the DMA transfer [ms] */
+
+    volatile uint32_t rx_received; /**< The number of the bytes received (published by the interrupts) */
+    uint32_t rx_readed;            /**< The number of the bytes read */
 } mcu_port_t;
 
 /*--------------------------------------------------------------
@@ -57,65 +70,143 @@ static DMA_HandleTypeDef hdma_usart_interface_rx = {0}; /**< Interface output re
 static DMA_HandleTypeDef hdma_usart_interface_tx = {0}; /**< Interface output transmit DMA handle */
 static mcu_port_t mcu_port = {0};                       /**< Port instance */
 
+static uint8_t uart_rx_buffer[RX_BUFFER_SIZE] DMA_BUFFER; /**< Receive buffer (the circular DMA, not cached) */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Drop the queued blocks, release the RS-485 driver
+ * @note Called from the interrupts or with the interrupts disabled
+ */
+static void uart_interface_tx_reset(void)
+{
+    mcu_port.tx_tail = mcu_port.tx_head;
+    mcu_port.tx_busy = 0;
+    HAL_GPIO_WritePin(RE_485_GPIO_Port, RE_485_Pin, GPIO_PIN_RESET);
+}
+
+/**
+ * @brief Start the DMA transfer of the next queued block, release the RS-485 driver if the queue is empty
+ * @note Called from the transmission complete interrupt or with the interrupts disabled
+ */
+static void uart_interface_tx_next(void)
+{
+    if (mcu_port.tx_tail == mcu_port.tx_head)
+    {
+        mcu_port.tx_busy = 0;
+        HAL_GPIO_WritePin(RE_485_GPIO_Port, RE_485_Pin, GPIO_PIN_RESET);
+        return;
+    }
+
+    uart_tx_block_t* block = &mcu_port.tx_queue[mcu_port.tx_tail % UART_INTERFACE_TX_QUEUE_SIZE];
+    mcu_port.tx_busy = 1;
+    mcu_port.tx_start_time = HAL_GetTick();
+    HAL_GPIO_WritePin(RE_485_GPIO_Port, RE_485_Pin, GPIO_PIN_SET);
+    if (HAL_UART_Transmit_DMA(&huart_interface, block->data, block->length) != HAL_OK)
+    {
+        /* The panel repeats the requests without the answers */
+        uart_interface_tx_reset();
+    }
+}
+
+/**
+ * @brief Publish the bytes written by the receive DMA (the idle line, the half and the full buffer interrupts)
+ * @note The interrupts are at least every half of the buffer, so the position of the DMA is not ambiguous
+ */
+static void uart_interface_rx_publish(void)
+{
+    /* The interrupts have different priorities: the counter is read in the section, so a preempting interrupt can not
+     * publish a newer position between the read and the update */
+    ENTER_CRITICAL();
+    uint32_t index = RX_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(&hdma_usart_interface_rx);
+    mcu_port.rx_received += (index - mcu_port.rx_received) & (RX_BUFFER_SIZE - 1);
+    EXIT_CRITICAL();
+}
+
 /*--------------------------------------------------------------
                        PUBLIC FUNCTIONS
 --------------------------------------------------------------*/
 
 /*
- * @brief Get received byte (the oldest one)
+ * @brief Get the received data: the oldest contiguous span of the bytes not read yet
+ * @note The span is kept until it is released with uart_interface_rx_release
  *
- * @param byte A byte read from the interface
+ * @param[out] data The span
+ * @param[out] length The size of the span
  *
- * @return The status of the operation
+ * @return The status of the operation: PFC_NULL if no data, PFC_WARNING if the buffer has been overflowed (the data is dropped)
  */
-status_t uart_interface_get_byte(uint8_t* byte)
+status_t uart_interface_get_data(const uint8_t** data, uint32_t* length)
 {
-    ARGUMENT_ASSERT(byte);
-    /*
-    if (mcu_port.rx_overflow) {
-        mcu_port.rx_overflow = 0;
-        mcu_port.rx_readed = mcu_port.rx_index;
-        return PFC_WARNING;
-    }
-    */
-    if (mcu_port.rx_buffer[mcu_port.rx_readed] != 0xFFFF)
+    ARGUMENT_ASSERT(data);
+    ARGUMENT_ASSERT(length);
+
+    uint32_t received = mcu_port.rx_received;
+    uint32_t count = received - mcu_port.rx_readed;
+    if (count == 0) return PFC_NULL;
+    if (count >= RX_BUFFER_SIZE)
     {
-        *byte = mcu_port.rx_buffer[mcu_port.rx_readed] & 0xFF;
-        mcu_port.rx_buffer[mcu_port.rx_readed] = 0xFFFF;
-        mcu_port.rx_readed++;
-        if (mcu_port.rx_readed == RX_BUFFER_SIZE)
-        {
-						SCB_CleanDCache_by_Addr((uint32_t*)mcu_port.rx_buffer, sizeof(mcu_port.rx_buffer));
-						SCB_InvalidateDCache_by_Addr((uint32_t*)mcu_port.rx_buffer, sizeof(mcu_port.rx_buffer));
-	
-            mcu_port.rx_readed = 0;
-        }
-        return PFC_SUCCESS;
+        mcu_port.rx_readed = received;
+        return PFC_WARNING;
     }
-    return PFC_NULL;
+
+    uint32_t position = mcu_port.rx_readed & (RX_BUFFER_SIZE - 1);
+    if (count > RX_BUFFER_SIZE - position) count = RX_BUFFER_SIZE - position;
+
+    *data = &uart_rx_buffer[position];
+    *length = count;
+    return PFC_SUCCESS;
 }
 
 /*
- * @brief Init receiving process
+ * @brief Release the bytes read from the span
  *
- * @param byte A byte read from the interface
+ * @param length The number of the bytes read
+ */
+void uart_interface_rx_release(uint32_t length)
+{
+    mcu_port.rx_readed += length;
+}
+
+/*
+ * @brief Init receiving process: the circular DMA, the idle line interrupt
  *
  * @return The status of the operation
  */
 status_t uart_interface_rx_init(void)
 {
-	  SCB_CleanDCache_by_Addr((uint32_t*)mcu_port.rx_buffer, sizeof(mcu_port.rx_buffer));
-    SCB_InvalidateDCache_by_Addr((uint32_t*)mcu_port.rx_buffer, sizeof(mcu_port.rx_buffer));
-	
-    memset(mcu_port.rx_buffer, UART_INTERFACE_BUFFER_DEFAULT_FILLER, sizeof(mcu_port.rx_buffer));
     HAL_GPIO_WritePin(RE_485_GPIO_Port, RE_485_Pin, GPIO_PIN_RESET);
-    HAL_UART_Receive_DMA(&huart_interface, (uint8_t*)mcu_port.rx_buffer, RX_BUFFER_SIZE);
-
+    mcu_port.rx_received = 0;
     mcu_port.rx_readed = 0;
+    HAL_UART_Receive_DMA(&huart_interface, uart_rx_buffer, RX_BUFFER_SIZE);
+    __HAL_UART_CLEAR_IDLEFLAG(&huart_interface);
+    __HAL_UART_ENABLE_IT(&huart_interface, UART_IT_IDLE);
 
     return PFC_SUCCESS;
 }
 
+/**
+ * @brief Reception half complete callback (the first half of the buffer is written)
+ *
+ * @param huart A pointer to the UART hardware handler
+ */
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef* huart)
+{
+    uart_interface_rx_publish();
+}
+
+/**
+ * @brief Reception complete callback (the buffer is written, the DMA continues from the start)
+ *
+ * @param huart A pointer to the UART hardware handler
+ */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart)
+{
+    uart_interface_rx_publish();
+}
+
 /**
  * @brief Error callback
  *
@@ -124,6 +215,7 @@ status_t uart_interface_rx_init(void)
 void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart)
 {
     HAL_UART_DMAStop(huart);
+    uart_interface_tx_reset();
     HAL_UART_DeInit(huart);
     HAL_UART_MspDeInit(huart);
     uart_init();
@@ -131,34 +223,75 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart)
 }
 
 /**
- * @brief Transmission complete callback
+ * @brief Transmission complete callback (the last stop bit is sent): start the next block or release the RS-485 driver
  *
  * @param huart A pointer to the UART hardware handler
  */
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart)
 {
+#if UART_INTERFACE_TX_DMA == 1
+    mcu_port.tx_tail++;
+    uart_interface_tx_next();
+#else
     HAL_GPIO_WritePin(RE_485_GPIO_Port, RE_485_Pin, GPIO_PIN_RESET);
+#endif
 }
 
 /*
- * @brief Transmit data to the interface UART
+ * @brief Transmit data to the interface UART: queue the block for the DMA transfer
+ * @note The data is not copied: it should not be changed until the block is transmitted
+ * (UART_INTERFACE_TX_QUEUE_SIZE blocks can be queued), it should be in the DMA region (DMA_BUFFER)
  *
  * @param data The data block pointer
  * @param length The size of the data block
  *
- * @return The status of the operation
+ * @return The status of the operation: PFC_NULL if the queue is full, PFC_ERROR_DATA if the block is not in the DMA region
  */
 status_t uart_interface_transmit(uint8_t* data, uint32_t length)
 {
     ARGUMENT_ASSERT(data);
 
+#if UART_INTERFACE_TX_DMA == 1
+    /* The DMA reads the memory: the block should not be cached */
+    if (length == 0 || length > UINT16_MAX || !dma_is_buffer(data, length)) return PFC_ERROR_DATA;
+    if (mcu_port.tx_head - mcu_port.tx_tail >= UART_INTERFACE_TX_QUEUE_SIZE) return PFC_NULL;
+
+    uart_tx_block_t* block = &mcu_port.tx_queue[mcu_port.tx_head % UART_INTERFACE_TX_QUEUE_SIZE];
+    block->data = data;
+    block->length = length;
+
+    ENTER_CRITICAL();
+    mcu_port.tx_head++;
+    if (!mcu_port.tx_busy) uart_interface_tx_next();
+    EXIT_CRITICAL();
+#else
     HAL_GPIO_WritePin(RE_485_GPIO_Port, RE_485_Pin, GPIO_PIN_SET);
     if (HAL_UART_Transmit(&huart_interface, data, length, UART_INTERFACE_TIMEOUT) != HAL_OK)
     {
         return PFC_ERROR_HAL;
     };
     HAL_GPIO_WritePin(RE_485_GPIO_Port, RE_485_Pin, GPIO_PIN_RESET);
+#endif
+
+    return PFC_SUCCESS;
+}
 
+/*
+ * @brief Check if a block can be queued to transmit (the back-pressure)
+ * @note The interface is restarted if a transfer is not finished in time (the queued blocks are dropped)
+ *
+ * @return PFC_SUCCESS if a block can be queued, PFC_NULL if the queue is full
+ */
+status_t uart_interface_tx_ready(void)
+{
+#if UART_INTERFACE_TX_DMA == 1
+    if (mcu_port.tx_busy && (HAL_GetTick() - mcu_port.tx_start_time) > UART_INTERFACE_TIMEOUT)
+    {
+        /* The transfer is lost: restart the interface */
+        HAL_UART_ErrorCallback(&huart_interface);
+    }
+    if (mcu_port.tx_head - mcu_port.tx_tail >= UART_INTERFACE_TX_QUEUE_SIZE) return PFC_NULL;
+#endif
     return PFC_SUCCESS;
 }
 
@@ -220,8 +353,8 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
         hdma_usart_interface_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
         hdma_usart_interface_rx.Init.PeriphInc = DMA_PINC_DISABLE;
         hdma_usart_interface_rx.Init.MemInc = DMA_MINC_ENABLE;
-        hdma_usart_interface_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
-        hdma_usart_interface_rx.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+        hdma_usart_interface_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        hdma_usart_interface_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
         hdma_usart_interface_rx.Init.Mode = DMA_CIRCULAR;
         hdma_usart_interface_rx.Init.Priority = DMA_PRIORITY_LOW;
         hdma_usart_interface_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
@@ -308,6 +441,12 @@ status_t uart_init(void)
  */
 void USART_INTERFACE_IRQ(void)
 {
+    if (__HAL_UART_GET_FLAG(&huart_interface, UART_FLAG_IDLE))
+    {
+        /* The end of a request: the received bytes are given to the protocol without waiting for the half buffer */
+        __HAL_UART_CLEAR_IDLEFLAG(&huart_interface);
+        uart_interface_rx_publish();
+    }
     HAL_UART_IRQHandler(&huart_interface);
 }
 
@@ -320,7 +459,7 @@ void USART_INTERFACE_DMA_RX_IRQ(void)
 }
 
 /**
- * @brief This function handles interface USART RX DMA global interrupt.
+ * @brief This function handles interface USART TX DMA global interrupt.
  */
 void USART_INTERFACE_DMA_TX_IRQ(void)
 {
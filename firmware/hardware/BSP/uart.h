@@ -18,20 +18,36 @@
 #include "BSP/debug.h"
 #include "stdint.h"
 
+/*--------------------------------------------------------------
+                       PUBLIC DEFINES
+--------------------------------------------------------------*/
+
+#define UART_INTERFACE_TX_QUEUE_SIZE (4U) /**< The number of the blocks queued to transmit (should be a power of 2) */
+
 /*--------------------------------------------------------------
                        PUBLIC FUNCTIONS
 --------------------------------------------------------------*/
 
 /**
- * @brief Transmit data to the interface UART
+ * @brief Transmit data to the interface UART: queue the block for the DMA transfer
+ * @note The data is not copied: it should not be changed until the block is transmitted
+ * (UART_INTERFACE_TX_QUEUE_SIZE blocks can be queued), it should be in the DMA region (DMA_BUFFER)
  *
  * @param data The data block pointer
  * @param length The size of the data block
  *
- * @return The status of the operation
+ * @return The status of the operation: PFC_NULL if the queue is full, PFC_ERROR_DATA if the block is not in the DMA region
  */
 status_t uart_interface_transmit(uint8_t* data, uint32_t length);
 
+/**
+ * @brief Check if a block can be queued to transmit (the back-pressure)
+ * @note The interface is restarted if a transfer is not finished in time (the queued blocks are dropped)
+ *
+ * @return PFC_SUCCESS if a block can be queued, PFC_NULL if the queue is full
+ */
+status_t uart_interface_tx_ready(void);
+
 /**
  * @brief Transmit data to the interface UART
  *
@@ -50,22 +66,29 @@ status_t uart_debug_transmit(uint8_t* data, uint32_t length);
 status_t uart_init(void);
 
 /**
- * @brief Init receiving process
- *
- * @param byte A byte read from the interface
+ * @brief Init receiving process: the circular DMA, the idle line interrupt
  *
  * @return The status of the operation
  */
 status_t uart_interface_rx_init(void);
 
 /**
- * @brief Get received byte (the oldest one)
+ * @brief Get the received data: the oldest contiguous span of the bytes not read yet
+ * @note The span is kept until it is released with uart_interface_rx_release
  *
- * @param byte A byte read from the interface
+ * @param[out] data The span
+ * @param[out] length The size of the span
  *
- * @return The status of the operation
+ * @return The status of the operation: PFC_NULL if no data, PFC_WARNING if the buffer has been overflowed (the data is dropped)
+ */
+status_t uart_interface_get_data(const uint8_t** data, uint32_t* length);
+
+/**
+ * @brief Release the bytes read from the span
+ *
+ * @param length The number of the bytes read
  */
-status_t uart_interface_get_byte(uint8_t* byte);
+void uart_interface_rx_release(uint32_t length);
 
 /** @} */
 #endif /* _UART_H */
@@ -0,0 +1,32 @@
+/**
+ * @file board.h
+ * @author Stanislav Karpikov
+ * @brief The board selection and the memory map of the board
+ *
+ * @note Only the preprocessor directives are allowed: the scatter file is preprocessed with this header
+ */
+
+#ifndef _BOARD_H
+#define _BOARD_H
+
+/** @addtogroup hdw_bsp_board
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#undef BOARD_STM32F767_MAIN /**< Define to use the main production board */
+#define BOARD_STM32F723_DISCO /**< Define to use the STM32F723E-DISCO development board */
+
+#if defined(BOARD_STM32F767_MAIN)
+#include "memory_stm32f765_main_v0_2.h"
+#elif defined(BOARD_STM32F723_DISCO)
+#include "memory_stm32f723_disco.h"
+#else
+#error "Please define the board"
+#endif
+
+/** @} */
+#endif /* _BOARD_H */
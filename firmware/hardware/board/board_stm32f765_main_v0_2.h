@@ -41,6 +41,32 @@
 #define EEPROM_PAGE_SIZE      ((uint32_t)8 * 1024)   /**< EEPROM memory storage size: 8 Kbytes */
 #define EEPROM_PAGE_FULL_SIZE ((uint32_t)256 * 1024) /**< EEPROM memory storage full size: 256 Kbytes */
 
+/*--------------------------------------------------------------
+											PUBLIC DEFINES::JOURNAL
+--------------------------------------------------------------*/
+
+#define JOURNAL_START_ADDRESS ((uint32_t)(0x081C0000)) /**< The start address of the events journal (after the EEPROM block) */
+#define JOURNAL_SECTOR_SIZE   ((uint32_t)128 * 1024)   /**< The size of a journal sector: 128 Kbytes */
+#define JOURNAL_SECTORS_NUM   (2U)                     /**< The number of the journal sectors */
+
+/*--------------------------------------------------------------
+											PUBLIC DEFINES::MEMORY
+--------------------------------------------------------------*/
+
+#define DMA_REGION_ADDRESS  ((uint32_t)(MEMORY_DMA_ADDRESS)) /**< The start address of the DMA buffers (SRAM2, the memory map) */
+#define DMA_REGION_SIZE     ((uint32_t)(MEMORY_DMA_SIZE))   /**< The size of the DMA buffers region: 16 Kbytes */
+#define DMA_REGION_MPU_SIZE (MPU_REGION_SIZE_16KB)           /**< The size of the MPU region of the DMA buffers (should match DMA_REGION_SIZE) */
+
+#define ITCM_SIZE ((uint32_t)(MEMORY_ITCM_SIZE)) /**< The size of the ITCM RAM (the code of the control interrupt): 16 Kbytes */
+#define DTCM_SIZE ((uint32_t)(MEMORY_DTCM_SIZE)) /**< The size of the DTCM RAM (the data of the control interrupt): 128 Kbytes */
+
+/*--------------------------------------------------------------
+											PUBLIC DEFINES::CAPTURE
+--------------------------------------------------------------*/
+
+#define CAPTURE_PERIODS   (4U) /**< The length of a waveform capture [grid periods] */
+#define CAPTURE_SLOTS_NUM (4U) /**< The number of the waveform capture slots in RAM (160 Kbytes), one is being recorded */
+
 /*--------------------------------------------------------------
 											PUBLIC DEFINES::GPIO
 --------------------------------------------------------------*/
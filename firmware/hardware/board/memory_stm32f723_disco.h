@@ -0,0 +1,34 @@
+/**
+ * @file memory_stm32f723_disco.h
+ * @author Stanislav Karpikov
+ * @brief The memory map of the STM32F723E-DISCO development board
+ *
+ * @note Only the plain numbers are allowed: the scatter file is preprocessed with this header
+ */
+
+#ifndef _MEMORY_STM32F723_DISCO_H
+#define _MEMORY_STM32F723_DISCO_H
+
+/** @addtogroup hdw_bsp_board
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       PUBLIC DEFINES
+--------------------------------------------------------------*/
+
+#define MEMORY_ROM1_ADDRESS  0x08000000 /**< The program, part 1: the flash sectors 0, 1 (before the EEPROM sectors 2, 3) */
+#define MEMORY_ROM1_SIZE     0x00008000 /**< The size of the program part 1: 32 Kbytes */
+#define MEMORY_ROM2_ADDRESS  0x08010000 /**< The program, part 2: the flash sectors 4, 5 (before the journal sectors 6, 7) */
+#define MEMORY_ROM2_SIZE     0x00030000 /**< The size of the program part 2: 192 Kbytes */
+#define MEMORY_ITCM_ADDRESS  0x00000000 /**< The ITCM RAM (the code of the control interrupt) */
+#define MEMORY_ITCM_SIZE     0x00004000 /**< The size of the ITCM RAM: 16 Kbytes */
+#define MEMORY_DTCM_ADDRESS  0x20000000 /**< The DTCM RAM (the data of the control interrupt) */
+#define MEMORY_DTCM_SIZE     0x00010000 /**< The size of the DTCM RAM: 64 Kbytes */
+#define MEMORY_SRAM1_ADDRESS 0x20010000 /**< The SRAM1 (the data, the stack) */
+#define MEMORY_SRAM1_SIZE    0x0002C000 /**< The size of the SRAM1: 176 Kbytes */
+#define MEMORY_DMA_ADDRESS   0x2003C000 /**< The DMA buffers: the SRAM2 (not cached by the MPU) */
+#define MEMORY_DMA_SIZE      0x00004000 /**< The size of the DMA buffers region: 16 Kbytes */
+
+/** @} */
+#endif /* _MEMORY_STM32F723_DISCO_H */
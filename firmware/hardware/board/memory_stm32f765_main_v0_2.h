@@ -0,0 +1,34 @@
+/**
+ * @file memory_stm32f765_main_v0_2.h
+ * @author Stanislav Karpikov
+ * @brief The memory map of the main production board
+ *
+ * @note Only the plain numbers are allowed: the scatter file is preprocessed with this header
+ */
+
+#ifndef _MEMORY_STM32F765_MAIN_H
+#define _MEMORY_STM32F765_MAIN_H
+
+/** @addtogroup hdw_bsp_board
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       PUBLIC DEFINES
+--------------------------------------------------------------*/
+
+#define MEMORY_ROM1_ADDRESS  0x08000000 /**< The program, part 1: the first flash bank */
+#define MEMORY_ROM1_SIZE     0x00100000 /**< The size of the program part 1: 1 Mbyte */
+#define MEMORY_ROM2_ADDRESS  0x08100000 /**< The program, part 2: the second flash bank up to the EEPROM block */
+#define MEMORY_ROM2_SIZE     0x00080000 /**< The size of the program part 2: 512 Kbytes */
+#define MEMORY_ITCM_ADDRESS  0x00000000 /**< The ITCM RAM (the code of the control interrupt) */
+#define MEMORY_ITCM_SIZE     0x00004000 /**< The size of the ITCM RAM: 16 Kbytes */
+#define MEMORY_DTCM_ADDRESS  0x20000000 /**< The DTCM RAM (the data of the control interrupt) */
+#define MEMORY_DTCM_SIZE     0x00020000 /**< The size of the DTCM RAM: 128 Kbytes */
+#define MEMORY_SRAM1_ADDRESS 0x20020000 /**< The SRAM1 (the data, the stack) */
+#define MEMORY_SRAM1_SIZE    0x0005C000 /**< The size of the SRAM1: 368 Kbytes */
+#define MEMORY_DMA_ADDRESS   0x2007C000 /**< The DMA buffers: the SRAM2 (not cached by the MPU) */
+#define MEMORY_DMA_SIZE      0x00004000 /**< The size of the DMA buffers region: 16 Kbytes */
+
+/** @} */
+#endif /* _MEMORY_STM32F765_MAIN_H */
@@ -91,7 +91,7 @@
 
 /*!< Uncomment the following line if you need to relocate your vector Table in
      Internal SRAM. */
-/* #define VECT_TAB_SRAM */
+/* #define VECT_TAB_SRAM */ /* The table is copied to the DTCM RAM by system_init (BSP/system.c) */
 #define VECT_TAB_OFFSET 0x00 /*!< Vector Table base offset field. \
                                   This value must be a multiple of 0x200. */
                              /******************************************************************************/
@@ -7,7 +7,7 @@
 /** @addtogroup mdw_eeprom_emulation
  * @{
  */
- 
+
 
 /** NOTE: See http://www.st.com/web/en/resource/technical/document/application_note/CD00165693.pdf */
 
@@ -17,28 +17,40 @@
 
 #include "eeprom_emulation.h"
 #include "BSP/bsp.h"
-#include "BSP/system.h"
-#include "stm32f7xx_hal.h"
+#include "BSP/flash.h"
+#include "string.h"
 
 /*--------------------------------------------------------------
                        DEFINES
 --------------------------------------------------------------*/
 
-#define __IO volatile
-
 #define EEPROM_PAGE0_BASE ((uint32_t)(EEPROM_START_ADDRESS))                         /**< EEPROM memory storage: the first page address */
 #define EEPROM_PAGE1_BASE ((uint32_t)(EEPROM_START_ADDRESS + EEPROM_PAGE_FULL_SIZE)) /**< EEPROM memory storage: the second page address */
 
 #define EEPROM_DEFAULT_DATA (0xFFFF) /**< Default data. Should be 0xFFFF due to the flash technology limitations */
 
+#define EEPROM_HEADER_SIZE (4U)                                                 /**< The page header: the page status and the erase counter */
+#define EEPROM_SLOT_SIZE   (4U)                                                 /**< A slot: the data and the virtual address (16 bit each) */
+#define EEPROM_SLOTS_NUM   ((EEPROM_PAGE_SIZE - EEPROM_HEADER_SIZE) / EEPROM_SLOT_SIZE) /**< The number of the slots in a page */
+#define EEPROM_EMPTY_SLOT  (0xFFFFFFFFU)                                        /**< The contents of an empty slot */
+
 /*--------------------------------------------------------------
                        PRIVATE DATA
 --------------------------------------------------------------*/
 
 static uint32_t page_base_first = EEPROM_PAGE0_BASE;    /**< The first page address */
 static uint32_t page_base_second = EEPROM_PAGE1_BASE;   /**< The second page address */
-static uint32_t page_size = EEPROM_PAGE_SIZE;           /**< The size of a page */
 static eeprom_status_t eeprom_status = EEPROM_NOT_INIT; /**< The EEPROM module status */
+static uint8_t erase_allowed = 1;                       /**< The page transfer (an erase) is allowed */
+
+/*
+ * The RAM index of the valid page: the last slot of every variable. It is built by eeprom_init (a single pass over
+ * the page) and updated by the writes, so a read or an update takes a single flash read instead of a page scan
+ */
+static uint32_t valid_page = 0;                          /**< The valid page address */
+static uint16_t variable_slot[EEPROM_VARIABLES_NUM];     /**< The last slot of every variable + 1, 0 - not stored */
+static uint16_t variables_count = 0;                     /**< The number of the variables stored */
+static uint16_t free_slot = 0;                           /**< The first empty slot of the valid page */
 
 /*--------------------------------------------------------------
                        PRIVATE TYPES
@@ -60,29 +72,12 @@ typedef enum
  * @brief Connection to the flash adapter: erate a page
  *
  * @param page_base The address of the memory range to erase
- * 
+ *
  * @return The status of the operation
  */
 static eeprom_status_t eeprom_adapter_erase(uint32_t page_base)
 {
-    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
-
-    FLASH_EraseInitTypeDef EraseInitStruct;
-    uint32_t page_error = 0;
-    EraseInitStruct.TypeErase = FLASH_TYPEERASE_SECTORS;
-    EraseInitStruct.NbSectors = 1;
-    EraseInitStruct.Sector = (page_base == EEPROM_PAGE0_BASE) ? EEPROM_PAGE0_SECTOR : EEPROM_PAGE1_SECTOR;
-    EraseInitStruct.VoltageRange = FLASH_VOLTAGE_RANGE_3;
-
-    ENTER_CRITICAL();
-    if (HAL_FLASHEx_Erase(&EraseInitStruct, &page_error) != HAL_OK)
-    {
-        //EEPROM_LOG( "HAL_FLASHEx_Erase Err: %X, %X\n",HAL_FLASH_GetError(),page_error);
-        EXIT_CRITICAL();
-        return EEPROM_BAD_FLASH;
-    }
-    EXIT_CRITICAL();
-    return EEPROM_OK;
+    return (flash_erase(page_base) == PFC_SUCCESS) ? EEPROM_OK : EEPROM_BAD_FLASH;
 }
 
 /**
@@ -90,44 +85,77 @@ static eeprom_status_t eeprom_adapter_erase(uint32_t page_base)
  *
  * @param page_base The address of the half word
  * @param data The data to be wriiten
- * 
+ *
  * @return The status of the operation
  */
-static eeprom_status_t eeprom_adapter_program_halfword(uint32_t page_base, uint32_t data)
+static eeprom_status_t eeprom_adapter_program_halfword(uint32_t page_base, uint16_t data)
 {
-    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+    return (flash_program_halfword(page_base, data) == PFC_SUCCESS) ? EEPROM_OK : EEPROM_BAD_FLASH;
+}
 
-    ENTER_CRITICAL();
-    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, page_base, data) != HAL_OK)
-    {
-        //EEPROM_LOG("Write error at 0x%08X\n",page_base);
-        EXIT_CRITICAL();
-        return EEPROM_BAD_FLASH;
-    }
-    EXIT_CRITICAL();
-    return EEPROM_OK;
+/**
+ * @brief Connection to the flash adapter: read a half word (16 bit)
+ *
+ * @param address The address of the half word
+ *
+ * @return The data
+ */
+static uint16_t eeprom_adapter_read_halfword(uint32_t address)
+{
+    uint16_t data = EEPROM_DEFAULT_DATA;
+    flash_read(address, &data, sizeof(data));
+    return data;
 }
 
 /**
- * @brief Unlock the flash memory
+ * @brief Connection to the flash adapter: read a slot (the data in the lower half word, the address in the upper one)
  *
- * @return The status of the operation
+ * @param address The address of the slot
+ *
+ * @return The contents of the slot
  */
-static eeprom_status_t eeprom_flash_unlock(void)
+static uint32_t eeprom_adapter_read_slot(uint32_t address)
 {
-    HAL_FLASH_Unlock();
-    return EEPROM_OK;
+    uint32_t slot = EEPROM_EMPTY_SLOT;
+    flash_read(address, &slot, sizeof(slot));
+    return slot;
 }
 
 /**
- * @brief Lock the flash memory
+ * @brief Get the address of a slot
  *
- * @return The status of the operation
+ * @param page_base The address of the page
+ * @param slot The number of the slot
+ *
+ * @return The address of the slot
  */
-static eeprom_status_t eeprom_flash_lock(void)
+static uint32_t eeprom_slot_address(uint32_t page_base, uint16_t slot)
 {
-    HAL_FLASH_Lock();
-    return EEPROM_OK;
+    return page_base + EEPROM_HEADER_SIZE + (uint32_t)slot * EEPROM_SLOT_SIZE;
+}
+
+/**
+ * @brief Build the RAM index of the valid page: a single pass over the written slots
+ *
+ * @param page_base The address of the valid page
+ */
+static void eeprom_index_build(uint32_t page_base)
+{
+    memset(variable_slot, 0, sizeof(variable_slot));
+    variables_count = 0;
+    valid_page = page_base;
+
+    /* The slots are written in turn: the first empty one ends the data */
+    for (free_slot = 0; free_slot < EEPROM_SLOTS_NUM; free_slot++)
+    {
+        uint32_t slot = eeprom_adapter_read_slot(eeprom_slot_address(page_base, free_slot));
+        if (slot == EEPROM_EMPTY_SLOT) break;
+
+        uint16_t address = (uint16_t)(slot >> 16);
+        if (address >= EEPROM_VARIABLES_NUM) continue;  // the power off after the data write, or an unknown variable
+        if (!variable_slot[address]) variables_count++;
+        variable_slot[address] = free_slot + 1;
+    }
 }
 
 /**
@@ -141,13 +169,13 @@ static eeprom_status_t eeprom_flash_lock(void)
   */
 static int eeprom_check_page(uint32_t page_base, uint16_t status)
 {
-    uint32_t page_end = page_base + (uint32_t)EEPROM_PAGE_SIZE;
+    uint16_t page_status = eeprom_adapter_read_halfword(page_base);
 
     // Page eeprom_status not EEPROM_ERASED and not a "state"
-    if ((*(__IO uint16_t *)page_base) != EEPROM_ERASED && (*(__IO uint16_t *)page_base) != status)
+    if (page_status != EEPROM_ERASED && page_status != status)
         return -1;
-    for (page_base += 4; page_base < page_end; page_base += 4)
-        if ((*(__IO uint32_t *)page_base) != 0xFFFFFFFF)  // Verify if slot is empty
+    for (uint16_t slot = 0; slot < EEPROM_SLOTS_NUM; slot++)
+        if (eeprom_adapter_read_slot(eeprom_slot_address(page_base, slot)) != EEPROM_EMPTY_SLOT)  // Verify if slot is empty
             return -1;
     return 0;
 }
@@ -156,15 +184,15 @@ static int eeprom_check_page(uint32_t page_base, uint16_t status)
   * @brief  Erase page and increment the erase counter (address: page + 2)
   *
   * @param  page_base The address of the page
-  * 
+  *
   * @return The status of the operation
   */
 static eeprom_status_t eeprom_erase_page(uint32_t page_base)
 {
     eeprom_status_t flash_status;
-    uint16_t data = (*(__IO uint16_t *)(page_base));
+    uint16_t data = eeprom_adapter_read_halfword(page_base);
     if ((data == EEPROM_ERASED) || (data == EEPROM_VALID_PAGE) || (data == EEPROM_RECEIVE_DATA))
-        data = (*(__IO uint16_t *)(page_base + 2)) + 1;
+        data = eeprom_adapter_read_halfword(page_base + 2) + 1;
     else
         data = 0;
 
@@ -192,7 +220,7 @@ static eeprom_status_t eeprom_check_erase_page(uint32_t page_base, uint16_t stat
         flash_status = eeprom_erase_page(page_base);
         if (flash_status != EEPROM_OK)
             return flash_status;
-        return (eeprom_status_t)eeprom_check_page(page_base, status);
+        return (eeprom_check_page(page_base, status) == 0) ? EEPROM_OK : EEPROM_BAD_FLASH;
     }
     return EEPROM_OK;
 }
@@ -204,8 +232,8 @@ static eeprom_status_t eeprom_check_erase_page(uint32_t page_base, uint16_t stat
   */
 static uint32_t eeprom_find_valid_page(void)
 {
-    uint16_t status0 = (*(__IO uint16_t *)page_base_first);   // Get Page0 actual status
-    uint16_t status1 = (*(__IO uint16_t *)page_base_second);  // Get Page1 actual status
+    uint16_t status0 = eeprom_adapter_read_halfword(page_base_first);   // Get Page0 actual status
+    uint16_t status1 = eeprom_adapter_read_halfword(page_base_second);  // Get Page1 actual status
 
     if (status0 == EEPROM_VALID_PAGE && status1 == EEPROM_ERASED)
         return page_base_first;
@@ -215,43 +243,9 @@ static uint32_t eeprom_find_valid_page(void)
     return 0;
 }
 
-/**
-  * @brief  Calculate the count of unique variables in the EEPROM memory
-  *
-	* @param  page_base The address of the first slot to check (address: page + 4)
-  * @param	address_to_skip A 16 bit virtual address of the variable to excluse (or 0XFFFF)
-  *
-  * @return The count of variables
-  */
-static uint16_t eeprom_get_variables_count(uint32_t page_base, uint16_t address_to_skip)
-{
-    uint16_t variable_address, next_address;
-    uint32_t idx;
-    uint32_t page_end = page_base + (uint32_t)EEPROM_PAGE_SIZE;
-    uint16_t count = 0;
-
-    for (page_base += 6; page_base < page_end; page_base += 4)
-    {
-        variable_address = (*(__IO uint16_t *)page_base);
-        if (variable_address == 0xFFFF || variable_address == address_to_skip)
-            continue;
-
-        count++;
-        for (idx = page_base + 4; idx < page_end; idx += 4)
-        {
-            next_address = (*(__IO uint16_t *)idx);
-            if (next_address == variable_address)
-            {
-                count--;
-                break;
-            }
-        }
-    }
-    return count;
-}
-
 /**
   * @brief  Transfer the last updated variables data from a full page to an empty one.
+  *         The RAM index should describe the old page, it is built for the new page after the transfer
   *
   * @param  new_page The new page base address
   * @param	old_page The old page base address
@@ -263,69 +257,53 @@ static uint16_t eeprom_get_variables_count(uint32_t page_base, uint16_t address_
   */
 static eeprom_status_t eeprom_transfer_page(uint32_t new_page, uint32_t old_page, uint16_t address_to_skip)
 {
-    uint32_t old_end, new_end;
-    uint32_t old_index, new_index, idx;
-    uint16_t address, data, found;
+    uint8_t present[(EEPROM_VARIABLES_NUM + 7) / 8] = {0};
+    uint16_t new_slot, address, data;
     eeprom_status_t flash_status;
 
-    // Transfer process: transfer variables from old to the new active page
-    new_end = new_page + ((uint32_t)EEPROM_PAGE_FULL_SIZE);
-
-    // Find first free element in new page
-    for (new_index = new_page + 4; new_index < new_end; new_index += 4)
-        if ((*(__IO uint32_t *)new_index) == 0xFFFFFFFF)  // Verify if element
-            break;                                        //  contents are 0xFFFFFFFF
-    if (new_index >= new_end)
-        return EEPROM_OUT_SIZE;
-
-    old_end = old_page + 4;
-    old_index = old_page + (uint32_t)(EEPROM_PAGE_SIZE - 2);
-
-    for (; old_index > old_end; old_index -= 4)
+    // The variables already in the new page (written before the transfer or before a power off) are the latest ones
+    for (new_slot = 0; new_slot < EEPROM_SLOTS_NUM; new_slot++)
     {
-        address = *(__IO uint16_t *)old_index;
-        if (address == 0xFFFF || address == address_to_skip)
-            continue;  // it's means that power off after write data
-
-        found = 0;
-        for (idx = new_page + 6; idx < new_index; idx += 4)
-            if ((*(__IO uint16_t *)(idx)) == address)
-            {
-                found = 1;
-                break;
-            }
+        uint32_t slot = eeprom_adapter_read_slot(eeprom_slot_address(new_page, new_slot));
+        if (slot == EEPROM_EMPTY_SLOT)
+            break;
+        address = (uint16_t)(slot >> 16);
+        if (address < EEPROM_VARIABLES_NUM)
+            present[address / 8] |= (uint8_t)(1U << (address % 8));
+    }
 
-        if (found)
+    // Transfer process: transfer the last values from the index of the old page to the new active page
+    for (address = 0; address < EEPROM_VARIABLES_NUM; address++)
+    {
+        if (!variable_slot[address] || address == address_to_skip || (present[address / 8] & (1U << (address % 8))))
             continue;
+        if (new_slot >= EEPROM_SLOTS_NUM)
+            return EEPROM_OUT_SIZE;
 
-        if (new_index < new_end)
-        {
-            data = (*(__IO uint16_t *)(old_index - 2));
+        data = eeprom_adapter_read_halfword(eeprom_slot_address(old_page, variable_slot[address] - 1));
 
-            flash_status = eeprom_adapter_program_halfword(new_index, data);
-            if (flash_status != EEPROM_OK)
-                return flash_status;
+        flash_status = eeprom_adapter_program_halfword(eeprom_slot_address(new_page, new_slot), data);
+        if (flash_status != EEPROM_OK)
+            return flash_status;
 
-            flash_status = eeprom_adapter_program_halfword(new_index + 2, address);
-            if (flash_status != EEPROM_OK)
-                return flash_status;
+        flash_status = eeprom_adapter_program_halfword(eeprom_slot_address(new_page, new_slot) + 2, address);
+        if (flash_status != EEPROM_OK)
+            return flash_status;
 
-            new_index += 4;
-        }
-        else
-            return EEPROM_OUT_SIZE;
+        new_slot++;
     }
 
     // Erase the old Page: Set old Page status to EEPROM_EEPROM_ERASED status
-    data = eeprom_check_erase_page(old_page, EEPROM_ERASED);
-    if (data != EEPROM_OK)
-        return (eeprom_status_t)data;
+    flash_status = eeprom_check_erase_page(old_page, EEPROM_ERASED);
+    if (flash_status != EEPROM_OK)
+        return flash_status;
 
     // Set new Page status
     flash_status = eeprom_adapter_program_halfword(new_page, EEPROM_VALID_PAGE);
     if (flash_status != EEPROM_OK)
         return flash_status;
 
+    eeprom_index_build(new_page);
     return EEPROM_OK;
 }
 
@@ -343,7 +321,7 @@ static eeprom_status_t eeprom_format_storage(void)
     status = eeprom_check_erase_page(page_base_first, EEPROM_VALID_PAGE);
     if (status != EEPROM_OK)
         return status;
-    if ((*(__IO uint16_t *)page_base_first) == EEPROM_ERASED)
+    if (eeprom_adapter_read_halfword(page_base_first) == EEPROM_ERASED)
     {
         // Set Page0 as valid page: Write VALID_PAGE at Page0 base address
         flash_status = eeprom_adapter_program_halfword(page_base_first, EEPROM_VALID_PAGE);
@@ -363,61 +341,48 @@ static eeprom_status_t eeprom_format_storage(void)
   *
   * @return The status of the operation, Flash error code: on write Flash error
   * @retval EEPROM_OK on success
-  * @retval EEPROM_PAGE_FULL if valid page is full (need page transfer)
-  * @retval EEPROM_NO_VALID_PAGE if no valid page was found
+  * @retval EEPROM_PAGE_FULL if valid page is full (need page transfer) and the erases are not allowed
   * @retval EEPROM_OUT_SIZE if EEPROM size exceeded
   */
 static eeprom_status_t eeprom_verify_page_full_write_variable(uint16_t address, uint16_t data)
 {
     eeprom_status_t flash_status;
-    uint32_t idx, page_base, page_end, new_page;
+    uint32_t slot_address, new_page;
     uint16_t count;
 
-    // Get valid Page for write operation
-    page_base = eeprom_find_valid_page();
-    if (page_base == 0)
-        return EEPROM_NO_VALID_PAGE;
-
-    // Get the valid Page end address
-    page_end = page_base + page_size;  // Set end of page
-
-    for (idx = page_end - 2; idx > page_base; idx -= 4)
+    // The last value has not been programmed (0xFFFF): it is programmed in place
+    if (variable_slot[address])
     {
-        if ((*(__IO uint16_t *)idx) == address)  // Find last value for address
-        {
-            count = (*(__IO uint16_t *)(idx - 2));  // Read last data
-            if (count == data)
-                return EEPROM_OK;
-            if (count == 0xFFFF)
-            {
-                flash_status = eeprom_adapter_program_halfword(idx - 2, data);  // Set variable data
-                if (flash_status == EEPROM_OK)
-                    return EEPROM_OK;
-            }
-            break;
-        }
+        slot_address = eeprom_slot_address(valid_page, variable_slot[address] - 1);
+        if (eeprom_adapter_read_halfword(slot_address) == EEPROM_DEFAULT_DATA &&
+            eeprom_adapter_program_halfword(slot_address, data) == EEPROM_OK)
+            return EEPROM_OK;
     }
 
-    // Check each active page address starting from begining
-    for (idx = page_base + 4; idx < page_end; idx += 4)
-        if ((*(__IO uint32_t *)idx) == 0xFFFFFFFF)                      // Verify if element
-        {                                                               //  contents are 0xFFFFFFFF
-            flash_status = eeprom_adapter_program_halfword(idx, data);  // Set variable data
-            if (flash_status != EEPROM_OK)
-                return flash_status;
-            flash_status = eeprom_adapter_program_halfword(idx + 2, address);  // Set variable virtual address
-            if (flash_status != EEPROM_OK)
-                return flash_status;
-            return EEPROM_OK;
-        }
+    if (free_slot < EEPROM_SLOTS_NUM)
+    {
+        slot_address = eeprom_slot_address(valid_page, free_slot);
+        flash_status = eeprom_adapter_program_halfword(slot_address, data);  // Set variable data
+        if (flash_status != EEPROM_OK)
+            return flash_status;
+        flash_status = eeprom_adapter_program_halfword(slot_address + 2, address);  // Set variable virtual address
+        if (flash_status != EEPROM_OK)
+            return flash_status;
+
+        if (!variable_slot[address]) variables_count++;
+        variable_slot[address] = ++free_slot;
+        return EEPROM_OK;
+    }
 
     // Empty slot not found, need page transfer
     // Calculate unique variables in page
-    count = eeprom_get_variables_count(page_base, address) + 1;
-    if (count >= (page_size / 4 - 1))
+    count = variables_count + (variable_slot[address] ? 0 : 1);
+    if (count >= EEPROM_SLOTS_NUM)
         return EEPROM_OUT_SIZE;
+    if (!erase_allowed)
+        return EEPROM_PAGE_FULL;
 
-    if (page_base == page_base_second)
+    if (valid_page == page_base_second)
         new_page = page_base_first;  // New page address where variable will be moved to
     else
         new_page = page_base_second;
@@ -428,15 +393,32 @@ static eeprom_status_t eeprom_verify_page_full_write_variable(uint16_t address,
         return flash_status;
 
     // Write the variable passed as parameter in the new active page
-    flash_status = eeprom_adapter_program_halfword(new_page + 4, data);
+    slot_address = eeprom_slot_address(new_page, 0);
+    flash_status = eeprom_adapter_program_halfword(slot_address, data);
     if (flash_status != EEPROM_OK)
         return flash_status;
 
-    flash_status = eeprom_adapter_program_halfword(new_page + 6, address);
+    flash_status = eeprom_adapter_program_halfword(slot_address + 2, address);
     if (flash_status != EEPROM_OK)
         return flash_status;
 
-    return eeprom_transfer_page(new_page, page_base, address);
+    return eeprom_transfer_page(new_page, valid_page, address);
+}
+
+/**
+  * @brief  Init the module again after an error (the index is built again from the flash memory)
+  * @note   The recovery can erase or transfer a page, so it waits while the erases are forbidden
+  *
+  * @return The status of the module
+  * @retval EEPROM_PAGE_FULL if the module is not initialized and the erases are not allowed
+  */
+static eeprom_status_t eeprom_recover(void)
+{
+    if (eeprom_status != EEPROM_NOT_INIT)
+        return eeprom_status;
+    if (!erase_allowed)
+        return EEPROM_PAGE_FULL;
+    return eeprom_init();
 }
 
 /**
@@ -447,33 +429,35 @@ static eeprom_status_t eeprom_verify_page_full_write_variable(uint16_t address,
   *
   * @return The status of the operation, or Flash error code on write Flash error
   *	@retval EEPROM_OK on success
-  *	@retval EEPROM_BAD_ADDRESS if address = 0xFFFF
+  *	@retval EEPROM_BAD_ADDRESS if address >= EEPROM_VARIABLES_NUM
   *	@retval EEPROM_PAGE_FULL if valid page is full
   *	@retval EEPROM_NO_VALID_PAGE if no valid page was found
   *	@retval EEPROM_OUT_SIZE if no empty EEPROM variables
   */
 static eeprom_status_t eeprom_write(uint16_t address, uint16_t data)
 {
-    if (eeprom_status == EEPROM_NOT_INIT)
-        if (eeprom_init() != EEPROM_OK)
-            return eeprom_status;
-
-    if (address == 0xFFFF)
+    if (address >= EEPROM_VARIABLES_NUM)
         return EEPROM_BAD_ADDRESS;
 
-    eeprom_flash_unlock();
-
-    // Write the variable virtual address and value in the EEPROM
-    eeprom_status_t status = eeprom_verify_page_full_write_variable(address, data);
+    if (eeprom_recover() == EEPROM_PAGE_FULL)
+        return EEPROM_PAGE_FULL;
 
-    if (status == EEPROM_NO_VALID_PAGE)
+    if (eeprom_status == EEPROM_NO_VALID_PAGE && erase_allowed)
     {
+        // Both pages are erased, so the storage is formatted
         eeprom_adapter_erase(EEPROM_PAGE0_BASE);
         eeprom_adapter_erase(EEPROM_PAGE1_BASE);
-        status = eeprom_verify_page_full_write_variable(address, data);
+        eeprom_init();
     }
+    if (eeprom_status != EEPROM_OK)
+        return eeprom_status;
+
+    // Write the variable virtual address and value in the EEPROM
+    eeprom_status_t status = eeprom_verify_page_full_write_variable(address, data);
 
-    eeprom_flash_lock();
+    // The index is built again from the flash memory after an error
+    if (status != EEPROM_OK && status != EEPROM_PAGE_FULL && status != EEPROM_OUT_SIZE)
+        eeprom_status = EEPROM_NOT_INIT;
 
     return status;
 }
@@ -483,7 +467,7 @@ static eeprom_status_t eeprom_write(uint16_t address, uint16_t data)
 --------------------------------------------------------------*/
 
 /*
-  * @brief  Init the EEPROM module
+  * @brief  Init the EEPROM module: recover the pages and build the RAM index of the valid page
   *
   * @return The status of the operation
   */
@@ -492,11 +476,10 @@ eeprom_status_t eeprom_init(void)
     eeprom_page_state_t status0, status1;
     eeprom_status_t flash_status;
 
-    eeprom_flash_unlock();
     eeprom_status = EEPROM_NO_VALID_PAGE;
 
-    status0 = (eeprom_page_state_t)(*(__IO uint16_t *)page_base_first);
-    status1 = (eeprom_page_state_t)(*(__IO uint16_t *)page_base_second);
+    status0 = (eeprom_page_state_t)eeprom_adapter_read_halfword(page_base_first);
+    status1 = (eeprom_page_state_t)eeprom_adapter_read_halfword(page_base_second);
 
     switch (status0)
     {
@@ -531,7 +514,10 @@ eeprom_status_t eeprom_init(void)
 */
         case EEPROM_RECEIVE_DATA:
             if (status1 == EEPROM_VALID_PAGE)  // Page0 receive, Page1 valid
+            {
+                eeprom_index_build(page_base_second);
                 eeprom_status = eeprom_transfer_page(page_base_first, page_base_second, 0xFFFF);
+            }
             else if (status1 == EEPROM_ERASED)  // Page0 receive, Page1 erased
             {
                 eeprom_status = eeprom_check_erase_page(page_base_second, EEPROM_ERASED);
@@ -556,7 +542,10 @@ eeprom_status_t eeprom_init(void)
             if (status1 == EEPROM_VALID_PAGE)  // Both pages valid
                 eeprom_status = EEPROM_NO_VALID_PAGE;
             else if (status1 == EEPROM_RECEIVE_DATA)
+            {
+                eeprom_index_build(page_base_first);
                 eeprom_status = eeprom_transfer_page(page_base_second, page_base_first, 0xFFFF);
+            }
             else
                 eeprom_status = eeprom_check_erase_page(page_base_second, EEPROM_ERASED);
             break;
@@ -584,7 +573,15 @@ eeprom_status_t eeprom_init(void)
             }
             break;
     }
-    eeprom_flash_lock();
+
+    if (eeprom_status == EEPROM_OK)
+    {
+        uint32_t page_base = eeprom_find_valid_page();
+        if (page_base == 0)
+            eeprom_status = EEPROM_NO_VALID_PAGE;
+        else
+            eeprom_index_build(page_base);
+    }
     return eeprom_status;
 }
 
@@ -599,36 +596,22 @@ eeprom_status_t eeprom_init(void)
   * @retval EEPROM_OK if variable was found
   * @retval EEPROM_BAD_ADDRESS if the variable was not found
   * @retval EEPROM_NO_VALID_PAGE if no valid page was found.
+  * @retval EEPROM_PAGE_FULL if the module is initialized again after an error and the erases are not allowed
   */
 eeprom_status_t eeprom_read_variable(uint16_t address, uint16_t *data)
 {
-    uint32_t page_base, page_end;
-
     // Set default data (empty EEPROM)
     *data = EEPROM_DEFAULT_DATA;
 
-    if (eeprom_status == EEPROM_NOT_INIT)
-        if (eeprom_init() != EEPROM_OK)
-            return eeprom_status;
-
-    // Get active Page for read operation
-    page_base = eeprom_find_valid_page();
-    if (page_base == 0)
-        return EEPROM_NO_VALID_PAGE;
-
-    // Get the valid Page end address
-    page_end = page_base + ((uint32_t)(page_size - 2));
+    eeprom_status_t status = eeprom_recover();
+    if (status != EEPROM_OK)
+        return status;
 
-    // Check each active page address starting from end
-    for (page_base += 6; page_end >= page_base; page_end -= 4)
-        if ((*(__IO uint16_t *)page_end) == address)  // Compare the read address with the virtual address
-        {
-            *data = (*(__IO uint16_t *)(page_end - 2));  // Get content of address-2 which is variable value
-            return EEPROM_OK;
-        }
+    if (address >= EEPROM_VARIABLES_NUM || !variable_slot[address])
+        return EEPROM_BAD_ADDRESS;
 
-    // Return ReadStatus value: (0: variable exist, 1: variable doesn't exist)
-    return EEPROM_BAD_ADDRESS;
+    *data = eeprom_adapter_read_halfword(eeprom_slot_address(valid_page, variable_slot[address] - 1));
+    return EEPROM_OK;
 }
 
 /*
@@ -641,7 +624,7 @@ eeprom_status_t eeprom_read_variable(uint16_t address, uint16_t *data)
   * @return The status of the operation, Flash error code: on write Flash error
   *	@retval EEPROM_SAME_VALUE If new data matches existing EEPROM data
   *	@retval EEPROM_OK on success
-  *	@retval EEPROM_BAD_ADDRESS if address = 0xFFFF
+  *	@retval EEPROM_BAD_ADDRESS if address >= EEPROM_VARIABLES_NUM
   *	@retval EEPROM_PAGE_FULL if valid page is full
   *	@retval EEPROM_NO_VALID_PAGE if no valid page was found
   *	@retval EEPROM_OUT_SIZE if no empty EEPROM slots
@@ -663,4 +646,16 @@ eeprom_status_t eeprom_update_variable(uint16_t address, uint16_t data)
     }
     return eeprom_write(address, data);
 }
+
+/*
+  * @brief  Allow or forbid the page transfer: the erase of a sector stalls the code fetch from the flash memory
+  *         for the whole erase time. A write which needs the transfer
+  *         or the recovery after an error returns EEPROM_PAGE_FULL while forbidden
+  *
+  * @param  allow 1 - the erases are allowed (the default)
+  */
+void eeprom_allow_erase(uint8_t allow)
+{
+    erase_allowed = allow;
+}
 /** @} */
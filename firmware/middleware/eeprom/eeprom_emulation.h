@@ -20,6 +20,12 @@
 
 #include "defines.h"
 
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define EEPROM_VARIABLES_NUM (512U) /**< The number of the virtual addresses (the size of the RAM index) */
+
 /*--------------------------------------------------------------
                        PUBLIC TYPES
 --------------------------------------------------------------*/
@@ -28,6 +34,7 @@
 typedef enum
 {
     EEPROM_OK = ((uint16_t)0x0000),           /**< The operation succeded */
+    EEPROM_PAGE_FULL = ((uint16_t)0x0080),    /**< The valid page is full, the page transfer (an erase) is not allowed now */
     EEPROM_OUT_SIZE = ((uint16_t)0x0081),     /**< No empty EEPROM slots */
     EEPROM_BAD_ADDRESS = ((uint16_t)0x0082),  /**< Wrong address of a variable or a page */
     EEPROM_BAD_FLASH = ((uint16_t)0x0083),    /**< An error at the flash memory level */
@@ -41,7 +48,7 @@ typedef enum
 --------------------------------------------------------------*/
 
 /**
-  * @brief  Init the EEPROM module
+  * @brief  Init the EEPROM module: recover the pages and build the RAM index of the valid page
   *
   * @return The status of the operation
   */
@@ -58,6 +65,7 @@ eeprom_status_t eeprom_init(void);
   * @retval EEPROM_OK if variable was found
   * @retval EEPROM_BAD_ADDRESS if the variable was not found
   * @retval EEPROM_NO_VALID_PAGE if no valid page was found.
+  * @retval EEPROM_PAGE_FULL if the module is initialized again after an error and the erases are not allowed
   */
 eeprom_status_t eeprom_read_variable(uint16_t address, uint16_t *data);
 
@@ -71,12 +79,21 @@ eeprom_status_t eeprom_read_variable(uint16_t address, uint16_t *data);
   * @return The status of the operation, Flash error code: on write Flash error
   *	@retval EEPROM_SAME_VALUE If new data matches existing EEPROM data
   *	@retval EEPROM_OK on success
-  *	@retval EEPROM_BAD_ADDRESS if address = 0xFFFF
+  *	@retval EEPROM_BAD_ADDRESS if address >= EEPROM_VARIABLES_NUM
   *	@retval EEPROM_PAGE_FULL if valid page is full
   *	@retval EEPROM_NO_VALID_PAGE if no valid page was found
   *	@retval EEPROM_OUT_SIZE if no empty EEPROM variables
   */
 eeprom_status_t eeprom_update_variable(uint16_t address, uint16_t data);
 
+/**
+  * @brief  Allow or forbid the page transfer: the erase of a sector stalls the code fetch from the flash memory
+  *         for the whole erase time. A write which needs the transfer
+  *         or the recovery after an error returns EEPROM_PAGE_FULL while forbidden
+  *
+  * @param  allow 1 - the erases are allowed (the default)
+  */
+void eeprom_allow_erase(uint8_t allow);
+
 /** @} */
 #endif /*__EEPROM_H*/
@@ -1,7 +1,7 @@
 /**
  * @file crc.c
  * @author Stanislav Karpikov
- * @brief Calculate CRC16
+ * @brief Calculate CRC16 (the packets) and CRC32 (the stored records)
  */
 
 /*--------------------------------------------------------------
@@ -10,12 +10,73 @@
 
 #include "crc.h"
 
+#include "crc16_table.h"
+
+#if CRC16_HARDWARE == 1
+#include "stm32f7xx_hal.h"
+#include "string.h"
+#endif
+
 /*--------------------------------------------------------------
                        DEFINES
 --------------------------------------------------------------*/
 
-#define CRC16_INITIAL_VALUE    (0x1D0F) /**< Initial CRC16 value, 0x1D0F for CRC16-CCITT */
-#define CRC16_POLYNOMIAL_VALUE (0x1021) /**< Polynomial CRC16 value, 0x1021 = 0001 0000 0010 0001  (0, 5, 12) for CRC16-CCITT */
+#define CRC32_INITIAL_VALUE (0xFFFFFFFFU) /**< Initial CRC32 value (the output is inverted as well) */
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+/** CRC32 of the nibbles (the reflected polynomial 0xEDB88320) */
+static const uint32_t crc32_nibble_table[16] = {
+    0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU, 0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+    0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU, 0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU,
+};
+
+#if CRC16_HARDWARE == 1
+static uint8_t crc16_hardware_ready = 0; /**< The CRC unit is configured */
+#endif
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+#if CRC16_HARDWARE == 1
+/**
+ * @brief Calculate CRC16 (CRC16-CCITT) with the CRC unit
+ * @note The unit is configured at the first call: the 16-bit polynomial, no reversal of the input and the output
+ *
+ * @param datablock The pointer to the data block
+ * @param len The size of the data block
+ *
+ * @return The CRC of the block
+ */
+static uint16_t crc16_hardware(const uint8_t* datablock, uint32_t len)
+{
+    if (!crc16_hardware_ready)
+    {
+        __HAL_RCC_CRC_CLK_ENABLE();
+        CRC->POL = CRC16_POLYNOMIAL_VALUE;
+        CRC->INIT = CRC16_INITIAL_VALUE;
+        CRC->CR = CRC_CR_POLYSIZE_0;
+        crc16_hardware_ready = 1;
+    }
+    CRC->CR |= CRC_CR_RESET;
+
+    /* A word is taken MSB first: the bytes are reversed (the copy is a single unaligned load on the Cortex-M7) */
+    for (; len >= sizeof(uint32_t); len -= sizeof(uint32_t), datablock += sizeof(uint32_t))
+    {
+        uint32_t word;
+        memcpy(&word, datablock, sizeof(word));
+        CRC->DR = __REV(word);
+    }
+    while (len--)
+    {
+        *(__IO uint8_t*)&CRC->DR = *datablock++;
+    }
+    return (uint16_t)CRC->DR;
+}
+#endif
 
 /*--------------------------------------------------------------
                        PUBLIC FUNCTIONS
@@ -23,27 +84,40 @@
 
 /*
  * @brief Calculate CRC16 (CRC16-CCITT)
- * 
- * @datablock The pointer to the data block
- * @len The size of the data block
+ * @note The CRC unit is used if CRC16_HARDWARE is set (should be called from a single context: the main loop)
+ *
+ * @param datablock The pointer to the data block
+ * @param len The size of the data block
+ *
+ * @return The CRC of the block
  */
-uint16_t crc16(uint8_t *datablock, uint32_t len)
+uint16_t crc16(const uint8_t* datablock, uint32_t len)
 {
-    uint16_t crc = CRC16_INITIAL_VALUE;
-    uint16_t polynomial = CRC16_POLYNOMIAL_VALUE;
-    uint8_t b, i;
-    for (b = 0; b < len; b++)
+#if CRC16_HARDWARE == 1
+    return crc16_hardware(datablock, len);
+#else
+    return crc16_table_calculate(datablock, len);
+#endif
+}
+
+/*
+ * @brief Calculate CRC32 (IEEE 802.3: the reflected polynomial 0xEDB88320, the initial value and the output inverted)
+ * @note A table of 16 values (a nibble per step): the blocks are small and rare (the settings records)
+ *
+ * @param datablock The pointer to the data block
+ * @param len The size of the data block
+ *
+ * @return The CRC of the block
+ */
+uint32_t crc32(const uint8_t* datablock, uint32_t len)
+{
+    uint32_t crc = CRC32_INITIAL_VALUE;
+    while (len--)
     {
-        for (i = 0; i < 8; i++)
-        {
-            uint16_t bit = ((datablock[b] >> (7 - i) & 1) == 1);
-            uint16_t c15 = ((crc >> 15 & 1) == 1);
-            crc <<= 1;
-            if (c15 ^ bit) crc ^= polynomial;
-        }
+        crc ^= *datablock++;
+        crc = (crc >> 4) ^ crc32_nibble_table[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32_nibble_table[crc & 0x0F];
     }
-
-    crc &= 0xffff;
-    return crc;
+    return crc ^ CRC32_INITIAL_VALUE;
 }
 /** @} */
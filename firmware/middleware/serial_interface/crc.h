@@ -1,7 +1,7 @@
 /**
  * @file crc.h
  * @author Stanislav Karpikov
- * @brief Calculate CRC16
+ * @brief Calculate CRC16 (the packets) and CRC32 (the stored records)
  */
 
 #ifndef __CRC_H__
@@ -13,18 +13,39 @@
 
 #include <stdint.h>
 
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#ifndef CRC16_HARDWARE
+#define CRC16_HARDWARE (0) /**< Use the CRC unit of the MCU (1) or the table (0) */
+#endif
+
 /*--------------------------------------------------------------
                        PUBLIC FUNCTIONS
 --------------------------------------------------------------*/
 
 /**
  * @brief Calculate CRC16 (CRC16-CCITT)
- * 
- * @datablock The pointer to the data block
- * @len The size of the data block
+ * @note The CRC unit is used if CRC16_HARDWARE is set (should be called from a single context: the main loop)
+ *
+ * @param datablock The pointer to the data block
+ * @param len The size of the data block
+ *
+ * @return The CRC of the block
  */
-uint16_t crc16(uint8_t *datablock, uint32_t len);
+uint16_t crc16(const uint8_t* datablock, uint32_t len);
+
+/**
+ * @brief Calculate CRC32 (IEEE 802.3: the reflected polynomial 0xEDB88320, the initial value and the output inverted)
+ * @note A table of 16 values (a nibble per step): the blocks are small and rare (the settings records)
+ *
+ * @param datablock The pointer to the data block
+ * @param len The size of the data block
+ *
+ * @return The CRC of the block
+ */
+uint32_t crc32(const uint8_t* datablock, uint32_t len);
 
 /** @} */
 #endif /* __CRC_H__ */
-
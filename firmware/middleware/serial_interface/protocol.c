@@ -13,6 +13,7 @@
 #include <string.h>
 
 #include "BSP/bsp.h"
+#include "BSP/dma.h"
 #include "BSP/uart.h"
 #include "command_processor.h"
 #include "crc.h"
@@ -23,12 +24,32 @@
 --------------------------------------------------------------*/
 
 #define PROTOCOL_START_BYTE ((uint8_t)0x55)
+#define PROTOCOL_FRAME_BYTE ((uint8_t)0x56) /**< The start byte of a frame (the version 2 framing) */
 #define PROTOCOL_STOP_BYTE  ((uint8_t)0x77)
 #define PROTOCOL_STATUS_MAX (31)  // 2**5bits - 1 = 31
 
 #define PROTOCOL_IGNORE_CRC             (0)
 #define PROTOCOL_IGNORE_UNKNOWN_COMMAND (1)
 
+#define PROTOCOL_TX_PACKETS_NUM (UART_INTERFACE_TX_QUEUE_SIZE + 1) /**< The answers: the queued ones and the one being filled */
+
+/*--------------------------------------------------------------
+                       PRIVATE TYPES
+--------------------------------------------------------------*/
+
+/** The place of an answer: a packet or a frame */
+typedef union
+{
+    packet_t packet; /**< The answer packet (the version 1 framing) */
+    frame_t frame;   /**< The answer frame (the version 2 framing) */
+} protocol_slot_t;
+
+/** Compile-time check: the length of a frame fits the length field */
+typedef char protocol_frame_check_t[(MAXIMUM_FRAME_LENGTH <= UINT16_MAX && MAXIMUM_FRAME_DATA_LENGTH >= MAXIMUM_RECORD_DATA_LENGTH + sizeof(struct frame_record_s)) ? 1 : -1];
+
+/** Compile-time check: the answers fit the DMA region */
+typedef char protocol_dma_check_t[(sizeof(protocol_slot_t) * PROTOCOL_TX_PACKETS_NUM <= DMA_REGION_SIZE) ? 1 : -1];
+
 /*--------------------------------------------------------------
                        PRIVATE DATA
 --------------------------------------------------------------*/
@@ -36,30 +57,59 @@
 /** Internal protocol context */
 static protocol_context_t protocol;
 
+/** The answers: written by the handlers and transmitted in place (by the DMA, not cached) */
+static protocol_slot_t packets_to_send[PROTOCOL_TX_PACKETS_NUM] DMA_BUFFER;
+
+/** The answer to a command of a frame (copied to the answer frame as a record) */
+static packet_t record_answer;
+
 /*--------------------------------------------------------------
                        PRIVATE FUNCTIONS
 --------------------------------------------------------------*/
 
 /**
  * @brief Send a packet to the interface adapter
+ * @note The data is not copied: it should not be changed until it is transmitted
  * 
  * @param data Pointer to the data block
  * @param len  Data block size
+ * @return Status of the operation
  */
-static void adapter_send_packet(uint8_t *data, uint32_t len)
+static status_t adapter_send_packet(uint8_t *data, uint32_t len)
 {
-    uart_interface_transmit(data, len);
+    return uart_interface_transmit(data, len);
 }
 
 /**
- * @brief Read a byte from the interface adapter
+ * @brief Check if the interface adapter can take a packet to send
  * 
- * @param[out] byte Pointer to the data byte to read
+ * @return Status of the operation: PFC_SUCCESS if a packet can be sent
+ */
+static status_t adapter_tx_ready(void)
+{
+    return uart_interface_tx_ready();
+}
+
+/**
+ * @brief Get the received data from the interface adapter (a contiguous span)
+ * 
+ * @param[out] data Pointer to the span
+ * @param[out] len The size of the span
  * @return Status of the operation
  */
-static status_t adapter_get_byte(uint8_t *byte)
+static status_t adapter_get_data(const uint8_t **data, uint32_t *len)
 {
-    return uart_interface_get_byte(byte);
+    return uart_interface_get_data(data, len);
+}
+
+/**
+ * @brief Release the data read from the interface adapter
+ * 
+ * @param len The number of the bytes read
+ */
+static void adapter_release(uint32_t len)
+{
+    uart_interface_rx_release(len);
 }
 
 /**
@@ -80,12 +130,412 @@ static status_t adapter_rx_init(void)
 static void protocol_reset(protocol_context_t *pc)
 {
     memset(&pc->packet_received, 0, sizeof(packet_t));
-    memset(&pc->packet_to_send, 0, sizeof(packet_t));
+    memset(pc->packet_to_send, 0, sizeof(packet_t));
 
     pc->stage = PROTOCOL_START;
     pc->size = 0;
     pc->data_pointer = pc->packet_received.data;
 }
+
+/**
+ * @brief Send the last answer again (it is kept until the next answers are queued)
+ * 
+ * @param pc The protocol context structure
+ * 
+ * @return Status of the operation
+ */
+static status_t protocol_resend_packet(protocol_context_t *pc)
+{
+    packet_t *packet = &packets_to_send[(pc->send_index + PROTOCOL_TX_PACKETS_NUM - 1) % PROTOCOL_TX_PACKETS_NUM].packet;
+    pc->stage = PROTOCOL_START;
+    if (packet->fields.start != PROTOCOL_START_BYTE) return PFC_NULL;
+    return adapter_send_packet(packet->data, packet->fields.len + MINIMUM_PACKET_LENGTH);
+}
+
+/**
+ * @brief Parse a received byte
+ * 
+ * @param pc The protocol context structure
+ * @param byte The byte
+ * 
+ * @return PFC_NULL if the packet is not finished, PFC_SUCCESS if a packet has been processed,
+ * PFC_WARNING if a packet with a wrong CRC has been received
+ */
+static status_t protocol_parse_byte(protocol_context_t *pc, uint8_t byte)
+{
+    switch (pc->stage)
+    {
+        case PROTOCOL_START:
+            if (byte == PROTOCOL_START_BYTE)
+            {
+                pc->stage = PROTOCOL_STATUS;
+            }
+            else if (byte == PROTOCOL_FRAME_BYTE)
+            {
+                pc->stage = PROTOCOL_FRAME;
+                pc->frame_received.fields.start = byte;
+                pc->frame_index = 1;
+            }
+            break;
+        case PROTOCOL_STATUS:
+            if (byte > PROTOCOL_STATUS_MAX)
+            {
+                pc->stage = PROTOCOL_START;
+            }
+            else
+            {
+                pc->stage = PROTOCOL_LEN;
+                pc->packet_received.fields.status.raw = byte;
+            }
+            break;
+        case PROTOCOL_LEN:
+            pc->stage = PROTOCOL_COMMAND;
+            pc->packet_received.fields.len = byte;
+            if (byte < MINIMUM_PACKET_LENGTH)
+            {
+                pc->stage = PROTOCOL_START;
+            }
+            else
+            {
+                if (byte > (MAXIMUM_PACKET_LENGTH - 4))
+                {
+                    pc->stage = PROTOCOL_START;
+                }
+                pc->size = byte;
+                pc->data_pointer = pc->packet_received.data + MINIMUM_PACKET_LENGTH;
+            }
+            break;
+        case PROTOCOL_COMMAND:
+            pc->packet_received.fields.command = byte;
+            if (pc->packet_received.fields.len == MINIMUM_PACKET_LENGTH)
+            {
+                pc->stage = PROTOCOL_CRC;
+            }
+            else
+            {
+                pc->stage = PROTOCOL_DATA;
+            }
+            pc->size--;
+            break;
+        case PROTOCOL_DATA:
+            *(pc->data_pointer) = byte;
+            pc->size--;
+            pc->data_pointer++;
+            if (pc->size > (MAXIMUM_PACKET_LENGTH - 4))
+            {
+                pc->stage = PROTOCOL_START;
+            }
+            if (pc->size <= MINIMUM_PACKET_LENGTH - 1)
+            {
+                pc->stage = PROTOCOL_CRC;
+            }
+            break;
+        case PROTOCOL_CRC:
+            pc->size--;
+            *(pc->data_pointer) = byte;
+            pc->data_pointer++;
+            if (pc->size == 1)
+            {
+                pc->stage = PROTOCOL_STOP;
+            }
+            break;
+        case PROTOCOL_STOP:
+            pc->size--;
+            if (byte == PROTOCOL_STOP_BYTE)
+            {
+                *(pc->data_pointer) = byte;
+                pc->data_pointer++;
+
+                uint16_t crcget = packet_get_crc(&pc->packet_received);
+                uint16_t crccalc = packet_calculate_crc(&pc->packet_received);
+                if (crcget != crccalc)
+                {
+#if PROTOCOL_IGNORE_CRC == 0
+                    packet_clear_status(pc->packet_to_send);
+                    pc->packet_to_send->fields.status.fields.crc_error = 1;
+                    packet_set_data_len(pc->packet_to_send, 0);
+                    protocol_send_packet(pc);
+#endif /* PROTOCOL_IGNORE_CRC */
+                    return PFC_WARNING;
+                }
+
+#if PROTOCOL_IGNORE_CRC == 0
+                else if (pc->packet_received.fields.status.fields.crc_error)
+                {
+                    protocol_resend_packet(pc);
+                    return PFC_WARNING;
+                }
+                else
+                {
+                    pc->packet_received.fields.status.fields.crc_error = 0;
+                }
+#endif /* PROTOCOL_IGNORE_CRC */
+
+                if (pc->packet_received.fields.command >= pc->handlers_count)
+                {
+#if PROTOCOL_IGNORE_UNKNOWN_COMMAND == 1
+#else /* PROTOCOL_IGNORE_UNKNOWN_COMMAND */
+                    protocol_unknown_command_handler(pc);
+#endif /* PROTOCOL_IGNORE_UNKNOWN_COMMAND */
+                }
+                else
+                {
+                    PFC_COMMAND_CALLBACK handler = pc->handlers[pc->packet_received.fields.command];
+                    if (handler) handler(pc);
+                }
+            }
+            else
+            {
+                //pc->packet_received.fields.status.fields.unexpected_stop = 1;
+            }
+            pc->stage = PROTOCOL_START;
+            return PFC_SUCCESS;
+        default:
+            pc->stage = PROTOCOL_START;
+            break;
+    }
+    return PFC_NULL;
+}
+
+/**
+ * @brief Copy the data bytes of a packet at once
+ * 
+ * @param pc The protocol context structure
+ * @param data The received data
+ * @param len The size of the received data
+ * 
+ * @return The number of the bytes copied
+ */
+static uint32_t protocol_parse_data(protocol_context_t *pc, const uint8_t *data, uint32_t len)
+{
+    /* The last data byte is parsed as a byte: it switches the stage */
+    uint32_t count = pc->size - MINIMUM_PACKET_LENGTH;
+    if (pc->size > MAXIMUM_PACKET_LENGTH - 4 || count == 0) return 0;
+    if (count > len) count = len;
+
+    memcpy(pc->data_pointer, data, count);
+    pc->data_pointer += count;
+    pc->size -= count;
+    return count;
+}
+
+/**
+ * @brief Continue with the next answer slot (the previous one is queued)
+ * 
+ * @param pc The protocol context structure
+ */
+static void protocol_next_slot(protocol_context_t *pc)
+{
+    pc->send_index = (pc->send_index + 1) % PROTOCOL_TX_PACKETS_NUM;
+    pc->packet_to_send = &packets_to_send[pc->send_index].packet;
+}
+
+/**
+ * @brief Queue the packet being filled for the transmission, the next packet is filled then
+ * 
+ * @param pc The protocol context structure
+ * 
+ * @return Status of the operation
+ */
+static status_t protocol_queue_packet(protocol_context_t *pc)
+{
+    packet_t *packet = pc->packet_to_send;
+    packet->fields.start = PROTOCOL_START_BYTE;
+    uint16_t crcsend = crc16(packet->data + 1,
+                             packet->fields.len);
+
+    packet->data[packet->fields.len + 1] = crcsend & 0xFF;
+    packet->data[packet->fields.len + 2] = crcsend >> 8;
+    packet->data[packet->fields.len + 3] = PROTOCOL_STOP_BYTE;
+    status_t status = adapter_send_packet(packet->data, packet->fields.len + MINIMUM_PACKET_LENGTH);
+    if (status != PFC_SUCCESS) return status;
+
+    protocol_next_slot(pc);
+    return PFC_SUCCESS;
+}
+
+/**
+ * @brief Queue the answer frame in the current slot for the transmission
+ * 
+ * @param pc The protocol context structure
+ * 
+ * @return Status of the operation
+ */
+static status_t protocol_queue_frame(protocol_context_t *pc)
+{
+    frame_t *frame = &packets_to_send[pc->send_index].frame;
+    uint16_t len = frame->fields.len;
+    frame->fields.start = PROTOCOL_FRAME_BYTE;
+    uint16_t crcsend = crc16(frame->data + 1, FRAME_HEADER_LENGTH - 1 + len);
+
+    frame->data[FRAME_HEADER_LENGTH + len] = crcsend & 0xFF;
+    frame->data[FRAME_HEADER_LENGTH + len + 1] = crcsend >> 8;
+    frame->data[FRAME_HEADER_LENGTH + len + 2] = PROTOCOL_STOP_BYTE;
+    status_t status = adapter_send_packet(frame->data, FRAME_SERVICE_LENGTH + len);
+    if (status != PFC_SUCCESS) return status;
+
+    protocol_next_slot(pc);
+    return PFC_SUCCESS;
+}
+
+/**
+ * @brief Append the answer to a command of a frame to the answer frame
+ * @note An answer which does not fit the frame is replaced by an error record
+ * 
+ * @param pc The protocol context structure
+ * 
+ * @return Status of the operation: PFC_NULL if the frame is full
+ */
+static status_t protocol_append_record(protocol_context_t *pc)
+{
+    frame_t *frame = pc->frame_to_send;
+    packet_t *answer = pc->packet_to_send;
+    uint16_t used = frame->fields.len;
+    uint16_t size = answer->fields.len - MINIMUM_PACKET_LENGTH;
+
+    struct frame_record_s record;
+    record.command = answer->fields.command;
+    record.status = answer->fields.status;
+    if (used + sizeof(record) + size > MAXIMUM_FRAME_DATA_LENGTH)
+    {
+        record.status.fields.error = 1;
+        size = 0;
+    }
+    if (used + sizeof(record) > MAXIMUM_FRAME_DATA_LENGTH)
+    {
+        frame->fields.status.fields.error = 1;
+        return PFC_NULL;
+    }
+    record.len = size;
+
+    uint8_t *place = frame->data + FRAME_HEADER_LENGTH + used;
+    memcpy(place, &record, sizeof(record));
+    memcpy(place + sizeof(record), answer->data + MINIMUM_PACKET_LENGTH, size);
+    frame->fields.len = used + sizeof(record) + size;
+    return PFC_SUCCESS;
+}
+
+/**
+ * @brief Run the handler of a command of a frame: the command is passed to the handler as a packet
+ * @note The unknown commands are answered with the error (a record per command is expected by the panel)
+ * 
+ * @param pc The protocol context structure
+ * @param record The record of the command
+ * @param data The data of the command
+ */
+static void protocol_dispatch_record(protocol_context_t *pc, const struct frame_record_s *record, const uint8_t *data)
+{
+    PFC_COMMAND_CALLBACK handler = 0;
+    if (record->command < pc->handlers_count) handler = pc->handlers[record->command];
+    if (!handler || record->len > MAXIMUM_RECORD_DATA_LENGTH)
+    {
+        protocol_error_handle(pc, record->command);
+        return;
+    }
+
+    packet_t *packet = &pc->packet_received;
+    packet->fields.status = record->status;
+    packet->fields.command = record->command;
+    packet_set_data_len(packet, record->len);
+    memcpy(packet->data + MINIMUM_PACKET_LENGTH, data, record->len);
+    handler(pc);
+}
+
+/**
+ * @brief Process a received frame: run the commands, answer with a frame of the same sequence number
+ * @note The answers are in the order of the commands, the commands without an answer record have not been run
+ * 
+ * @param pc The protocol context structure
+ * 
+ * @return PFC_SUCCESS if the frame has been processed, PFC_WARNING if a frame with a wrong CRC has been received
+ */
+static status_t protocol_process_frame(protocol_context_t *pc)
+{
+    const frame_t *request = &pc->frame_received;
+    uint16_t len = request->fields.len;
+    const uint8_t *records = request->data + FRAME_HEADER_LENGTH;
+    if (records[len + 2] != PROTOCOL_STOP_BYTE) return PFC_SUCCESS;
+
+    frame_t *answer = &packets_to_send[pc->send_index].frame;
+    answer->fields.status.raw = 0;
+    answer->fields.len = 0;
+    answer->fields.sequence = request->fields.sequence;
+
+    uint16_t crcget = records[len] | (records[len + 1] << 8);
+    if (crcget != crc16(request->data + 1, FRAME_HEADER_LENGTH - 1 + len))
+    {
+#if PROTOCOL_IGNORE_CRC == 0
+        /* The panel repeats the request of the sequence number */
+        answer->fields.status.fields.crc_error = 1;
+        protocol_queue_frame(pc);
+#endif /* PROTOCOL_IGNORE_CRC */
+        return PFC_WARNING;
+    }
+
+    /* The handlers fill the answers as packets, the answers are copied to the frame */
+    pc->frame_to_send = answer;
+    pc->packet_to_send = &record_answer;
+    uint16_t offset = 0;
+    while (offset < len)
+    {
+        /* The rest of the commands is not run if the longest answer does not fit: the panel sends them again */
+        if (answer->fields.len + sizeof(struct frame_record_s) + MAXIMUM_RECORD_DATA_LENGTH > MAXIMUM_FRAME_DATA_LENGTH) break;
+
+        struct frame_record_s record;
+        if ((uint32_t)(len - offset) < sizeof(record))
+        {
+            answer->fields.status.fields.error = 1;
+            break;
+        }
+        memcpy(&record, records + offset, sizeof(record));
+        offset += sizeof(record);
+        if (record.len > len - offset)
+        {
+            answer->fields.status.fields.error = 1;
+            break;
+        }
+        protocol_dispatch_record(pc, &record, records + offset);
+        offset += record.len;
+    }
+    pc->frame_to_send = 0;
+    pc->packet_to_send = &packets_to_send[pc->send_index].packet;
+    protocol_queue_frame(pc);
+    return PFC_SUCCESS;
+}
+
+/**
+ * @brief Copy the bytes of a frame: the header, then the records, the CRC and the stop byte
+ * 
+ * @param pc The protocol context structure
+ * @param data The received data
+ * @param len The size of the received data
+ * @param[out] status PFC_NULL if the frame is not finished, the status of the frame processing otherwise
+ * 
+ * @return The number of the bytes copied
+ */
+static uint32_t protocol_parse_frame(protocol_context_t *pc, const uint8_t *data, uint32_t len, status_t *status)
+{
+    frame_t *frame = &pc->frame_received;
+    uint8_t header = pc->frame_index < FRAME_HEADER_LENGTH;
+    uint32_t total = header ? FRAME_HEADER_LENGTH : FRAME_SERVICE_LENGTH + frame->fields.len;
+    uint32_t count = total - pc->frame_index;
+    if (count > len) count = len;
+
+    memcpy(frame->data + pc->frame_index, data, count);
+    pc->frame_index += count;
+    if (pc->frame_index < total) return count;
+
+    if (header)
+    {
+        /* The frame is dropped, the start byte is looked for after the header */
+        if (frame->fields.status.raw > PROTOCOL_STATUS_MAX || frame->fields.len > MAXIMUM_FRAME_DATA_LENGTH) pc->stage = PROTOCOL_START;
+        return count;
+    }
+    pc->stage = PROTOCOL_START;
+    *status = protocol_process_frame(pc);
+    return count;
+}
+
 /*--------------------------------------------------------------
                        PUBLIC FUNCTIONS
 --------------------------------------------------------------*/
@@ -120,12 +570,16 @@ status_t protocol_init(PFC_COMMAND_CALLBACK *handlers,
 {
     protocol.handlers = handlers;
     protocol.handlers_count = handlers_count;
+    protocol.send_index = 0;
+    protocol.packet_to_send = &packets_to_send[0].packet;
+    protocol.frame_to_send = 0;
 
     return PFC_SUCCESS;
 }
 
 /*
- * @brief Send a packet to the panel
+ * @brief Send a packet to the panel: the packet is queued, the next answer is written to the next packet.
+ * The answer to a command of a frame is added to the answer frame
  * 
  * @param pc Protocol context structure
  * 
@@ -134,15 +588,29 @@ status_t protocol_init(PFC_COMMAND_CALLBACK *handlers,
 status_t protocol_send_packet(protocol_context_t *pc)
 {
     pc->stage = PROTOCOL_START;
-    pc->packet_to_send.fields.start = PROTOCOL_START_BYTE;
-    uint16_t crcsend = crc16(pc->packet_to_send.data + 1,
-                             pc->packet_to_send.fields.len);
-
-    pc->packet_to_send.data[pc->packet_to_send.fields.len + 1] = crcsend & 0xFF;
-    pc->packet_to_send.data[pc->packet_to_send.fields.len + 2] = crcsend >> 8;
-    pc->packet_to_send.data[pc->packet_to_send.fields.len + 3] = PROTOCOL_STOP_BYTE;
-    adapter_send_packet(pc->packet_to_send.data, pc->packet_to_send.fields.len + MINIMUM_PACKET_LENGTH);
-    return PFC_SUCCESS;
+    if (pc->frame_to_send) return protocol_append_record(pc);
+    return protocol_queue_packet(pc);
+}
+
+/*
+ * @brief Get the packet to fill for a push (a packet sent without a request)
+ *
+ * @return The packet
+ */
+packet_t *protocol_get_push_packet(void)
+{
+    return protocol.packet_to_send;
+}
+
+/*
+ * @brief Send the push packet to the panel (the parsing of the received data is not affected)
+ *
+ * @return Status of the operation: PFC_NULL if the transmission queue is full
+ */
+status_t protocol_push_packet(void)
+{
+    if (adapter_tx_ready() != PFC_SUCCESS) return PFC_NULL;
+    return protocol_queue_packet(&protocol);
 }
 
 /*
@@ -156,7 +624,7 @@ status_t protocol_send_packet(protocol_context_t *pc)
 void protocol_error_handle(protocol_context_t *pc, uint8_t command)
 {
     packet_t *out;
-    out = &pc->packet_to_send;
+    out = pc->packet_to_send;
     packet_clear_status(out);
     packet_set_error(out, 1);
     packet_set_command(out, command);
@@ -183,135 +651,26 @@ void protocol_unknown_command_handle(protocol_context_t *pc)
  */
 status_t protocol_work(void)
 {
-    uint8_t byte;
+    const uint8_t *data;
+    uint32_t len;
     status_t receive_status = PFC_NULL;
-    while ((receive_status = adapter_get_byte(&byte)) == PFC_SUCCESS)
+    /* The back-pressure: the requests are kept in the receiver while the answers can not be queued */
+    while (adapter_tx_ready() == PFC_SUCCESS && (receive_status = adapter_get_data(&data, &len)) == PFC_SUCCESS)
     {
-        switch (protocol.stage)
+        status_t status = PFC_NULL;
+        uint32_t parsed = 0;
+        while (parsed < len && status == PFC_NULL)
         {
-            case PROTOCOL_START:
-                if (byte == PROTOCOL_START_BYTE)
-                {
-                    protocol.stage = PROTOCOL_STATUS;
-                }
-                break;
-            case PROTOCOL_STATUS:
-                if (byte > PROTOCOL_STATUS_MAX)
-                {
-                    protocol.stage = PROTOCOL_START;
-                }
-                else
-                {
-                    protocol.stage = PROTOCOL_LEN;
-                    protocol.packet_received.fields.status.raw = byte;
-                }
-                break;
-            case PROTOCOL_LEN:
-                protocol.stage = PROTOCOL_COMMAND;
-                protocol.packet_received.fields.len = byte;
-                if (byte < MINIMUM_PACKET_LENGTH)
-                {
-                    protocol.stage = PROTOCOL_START;
-                }
-                else
-                {
-                    if (byte > (MAXIMUM_PACKET_LENGTH - 4))
-                    {
-                        protocol.stage = PROTOCOL_START;
-                    }
-                    protocol.size = byte;
-                    protocol.data_pointer = protocol.packet_received.data + MINIMUM_PACKET_LENGTH;
-                }
-                break;
-            case PROTOCOL_COMMAND:
-                protocol.packet_received.fields.command = byte;
-                if (protocol.packet_received.fields.len == MINIMUM_PACKET_LENGTH)
-                {
-                    protocol.stage = PROTOCOL_CRC;
-                }
-                else
-                {
-                    protocol.stage = PROTOCOL_DATA;
-                }
-                protocol.size--;
-                break;
-            case PROTOCOL_DATA:
-                *(protocol.data_pointer) = byte;
-                protocol.size--;
-                protocol.data_pointer++;
-                if (protocol.size > (MAXIMUM_PACKET_LENGTH - 4))
-                {
-                    protocol.stage = PROTOCOL_START;
-                }
-                if (protocol.size <= MINIMUM_PACKET_LENGTH - 1)
-                {
-                    protocol.stage = PROTOCOL_CRC;
-                }
-                break;
-            case PROTOCOL_CRC:
-                protocol.size--;
-                *(protocol.data_pointer) = byte;
-                protocol.data_pointer++;
-                if (protocol.size == 1)
-                {
-                    protocol.stage = PROTOCOL_STOP;
-                }
-                break;
-            case PROTOCOL_STOP:
-                protocol.size--;
-                if (byte == PROTOCOL_STOP_BYTE)
-                {
-                    *(protocol.data_pointer) = byte;
-                    protocol.data_pointer++;
-
-                    uint16_t crcget = packet_get_crc(&protocol.packet_received);
-                    uint16_t crccalc = packet_calculate_crc(&protocol.packet_received);
-                    if (crcget != crccalc)
-                    {
-#if PROTOCOL_IGNORE_CRC == 0
-                        packet_clear_status(&protocol.packet_to_send);
-                        protocol.packet_to_send.fields.status.fields.crc_error = 1;
-                        packet_set_data_len(&protocol.packet_to_send, 0);
-                        protocol_send_packet(&protocol);
-#endif /* PROTOCOL_IGNORE_CRC */
-                        return PFC_WARNING;
-                    }
-
-#if PROTOCOL_IGNORE_CRC == 0
-                    else if (protocol.packet_received.fields.status.fields.crc_error)
-                    {
-                        protocol_send_packet(&protocol);
-                        return PFC_WARNING;
-                    }
-                    else
-                    {
-                        protocol.packet_received.fields.status.fields.crc_error = 0;
-                    }
-#endif /* PROTOCOL_IGNORE_CRC */
-
-                    if (protocol.packet_received.fields.command >= protocol.handlers_count)
-                    {
-#if PROTOCOL_IGNORE_UNKNOWN_COMMAND == 1
-#else /* PROTOCOL_IGNORE_UNKNOWN_COMMAND */
-                        protocol_unknown_command_handler(&protocol);
-#endif /* PROTOCOL_IGNORE_UNKNOWN_COMMAND */
-                    }
-                    else
-                    {
-                        PFC_COMMAND_CALLBACK handler = protocol.handlers[protocol.packet_received.fields.command];
-                        if (handler) handler(&protocol);
-                    }
-                }
-                else
-                {
-                    //protocol.packet_received.fields.status.fields.unexpected_stop = 1;
-                }
-                protocol.stage = PROTOCOL_START;
-                return PFC_SUCCESS;
-            default:
-                protocol.stage = PROTOCOL_START;
-                break;
+            if (protocol.stage == PROTOCOL_FRAME)
+            {
+                parsed += protocol_parse_frame(&protocol, data + parsed, len - parsed, &status);
+                continue;
+            }
+            if (protocol.stage == PROTOCOL_DATA) parsed += protocol_parse_data(&protocol, data + parsed, len - parsed);
+            if (parsed < len) status = protocol_parse_byte(&protocol, data[parsed++]);
         }
+        adapter_release(parsed);
+        if (status != PFC_NULL) return status;
     }
     if (receive_status == PFC_WARNING)
     {
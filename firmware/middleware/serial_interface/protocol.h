@@ -13,8 +13,11 @@
 
 #include "BSP/debug.h"
 #include "adc_logic.h"
+#include "capture.h"
 #include "defines.h"
 #include "events.h"
+#include "pfc_logic.h"
+#include "tasks.h"
 
 /*--------------------------------------------------------------
                        DEFINES
@@ -32,6 +35,33 @@
 /** The maximum number of events that can be transferred */
 #define MAX_NUM_TRANSFERED_EVENTS (MAX_EVENTS_PACKET_SIZE / (sizeof(struct event_record_s)))
 
+#define MAX_TRACE_PACKET_SIZE (192) /**< The maximum size of the packet that can be occupied by state transitions */
+
+/** The maximum number of state transitions that can be transferred */
+#define MAX_NUM_TRANSFERED_TRANSITIONS (MAX_TRACE_PACKET_SIZE / (sizeof(struct pfc_transition_record_s)))
+
+#define MAX_CAPTURES_PACKET_SIZE (150) /**< The maximum size of the packet that can be occupied by capture descriptions */
+
+/** The maximum number of capture descriptions that can be transferred */
+#define MAX_NUM_TRANSFERED_CAPTURES (MAX_CAPTURES_PACKET_SIZE / (sizeof(struct capture_record_s)))
+
+#define MAX_TELEMETRY_PACKET_SIZE (MAXIMUM_PACKET_LENGTH - 2 * MINIMUM_PACKET_LENGTH) /**< The maximum size of the data of a push */
+
+#define PROTOCOL_VERSION (2) /**< The latest framing supported: 1 - the packets, 2 - the frames with the sequence numbers */
+
+#define FRAME_HEADER_LENGTH        (6)                                            /**< The frame header: the start, the status, the length, the sequence number */
+#define FRAME_SERVICE_LENGTH       (FRAME_HEADER_LENGTH + 3)                      /**< The service bytes of a frame: the header, the CRC and the stop byte */
+#define MAXIMUM_FRAME_LENGTH       (512)                                          /**< The maximum length of a frame (the requests and the answers) */
+#define MAXIMUM_FRAME_DATA_LENGTH  (MAXIMUM_FRAME_LENGTH - FRAME_SERVICE_LENGTH)  /**< The maximum size of the records of a frame */
+#define MAXIMUM_RECORD_DATA_LENGTH (MAXIMUM_PACKET_LENGTH - 2 * MINIMUM_PACKET_LENGTH) /**< The data of a record is limited as in a packet */
+
+#define OSCILLOG_CHUNK_SIZE (192) /**< The maximum size of the encoded oscillogram snapshot in an answer */
+
+#define MAX_SAMPLES_PACKET_SIZE (160) /**< The maximum size of the packet that can be occupied by capture samples */
+
+/** The maximum number of capture samples that can be transferred */
+#define MAX_NUM_TRANSFERED_SAMPLES (MAX_SAMPLES_PACKET_SIZE / (sizeof(float)))
+
 /*--------------------------------------------------------------
                        PUBLIC TYPES
 --------------------------------------------------------------*/
@@ -53,6 +83,7 @@ typedef enum
     PROTOCOL_DATA,
     PROTOCOL_CRC,
     PROTOCOL_STOP,
+    PROTOCOL_FRAME, /**< A frame (the version 2 framing) is being received */
 } protocol_stage_t;
 
 /** Protocol status byte structure */
@@ -83,6 +114,30 @@ typedef union
     uint8_t data[MAXIMUM_PACKET_LENGTH];
 } packet_t;
 
+/**
+ * @brief The frame structure (the version 2 framing): the records of the commands follow the header,
+ * the CRC16 (of the bytes after the start one) and the stop byte follow the records
+ */
+typedef union
+{
+    struct _PACKED
+    {
+        uint8_t start;
+        status_byte_t status;
+        uint16_t len;      /**< The size of the records */
+        uint16_t sequence; /**< The number of the request (echoed in the answer) */
+    } fields;
+    uint8_t data[MAXIMUM_FRAME_LENGTH];
+} frame_t;
+
+/** The record of a command (an answer) in a frame, the data follows */
+struct _PACKED frame_record_s
+{
+    uint8_t command;
+    status_byte_t status;
+    uint16_t len; /**< The size of the data */
+};
+
 /** The protocol context */
 typedef struct
 {
@@ -92,10 +147,15 @@ typedef struct
     protocol_stage_t stage;
 
     packet_t packet_received;
-    packet_t packet_to_send;
+    packet_t *packet_to_send; /**< The answer being filled (in the transmit queue: sent without a copy) */
+    uint8_t send_index;       /**< The index of the answer in the transmit queue */
 
     uint8_t *data_pointer;
     uint8_t size;
+
+    frame_t frame_received;  /**< The frame being received (the version 2 framing) */
+    uint16_t frame_index;    /**< The number of the bytes of the frame received */
+    frame_t *frame_to_send;  /**< The answer frame being filled with the records, NULL - the answers are sent as packets */
 } protocol_context_t;
 
 /*--------------------------------------------------------------
@@ -182,6 +242,20 @@ struct _PACKED answer_get_work_state
     uint32_t active_channels[PFC_NCHAN];
 };
 
+/** Command: Test the connection, negotiate the framing (the data is optional) */
+struct _PACKED command_test
+{
+    uint8_t version; /**< The latest framing supported by the panel */
+};
+
+/** Answer: Test the connection (the answer is in the framing of the request) */
+struct _PACKED answer_test
+{
+    uint8_t version;      /**< The latest framing supported by the firmware (PROTOCOL_VERSION) */
+    uint16_t frame_size;  /**< The maximum length of a frame (MAXIMUM_FRAME_LENGTH) */
+    uint16_t record_size; /**< The maximum size of the data of a record (MAXIMUM_RECORD_DATA_LENGTH) */
+};
+
 /** Command: Get the version info */
 struct _PACKED command_get_version_info
 {
@@ -373,16 +447,167 @@ struct _PACKED answer_get_net_params
 /** Command: Get events */
 struct _PACKED command_get_events
 {
-    uint64_t after_index;
+    uint32_t sequence; /**< The sequence number of the first event to get */
 };
 
 /** Answer: Get events */
 struct _PACKED answer_get_events
 {
+    uint32_t last_sequence; /**< The sequence number of the last event in the device */
     uint16_t num;
     struct event_record_s events[MAX_NUM_TRANSFERED_EVENTS];
 };
 
+/** Command: Get the state transitions trace */
+struct _PACKED command_get_state_trace
+{
+    uint32_t after_index;
+};
+
+/** Answer: Get the state transitions trace */
+struct _PACKED answer_get_state_trace
+{
+    uint32_t first_index;
+    uint32_t total;
+    uint16_t num;
+    struct pfc_transition_record_s transitions[MAX_NUM_TRANSFERED_TRANSITIONS];
+};
+
+/** Command: Set the waveform capture */
+struct _PACKED command_set_capture
+{
+    uint8_t triggers;      /**< The enabled triggers (capture_trigger_t mask) */
+    uint16_t post_samples; /**< The post-trigger window [samples] */
+    uint8_t trigger;       /**< Trigger a capture now (if CAPTURE_TRIGGER_COMMAND is enabled) */
+};
+
+/** Answer: Set the waveform capture */
+struct _PACKED answer_set_capture
+{
+    uint8_t result; /**< 1 - the settings have been applied, 0 - wrong settings */
+};
+
+/** Command: Get the list of the waveform captures */
+struct _PACKED command_get_captures
+{
+    uint8_t null;
+};
+
+/** Answer: Get the list of the waveform captures */
+struct _PACKED answer_get_captures
+{
+    uint8_t triggers;      /**< The enabled triggers (capture_trigger_t mask) */
+    uint16_t post_samples; /**< The post-trigger window [samples] */
+    uint16_t max_samples;  /**< The length of a capture [samples] */
+    uint8_t channels;      /**< The number of the channels (as ADC channels with the mathematical ones) */
+    uint8_t num;
+    struct capture_record_s captures[MAX_NUM_TRANSFERED_CAPTURES];
+};
+
+/** Command: Get the samples of a waveform capture */
+struct _PACKED command_get_capture_data
+{
+    uint32_t sequence; /**< The number of the capture */
+    uint8_t channel;   /**< The channel */
+    uint16_t offset;   /**< The first sample (from the start of the capture) */
+};
+
+/** Answer: Get the samples of a waveform capture */
+struct _PACKED answer_get_capture_data
+{
+    uint32_t sequence;
+    uint8_t channel;
+    uint16_t offset;
+    uint16_t num; /**< The number of the samples (0 - the capture has been overwritten or the end is reached) */
+    float data[MAX_NUM_TRANSFERED_SAMPLES];
+};
+
+/** Command: Get the oscillogram channels of a period in the full resolution (the encoded snapshot by chunks) */
+struct _PACKED command_get_oscillog_bulk
+{
+    uint16_t channels; /**< The channels of a new snapshot (a mask) */
+    uint16_t snapshot; /**< The number of the snapshot, 0 - take a new snapshot */
+    uint16_t offset;   /**< The offset of the chunk in the encoded snapshot */
+};
+
+/**
+ * @brief Answer: Get the oscillogram channels of a period in the full resolution
+ * @note The snapshot holds the encoded channels in the order of the mask bits (see oscillog_codec.h),
+ * the data is sent up to the length of the chunk
+ */
+struct _PACKED answer_get_oscillog_bulk
+{
+    uint16_t snapshot; /**< The number of the snapshot: all the chunks of a snapshot are of the same period */
+    uint16_t channels; /**< The channels of the snapshot (a mask) */
+    uint16_t samples;  /**< The number of the samples of a channel */
+    uint16_t size;     /**< The size of the encoded snapshot */
+    uint16_t offset;   /**< The offset of the chunk */
+    uint8_t len;       /**< The size of the chunk, 0 - the snapshot has been replaced or the offset is at the end */
+    uint8_t data[OSCILLOG_CHUNK_SIZE];
+};
+
+/** Command: Subscribe to the telemetry (renew the subscription, cancel it) */
+struct _PACKED command_subscribe
+{
+    uint8_t groups;     /**< The groups (telemetry_group_t mask), 0 - cancel the subscription */
+    uint16_t oscillogs; /**< The oscillogram channels (a mask) for TELEMETRY_GROUP_OSCILLOG */
+    uint8_t decimation; /**< The push is made every decimation periods of the network */
+    uint16_t timeout;   /**< The subscription time without a renewal [ms], 0 - the default time */
+};
+
+/** Answer: Subscribe to the telemetry */
+struct _PACKED answer_subscribe
+{
+    uint8_t result;    /**< 1 - the subscription has been applied, 0 - wrong parameters */
+    uint32_t sequence; /**< The number of the last push packet */
+};
+
+/** Push: Telemetry (the blocks of the groups follow the header in the order of the bits) */
+struct _PACKED answer_telemetry
+{
+    uint32_t sequence; /**< The number of the push packet (incremented for every packet) */
+    uint8_t groups;    /**< The groups in the packet (telemetry_group_t mask) */
+};
+
+/** Bundle sections (a mask): the sections of the answer follow the header in the order of the bits */
+enum
+{
+    BUNDLE_SECTION_ADC_ACTIVE = (1U << 0),     /**< The active values (as answer_get_adc_active) */
+    BUNDLE_SECTION_ADC_ACTIVE_RAW = (1U << 1), /**< The active values without the calibrations (as answer_get_adc_active_raw) */
+    BUNDLE_SECTION_NET_PARAMS = (1U << 2),     /**< The network parameters (as answer_get_net_params) */
+    BUNDLE_SECTION_WORK_STATE = (1U << 3),     /**< The work state (as answer_get_work_state) */
+    BUNDLE_SECTIONS_ALL = 0x0F,                /**< All the sections */
+};
+
+/** Command: Get the live values of a period at once (the sections replace the separate requests) */
+struct _PACKED command_get_bundle
+{
+    uint8_t sections;     /**< The sections (a mask) */
+    uint64_t currentTime; /**< The time of the panel, set with BUNDLE_SECTION_WORK_STATE (as command_get_work_state) */
+};
+
+/** Answer: Get the live values of a period at once (the sections follow the header in the order of the bits) */
+struct _PACKED answer_get_bundle
+{
+    uint32_t period;  /**< The number of the period of the values (incremented for every period) */
+    uint8_t sections; /**< The sections in the answer (a mask), the unknown ones are omitted */
+};
+
+/** Command: Get the statistics of the main loop tasks */
+struct _PACKED command_get_scheduler_stats
+{
+    uint8_t clear; /**< 1 - the statistics are cleared after the read */
+};
+
+/** Answer: Get the statistics of the main loop tasks and the control interrupt */
+struct _PACKED answer_get_scheduler_stats
+{
+    uint8_t num;                                  /**< The number of the tasks */
+    struct scheduler_stats_s tasks[TASKS_COUNT]; /**< The statistics (in the order of task_t) */
+    uint32_t isr_cycles_last;                     /**< The cycles of the last run of the control interrupt */
+    uint32_t isr_cycles_max;                      /**< The maximum cycles of a run of the control interrupt */
+};
+
 /** Event types: subevents for power control */
 enum
 {
@@ -407,6 +632,16 @@ enum
     SUB_EVENT_TYPE_PROTECTION_IGBT,
 };
 
+/** Event types: other events */
+enum
+{
+    SUB_EVENT_TYPE_EVENT_SUPPRESSED,      /**< Repeated protection events have been suppressed (info: the subevent << 16 | the channel, value: the count) */
+    SUB_EVENT_TYPE_EVENT_SETTINGS_SAVED,  /**< The settings have been written to the flash memory (info: the number of the save, value: the time [ms]) */
+    SUB_EVENT_TYPE_EVENT_SETTINGS_FAILED, /**< The settings have not been written: a flash memory error (info: the number of the save) */
+    SUB_EVENT_TYPE_EVENT_ADC_FAILED,        /**< The ADC DMA conversion has not been started, the fault state (info: the status) */
+    SUB_EVENT_TYPE_EVENT_SETTINGS_DEFERRED  /**< The settings have not been written: the PWM has been on until the deadline of the page transfer (info: the number of the save, value: the time [ms]) */
+};
+
 /** Protection event types */
 enum
 {
@@ -455,6 +690,20 @@ status_t protocol_init(PFC_COMMAND_CALLBACK *handlers,
  */
 status_t protocol_send_packet(protocol_context_t *pc);
 
+/**
+ * @brief Get the packet to fill for a push (a packet sent without a request)
+ *
+ * @return The packet
+ */
+packet_t *protocol_get_push_packet(void);
+
+/**
+ * @brief Send the push packet to the panel (the parsing of the received data is not affected)
+ *
+ * @return Status of the operation: PFC_NULL if the transmission queue is full
+ */
+status_t protocol_push_packet(void);
+
 /**
  * @brief Send an error packet to the panel
  * 
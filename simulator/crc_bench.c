@@ -0,0 +1,178 @@
+/**
+ * @file crc_bench.c
+ * @author Stanislav Karpikov
+ * @brief CRC16 benchmark: the check of the table calculation and the throughput, the check of CRC32
+ */
+
+/** @addtogroup sim_crc_bench
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "crc_bench.h"
+
+#include "crc.h"
+#include "string.h"
+#include "time.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define CRC_BENCH_INITIAL_VALUE    (0x1D0FU)     /**< Initial CRC16 value of the protocol */
+#define CRC_BENCH_POLYNOMIAL_VALUE (0x1021U)     /**< Polynomial CRC16 value (CCITT) */
+#define CRC_BENCH_BLOCK_SIZE       (256U)        /**< The maximum size of a random block (longer than a packet) */
+#define CRC_BENCH_BLOCKS_NUM       (64U)         /**< The number of the random blocks */
+#define CRC_BENCH_SEED             (0x6C8E9CF5U) /**< The initial value of the data generator */
+
+/*--------------------------------------------------------------
+                       PRIVATE TYPES
+--------------------------------------------------------------*/
+
+/** A reference vector */
+typedef struct
+{
+    const char* data; /**< The data */
+    uint16_t crc;     /**< The CRC of the data */
+} crc_bench_vector_t;
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+/** The reference vectors: the check value of CRC-16/AUG-CCITT (the same parameters), the initial value of the empty block */
+static const crc_bench_vector_t crc_bench_vectors[] = {
+    {"123456789", 0xE5CC},
+    {"", 0x1D0F},
+    {"A", 0x9479},
+};
+
+/** A reference vector of CRC32 */
+typedef struct
+{
+    const char* data; /**< The data */
+    uint32_t crc;     /**< The CRC of the data */
+} crc_bench_vector32_t;
+
+/** The reference vectors of CRC32: the check value of CRC-32/ISO-HDLC, the empty block */
+static const crc_bench_vector32_t crc_bench_vectors32[] = {
+    {"123456789", 0xCBF43926U},
+    {"", 0x00000000U},
+    {"a", 0xE8B7BE43U},
+};
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Calculate CRC16 bit by bit (the reference: the former firmware calculation)
+ *
+ * @param datablock The pointer to the data block
+ * @param len The size of the data block
+ *
+ * @return The CRC of the block
+ */
+static uint16_t crc_bench_bitwise(const uint8_t* datablock, uint32_t len)
+{
+    uint16_t crc = CRC_BENCH_INITIAL_VALUE;
+    for (uint32_t b = 0; b < len; b++)
+    {
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            uint16_t bit = (datablock[b] >> (7 - i)) & 1;
+            uint16_t c15 = (crc >> 15) & 1;
+            crc <<= 1;
+            if (c15 ^ bit) crc ^= CRC_BENCH_POLYNOMIAL_VALUE;
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Get the next pseudo-random number (xorshift)
+ *
+ * @param[in,out] state The generator state
+ *
+ * @return The number
+ */
+static uint32_t crc_bench_random(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Check the firmware CRC16 with the reference vectors and the bit-serial calculation, measure the time;
+ * check the firmware CRC32 with the reference vectors
+ *
+ * @param rounds The number of the passes over the test blocks
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t crc_bench_run(uint32_t rounds, crc_bench_result_t* result)
+{
+    ARGUMENT_ASSERT(result);
+    memset(result, 0, sizeof(crc_bench_result_t));
+
+    for (uint32_t i = 0; i < sizeof(crc_bench_vectors) / sizeof(crc_bench_vectors[0]); i++)
+    {
+        const crc_bench_vector_t* vector = &crc_bench_vectors[i];
+        uint32_t len = (uint32_t)strlen(vector->data);
+        if (crc16((const uint8_t*)vector->data, len) != vector->crc) result->mismatches++;
+        if (crc_bench_bitwise((const uint8_t*)vector->data, len) != vector->crc) result->mismatches++;
+        result->vectors++;
+    }
+    for (uint32_t i = 0; i < sizeof(crc_bench_vectors32) / sizeof(crc_bench_vectors32[0]); i++)
+    {
+        const crc_bench_vector32_t* vector = &crc_bench_vectors32[i];
+        if (crc32((const uint8_t*)vector->data, (uint32_t)strlen(vector->data)) != vector->crc) result->mismatches++;
+        result->vectors++;
+    }
+
+    /* The blocks of all the sizes at all the alignments */
+    static uint8_t blocks[CRC_BENCH_BLOCKS_NUM][CRC_BENCH_BLOCK_SIZE + sizeof(uint32_t)];
+    uint32_t lengths[CRC_BENCH_BLOCKS_NUM];
+    uint32_t random = CRC_BENCH_SEED;
+    for (uint32_t i = 0; i < CRC_BENCH_BLOCKS_NUM; i++)
+    {
+        for (uint32_t j = 0; j < sizeof(blocks[i]); j++) blocks[i][j] = (uint8_t)crc_bench_random(&random);
+        lengths[i] = crc_bench_random(&random) % (CRC_BENCH_BLOCK_SIZE + 1);
+        uint32_t offset = i % sizeof(uint32_t);
+        if (crc16(blocks[i] + offset, lengths[i]) != crc_bench_bitwise(blocks[i] + offset, lengths[i])) result->mismatches++;
+        result->blocks++;
+    }
+
+    /* The sums are kept to calculate the CRC for real */
+    volatile uint16_t sum = 0;
+    clock_t start = clock();
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        for (uint32_t i = 0; i < CRC_BENCH_BLOCKS_NUM; i++) sum += crc_bench_bitwise(blocks[i], lengths[i]);
+    }
+    result->bitwise_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        for (uint32_t i = 0; i < CRC_BENCH_BLOCKS_NUM; i++) sum += crc16(blocks[i], lengths[i]);
+    }
+    result->table_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+    (void)sum;
+
+    for (uint32_t i = 0; i < CRC_BENCH_BLOCKS_NUM; i++) result->bytes += lengths[i] * rounds;
+    return PFC_SUCCESS;
+}
+/** @} */
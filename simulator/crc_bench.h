@@ -0,0 +1,52 @@
+/**
+ * @file crc_bench.h
+ * @author Stanislav Karpikov
+ * @brief CRC16 benchmark: the check of the table calculation and the throughput, the check of CRC32 (header)
+ */
+
+#ifndef _CRC_BENCH_H
+#define _CRC_BENCH_H
+
+/** @addtogroup sim_crc_bench
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/debug.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** CRC16 benchmark results */
+typedef struct
+{
+    uint32_t vectors;      /**< The number of the reference vectors checked (CRC16 and CRC32) */
+    uint32_t blocks;       /**< The number of the random blocks compared with the bit-serial calculation */
+    uint32_t mismatches;   /**< The number of the wrong CRC values */
+    uint32_t bytes;        /**< The number of the bytes calculated by every method */
+    double bitwise_time;   /**< The time of the bit-serial calculation [s] */
+    double table_time;     /**< The time of the table calculation [s] */
+} crc_bench_result_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Check the firmware CRC16 with the reference vectors and the bit-serial calculation, measure the time;
+ * check the firmware CRC32 with the reference vectors
+ *
+ * @param rounds The number of the passes over the test blocks
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t crc_bench_run(uint32_t rounds, crc_bench_result_t* result);
+
+/** @} */
+#endif /* _CRC_BENCH_H */
@@ -0,0 +1,226 @@
+/**
+ * @file eeprom_bench.c
+ * @author Stanislav Karpikov
+ * @brief EEPROM emulation benchmark: the settings load at the start from a full page
+ */
+
+/** @addtogroup sim_eeprom_bench
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "eeprom_bench.h"
+
+#include "BSP/bsp.h"
+#include "BSP/flash.h"
+#include "eeprom_emulation.h"
+#include "host_bsp.h"
+#include "settings.h"
+#include "string.h"
+#include "time.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define EEPROM_BENCH_VARIABLES (sizeof(settings_t) / 2) /**< The number of the variables: the halfwords of the settings */
+#define EEPROM_BENCH_CHANGES   (8U)                      /**< The maximum number of the variables changed by a save */
+#define EEPROM_BENCH_SAVES_MAX (100000U)                 /**< The limit of the saves to fill the page */
+#define EEPROM_BENCH_SEED      (0x2545F491U)             /**< The initial value of the data generator */
+
+#define EEPROM_BENCH_PAGE0  (EEPROM_START_ADDRESS)                         /**< The first page address */
+#define EEPROM_BENCH_PAGE1  (EEPROM_START_ADDRESS + EEPROM_PAGE_FULL_SIZE) /**< The second page address */
+#define EEPROM_BENCH_VALID  (0x0000U)                                      /**< The status of the valid page */
+#define EEPROM_BENCH_ERASED (0xFFFFU)                                      /**< The status of the erased page */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Get the next pseudo-random number (xorshift)
+ *
+ * @param[in,out] state The generator state
+ *
+ * @return The number
+ */
+static uint32_t eeprom_bench_random(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief Read a half word of the flash memory
+ *
+ * @param address The address
+ *
+ * @return The data
+ */
+static uint16_t eeprom_bench_read_halfword(uint32_t address)
+{
+    uint16_t data = 0xFFFF;
+    flash_read(address, &data, sizeof(data));
+    return data;
+}
+
+/**
+ * @brief Read a variable with a scan of the valid page from the end (the reference: the former firmware read)
+ *
+ * @param address The variable virtual address
+ * @param[out] data The data
+ *
+ * @return The status of the operation
+ */
+static eeprom_status_t eeprom_bench_linear_read(uint16_t address, uint16_t* data)
+{
+    uint16_t status0 = eeprom_bench_read_halfword(EEPROM_BENCH_PAGE0);
+    uint16_t status1 = eeprom_bench_read_halfword(EEPROM_BENCH_PAGE1);
+    uint32_t page_base;
+    if (status0 == EEPROM_BENCH_VALID && status1 == EEPROM_BENCH_ERASED)
+        page_base = EEPROM_BENCH_PAGE0;
+    else if (status1 == EEPROM_BENCH_VALID && status0 == EEPROM_BENCH_ERASED)
+        page_base = EEPROM_BENCH_PAGE1;
+    else
+        return EEPROM_NO_VALID_PAGE;
+
+    for (uint32_t slot = page_base + EEPROM_PAGE_SIZE - 2; slot >= page_base + 6; slot -= 4)
+    {
+        if (eeprom_bench_read_halfword(slot) == address)
+        {
+            *data = eeprom_bench_read_halfword(slot - 2);
+            return EEPROM_OK;
+        }
+    }
+    return EEPROM_BAD_ADDRESS;
+}
+
+/**
+ * @brief Get the number of the bytes read from the flash memory
+ *
+ * @return The number of the bytes
+ */
+static uint32_t eeprom_bench_read_bytes(void)
+{
+    host_flash_state_t state;
+    host_flash_get_state(&state);
+    return state.read_bytes;
+}
+
+/**
+ * @brief Fail a write with an injected error while the erases are forbidden and write again: the recovery of the
+ * emulation (the init, it can erase a page) waits for the erases
+ *
+ * @param address The variable to write
+ * @param value The value (differs from the stored one)
+ *
+ * @return 1 if the recovery has been deferred (no erases) and is done after the erases are allowed
+ */
+static uint8_t eeprom_bench_recovery(uint16_t address, uint16_t value)
+{
+    host_flash_state_t before, after;
+    host_flash_get_state(&before);
+    host_flash_set_error(1);
+    eeprom_status_t status = eeprom_update_variable(address, value);
+    host_flash_set_error(0);
+    if (status == EEPROM_OK) return 0;
+
+    status = eeprom_update_variable(address, value);
+    host_flash_get_state(&after);
+    uint8_t deferred = (status == EEPROM_PAGE_FULL) &&
+                       !memcmp(before.eeprom_erases, after.eeprom_erases, sizeof(before.eeprom_erases));
+
+    eeprom_allow_erase(1);
+    if (eeprom_init() != EEPROM_OK) deferred = 0;
+    eeprom_allow_erase(0);
+    return deferred;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Fill the EEPROM page with the settings saves (no page transfer), then load the settings as at the start
+ * with the RAM index and with the page scans (the former reads), check the values and measure the time. A write error
+ * is injected while the erases are forbidden: the recovery of the emulation should wait for them
+ *
+ * @param rounds The number of the loads by every method
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t eeprom_bench_run(uint32_t rounds, eeprom_bench_result_t* result)
+{
+    ARGUMENT_ASSERT(result);
+    memset(result, 0, sizeof(eeprom_bench_result_t));
+    result->variables = EEPROM_BENCH_VARIABLES;
+
+    host_flash_erase_all();
+    if (eeprom_init() != EEPROM_OK) return PFC_ERROR_GENERIC;
+
+    /* The saves change a few variables each, the page is filled up to the transfer (the worst case of the scans) */
+    uint16_t values[EEPROM_BENCH_VARIABLES];
+    uint32_t random = EEPROM_BENCH_SEED;
+    eeprom_status_t status = EEPROM_OK;
+    memset(values, 0, sizeof(values));
+    eeprom_allow_erase(0);
+    for (uint16_t address = 0; address < EEPROM_BENCH_VARIABLES && status == EEPROM_OK; address++)
+    {
+        status = eeprom_update_variable(address, values[address]);
+    }
+    if (status == EEPROM_OK) result->recovery_deferred = eeprom_bench_recovery(0, values[0] + 1);
+    while (status == EEPROM_OK && result->saves < EEPROM_BENCH_SAVES_MAX)
+    {
+        uint32_t changes = 1 + eeprom_bench_random(&random) % EEPROM_BENCH_CHANGES;
+        for (uint32_t i = 0; i < changes && status == EEPROM_OK; i++)
+        {
+            uint16_t address = eeprom_bench_random(&random) % EEPROM_BENCH_VARIABLES;
+            uint16_t value = (uint16_t)eeprom_bench_random(&random);
+            status = eeprom_update_variable(address, value);
+            if (status == EEPROM_OK) values[address] = value;
+        }
+        result->saves++;
+    }
+    eeprom_allow_erase(1);
+    if (status != EEPROM_PAGE_FULL) return PFC_ERROR_GENERIC;
+
+    /* The load at the start: the init (the RAM index is built) and the reads */
+    uint32_t bytes = eeprom_bench_read_bytes();
+    clock_t start = clock();
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        if (eeprom_init() != EEPROM_OK) return PFC_ERROR_GENERIC;
+        for (uint16_t address = 0; address < EEPROM_BENCH_VARIABLES; address++)
+        {
+            uint16_t data;
+            if (eeprom_read_variable(address, &data) != EEPROM_OK || data != values[address]) result->mismatches++;
+        }
+    }
+    result->index_time = (double)(clock() - start) / CLOCKS_PER_SEC / rounds;
+    result->index_bytes = (eeprom_bench_read_bytes() - bytes) / rounds;
+
+    /* The same load with a scan of the page per variable */
+    bytes = eeprom_bench_read_bytes();
+    start = clock();
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        if (eeprom_init() != EEPROM_OK) return PFC_ERROR_GENERIC;
+        for (uint16_t address = 0; address < EEPROM_BENCH_VARIABLES; address++)
+        {
+            uint16_t data;
+            if (eeprom_bench_linear_read(address, &data) != EEPROM_OK || data != values[address]) result->mismatches++;
+        }
+    }
+    result->linear_time = (double)(clock() - start) / CLOCKS_PER_SEC / rounds;
+    result->linear_bytes = (eeprom_bench_read_bytes() - bytes) / rounds;
+    return PFC_SUCCESS;
+}
+/** @} */
@@ -0,0 +1,55 @@
+/**
+ * @file eeprom_bench.h
+ * @author Stanislav Karpikov
+ * @brief EEPROM emulation benchmark: the settings load at the start from a full page (header)
+ */
+
+#ifndef _EEPROM_BENCH_H
+#define _EEPROM_BENCH_H
+
+/** @addtogroup sim_eeprom_bench
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/debug.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** EEPROM emulation benchmark results */
+typedef struct
+{
+    uint32_t variables;        /**< The number of the variables (the halfwords of the settings) */
+    uint32_t saves;            /**< The number of the settings saves written to fill the page */
+    uint32_t mismatches;       /**< The number of the variables read wrong (by every method) */
+    uint32_t index_bytes;      /**< The flash memory read by a load with the RAM index: the init and the reads [bytes] */
+    uint32_t linear_bytes;     /**< The flash memory read by a load with the page scans: the init and a scan per variable [bytes] */
+    double index_time;         /**< The time of a load with the RAM index [s] */
+    double linear_time;        /**< The time of a load with the page scans [s] */
+    uint8_t recovery_deferred; /**< The recovery after a write error has waited for the erases to be allowed */
+} eeprom_bench_result_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Fill the EEPROM page with the settings saves (no page transfer), then load the settings as at the start
+ * with the RAM index and with the page scans (the former reads), check the values and measure the time. A write error
+ * is injected while the erases are forbidden: the recovery of the emulation should wait for them
+ *
+ * @param rounds The number of the loads by every method
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t eeprom_bench_run(uint32_t rounds, eeprom_bench_result_t* result);
+
+/** @} */
+#endif /* _EEPROM_BENCH_H */
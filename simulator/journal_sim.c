@@ -0,0 +1,157 @@
+/**
+ * @file journal_sim.c
+ * @author Stanislav Karpikov
+ * @brief Events journal simulation: power cuts during the flash memory writes
+ */
+
+/** @addtogroup sim_journal
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "journal_sim.h"
+
+#include "host_bsp.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define JOURNAL_SIM_READ_SIZE (128U)        /**< The number of the events read at once for the check */
+#define JOURNAL_SIM_SEED      (0x2545F491U) /**< The initial value of the power cut generator */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Get the next pseudo-random number (xorshift)
+ *
+ * @param[in,out] state The generator state
+ *
+ * @return The number
+ */
+static uint32_t journal_sim_random(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief Fill an event: the data is defined by the sequence number
+ *
+ * @param sequence The sequence number
+ * @param[out] event The event
+ */
+static void journal_sim_event(uint32_t sequence, struct event_record_s* event)
+{
+    memset(event, 0, sizeof(struct event_record_s));
+    event->sequence = sequence;
+    event->unix_time_s_ms = (uint64_t)sequence * 1000U + 7U;
+    event->type = EVENT_TYPE_PROTECTION | ((sequence % EVENTS_PROTECTION_SUBTYPES_NUM) << 16);
+    event->info = sequence % 3U;
+    event->value = (float)sequence * 0.5f;
+}
+
+/**
+ * @brief Read the whole journal and check the events: the sequence numbers follow each other, the data is correct
+ *
+ * @param journal The journal instance
+ * @param[out] records The number of the events read
+ *
+ * @return The number of the wrong events
+ */
+static uint32_t journal_sim_check(const journal_t* journal, uint32_t* records)
+{
+    struct event_record_s buf[JOURNAL_SIM_READ_SIZE];
+    uint32_t wrong = 0;
+    uint32_t sequence = 0;
+    uint32_t previous = 0;
+    uint16_t num;
+    *records = 0;
+
+    while ((num = journal_read(journal, sequence, JOURNAL_SIM_READ_SIZE, buf)) > 0)
+    {
+        for (uint16_t i = 0; i < num; i++)
+        {
+            struct event_record_s expected;
+            journal_sim_event(buf[i].sequence, &expected);
+            if (memcmp(&expected, &buf[i], sizeof(expected)) || (previous && buf[i].sequence != previous + 1)) wrong++;
+            previous = buf[i].sequence;
+        }
+        *records += num;
+        sequence = buf[num - 1].sequence + 1;
+    }
+    if (previous != journal->last_sequence) wrong++;
+    return wrong;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Write events to the journal with power cuts, restart and check the journal after every cut
+ *
+ * @param events The number of the events to write
+ * @param cut_period The mean number of the flash operations between the power cuts
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t journal_sim_run(uint32_t events, uint32_t cut_period, journal_sim_result_t* result)
+{
+    ARGUMENT_ASSERT(result);
+    if (cut_period == 0) return PFC_ERROR_DATA;
+
+    journal_t journal;
+    uint32_t random = JOURNAL_SIM_SEED;
+    uint32_t written = 0;
+    uint32_t records = 0;
+
+    memset(result, 0, sizeof(journal_sim_result_t));
+    host_flash_erase_all();
+    journal_init(&journal);
+    host_flash_set_power_cut(1 + journal_sim_random(&random) % (2 * cut_period));
+
+    while (result->events < events)
+    {
+        struct event_record_s event;
+        journal_sim_event(journal.last_sequence + 1, &event);
+        result->events++;
+        if (journal_append(&journal, &event, 1) == PFC_SUCCESS)
+        {
+            written = event.sequence;
+            continue;
+        }
+
+        /* The power cut: the restart, the numbering is continued after the stored events (as in the firmware) */
+        result->cuts++;
+        host_flash_power_on();
+        journal_init(&journal);
+        if (journal.last_sequence < written) result->lost += written - journal.last_sequence;
+        result->wrong += journal_sim_check(&journal, &records);
+        written = journal.last_sequence;
+        host_flash_set_power_cut(1 + journal_sim_random(&random) % (2 * cut_period));
+    }
+
+    host_flash_set_power_cut(0);
+    journal_init(&journal);
+    result->wrong += journal_sim_check(&journal, &result->records);
+    result->corrupted = journal.corrupted;
+
+    host_flash_state_t flash;
+    host_flash_get_state(&flash);
+    memcpy(result->erases, flash.erases, sizeof(result->erases));
+    result->overwrites = flash.errors;
+    return PFC_SUCCESS;
+}
+/** @} */
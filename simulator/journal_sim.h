@@ -0,0 +1,54 @@
+/**
+ * @file journal_sim.h
+ * @author Stanislav Karpikov
+ * @brief Events journal simulation: power cuts during the flash memory writes (header)
+ */
+
+#ifndef _JOURNAL_SIM_H
+#define _JOURNAL_SIM_H
+
+/** @addtogroup sim_journal
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "journal.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** Journal simulation results */
+typedef struct
+{
+    uint32_t events;                      /**< The number of the events written */
+    uint32_t cuts;                        /**< The number of the power cuts (the restarts) */
+    uint32_t records;                     /**< The number of the events in the journal at the end */
+    uint32_t corrupted;                   /**< The number of the corrupted records skipped at the end */
+    uint32_t lost;                        /**< The number of the written events missed after the restarts */
+    uint32_t wrong;                       /**< The number of the wrong events read (the order or the data) */
+    uint32_t overwrites;                  /**< The number of the words programmed over the not erased data */
+    uint32_t erases[JOURNAL_SECTORS_NUM]; /**< The number of the erases of every sector */
+} journal_sim_result_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Write events to the journal with power cuts, restart and check the journal after every cut
+ *
+ * @param events The number of the events to write
+ * @param cut_period The mean number of the flash operations between the power cuts
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t journal_sim_run(uint32_t events, uint32_t cut_period, journal_sim_result_t* result);
+
+/** @} */
+#endif /* _JOURNAL_SIM_H */
@@ -0,0 +1,900 @@
+/**
+ * @file main.c
+ * @author Stanislav Karpikov
+ * @brief The PFC simulator entry point: command line processing
+ */
+
+/** @addtogroup sim_main
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "capture.h"
+#include "crc_bench.h"
+#include "eeprom_bench.h"
+#include "journal_sim.h"
+#include "math.h"
+#include "oscillog_bench.h"
+#include "protocol_bench.h"
+#include "scheduler_sim.h"
+#include "settings.h"
+#include "sim.h"
+#include "storage_bench.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define SCENARIO_CHARGE_TOLERANCE (0.05f) /**< Scenario check: the allowed DC-link voltage error after the charge */
+#define SCENARIO_FINAL_TOLERANCE  (0.10f) /**< Scenario check: the allowed DC-link voltage error at the end */
+#define JOURNAL_SIM_EVENTS        (20000U)  /**< Journal check: the number of the events (the sectors are rotated a few times) */
+#define JOURNAL_SIM_CUT_PERIOD    (2000U)   /**< Journal check: the mean number of the flash operations between the power cuts */
+#define CAPTURE_READ_SIZE         (64U)     /**< The number of the capture samples read at once (as by the panel) */
+#define UART_STALL_PANEL_PERIOD   (0.02f)   /**< Main loop stall check: the period of the panel requests [s] */
+#define TELEMETRY_POLL_PERIOD     (0.054f)  /**< Telemetry check: the period of the oscillogram poll (the panel timer) [s] */
+#define TELEMETRY_DECIMATION      (3U)      /**< Telemetry check: the push decimation (a push per 60 ms at 50 Hz) */
+#define PROTOCOL_BENCH_ROUNDS     (20000U)  /**< Protocol benchmark: the number of the receiver fillings */
+#define CRC_BENCH_ROUNDS          (2000U)   /**< CRC16 benchmark: the number of the passes over the test blocks */
+#define EEPROM_BENCH_ROUNDS       (200U)    /**< EEPROM benchmark: the number of the settings loads by every method */
+#define STORAGE_BENCH_SAVES       (10000U)  /**< Storage benchmark: the number of the saves to count the wear */
+#define STORAGE_BENCH_ROUNDS      (2000U)   /**< Storage benchmark: the number of the saves interrupted by the power cuts */
+#define FLASH_ENDURANCE_CYCLES    (10000U)  /**< The erase cycles of a flash memory sector (the minimum by the datasheet) */
+#define OSCILLOG_BENCH_ROUNDS     (200U)    /**< Oscillogram benchmark: the number of the encoding passes over the capture */
+#define SCHEDULER_SIM_TIME        (100000U) /**< Scheduler check: the model time of the run [us] */
+#define LINK_BYTE_BITS            (10U)     /**< The bits of a byte on the line of the panel (the start and the stop bits) */
+#define COMMAND_LINE_SIZE         (1024U)  /**< The maximum length of the command line to run a fault injection */
+
+/*--------------------------------------------------------------
+                       PRIVATE TYPES
+--------------------------------------------------------------*/
+
+/** Command line option with a float value */
+typedef struct
+{
+    const char* name;    /**< The option name */
+    float* value;        /**< The value to fill */
+    const char* comment; /**< The option description */
+} option_t;
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Print the usage information
+ *
+ * @param options The options table
+ * @param count The number of the options
+ */
+static void print_usage(const option_t* options, int count)
+{
+    printf("Usage: pfc_simulator [--scenario | --trip-latency | --journal-power-cut | --uart-stall | --telemetry | --page-poll | --settings-save | --eeprom-bench | --storage-bench | --protocol-bench | --crc-bench | --oscillog-bench | --scheduler-check] [--fault NAME] [--brief] [--uart-blocking] [--flash-timing] [--trace FILE] [--capture FILE] [OPTION VALUE]...\n");
+    printf("  --scenario                 Run the README scenario and check the results (exit code 0 - passed)\n");
+    printf("  --trip-latency             Inject every fault in a separate run and print the time to the PWM switch off\n");
+    printf("  --journal-power-cut        Write the events journal with power cuts and check it after the restarts\n");
+    printf("  --uart-stall               Poll the oscillogram as the panel and print the main loop stall and the period task jitter (the blocking and the DMA transmission)\n");
+    printf("  --telemetry                Compare the oscillogram poll with the pushed telemetry subscription\n");
+    printf("  --page-poll                Compare the main page poll as the separate requests and as a bundle\n");
+    printf("  --settings-save            Save the settings from the panel before the start, read the result event and check the stored data\n");
+    printf("  --eeprom-bench             Load the settings from a full EEPROM page with the RAM index and with the page scans\n");
+    printf("  --storage-bench            Count the flash memory wear by the settings saves, check the recovery after the power cuts\n");
+    printf("  --protocol-bench           Parse the received requests and print the throughput, check a batch in a frame\n");
+    printf("  --crc-bench                Check the CRC16 and CRC32 with the reference vectors and print the CRC16 throughput\n");
+    printf("  --oscillog-bench           Compress the waveforms captured at the load step, compare the oscillogram transfers\n");
+    printf("  --scheduler-check          Run the scheduler with the tasks taking the model time, check the jitter and the deadline miss\n");
+    printf("  --fault NAME               Inject the fault during the charge: ");
+    for (int fault = SIM_FAULT_NONE + 1; fault < SIM_FAULT_COUNT; fault++)
+    {
+        printf("%s%s", sim_fault_name((sim_fault_t)fault), (fault + 1 < SIM_FAULT_COUNT) ? ", " : "\n");
+    }
+    printf("  --brief                    Print only the trip latency of the fault (exit code 0 - the PWM is switched off)\n");
+    printf("                             or the main loop stall with the panel requests (the main page poll with --page)\n");
+    printf("  --uart-blocking            Transmit the answers with the blocking calls instead of the DMA\n");
+    printf("  --flash-timing             Stall the main loop for the flash memory operations (the typical erase and program times)\n");
+    printf("  --trace FILE               Write the trace (one line per grid period) to the CSV file\n");
+    printf("  --capture FILE             Write the first waveform capture (one line per sample) to the CSV file\n");
+    for (int i = 0; i < count; i++)
+    {
+        printf("  --%-24s %s\n", options[i].name, options[i].comment);
+    }
+}
+
+/**
+ * @brief Print the results of the simulation
+ *
+ * @param result The results
+ */
+static void print_result(const sim_result_t* result)
+{
+    printf("Model time:            %.3f s\n", result->model_time);
+    printf("Host time:             %.3f s\n", result->wall_time);
+    printf("Real-time factor:      %.1f\n", (result->wall_time > 0) ? result->model_time / result->wall_time : 0);
+    printf("ADC samples:           %u\n", result->samples);
+    printf("Work state reached at: %.3f s\n", result->work_time);
+    printf("Ucap max (charge):     %.1f V\n", result->ucap_max_charge);
+    printf("Ucap before load:      %.1f V\n", result->ucap_before_load);
+    printf("Ucap min (load):       %.1f V\n", result->ucap_min_load);
+    printf("Ucap final:            %.1f V\n", result->ucap_final);
+    printf("Peak phase current:    %.1f A\n", result->i_peak);
+    printf("Faults:                %u\n", result->faults);
+    printf("Final state:           %d\n", result->final_state);
+}
+
+/**
+ * @brief Print the trip latency of the injected fault (a row of the trip latency table)
+ *
+ * @param fault The fault
+ * @param result The results
+ *
+ * @retval 0 The PWM has been switched off and the fault state has been reached
+ * @retval 1 The protection has failed
+ */
+static int print_trip(sim_fault_t fault, const sim_result_t* result)
+{
+    int tripped = (result->trip_samples >= 0) && (result->final_state == PFC_STATE_FAULTBLOCK);
+    if (result->trip_samples >= 0)
+    {
+        printf("%-12s %8d %10.1f %6d %s\n", sim_fault_name(fault), result->trip_samples, result->trip_time * 1e6f,
+               result->final_state, tripped ? "ok" : "FAILED");
+    }
+    else
+    {
+        printf("%-12s %8s %10s %6d %s\n", sim_fault_name(fault), "-", "-", result->final_state, "FAILED");
+    }
+    return !tripped;
+}
+
+/**
+ * @brief Print the main loop stall and the period task jitter with the panel requests (a row of the stall table)
+ *
+ * @param config The configuration
+ * @param result The results
+ */
+static void print_stall(const sim_config_t* config, const sim_result_t* result)
+{
+    const char* mode = config->telemetry_decimation ? "push" : (config->uart_blocking ? "blocking" : "dma");
+    double time = (result->model_time > 0) ? result->model_time : 1;
+    printf("%-8s %8u %8u %10.1f %8.1f %8.1f %6u %10.1f %8u\n", mode, result->requests, result->tx_bytes,
+           result->loop_stall_max * 1e6f, result->oscillogs / time, result->values / time, result->pushes_lost,
+           result->period_jitter * 1e6f, result->period_overrun);
+}
+
+/**
+ * @brief Print the header of the stall table
+ */
+static void print_stall_header(void)
+{
+    printf("%-8s %8s %8s %10s %8s %8s %6s %10s %8s\n", "tx", "requests", "bytes", "stall_us", "osc/s", "values/s", "lost",
+           "jitter_us", "overruns");
+    fflush(stdout);
+}
+
+/**
+ * @brief Print the main page poll (a row of the page table)
+ *
+ * @param config The configuration
+ * @param result The results
+ *
+ * @retval 0 The answers are correct, the values of a bundle are of one period
+ * @retval 1 The check has failed
+ */
+static int print_page(const sim_config_t* config, const sim_result_t* result)
+{
+    const char* mode = (config->page_poll == SIM_PAGE_BUNDLE) ? "bundle" : "requests";
+    double link = (result->model_time > 0 && config->baudrate) ? result->model_time * config->baudrate / LINK_BYTE_BITS : 1;
+    int failed = result->page_errors || (config->page_poll == SIM_PAGE_BUNDLE && result->page_spread);
+    printf("%-8s %6u %9u %8u %7.2f %8.1f %7u %s\n", mode, result->page_polls, result->page_exchanges, result->page_bytes,
+           result->page_bytes * 100.0 / link, result->page_age * 1e3f, result->page_spread, failed ? "FAILED" : "ok");
+    return failed;
+}
+
+/**
+ * @brief Run the main page poll as the separate requests and as a bundle in separate processes and print the table
+ *
+ * @param program The path to the simulator
+ *
+ * @retval 0 The simulations have been run, the answers are correct
+ * @retval 1 A simulation has failed
+ */
+static int run_page_poll(const char* program)
+{
+    int failed = 0;
+    printf("%-8s %6s %9s %8s %7s %8s %7s\n", "poll", "polls", "exchanges", "bytes", "link_%", "age_ms", "spread");
+    fflush(stdout);
+    for (int page = SIM_PAGE_REQUESTS; page <= SIM_PAGE_BUNDLE; page++)
+    {
+        char command[COMMAND_LINE_SIZE];
+        snprintf(command, sizeof(command), "\"%s\" --page %d --brief", program, page);
+        if (system(command) != 0) failed = 1;
+    }
+    return failed;
+}
+
+/**
+ * @brief Run the panel requests with the blocking and the DMA transmission in separate processes and print the table
+ *
+ * @param program The path to the simulator
+ *
+ * @retval 0 The simulations have been run
+ * @retval 1 A simulation has failed
+ */
+static int run_uart_stall(const char* program)
+{
+    int failed = 0;
+    print_stall_header();
+    for (int blocking = 1; blocking >= 0; blocking--)
+    {
+        char command[COMMAND_LINE_SIZE];
+        snprintf(command, sizeof(command), "\"%s\" --panel-period %g --brief%s", program, UART_STALL_PANEL_PERIOD,
+                 blocking ? " --uart-blocking" : "");
+        if (system(command) != 0) failed = 1;
+    }
+    return failed;
+}
+
+/**
+ * @brief Run the oscillogram poll and the telemetry subscription in separate processes and print the table
+ *
+ * @param program The path to the simulator
+ *
+ * @retval 0 The simulations have been run
+ * @retval 1 A simulation has failed
+ */
+static int run_telemetry(const char* program)
+{
+    int failed = 0;
+    char command[COMMAND_LINE_SIZE];
+    print_stall_header();
+    snprintf(command, sizeof(command), "\"%s\" --panel-period %g --brief", program, TELEMETRY_POLL_PERIOD);
+    if (system(command) != 0) failed = 1;
+    snprintf(command, sizeof(command), "\"%s\" --telemetry-decimation %u --brief", program, TELEMETRY_DECIMATION);
+    if (system(command) != 0) failed = 1;
+    return failed;
+}
+
+/**
+ * @brief Run the protocol benchmark and print the parsing throughput
+ *
+ * @retval 0 All the packets have been parsed
+ * @retval 1 The benchmark has failed
+ */
+static int run_protocol_bench(void)
+{
+    protocol_bench_result_t result;
+    if (protocol_bench_run(PROTOCOL_BENCH_ROUNDS, &result) != PFC_SUCCESS)
+    {
+        printf("FAILED: a packet has not been parsed or an answer is wrong\n");
+        return 1;
+    }
+
+    printf("Packets parsed:        %u\n", result.packets);
+    printf("Bytes parsed:          %u\n", result.bytes);
+    printf("Parse time:            %.3f s\n", result.time);
+    printf("Throughput:            %.1f bytes/us\n", (result.time > 0) ? result.bytes / (result.time * 1e6) : 0);
+    printf("Batch of %u commands:\n", result.frame_commands);
+    printf("  packets:             %u exchanges, %u bytes\n", result.packet_exchanges, result.packet_bytes);
+    printf("  frame:               1 exchange, %u bytes\n", result.frame_bytes);
+    return 0;
+}
+
+/**
+ * @brief Run the CRC16 benchmark: check the firmware calculation, print the throughput of the bit-serial and the table ones
+ *
+ * @retval 0 All the CRC values are correct
+ * @retval 1 The check has failed
+ */
+static int run_crc_bench(void)
+{
+    crc_bench_result_t result;
+    if (crc_bench_run(CRC_BENCH_ROUNDS, &result) != PFC_SUCCESS) return 1;
+
+    printf("Reference vectors:     %u\n", result.vectors);
+    printf("Random blocks:         %u\n", result.blocks);
+    printf("Bytes per method:      %u\n", result.bytes);
+    printf("Bit-serial:            %.1f bytes/us\n", (result.bitwise_time > 0) ? result.bytes / (result.bitwise_time * 1e6) : 0);
+    printf("Table:                 %.1f bytes/us\n", (result.table_time > 0) ? result.bytes / (result.table_time * 1e6) : 0);
+    if (result.mismatches)
+    {
+        printf("FAILED: %u wrong CRC values\n", result.mismatches);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
+
+/**
+ * @brief Run the EEPROM benchmark: fill a page with the settings saves, print the flash reads and the time of the
+ * settings load with the RAM index and with the page scans
+ *
+ * @retval 0 All the loaded values are correct
+ * @retval 1 The check has failed
+ */
+static int run_eeprom_bench(void)
+{
+    eeprom_bench_result_t result;
+    if (eeprom_bench_run(EEPROM_BENCH_ROUNDS, &result) != PFC_SUCCESS) return 1;
+
+    printf("Variables:             %u\n", result.variables);
+    printf("Saves to fill a page:  %u\n", result.saves);
+    printf("Page scans:            %u bytes read, %.1f us per load\n", result.linear_bytes, result.linear_time * 1e6);
+    printf("RAM index:             %u bytes read, %.1f us per load\n", result.index_bytes, result.index_time * 1e6);
+    printf("Recovery after error:  %s\n", result.recovery_deferred ? "deferred while the erases are forbidden" : "not deferred");
+    if (result.mismatches || !result.recovery_deferred)
+    {
+        printf("FAILED: %u wrong values%s\n", result.mismatches, result.recovery_deferred ? "" : ", the recovery is not deferred");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
+
+/**
+ * @brief Run the settings storage benchmark: print the flash memory wear and the time of the saves, check the settings
+ * loaded after the power cuts and the errors
+ *
+ * @retval 0 The interrupted saves are loaded either new or previous
+ * @retval 1 The check has failed
+ */
+static int run_storage_bench(void)
+{
+    storage_bench_result_t result;
+    if (storage_bench_run(STORAGE_BENCH_SAVES, STORAGE_BENCH_ROUNDS, &result) != PFC_SUCCESS) return 1;
+
+    double saves = (result.saves > 0) ? result.saves : 1;
+    printf("Saves:                 %u, %.1f bytes changed per save\n", result.saves, result.changed_bytes / saves);
+    printf("Programmed:            %.1f half words per save\n", result.half_words / saves);
+    printf("Page erases:           %.1f per 10k saves, a page endures %.0f saves (%u cycles)\n", result.erases * 10000.0 / saves,
+           (result.page_erases > 0) ? FLASH_ENDURANCE_CYCLES * saves / result.page_erases : 0, FLASH_ENDURANCE_CYCLES);
+    printf("Flash memory time:     %.2f ms per save, a run %.1f us max, %.1f ms with a page transfer\n", result.busy_time * 1e3 / saves,
+           result.run_time_max * 1e6, result.transfer_time_max * 1e3);
+    printf("Interrupted saves:     %u (%u power cuts, %u errors), %u with a page transfer\n", result.rounds, result.cuts,
+           result.errors, result.transfers);
+    printf("Loaded at the restart: %u new, %u previous\n", result.loaded_new, result.loaded_old);
+    if (result.failures)
+    {
+        printf("FAILED: %u wrong restarts\n", result.failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
+
+/**
+ * @brief Run the scheduler check: the tasks take the model time, an interrupt releases the event task during the others
+ *
+ * @retval 0 The statistics show the delay of the event task, the deadline miss and the lost periods
+ * @retval 1 The check has failed
+ */
+static int run_scheduler_check(void)
+{
+    scheduler_sim_result_t result;
+    if (scheduler_sim_run(SCHEDULER_SIM_TIME, &result) != PFC_SUCCESS) return 1;
+
+    printf("Passes: %u, interrupts: %u\n", result.passes, result.interrupts);
+    printf("%-12s %8s %8s %8s %8s %8s %8s %8s\n", "Task", "Runs", "Exec", "Deadline", "Exec max", "Jitter", "Overruns",
+           "Missed");
+    uint32_t wrong = 0;
+    for (uint8_t i = 0; i < SCHEDULER_SIM_TASKS_NUM; i++)
+    {
+        const scheduler_sim_task_t* task = &result.tasks[i];
+        const struct scheduler_stats_s* stats = &result.stats[i];
+        printf("%-12s %8u %8u %8u %8u %8u %8u %8u\n", task->name, stats->runs, task->exec, task->config.deadline,
+               stats->exec_max, stats->jitter_max, stats->overruns, stats->missed);
+        if (stats->runs == 0 || stats->exec_max != task->exec) wrong++;
+    }
+
+    /* The event task waits for the background one, the background one ends after its deadline and delays the periods */
+    if (wrong || result.stats[0].jitter_max == 0 || result.stats[1].overruns != result.stats[1].runs ||
+        result.stats[2].missed == 0)
+    {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
+
+/**
+ * @brief Print a transfer of the oscillogram benchmark: the exchanges, the traffic and the link time
+ *
+ * @param name The name of the transfer
+ * @param exchanges The number of the exchanges
+ * @param bytes The traffic
+ * @param baudrate The baudrate of the interface UART
+ */
+static void print_oscillog_transfer(const char* name, uint32_t exchanges, uint32_t bytes, uint32_t baudrate)
+{
+    printf("  %-20s %3u exchanges, %5u bytes, %6.1f ms\n", name, exchanges, bytes, bytes * LINK_BYTE_BITS * 1e3 / baudrate);
+}
+
+/**
+ * @brief Run the README scenario with a capture at the load step, run the oscillogram benchmark and print the results
+ *
+ * @param config The configuration
+ *
+ * @retval 0 The waveforms have been decoded without errors, the transfers are correct
+ * @retval 1 The benchmark has failed
+ */
+static int run_oscillog_bench(sim_config_t* config)
+{
+    sim_result_t sim_result;
+    oscillog_bench_result_t result;
+    /* The capture holds a period before the load step and the step itself */
+    config->capture_load = CAPTURE_SAMPLES_NUM / 2;
+    if (sim_run(config, &sim_result) != PFC_SUCCESS) return 1;
+
+    status_t status = oscillog_bench_run(OSCILLOG_BENCH_ROUNDS, &result);
+    if (status == PFC_NULL)
+    {
+        printf("FAILED: no waveform captures\n");
+        return 1;
+    }
+
+    printf("Windows encoded:       %u (%u samples)\n", result.windows, result.samples);
+    if (result.samples)
+    {
+        printf("Encoded size:          %u bytes, %.2f bits/sample\n", result.encoded_bytes, result.encoded_bytes * 8.0 / result.samples);
+        printf("Compression ratio:     %.2f (16-bit), %.2f (float)\n", result.samples * 2.0 / result.encoded_bytes,
+               result.samples * 4.0 / result.encoded_bytes);
+    }
+    printf("Encode time:           %.2f us per window\n", result.encode_time * 1e6);
+    if (status == PFC_SUCCESS)
+    {
+        printf("Transfer of %u channels (%u bytes encoded):\n", result.channels, result.snapshot_size);
+        print_oscillog_transfer("8-bit polls:", result.poll_exchanges, result.poll_bytes, config->baudrate);
+        print_oscillog_transfer("bulk packets:", result.packet_exchanges, result.packet_bytes, config->baudrate);
+        print_oscillog_transfer("bulk frames:", result.frame_exchanges, result.frame_bytes, config->baudrate);
+        printf("Bulk vs 8-bit poll:    %.3f steps max\n", result.poll_error);
+    }
+    if (status != PFC_SUCCESS || result.mismatches)
+    {
+        printf("FAILED: %u windows decoded with errors%s\n", result.mismatches, (status != PFC_SUCCESS) ? ", a transfer is wrong" : "");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
+
+/**
+ * @brief Check the events journal with power cuts and print the results
+ *
+ * @retval 0 The journal has been restored correctly after all the cuts
+ * @retval 1 The check has failed
+ */
+static int run_journal_power_cut(void)
+{
+    journal_sim_result_t result;
+    if (journal_sim_run(JOURNAL_SIM_EVENTS, JOURNAL_SIM_CUT_PERIOD, &result) != PFC_SUCCESS) return 1;
+
+    printf("Events written:        %u\n", result.events);
+    printf("Power cuts:            %u\n", result.cuts);
+    printf("Events in the journal: %u\n", result.records);
+    printf("Corrupted records:     %u (skipped)\n", result.corrupted);
+    printf("Sector erases:        ");
+    for (uint32_t sector = 0; sector < JOURNAL_SECTORS_NUM; sector++)
+    {
+        printf(" %u", result.erases[sector]);
+    }
+    printf("\n");
+    printf("Lost events:           %u\n", result.lost);
+    printf("Wrong events:          %u\n", result.wrong);
+    printf("Overwritten words:     %u\n", result.overwrites);
+
+    if (result.lost || result.wrong || result.overwrites || !result.records)
+    {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
+
+/**
+ * @brief Inject every fault in a separate process (the firmware uses the global state) and print the table
+ *
+ * @param program The path to the simulator
+ *
+ * @retval 0 All the faults switched the PWM off
+ * @retval 1 A protection has failed
+ */
+static int run_trip_latency(const char* program)
+{
+    int failed = 0;
+    printf("%-12s %8s %10s %6s\n", "fault", "samples", "time_us", "state");
+    fflush(stdout);
+    for (int fault = SIM_FAULT_NONE + 1; fault < SIM_FAULT_COUNT; fault++)
+    {
+        char command[COMMAND_LINE_SIZE];
+        snprintf(command, sizeof(command), "\"%s\" --fault %s --brief", program, sim_fault_name((sim_fault_t)fault));
+        if (system(command) != 0) failed = 1;
+    }
+    return failed;
+}
+
+/**
+ * @brief Print the state transitions trace of the firmware
+ */
+static void print_transitions(void)
+{
+    static const char* causes[] = {"guard", "command", "timeout", "fault"};
+    struct pfc_transition_record_s transitions[PFC_TRACE_RECORDS_NUM];
+    uint32_t first_index = 0;
+    uint16_t count = pfc_get_trace(0, PFC_TRACE_RECORDS_NUM, transitions, &first_index);
+
+    printf("State transitions:\n");
+    for (uint16_t i = 0; i < count; i++)
+    {
+        const struct pfc_transition_record_s* t = &transitions[i];
+        printf("  %3u: period %6u: %2u -> %2u (%s) after %u periods\n", first_index + i, t->period, t->from, t->to,
+               (t->cause < sizeof(causes) / sizeof(causes[0])) ? causes[t->cause] : "-", t->duration);
+    }
+}
+
+/**
+ * @brief Print the list of the waveform captures of the firmware
+ */
+static void print_captures(void)
+{
+    struct capture_record_s records[CAPTURE_SLOTS_NUM];
+    uint8_t count = capture_get_records(capture_get_instance(), CAPTURE_SLOTS_NUM, records);
+
+    printf("Waveform captures:\n");
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const struct capture_record_s* r = &records[i];
+        printf("  %3u: %.3f s, trigger %u, event %u/%u, info %u, %u samples (%u before the trigger)\n", r->sequence,
+               r->unix_time_s_ms / 1000.0, r->trigger, r->type & 0xFFFF, r->type >> 16, r->info, r->samples, r->pre_samples);
+    }
+}
+
+/** The names of the captured channels (the CSV header) */
+static const char* capture_names[] = {"ucap", "u_a", "u_b", "u_c", "i_a", "i_b", "i_c", "i_et", "temp1", "temp2",
+                                      "edc_a", "edc_b", "edc_c", "edc_i", "math_a", "math_b", "math_c", "out_a", "out_b", "out_c"};
+
+/** Compile-time check: all the captured channels are named */
+typedef char capture_names_check_t[(sizeof(capture_names) / sizeof(capture_names[0]) == CAPTURE_CHANNELS_NUM) ? 1 : -1];
+
+/**
+ * @brief Write the first waveform capture of the firmware to a CSV file (read in chunks, as by the panel)
+ *
+ * @param file The file
+ *
+ * @return The status of the operation
+ */
+static status_t write_capture(FILE* file)
+{
+    static float data[CAPTURE_CHANNELS_NUM][CAPTURE_SAMPLES_NUM];
+    struct capture_record_s records[CAPTURE_SLOTS_NUM];
+    uint8_t count = capture_get_records(capture_get_instance(), CAPTURE_SLOTS_NUM, records);
+    if (!count) return PFC_NULL;
+
+    const struct capture_record_s* first = &records[0];
+    for (uint8_t channel = 0; channel < CAPTURE_CHANNELS_NUM; channel++)
+    {
+        for (uint16_t offset = 0; offset < first->samples; offset += CAPTURE_READ_SIZE)
+        {
+            if (!capture_read(capture_get_instance(), first->sequence, channel, offset, CAPTURE_READ_SIZE, &data[channel][offset])) return PFC_ERROR_DATA;
+        }
+    }
+
+    fprintf(file, "sample");
+    for (uint8_t channel = 0; channel < CAPTURE_CHANNELS_NUM; channel++) fprintf(file, ",%s", capture_names[channel]);
+    fprintf(file, "\n");
+    for (uint16_t sample = 0; sample < first->samples; sample++)
+    {
+        fprintf(file, "%d", (int)sample - (int)first->pre_samples);
+        for (uint8_t channel = 0; channel < CAPTURE_CHANNELS_NUM; channel++) fprintf(file, ",%g", data[channel][sample]);
+        fprintf(file, "\n");
+    }
+    return PFC_SUCCESS;
+}
+
+/**
+ * @brief Check the results of the README scenario
+ *
+ * @param result The results
+ *
+ * @retval 0 The scenario has passed
+ * @retval 1 The scenario has failed
+ */
+static int check_scenario(const sim_result_t* result)
+{
+    settings_capacitors_t capacitors = settings_get_capacitors();
+    settings_protection_t protection = settings_get_protection();
+    int failed = 0;
+
+    if (result->work_time < 0)
+    {
+        printf("FAILED: the work state has not been reached\n");
+        return 1;
+    }
+    if (result->faults)
+    {
+        printf("FAILED: the fault state has been reached\n");
+        failed = 1;
+    }
+    if (fabsf(result->ucap_before_load - capacitors.Ucap_nominal) > capacitors.Ucap_nominal * SCENARIO_CHARGE_TOLERANCE)
+    {
+        printf("FAILED: the capacitors are not charged to the nominal voltage\n");
+        failed = 1;
+    }
+    if (result->ucap_max_charge > protection.Ucap_max)
+    {
+        printf("FAILED: the capacitors voltage is above the protection level during the charge\n");
+        failed = 1;
+    }
+    if (result->ucap_min_load < protection.Ucap_min)
+    {
+        printf("FAILED: the capacitors voltage is below the protection level after the load step\n");
+        failed = 1;
+    }
+    if (fabsf(result->ucap_final - capacitors.Ucap_nominal) > capacitors.Ucap_nominal * SCENARIO_FINAL_TOLERANCE)
+    {
+        printf("FAILED: the capacitors voltage is not restored after the load step\n");
+        failed = 1;
+    }
+    if (!failed) printf("PASSED\n");
+    return failed;
+}
+
+/**
+ * @brief Run the scenario with the settings saved by the panel before the start: the settings are written
+ * in the background during the charge
+ *
+ * @param config The configuration
+ *
+ * @retval 0 The save has been reported, the stored settings match, the scenario has passed
+ * @retval 1 The check has failed
+ */
+static int run_settings_save(sim_config_t* config)
+{
+    sim_result_t result;
+    config->settings_save = 1;
+    if (sim_run(config, &result) != PFC_SUCCESS)
+    {
+        printf("Wrong configuration\n");
+        return 2;
+    }
+
+    printf("Settings save:         #%u reported in %.1f ms, the stored data %s\n", result.settings_saved,
+           result.settings_time * 1e3f, result.settings_stored ? "match" : "differ");
+    printf("Period task:           jitter max %.1f us, %u overruns, %u missed\n", result.period_jitter * 1e6f,
+           result.period_overrun, result.period_missed);
+    if (config->flash_timing) printf("Settings task:         exec max %.1f us\n", result.settings_exec * 1e6f);
+    if (!result.settings_saved)
+    {
+        printf("FAILED: the save has not been reported\n");
+        return 1;
+    }
+    if (!result.settings_stored)
+    {
+        printf("FAILED: the stored settings differ\n");
+        return 1;
+    }
+    return check_scenario(&result);
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief The simulator entry point
+ *
+ * @param argc The number of arguments
+ * @param argv Arguments
+ *
+ * @return The exit code
+ */
+int main(int argc, char* argv[])
+{
+    sim_config_t config;
+    sim_default_config(&config);
+
+    float substeps = (float)config.plant.substeps;
+    float baudrate = (float)config.baudrate;
+    float decimation = 0;
+    float page = SIM_PAGE_NONE;
+    const option_t options[] = {
+        {"kp", &config.ucap_kp, "The capacitors charge PID: proportional coefficient"},
+        {"ki", &config.ucap_ki, "The capacitors charge PID: integral coefficient"},
+        {"precharge", &config.ucap_precharge, "The precharge level [V]"},
+        {"i-max-rms", &config.i_max_rms, "The protection level: maximum current (RMS) [A]"},
+        {"i-max-peak", &config.i_max_peak, "The protection level: maximum current (peak) [A]"},
+        {"charge-time", &config.charge_time, "The charge time before the load step [s]"},
+        {"load-time", &config.load_time, "The time with the load [s]"},
+        {"fault-time", &config.fault_time, "The fault injection time (from the work state) [s]"},
+        {"grid-voltage", &config.plant.grid_voltage, "Grid phase voltage (RMS) [V]"},
+        {"grid-frequency", &config.plant.grid_frequency, "Grid frequency [Hz]"},
+        {"harmonic-5", &config.plant.harmonic_5, "The 5th harmonic (relative)"},
+        {"harmonic-7", &config.plant.harmonic_7, "The 7th harmonic (relative)"},
+        {"unbalance", &config.plant.unbalance, "Phase B amplitude deviation (relative)"},
+        {"inductance", &config.plant.inductance, "Boost inductance [H]"},
+        {"resistance", &config.plant.resistance, "Inductor resistance [Ohm]"},
+        {"capacitance", &config.plant.capacitance, "DC-link capacitance [F]"},
+        {"load", &config.plant.load_resistance, "Switched load [Ohm]"},
+        {"noise", &config.plant.noise, "Measurement noise [ADC codes]"},
+        {"substeps", &substeps, "Integration steps per ADC sample"},
+        {"panel-period", &config.panel_period, "The period of the panel requests (the oscillogram), 0 - no requests [s]"},
+        {"baudrate", &baudrate, "The baudrate of the interface UART, 0 - the answers are transmitted at once"},
+        {"telemetry-decimation", &decimation, "Subscribe to the telemetry pushed every N periods, 0 - no subscription"},
+        {"page", &page, "Poll the main page every 300 ms: 1 - a request per value group, 2 - a bundle, 0 - no polls"},
+    };
+    const int options_count = sizeof(options) / sizeof(options[0]);
+    int scenario = 0;
+    int brief = 0;
+    FILE* capture = NULL;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (!strcmp(argv[arg], "--scenario"))
+        {
+            scenario = 1;
+            continue;
+        }
+        if (!strcmp(argv[arg], "--trip-latency"))
+        {
+            return run_trip_latency(argv[0]);
+        }
+        if (!strcmp(argv[arg], "--journal-power-cut"))
+        {
+            return run_journal_power_cut();
+        }
+        if (!strcmp(argv[arg], "--eeprom-bench"))
+        {
+            return run_eeprom_bench();
+        }
+        if (!strcmp(argv[arg], "--storage-bench"))
+        {
+            return run_storage_bench();
+        }
+        if (!strcmp(argv[arg], "--protocol-bench"))
+        {
+            return run_protocol_bench();
+        }
+        if (!strcmp(argv[arg], "--crc-bench"))
+        {
+            return run_crc_bench();
+        }
+        if (!strcmp(argv[arg], "--oscillog-bench"))
+        {
+            return run_oscillog_bench(&config);
+        }
+        if (!strcmp(argv[arg], "--scheduler-check"))
+        {
+            return run_scheduler_check();
+        }
+        if (!strcmp(argv[arg], "--uart-stall"))
+        {
+            return run_uart_stall(argv[0]);
+        }
+        if (!strcmp(argv[arg], "--telemetry"))
+        {
+            return run_telemetry(argv[0]);
+        }
+        if (!strcmp(argv[arg], "--page-poll"))
+        {
+            return run_page_poll(argv[0]);
+        }
+        if (!strcmp(argv[arg], "--settings-save"))
+        {
+            return run_settings_save(&config);
+        }
+        if (!strcmp(argv[arg], "--brief"))
+        {
+            brief = 1;
+            continue;
+        }
+        if (!strcmp(argv[arg], "--uart-blocking"))
+        {
+            config.uart_blocking = 1;
+            continue;
+        }
+        if (!strcmp(argv[arg], "--flash-timing"))
+        {
+            config.flash_timing = 1;
+            continue;
+        }
+        if (!strcmp(argv[arg], "--fault") && arg + 1 < argc)
+        {
+            arg++;
+            for (int fault = SIM_FAULT_NONE + 1; fault < SIM_FAULT_COUNT; fault++)
+            {
+                if (!strcmp(argv[arg], sim_fault_name((sim_fault_t)fault))) config.fault = (sim_fault_t)fault;
+            }
+            if (config.fault == SIM_FAULT_NONE)
+            {
+                print_usage(options, options_count);
+                return 2;
+            }
+            continue;
+        }
+        if (!strcmp(argv[arg], "--trace") && arg + 1 < argc)
+        {
+            config.trace = fopen(argv[++arg], "w");
+            if (!config.trace)
+            {
+                printf("Can not open the trace file %s\n", argv[arg]);
+                return 2;
+            }
+            continue;
+        }
+        if (!strcmp(argv[arg], "--capture") && arg + 1 < argc)
+        {
+            capture = fopen(argv[++arg], "w");
+            if (!capture)
+            {
+                printf("Can not open the capture file %s\n", argv[arg]);
+                return 2;
+            }
+            continue;
+        }
+        int found = 0;
+        for (int i = 0; i < options_count; i++)
+        {
+            if (!strncmp(argv[arg], "--", 2) && !strcmp(argv[arg] + 2, options[i].name) && arg + 1 < argc)
+            {
+                *options[i].value = (float)atof(argv[++arg]);
+                found = 1;
+                break;
+            }
+        }
+        if (!found)
+        {
+            print_usage(options, options_count);
+            return 2;
+        }
+    }
+    config.plant.substeps = (uint32_t)substeps;
+    config.baudrate = (uint32_t)baudrate;
+    config.telemetry_decimation = (uint8_t)decimation;
+    config.page_poll = (page >= SIM_PAGE_BUNDLE) ? SIM_PAGE_BUNDLE : (sim_page_t)page;
+
+    sim_result_t result;
+    status_t status = sim_run(&config, &result);
+    if (config.trace) fclose(config.trace);
+    if (capture)
+    {
+        if (status == PFC_SUCCESS && write_capture(capture) != PFC_SUCCESS) printf("No waveform captures\n");
+        fclose(capture);
+    }
+    if (status != PFC_SUCCESS)
+    {
+        printf("Wrong configuration\n");
+        return 2;
+    }
+
+    if (brief && config.page_poll != SIM_PAGE_NONE) return print_page(&config, &result);
+    if (brief && config.fault == SIM_FAULT_NONE)
+    {
+        print_stall(&config, &result);
+        return 0;
+    }
+    if (brief) return print_trip(config.fault, &result);
+
+    print_result(&result);
+    if (config.panel_period > 0 || config.telemetry_decimation)
+    {
+        printf("Panel requests:        %u (%u bytes answered)\n", result.requests, result.tx_bytes);
+        printf("Panel received:        %u oscillograms, %u value sets, %u pushes (%u lost)\n", result.oscillogs,
+               result.values, result.pushes, result.pushes_lost);
+        printf("Main loop stall max:   %.1f us\n", result.loop_stall_max * 1e6f);
+    }
+    printf("Period task:           jitter max %.1f us, %u overruns, %u missed\n", result.period_jitter * 1e6f,
+           result.period_overrun, result.period_missed);
+    printf("Protocol task:         execution max %.1f us\n", result.protocol_exec * 1e6f);
+    print_transitions();
+    print_captures();
+    if (config.fault != SIM_FAULT_NONE)
+    {
+        printf("Trip latency:          %d samples, %.1f us\n", result.trip_samples, result.trip_time * 1e6f);
+    }
+    return scenario ? check_scenario(&result) : 0;
+}
+/** @} */
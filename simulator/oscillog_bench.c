@@ -0,0 +1,461 @@
+/**
+ * @file oscillog_bench.c
+ * @author Stanislav Karpikov
+ * @brief Oscillogram bulk transfer benchmark: the compression of the recorded waveforms, the transfer by the panel
+ */
+
+/** @addtogroup sim_oscillog_bench
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "oscillog_bench.h"
+
+#include "BSP/uart.h"
+#include "capture.h"
+#include "command_processor.h"
+#include "crc.h"
+#include "host_bsp.h"
+#include "math.h"
+#include "oscillog_codec.h"
+#include "string.h"
+#include "time.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define OSCILLOG_BENCH_START_BYTE    (0x55U)   /**< The start byte of a packet */
+#define OSCILLOG_BENCH_FRAME_BYTE    (0x56U)   /**< The start byte of a frame */
+#define OSCILLOG_BENCH_STOP_BYTE     (0x77U)   /**< The stop byte of a packet */
+#define OSCILLOG_BENCH_CHANNELS      (10U)     /**< The number of the oscillogram channels (as shown by the panel) */
+#define OSCILLOG_BENCH_EXCHANGES     (32U)     /**< The maximum number of the exchanges of a transfer */
+#define OSCILLOG_BENCH_TOLERANCE     (1.01f)   /**< The allowed difference of the bulk transfer and the 8-bit poll [8-bit steps] */
+#define OSCILLOG_BENCH_FLAT_ERROR    (1e-6f)   /**< The allowed relative difference of a flat channel */
+
+/** The maximum size of the encoded snapshot */
+#define OSCILLOG_BENCH_SNAPSHOT_SIZE (OSCILLOG_BENCH_CHANNELS * OSCILLOG_CODEC_CHANNEL_MAX(OSCILLOG_TRANSFER_SIZE))
+
+/** The maximum number of the chunks of the snapshot */
+#define OSCILLOG_BENCH_CHUNKS ((OSCILLOG_BENCH_SNAPSHOT_SIZE + OSCILLOG_CHUNK_SIZE - 1) / OSCILLOG_CHUNK_SIZE)
+
+/** The number of the requests in a frame: the chunks answered in a frame */
+#define OSCILLOG_BENCH_FRAME_RECORDS (MAXIMUM_FRAME_DATA_LENGTH / (sizeof(struct frame_record_s) + sizeof(struct answer_get_oscillog_bulk)))
+
+/** The size of the answer header (the chunk data follows) */
+#define OSCILLOG_BENCH_HEADER_SIZE (sizeof(struct answer_get_oscillog_bulk) - OSCILLOG_CHUNK_SIZE)
+
+/*--------------------------------------------------------------
+                       PRIVATE TYPES
+--------------------------------------------------------------*/
+
+/** The snapshot received by the panel */
+typedef struct
+{
+    uint16_t snapshot;                            /**< The number of the snapshot, 0 - no chunks yet */
+    uint16_t size;                                /**< The size of the encoded snapshot */
+    uint8_t received[OSCILLOG_BENCH_CHUNKS];      /**< The chunks received */
+    uint8_t data[OSCILLOG_BENCH_SNAPSHOT_SIZE];   /**< The encoded snapshot */
+} oscillog_bench_transfer_t;
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static uint8_t oscillog_bench_answer[MAXIMUM_FRAME_LENGTH]; /**< The last answer transmitted */
+static uint32_t oscillog_bench_answer_length = 0;           /**< The length of the last answer */
+static uint32_t oscillog_bench_answers = 0;                 /**< The number of the answers transmitted */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Keep the transmitted answer (the panel receiver)
+ *
+ * @param data The data block pointer
+ * @param length The size of the data block
+ */
+static void oscillog_bench_monitor(const uint8_t* data, uint32_t length)
+{
+    if (length > sizeof(oscillog_bench_answer)) length = sizeof(oscillog_bench_answer);
+    memcpy(oscillog_bench_answer, data, length);
+    oscillog_bench_answer_length = length;
+    oscillog_bench_answers++;
+}
+
+/**
+ * @brief Send a request, process it, take the answer
+ *
+ * @param request The request
+ * @param length The size of the request
+ * @param[out] bytes The traffic counter: the request and the answer are added
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if there is no single answer
+ */
+static status_t oscillog_bench_exchange(const uint8_t* request, uint32_t length, uint32_t* bytes)
+{
+    const uint8_t* data;
+    uint32_t pending;
+
+    oscillog_bench_answers = 0;
+    uint32_t transmitted = host_uart_get_transmitted();
+    if (host_uart_receive(request, length) != PFC_SUCCESS) return PFC_ERROR_DATA;
+    while (uart_interface_get_data(&data, &pending) == PFC_SUCCESS) protocol_work();
+    host_uart_step(0);
+    *bytes += length + host_uart_get_transmitted() - transmitted;
+    return (oscillog_bench_answers == 1) ? PFC_SUCCESS : PFC_ERROR_DATA;
+}
+
+/**
+ * @brief Fill a request packet
+ *
+ * @param command The command
+ * @param data The data of the request
+ * @param size The size of the data
+ * @param[out] packet The packet
+ *
+ * @return The size of the packet
+ */
+static uint32_t oscillog_bench_packet(uint8_t command, const void* data, uint8_t size, uint8_t* packet)
+{
+    uint8_t len = MINIMUM_PACKET_LENGTH + size;
+
+    packet[0] = OSCILLOG_BENCH_START_BYTE;
+    packet[1] = 0;
+    packet[2] = len;
+    packet[3] = command;
+    memcpy(packet + MINIMUM_PACKET_LENGTH, data, size);
+    uint16_t crc = crc16(packet + 1, len - 1);
+    packet[len] = crc & 0xFF;
+    packet[len + 1] = crc >> 8;
+    packet[len + 2] = OSCILLOG_BENCH_STOP_BYTE;
+    return len + 3;
+}
+
+/**
+ * @brief Fill a request frame with the bulk requests
+ *
+ * @param requests The requests
+ * @param count The number of the requests
+ * @param sequence The sequence number
+ * @param[out] frame The frame
+ *
+ * @return The size of the frame
+ */
+static uint32_t oscillog_bench_frame(const struct command_get_oscillog_bulk* requests, uint32_t count, uint16_t sequence, uint8_t* frame)
+{
+    uint16_t len = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        struct frame_record_s record = {0};
+        record.command = PFC_COMMAND_GET_OSCILLOG_BULK;
+        record.len = sizeof(requests[i]);
+        memcpy(frame + FRAME_HEADER_LENGTH + len, &record, sizeof(record));
+        memcpy(frame + FRAME_HEADER_LENGTH + len + sizeof(record), &requests[i], sizeof(requests[i]));
+        len += sizeof(record) + sizeof(requests[i]);
+    }
+    frame[0] = OSCILLOG_BENCH_FRAME_BYTE;
+    frame[1] = 0;
+    frame[2] = len & 0xFF;
+    frame[3] = len >> 8;
+    frame[4] = sequence & 0xFF;
+    frame[5] = sequence >> 8;
+    uint16_t crc = crc16(frame + 1, FRAME_HEADER_LENGTH - 1 + len);
+    frame[FRAME_HEADER_LENGTH + len] = crc & 0xFF;
+    frame[FRAME_HEADER_LENGTH + len + 1] = crc >> 8;
+    frame[FRAME_HEADER_LENGTH + len + 2] = OSCILLOG_BENCH_STOP_BYTE;
+    return FRAME_SERVICE_LENGTH + len;
+}
+
+/**
+ * @brief Take a chunk of the snapshot (the first answer starts the transfer)
+ *
+ * @param data The answer data
+ * @param size The size of the answer data
+ * @param transfer The snapshot received
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if the chunk is wrong or of another snapshot
+ */
+static status_t oscillog_bench_chunk(const uint8_t* data, uint32_t size, oscillog_bench_transfer_t* transfer)
+{
+    struct answer_get_oscillog_bulk answer;
+    if (size < OSCILLOG_BENCH_HEADER_SIZE || size > sizeof(answer)) return PFC_ERROR_DATA;
+    memcpy(&answer, data, size);
+    if (size != OSCILLOG_BENCH_HEADER_SIZE + answer.len) return PFC_ERROR_DATA;
+
+    if (!transfer->snapshot)
+    {
+        if (answer.size > sizeof(transfer->data)) return PFC_ERROR_DATA;
+        transfer->snapshot = answer.snapshot;
+        transfer->size = answer.size;
+    }
+    if (answer.snapshot != transfer->snapshot || answer.size != transfer->size) return PFC_ERROR_DATA;
+
+    uint32_t expected = transfer->size - answer.offset;
+    if (answer.offset % OSCILLOG_CHUNK_SIZE || answer.offset >= transfer->size) return PFC_ERROR_DATA;
+    if (answer.len != ((expected < OSCILLOG_CHUNK_SIZE) ? expected : OSCILLOG_CHUNK_SIZE)) return PFC_ERROR_DATA;
+    memcpy(transfer->data + answer.offset, answer.data, answer.len);
+    transfer->received[answer.offset / OSCILLOG_CHUNK_SIZE] = 1;
+    return PFC_SUCCESS;
+}
+
+/**
+ * @brief Check if all the chunks of the snapshot have been received
+ *
+ * @param transfer The snapshot received
+ *
+ * @return 1 if the snapshot is complete
+ */
+static int oscillog_bench_complete(const oscillog_bench_transfer_t* transfer)
+{
+    if (!transfer->snapshot) return 0;
+    for (uint32_t offset = 0; offset < transfer->size; offset += OSCILLOG_CHUNK_SIZE)
+    {
+        if (!transfer->received[offset / OSCILLOG_CHUNK_SIZE]) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Encode the channels of the first capture by the oscillogram windows, check the decoding, measure the time
+ *
+ * @param rounds The number of the encoding passes
+ * @param[out] result The results
+ *
+ * @return The status of the operation: PFC_NULL if there are no captures
+ */
+static status_t oscillog_bench_codec(uint32_t rounds, oscillog_bench_result_t* result)
+{
+    static float values[CAPTURE_CHANNELS_NUM][CAPTURE_SAMPLES_NUM];
+    static uint8_t encoded[OSCILLOG_CODEC_CHANNEL_MAX(OSCILLOG_TRANSFER_SIZE)];
+    struct capture_record_s records[CAPTURE_SLOTS_NUM];
+    uint8_t count = capture_get_records(capture_get_instance(), CAPTURE_SLOTS_NUM, records);
+    if (!count) return PFC_NULL;
+
+    uint16_t windows = records[0].samples / OSCILLOG_TRANSFER_SIZE;
+    for (uint8_t channel = 0; channel < CAPTURE_CHANNELS_NUM; channel++)
+    {
+        if (capture_read(capture_get_instance(), records[0].sequence, channel, 0, records[0].samples, values[channel]) != records[0].samples)
+        {
+            return PFC_ERROR_DATA;
+        }
+    }
+
+    for (uint8_t channel = 0; channel < CAPTURE_CHANNELS_NUM; channel++)
+    {
+        for (uint16_t window = 0; window < windows; window++)
+        {
+            const float* window_values = &values[channel][window * OSCILLOG_TRANSFER_SIZE];
+            int16_t samples[OSCILLOG_TRANSFER_SIZE];
+            int16_t decoded[OSCILLOG_TRANSFER_SIZE];
+
+            oscillog_codec_quantize(window_values, OSCILLOG_TRANSFER_SIZE, samples);
+            uint32_t size = oscillog_codec_encode(samples, OSCILLOG_TRANSFER_SIZE, encoded, sizeof(encoded));
+            if (!size || oscillog_codec_decode(encoded, size, decoded, OSCILLOG_TRANSFER_SIZE) != size ||
+                memcmp(samples, decoded, sizeof(samples)))
+            {
+                result->mismatches++;
+            }
+            result->encoded_bytes += sizeof(float) + size;
+            result->samples += OSCILLOG_TRANSFER_SIZE;
+            result->windows++;
+        }
+    }
+
+    clock_t start = clock();
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        for (uint8_t channel = 0; channel < CAPTURE_CHANNELS_NUM; channel++)
+        {
+            for (uint16_t window = 0; window < windows; window++)
+            {
+                oscillog_codec_encode_channel(&values[channel][window * OSCILLOG_TRANSFER_SIZE], OSCILLOG_TRANSFER_SIZE, encoded, sizeof(encoded));
+            }
+        }
+    }
+    double time = (double)(clock() - start) / CLOCKS_PER_SEC;
+    result->encode_time = (rounds && result->windows) ? time / ((double)rounds * result->windows) : 0;
+    return PFC_SUCCESS;
+}
+
+/**
+ * @brief Poll the oscillogram channels with the 8-bit values (a channel per request)
+ *
+ * @param[out] values The values of the channels
+ * @param[out] steps The steps of the 8-bit values of the channels
+ * @param[out] result The results
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if an answer is wrong
+ */
+static status_t oscillog_bench_poll(float values[][OSCILLOG_TRANSFER_SIZE], float* steps, oscillog_bench_result_t* result)
+{
+    uint8_t request[MAXIMUM_PACKET_LENGTH];
+    for (uint8_t channel = 0; channel < OSCILLOG_BENCH_CHANNELS; channel++)
+    {
+        struct command_get_oscillog req = {0};
+        struct answer_get_oscillog answer;
+        req.num = channel;
+        uint32_t length = oscillog_bench_packet(PFC_COMMAND_GET_OSCILLOG, &req, sizeof(req), request);
+        if (oscillog_bench_exchange(request, length, &result->poll_bytes) != PFC_SUCCESS) return PFC_ERROR_DATA;
+        if (oscillog_bench_answer[3] != PFC_COMMAND_GET_OSCILLOG ||
+            oscillog_bench_answer[2] != MINIMUM_PACKET_LENGTH + sizeof(answer)) return PFC_ERROR_DATA;
+        result->poll_exchanges++;
+
+        memcpy(&answer, oscillog_bench_answer + MINIMUM_PACKET_LENGTH, sizeof(answer));
+        steps[channel] = (answer.max - answer.min) / 255.0f;
+        for (uint16_t i = 0; i < OSCILLOG_TRANSFER_SIZE; i++) values[channel][i] = answer.min + answer.data[i] * steps[channel];
+    }
+    return PFC_SUCCESS;
+}
+
+/**
+ * @brief Transfer a new snapshot as the packets (a chunk per request)
+ *
+ * @param channels The channels (a mask)
+ * @param[out] transfer The snapshot received
+ * @param[out] result The results
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if an answer is wrong
+ */
+static status_t oscillog_bench_packets(uint16_t channels, oscillog_bench_transfer_t* transfer, oscillog_bench_result_t* result)
+{
+    uint8_t request[MAXIMUM_PACKET_LENGTH];
+    struct command_get_oscillog_bulk req = {channels, 0, 0};
+    memset(transfer, 0, sizeof(oscillog_bench_transfer_t));
+    do
+    {
+        uint32_t length = oscillog_bench_packet(PFC_COMMAND_GET_OSCILLOG_BULK, &req, sizeof(req), request);
+        if (oscillog_bench_exchange(request, length, &result->packet_bytes) != PFC_SUCCESS) return PFC_ERROR_DATA;
+        if (oscillog_bench_answer[3] != PFC_COMMAND_GET_OSCILLOG_BULK) return PFC_ERROR_DATA;
+        if (oscillog_bench_chunk(oscillog_bench_answer + MINIMUM_PACKET_LENGTH, oscillog_bench_answer[2] - MINIMUM_PACKET_LENGTH, transfer) != PFC_SUCCESS)
+        {
+            return PFC_ERROR_DATA;
+        }
+        result->packet_exchanges++;
+        req.snapshot = transfer->snapshot;
+        req.offset += OSCILLOG_CHUNK_SIZE;
+    } while (req.offset < transfer->size);
+    return PFC_SUCCESS;
+}
+
+/**
+ * @brief Transfer a new snapshot in the frames: the first chunk, then the rest at once (the unanswered requests are sent again)
+ *
+ * @param channels The channels (a mask)
+ * @param[out] transfer The snapshot received
+ * @param[out] result The results
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if an answer is wrong
+ */
+static status_t oscillog_bench_frames(uint16_t channels, oscillog_bench_transfer_t* transfer, oscillog_bench_result_t* result)
+{
+    static uint8_t request[MAXIMUM_FRAME_LENGTH];
+    struct command_get_oscillog_bulk requests[OSCILLOG_BENCH_FRAME_RECORDS] = {{channels, 0, 0}};
+    uint32_t count = 1;
+    memset(transfer, 0, sizeof(oscillog_bench_transfer_t));
+    for (uint16_t sequence = 1; sequence <= OSCILLOG_BENCH_EXCHANGES; sequence++)
+    {
+        uint32_t length = oscillog_bench_frame(requests, count, sequence, request);
+        if (oscillog_bench_exchange(request, length, &result->frame_bytes) != PFC_SUCCESS) return PFC_ERROR_DATA;
+        result->frame_exchanges++;
+
+        const uint8_t* frame = oscillog_bench_answer;
+        uint32_t len = frame[2] | (frame[3] << 8);
+        if (frame[0] != OSCILLOG_BENCH_FRAME_BYTE || (frame[4] | (frame[5] << 8)) != sequence) return PFC_ERROR_DATA;
+        if (oscillog_bench_answer_length != FRAME_SERVICE_LENGTH + len) return PFC_ERROR_DATA;
+        for (uint32_t offset = FRAME_HEADER_LENGTH; offset < FRAME_HEADER_LENGTH + len;)
+        {
+            struct frame_record_s record;
+            memcpy(&record, frame + offset, sizeof(record));
+            offset += sizeof(record);
+            if (record.command != PFC_COMMAND_GET_OSCILLOG_BULK || record.status.fields.error) return PFC_ERROR_DATA;
+            if (offset + record.len > FRAME_HEADER_LENGTH + len) return PFC_ERROR_DATA;
+            if (oscillog_bench_chunk(frame + offset, record.len, transfer) != PFC_SUCCESS) return PFC_ERROR_DATA;
+            offset += record.len;
+        }
+        if (oscillog_bench_complete(transfer)) return PFC_SUCCESS;
+
+        count = 0;
+        for (uint32_t offset = 0; offset < transfer->size && count < OSCILLOG_BENCH_FRAME_RECORDS; offset += OSCILLOG_CHUNK_SIZE)
+        {
+            if (transfer->received[offset / OSCILLOG_CHUNK_SIZE]) continue;
+            requests[count].channels = channels;
+            requests[count].snapshot = transfer->snapshot;
+            requests[count].offset = offset;
+            count++;
+        }
+        if (!count) return PFC_ERROR_DATA;
+    }
+    return PFC_ERROR_DATA;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Encode the channels of the first waveform capture by the oscillogram windows, check the decoding and measure the time,
+ * then transfer the last oscillogram as the 8-bit polls and in the full resolution (as the packets and in the frames)
+ * @note The simulation with a capture should be run before, the firmware state is used
+ *
+ * @param rounds The number of the encoding passes (the time measurement)
+ * @param[out] result The results
+ *
+ * @return The status of the operation: PFC_NULL if there are no captures, PFC_ERROR_DATA if an answer is wrong
+ */
+status_t oscillog_bench_run(uint32_t rounds, oscillog_bench_result_t* result)
+{
+    ARGUMENT_ASSERT(result);
+    static float polled[OSCILLOG_BENCH_CHANNELS][OSCILLOG_TRANSFER_SIZE];
+    static oscillog_bench_transfer_t packets;
+    static oscillog_bench_transfer_t frames;
+    float steps[OSCILLOG_BENCH_CHANNELS];
+    uint16_t channels = (1U << OSCILLOG_BENCH_CHANNELS) - 1;
+
+    memset(result, 0, sizeof(oscillog_bench_result_t));
+    status_t status = oscillog_bench_codec(rounds, result);
+    if (status != PFC_SUCCESS) return status;
+
+    /* The answers are transmitted at once, the link time is calculated by the traffic */
+    host_uart_set_line(0, 0);
+    host_uart_set_monitor(oscillog_bench_monitor);
+    status = oscillog_bench_poll(polled, steps, result);
+    if (status == PFC_SUCCESS) status = oscillog_bench_packets(channels, &packets, result);
+    if (status == PFC_SUCCESS) status = oscillog_bench_frames(channels, &frames, result);
+    host_uart_set_monitor(NULL);
+    if (status != PFC_SUCCESS) return status;
+
+    /* The oscillogram is not updated between the transfers: the snapshots are the same */
+    if (packets.size != frames.size || memcmp(packets.data, frames.data, packets.size)) return PFC_ERROR_DATA;
+    result->channels = OSCILLOG_BENCH_CHANNELS;
+    result->snapshot_size = frames.size;
+
+    uint32_t offset = 0;
+    for (uint8_t channel = 0; channel < OSCILLOG_BENCH_CHANNELS; channel++)
+    {
+        float values[OSCILLOG_TRANSFER_SIZE];
+        float scale;
+        uint32_t size = oscillog_codec_decode_channel(frames.data + offset, frames.size - offset, values, OSCILLOG_TRANSFER_SIZE);
+        if (!size) return PFC_ERROR_DATA;
+        memcpy(&scale, frames.data + offset, sizeof(scale));
+        offset += size;
+
+        for (uint16_t i = 0; i < OSCILLOG_TRANSFER_SIZE; i++)
+        {
+            /* The rounding of the 16-bit values is not counted: it is notable for the channels with a small ripple */
+            float error = fabsf(values[i] - polled[channel][i]) - scale / 2;
+            if (error <= 0) continue;
+            /* A flat channel is polled exactly, only the rounding of the scale is allowed */
+            float step = (steps[channel] > 0) ? steps[channel] : fabsf(polled[channel][i]) * OSCILLOG_BENCH_FLAT_ERROR;
+            float steps_error = (step > 0) ? error / step : INFINITY;
+            if (steps_error > result->poll_error) result->poll_error = steps_error;
+        }
+    }
+    if (offset != frames.size || result->poll_error > OSCILLOG_BENCH_TOLERANCE) return PFC_ERROR_DATA;
+    return PFC_SUCCESS;
+}
+/** @} */
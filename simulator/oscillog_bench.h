@@ -0,0 +1,62 @@
+/**
+ * @file oscillog_bench.h
+ * @author Stanislav Karpikov
+ * @brief Oscillogram bulk transfer benchmark: the compression of the recorded waveforms, the transfer by the panel (header)
+ */
+
+#ifndef _OSCILLOG_BENCH_H
+#define _OSCILLOG_BENCH_H
+
+/** @addtogroup sim_oscillog_bench
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/debug.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** Oscillogram benchmark results */
+typedef struct
+{
+    uint32_t windows;       /**< The number of the capture windows encoded (a channel, an oscillogram length) */
+    uint32_t samples;       /**< The number of the samples encoded */
+    uint32_t encoded_bytes; /**< The size of the encoded windows (with the scales) */
+    uint32_t mismatches;    /**< The number of the windows decoded with an error (the codec is lossless) */
+    double encode_time;     /**< The time to encode a window [s] */
+
+    uint16_t channels;         /**< The number of the channels transferred */
+    uint16_t snapshot_size;    /**< The size of the encoded snapshot */
+    uint32_t poll_exchanges;   /**< The number of the exchanges of the 8-bit oscillogram polls (a channel per request) */
+    uint32_t poll_bytes;       /**< The traffic of the 8-bit oscillogram polls: the requests and the answers */
+    uint32_t packet_exchanges; /**< The number of the exchanges of the bulk transfer as the packets */
+    uint32_t packet_bytes;     /**< The traffic of the bulk transfer as the packets */
+    uint32_t frame_exchanges;  /**< The number of the exchanges of the bulk transfer in the frames */
+    uint32_t frame_bytes;      /**< The traffic of the bulk transfer in the frames */
+    float poll_error;          /**< The maximum difference of the bulk transfer (less its rounding) and the 8-bit poll [8-bit steps] */
+} oscillog_bench_result_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Encode the channels of the first waveform capture by the oscillogram windows, check the decoding and measure the time,
+ * then transfer the last oscillogram as the 8-bit polls and in the full resolution (as the packets and in the frames)
+ * @note The simulation with a capture should be run before, the firmware state is used
+ *
+ * @param rounds The number of the encoding passes (the time measurement)
+ * @param[out] result The results
+ *
+ * @return The status of the operation: PFC_NULL if there are no captures, PFC_ERROR_DATA if an answer is wrong
+ */
+status_t oscillog_bench_run(uint32_t rounds, oscillog_bench_result_t* result);
+
+/** @} */
+#endif /* _OSCILLOG_BENCH_H */
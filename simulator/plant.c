@@ -0,0 +1,299 @@
+/**
+ * @file plant.c
+ * @author Stanislav Karpikov
+ * @brief Discrete-time model of the PFC power stage
+ *
+ * @note The model follows models/PWM_Rectifier_3phase_sensless.slx: three-phase grid,
+ * boost inductors, the IGBT bridge (averaged model), the DC-link capacitor and a switched resistive load.
+ * The bridge works as a diode rectifier when the PWM is disabled.
+ */
+
+/** @addtogroup sim_plant
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "plant.h"
+
+#include "math.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define ADC_CODE_MAX    (4095U) /**< The maximum ADC code (12 bit) */
+#define ADC_CODE_MIDDLE (2048U) /**< The ADC code for zero of the bipolar sensors */
+
+#define SENSOR_UCAP_GAIN    (4.0f)  /**< The DC-link voltage sensor gain [codes/V] */
+#define SENSOR_U_GAIN       (4.0f)  /**< The grid voltage sensors gain [codes/V] */
+#define SENSOR_EDC_GAIN     (-4.0f) /**< The EDC sensors gain (inverting amplifiers) [codes/V] */
+#define SENSOR_I_GAIN       (20.0f) /**< The phase current sensors gain [codes/A] */
+#define SENSOR_I_LOAD_GAIN  (20.0f) /**< The load current sensor gain [codes/A] */
+#define SENSOR_TEMPERATURE  (2000U) /**< The code of the temperature channels */
+
+#define DEFAULT_GRID_VOLTAGE         (220.0f)  /**< Default parameters: grid phase voltage (RMS) [V] */
+#define DEFAULT_GRID_FREQUENCY       (50.0f)   /**< Default parameters: grid frequency [Hz] */
+#define DEFAULT_INDUCTANCE           (5e-3f)   /**< Default parameters: boost inductance [H] */
+#define DEFAULT_RESISTANCE           (0.1f)    /**< Default parameters: inductor resistance [Ohm] */
+#define DEFAULT_PRECHARGE_RESISTANCE (47.0f)   /**< Default parameters: precharge resistor [Ohm] */
+#define DEFAULT_CAPACITANCE          (4.7e-3f) /**< Default parameters: DC-link capacitance [F] */
+#define DEFAULT_BLEEDER_RESISTANCE   (20e3f)   /**< Default parameters: discharge resistor [Ohm] */
+#define DEFAULT_LOAD_RESISTANCE      (20.0f)   /**< Default parameters: switched load [Ohm] */
+#define DEFAULT_SUBSTEPS             (8U)      /**< Default parameters: integration steps per sample */
+
+#define PHASE_SHIFT (2.0f * MATH_PI / 3.0f) /**< The phase shift between the grid phases [rad] */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Generate a pseudo-random value in the range [-1..1]
+ *
+ * @param seed The state of the generator
+ *
+ * @return The random value
+ */
+static float plant_random(uint32_t* seed)
+{
+    *seed = *seed * 1664525UL + 1013904223UL;
+    return (float)(*seed >> 8) / (float)(1UL << 23) - 1.0f;
+}
+
+/**
+ * @brief Convert a value to an ADC code
+ *
+ * @param value The value in ADC codes (unlimited)
+ *
+ * @return The saturated ADC code
+ */
+static uint16_t plant_adc_code(float value)
+{
+    value = floorf(value + 0.5f);
+    if (value < 0) return 0;
+    if (value > ADC_CODE_MAX) return ADC_CODE_MAX;
+    return (uint16_t)value;
+}
+
+/**
+ * @brief Calculate the grid voltages for the current grid angle
+ *
+ * @param plant The plant instance
+ */
+static void plant_update_grid(plant_t* plant)
+{
+    const plant_params_t* p = &plant->params;
+    float amplitude = p->grid_voltage * MATH_SQRT2;
+    for (uint32_t k = 0; k < PFC_NCHAN; k++)
+    {
+        float angle = (float)plant->theta - PHASE_SHIFT * k;
+        float u = sinf(angle) + p->harmonic_5 * sinf(5.0f * angle) + p->harmonic_7 * sinf(7.0f * angle);
+        if (k == PFC_BCHAN) u *= 1.0f + p->unbalance;
+        plant->u[k] = amplitude * u;
+    }
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Fill the plant parameters with the default values (the Simulink model values)
+ *
+ * @param[out] params The parameters of the plant
+ */
+void plant_default_params(plant_params_t* params)
+{
+    if (!params) return;
+    memset(params, 0, sizeof(plant_params_t));
+    params->grid_voltage = DEFAULT_GRID_VOLTAGE;
+    params->grid_frequency = DEFAULT_GRID_FREQUENCY;
+    params->inductance = DEFAULT_INDUCTANCE;
+    params->resistance = DEFAULT_RESISTANCE;
+    params->precharge_resistance = DEFAULT_PRECHARGE_RESISTANCE;
+    params->capacitance = DEFAULT_CAPACITANCE;
+    params->bleeder_resistance = DEFAULT_BLEEDER_RESISTANCE;
+    params->load_resistance = DEFAULT_LOAD_RESISTANCE;
+    params->substeps = DEFAULT_SUBSTEPS;
+}
+
+/*
+ * @brief Init the plant: discharged capacitors, no currents
+ *
+ * @param plant The plant instance
+ * @param params The parameters of the plant
+ *
+ * @return The status of the operation
+ */
+status_t plant_init(plant_t* plant, const plant_params_t* params)
+{
+    ARGUMENT_ASSERT(plant);
+    ARGUMENT_ASSERT(params);
+    if (params->inductance <= 0 || params->capacitance <= 0 || params->substeps == 0) return PFC_ERROR_DATA;
+
+    memset(plant, 0, sizeof(plant_t));
+    plant->params = *params;
+    plant->noise_seed = 1;
+    plant_update_grid(plant);
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Integrate the plant for one ADC sampling interval
+ *
+ * @param plant The plant instance
+ * @param inputs Control inputs (hold for the whole interval)
+ * @param dt The interval [s]
+ *
+ * @return The status of the operation
+ */
+status_t plant_step(plant_t* plant, const plant_inputs_t* inputs, double dt)
+{
+    ARGUMENT_ASSERT(plant);
+    ARGUMENT_ASSERT(inputs);
+
+    const plant_params_t* p = &plant->params;
+    float h = (float)(dt / p->substeps);
+    float d_theta = 2.0f * MATH_PI * p->grid_frequency * h;
+
+    uint8_t connected = inputs->main_relay || inputs->preload_relay;
+    float r_line = p->resistance + (inputs->main_relay ? 0 : p->precharge_resistance);
+
+    float g_load = (p->bleeder_resistance > 0) ? (1.0f / p->bleeder_resistance) : 0;
+    if (inputs->load_on && p->load_resistance > 0) g_load += 1.0f / p->load_resistance;
+
+    for (uint32_t step = 0; step < p->substeps; step++)
+    {
+        plant->theta += d_theta;
+        if (plant->theta > 2.0 * MATH_PI) plant->theta -= 2.0 * MATH_PI;
+        plant_update_grid(plant);
+
+        float i_dc = 0;
+        if (!connected)
+        {
+            memset(plant->i, 0, sizeof(plant->i));
+            plant->i_rectifier = 0;
+        }
+        else if (inputs->pwm_on)
+        {
+            /* Averaged bridge: the pole voltage is referred to the DC-link midpoint */
+            float v[PFC_NCHAN];
+            float v_neutral = 0;
+            for (uint32_t k = 0; k < PFC_NCHAN; k++)
+            {
+                v[k] = (inputs->duty[k] - 0.5f) * plant->ucap;
+                v_neutral += v[k] / PFC_NCHAN;
+            }
+            float i_sum = 0;
+            for (uint32_t k = 0; k < PFC_NCHAN; k++)
+            {
+                float di = (plant->u[k] - (v[k] - v_neutral) - r_line * plant->i[k]) / p->inductance;
+                plant->i[k] += h * di;
+                i_sum += plant->i[k];
+            }
+            /* No neutral connection: keep the sum of the currents zero */
+            for (uint32_t k = 0; k < PFC_NCHAN; k++)
+            {
+                plant->i[k] -= i_sum / PFC_NCHAN;
+                i_dc += inputs->duty[k] * plant->i[k];
+            }
+            plant->i_rectifier = 0;
+        }
+        else
+        {
+            /* Diode rectifier: the conducting pair is the maximum and the minimum phase */
+            uint32_t k_max = 0, k_min = 0;
+            for (uint32_t k = 1; k < PFC_NCHAN; k++)
+            {
+                if (plant->u[k] > plant->u[k_max]) k_max = k;
+                if (plant->u[k] < plant->u[k_min]) k_min = k;
+            }
+            float u_line = plant->u[k_max] - plant->u[k_min];
+            float di = (u_line - plant->ucap - 2.0f * r_line * plant->i_rectifier) / (2.0f * p->inductance);
+            plant->i_rectifier += h * di;
+            if (plant->i_rectifier < 0) plant->i_rectifier = 0;
+
+            memset(plant->i, 0, sizeof(plant->i));
+            plant->i[k_max] = plant->i_rectifier;
+            plant->i[k_min] = -plant->i_rectifier;
+            i_dc = plant->i_rectifier;
+        }
+
+        plant->i_load = plant->ucap * g_load;
+        plant->ucap += h * (i_dc - plant->i_load) / p->capacitance;
+        if (plant->ucap < 0) plant->ucap = 0;
+    }
+    plant->time += dt;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Sample the plant with the ADC
+ *
+ * @param plant The plant instance
+ * @param[out] codes ADC codes for all the physical channels
+ *
+ * @return The status of the operation
+ */
+status_t plant_sample(plant_t* plant, uint16_t codes[ADC_CHANNEL_NUMBER])
+{
+    ARGUMENT_ASSERT(plant);
+    ARGUMENT_ASSERT(codes);
+
+    float noise[ADC_CHANNEL_NUMBER];
+    for (int ch = 0; ch < ADC_CHANNEL_NUMBER; ch++)
+    {
+        noise[ch] = (plant->params.noise > 0) ? plant->params.noise * plant_random(&plant->noise_seed) : 0;
+    }
+
+    codes[ADC_UCAP] = plant_adc_code(plant->ucap * SENSOR_UCAP_GAIN + noise[ADC_UCAP]);
+    for (uint32_t k = 0; k < PFC_NCHAN; k++)
+    {
+        codes[ADC_U_A + k] = plant_adc_code(ADC_CODE_MIDDLE + plant->u[k] * SENSOR_U_GAIN + noise[ADC_U_A + k]);
+        codes[ADC_EDC_A + k] = plant_adc_code(ADC_CODE_MIDDLE + plant->u[k] * SENSOR_EDC_GAIN + noise[ADC_EDC_A + k]);
+        codes[ADC_I_A + k] = plant_adc_code(ADC_CODE_MIDDLE + plant->i[k] * SENSOR_I_GAIN + noise[ADC_I_A + k]);
+    }
+    codes[ADC_I_ET] = plant_adc_code(ADC_CODE_MIDDLE + plant->i_load * SENSOR_I_LOAD_GAIN + noise[ADC_I_ET]);
+    codes[ADC_I_TEMP1] = SENSOR_TEMPERATURE;
+    codes[ADC_I_TEMP2] = SENSOR_TEMPERATURE;
+    codes[ADC_EDC_I] = ADC_CODE_MIDDLE;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Get the calibrations that match the sensors of the plant
+ *
+ * @param[out] calibrations The calibrations settings
+ *
+ * @return The status of the operation
+ */
+status_t plant_get_calibrations(settings_calibrations_t* calibrations)
+{
+    ARGUMENT_ASSERT(calibrations);
+    memset(calibrations, 0, sizeof(settings_calibrations_t));
+    for (int ch = 0; ch < ADC_CHANNEL_NUMBER; ch++)
+    {
+        calibrations->calibration[ch] = 1.0f;
+    }
+
+    calibrations->calibration[ADC_UCAP] = 1.0f / SENSOR_UCAP_GAIN;
+    for (uint32_t k = 0; k < PFC_NCHAN; k++)
+    {
+        calibrations->offset[ADC_U_A + k] = ADC_CODE_MIDDLE;
+        calibrations->calibration[ADC_U_A + k] = 1.0f / SENSOR_U_GAIN;
+        /* The inverted EDC sensors are compensated by the mathematical channels */
+        calibrations->offset[ADC_EDC_A + k] = ADC_CODE_MIDDLE;
+        calibrations->calibration[ADC_EDC_A + k] = 1.0f / -SENSOR_EDC_GAIN;
+        calibrations->offset[ADC_I_A + k] = ADC_CODE_MIDDLE;
+        calibrations->calibration[ADC_I_A + k] = 1.0f / SENSOR_I_GAIN;
+    }
+    calibrations->offset[ADC_I_ET] = ADC_CODE_MIDDLE;
+    calibrations->calibration[ADC_I_ET] = 1.0f / SENSOR_I_LOAD_GAIN;
+    calibrations->offset[ADC_EDC_I] = ADC_CODE_MIDDLE;
+    return PFC_SUCCESS;
+}
+/** @} */
@@ -0,0 +1,121 @@
+/**
+ * @file plant.h
+ * @author Stanislav Karpikov
+ * @brief Discrete-time model of the PFC power stage (header)
+ */
+
+#ifndef _PLANT_H
+#define _PLANT_H
+
+/** @addtogroup sim_plant
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "adc_logic.h"
+#include "defines.h"
+#include "settings.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** Parameters of the plant */
+typedef struct
+{
+    float grid_voltage;         /**< Grid phase voltage (RMS) [V] */
+    float grid_frequency;       /**< Grid frequency [Hz] */
+    float harmonic_5;           /**< The 5th harmonic amplitude (relative to the fundamental) */
+    float harmonic_7;           /**< The 7th harmonic amplitude (relative to the fundamental) */
+    float unbalance;            /**< Phase B amplitude deviation (relative to the fundamental) */
+    float inductance;           /**< Boost inductance per phase [H] */
+    float resistance;           /**< Series resistance per phase [Ohm] */
+    float precharge_resistance; /**< Precharge resistor (in series with the preload relay) [Ohm] */
+    float capacitance;          /**< DC-link capacitance [F] */
+    float bleeder_resistance;   /**< Permanent DC-link load (discharge resistor) [Ohm] */
+    float load_resistance;      /**< Switched DC-link load [Ohm] */
+    float noise;                /**< Measurement noise amplitude [ADC codes] */
+    uint32_t substeps;          /**< The number of integration steps per ADC sample */
+} plant_params_t;
+
+/** Control inputs of the plant */
+typedef struct
+{
+    uint8_t main_relay;     /**< The main relay is switched on */
+    uint8_t preload_relay;  /**< The preload relay is switched on */
+    uint8_t pwm_on;         /**< The bridge is modulated (otherwise works as a diode rectifier) */
+    float duty[PFC_NCHAN];  /**< Duty cycle of the upper switches [0..1] */
+    uint8_t load_on;        /**< The switched load is connected */
+} plant_inputs_t;
+
+/** The state of the plant */
+typedef struct
+{
+    plant_params_t params;     /**< The parameters of the plant */
+    double time;               /**< The model time [s] */
+    double theta;              /**< The grid angle [rad] */
+    float u[PFC_NCHAN];        /**< Grid phase voltages [V] */
+    float i[PFC_NCHAN];        /**< Phase currents, positive into the converter [A] */
+    float i_rectifier;         /**< The DC current in the diode rectifier mode [A] */
+    float i_load;              /**< The DC-link load current [A] */
+    float ucap;                /**< The DC-link voltage [V] */
+    uint32_t noise_seed;       /**< The state of the noise generator */
+} plant_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Fill the plant parameters with the default values (the Simulink model values)
+ *
+ * @param[out] params The parameters of the plant
+ */
+void plant_default_params(plant_params_t* params);
+
+/**
+ * @brief Init the plant: discharged capacitors, no currents
+ *
+ * @param plant The plant instance
+ * @param params The parameters of the plant
+ *
+ * @return The status of the operation
+ */
+status_t plant_init(plant_t* plant, const plant_params_t* params);
+
+/**
+ * @brief Integrate the plant for one ADC sampling interval
+ *
+ * @param plant The plant instance
+ * @param inputs Control inputs (hold for the whole interval)
+ * @param dt The interval [s]
+ *
+ * @return The status of the operation
+ */
+status_t plant_step(plant_t* plant, const plant_inputs_t* inputs, double dt);
+
+/**
+ * @brief Sample the plant with the ADC
+ *
+ * @param plant The plant instance
+ * @param[out] codes ADC codes for all the physical channels
+ *
+ * @return The status of the operation
+ */
+status_t plant_sample(plant_t* plant, uint16_t codes[ADC_CHANNEL_NUMBER]);
+
+/**
+ * @brief Get the calibrations that match the sensors of the plant
+ *
+ * @param[out] calibrations The calibrations settings
+ *
+ * @return The status of the operation
+ */
+status_t plant_get_calibrations(settings_calibrations_t* calibrations);
+
+/** @} */
+#endif /* _PLANT_H */
@@ -0,0 +1,115 @@
+/**
+ * @file adc_host.c
+ * @author Stanislav Karpikov
+ * @brief Host port: ADC
+ */
+
+/** @addtogroup sim_port
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/adc.h"
+#include "adc_logic.h"
+#include "host_bsp.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static ADC_TRANSFER_CALLBACK adc_cplt_callback = 0;      /**< ADC DMA full complete callback */
+static ADC_TRANSFER_CALLBACK adc_half_cplt_callback = 0; /**< ADC DMA half complete callback */
+
+static uint16_t* dma_buffer = 0;  /**< The buffer of the started DMA transfer */
+static uint32_t dma_buffer_size = 0; /**< The size of the DMA buffer [bytes] */
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Set callbacks for the ADC module
+ *
+ * @param cptl_callback ADC DMA full complete callback
+ * @param half_cplt_callback ADC DMA half complete callback
+ *
+ * @return The status of the operation
+ */
+status_t adc_register_callbacks(ADC_TRANSFER_CALLBACK cptl_callback, ADC_TRANSFER_CALLBACK half_cplt_callback)
+{
+    adc_cplt_callback = cptl_callback;
+    adc_half_cplt_callback = half_cplt_callback;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Start the ADC DMA conversion
+ *
+ * @param buffer A buffer for the data
+ * @param buffer_size The buffer size
+ *
+ * @return The status of the operation
+ */
+status_t adc_start(uint32_t* buffer, uint32_t buffer_size)
+{
+    ARGUMENT_ASSERT(buffer);
+    dma_buffer = (uint16_t*)buffer;
+    dma_buffer_size = buffer_size;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Restart the ADC DMA conversion with the buffer of adc_start
+ *
+ * @return The status of the operation: PFC_ERROR_GENERIC if the conversion has not been started before
+ */
+status_t adc_restart(void)
+{
+    return dma_buffer ? PFC_SUCCESS : PFC_ERROR_GENERIC;
+}
+
+/*
+ * @brief Stop the ADC DMA conversion
+ *
+ * @return The status of the operation
+ */
+status_t adc_stop(void)
+{
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief ADC Initialization Function
+ *
+ * @return The status of the operation
+ */
+status_t adc_init(void)
+{
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Emulate a finished ADC DMA transfer: write the data and call the callbacks
+ *
+ * @param codes ADC codes for all the physical channels
+ *
+ * @return The status of the operation
+ */
+status_t host_adc_convert(const uint16_t* codes)
+{
+    ARGUMENT_ASSERT(codes);
+    if (!dma_buffer) return PFC_NULL;
+
+    uint32_t size = ADC_CHANNEL_NUMBER * sizeof(uint16_t);
+    if (size > dma_buffer_size) size = dma_buffer_size;
+    memcpy(dma_buffer, codes, size);
+
+    if (adc_cplt_callback) adc_cplt_callback();
+    if (adc_half_cplt_callback) adc_half_cplt_callback();
+    return PFC_SUCCESS;
+}
+/** @} */
@@ -0,0 +1,348 @@
+/**
+ * @file flash_host.c
+ * @author Stanislav Karpikov
+ * @brief Host port: internal flash memory (the EEPROM pages and the journal sectors) with the operation times,
+ * the power cut and the error injection
+ */
+
+/** @addtogroup sim_port
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/flash.h"
+#include "host_bsp.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define FLASH_EEPROM_SIZE    (HOST_EEPROM_PAGES_NUM * EEPROM_PAGE_FULL_SIZE)   /**< The size of the EEPROM pages */
+#define FLASH_JOURNAL_SIZE   (JOURNAL_SECTORS_NUM * JOURNAL_SECTOR_SIZE)       /**< The size of the journal sectors */
+#define FLASH_HOST_SIZE      (FLASH_EEPROM_SIZE + FLASH_JOURNAL_SIZE)          /**< The size of the emulated memory */
+#define FLASH_ERASED_BYTE    (0xFFU)                                           /**< The value of the erased memory */
+#define FLASH_HALF_WORD_MASK (0x0000FFFFU)                                     /**< The part of a word programmed before a power cut */
+#define FLASH_BYTE_MASK      (0x00FFU)                                         /**< The part of a half word programmed before a power cut */
+
+/*--------------------------------------------------------------
+                       PRIVATE TYPES
+--------------------------------------------------------------*/
+
+/** A range of the emulated memory */
+typedef struct
+{
+    uint32_t start;       /**< The start address */
+    uint32_t sector_size; /**< The size of a sector */
+    uint32_t sectors;     /**< The number of the sectors */
+    uint32_t offset;      /**< The offset in the emulated memory */
+    double erase_time;    /**< The time to erase a sector [s] */
+    uint32_t* erases;     /**< The erase counters of the sectors */
+} flash_region_t;
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static uint8_t memory[FLASH_HOST_SIZE];                  /**< The emulated memory */
+static uint8_t memory_erased = 0;                        /**< The memory has been erased after the start */
+static host_flash_state_t flash = {{0}, {0}, 0, 0, 0, 0, 0, 0, 1}; /**< The emulated flash memory state */
+static uint32_t operations_to_cut = 0;                   /**< The operations before the power cut, 0 - no cuts */
+static uint32_t operations_to_error = 0;                 /**< The operations before the error, 0 - no errors */
+static double stall = 0;                                 /**< The time of the operations since the last take [s] */
+static uint8_t stall_enabled = 0;                        /**< The operations stall the main loop */
+
+/** The emulated ranges: the EEPROM pages, the journal sectors */
+static const flash_region_t regions[] = {
+    {EEPROM_START_ADDRESS, EEPROM_PAGE_FULL_SIZE, HOST_EEPROM_PAGES_NUM, 0, HOST_FLASH_EEPROM_ERASE_TIME, flash.eeprom_erases},
+    {JOURNAL_START_ADDRESS, JOURNAL_SECTOR_SIZE, JOURNAL_SECTORS_NUM, FLASH_EEPROM_SIZE, HOST_FLASH_JOURNAL_ERASE_TIME, flash.erases},
+};
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Erase the memory on the first access (the memory is erased when delivered)
+ */
+static void flash_check_erased(void)
+{
+    if (memory_erased) return;
+    memset(memory, FLASH_ERASED_BYTE, sizeof(memory));
+    memory_erased = 1;
+}
+
+/**
+ * @brief Count an operation for the power cut
+ *
+ * @return 1 if the power is cut at the operation, 0 otherwise
+ */
+static uint8_t flash_power_cut(void)
+{
+    if (operations_to_cut == 0) return 0;
+    if (--operations_to_cut) return 0;
+    flash.powered = 0;
+    return 1;
+}
+
+/**
+ * @brief Count an operation for the error injection
+ *
+ * @return 1 if the operation fails, 0 otherwise
+ */
+static uint8_t flash_error(void)
+{
+    if (operations_to_error == 0) return 0;
+    if (--operations_to_error) return 0;
+    flash.failures++;
+    return 1;
+}
+
+/**
+ * @brief Count the time of an operation
+ *
+ * @param time The time of the operation [s]
+ */
+static void flash_busy(double time)
+{
+    flash.busy_time += time;
+    if (stall_enabled) stall += time;
+}
+
+/**
+ * @brief Find the emulated range of an address range
+ *
+ * @param address The address
+ * @param size The size of the range
+ *
+ * @return The emulated range, NULL if the address range is out of the emulated memory
+ */
+static const flash_region_t* flash_find_region(uint32_t address, uint32_t size)
+{
+    for (uint32_t i = 0; i < sizeof(regions) / sizeof(regions[0]); i++)
+    {
+        const flash_region_t* region = &regions[i];
+        if (address >= region->start && address - region->start + size <= region->sector_size * region->sectors) return region;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Get the offset of an address in the emulated memory
+ *
+ * @param region The emulated range of the address
+ * @param address The address
+ *
+ * @return The offset
+ */
+static uint32_t flash_offset(const flash_region_t* region, uint32_t address)
+{
+    return region->offset + address - region->start;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Erase a flash sector
+ *
+ * @param address The start address of the sector
+ *
+ * @return The status of the operation
+ */
+status_t flash_erase(uint32_t address)
+{
+    flash_check_erased();
+    const flash_region_t* region = flash_find_region(address, 1);
+    if (!region || (address - region->start) % region->sector_size) return PFC_ERROR_DATA;
+    if (!flash.powered) return PFC_ERROR_HAL;
+    if (flash_error()) return PFC_ERROR_HAL;
+
+    uint8_t cut = flash_power_cut();
+    memset(&memory[flash_offset(region, address)], FLASH_ERASED_BYTE, cut ? region->sector_size / 2 : region->sector_size);
+    region->erases[(address - region->start) / region->sector_size]++;
+    flash_busy(cut ? region->erase_time / 2 : region->erase_time);
+    return cut ? PFC_ERROR_HAL : PFC_SUCCESS;
+}
+
+/*
+ * @brief Program words to the erased flash memory (the bits can be only cleared)
+ *
+ * @param address The address (aligned to a word)
+ * @param data The data
+ * @param words The number of the words
+ *
+ * @return The status of the operation
+ */
+status_t flash_program(uint32_t address, const uint32_t* data, uint32_t words)
+{
+    ARGUMENT_ASSERT(data);
+    flash_check_erased();
+    const flash_region_t* region = flash_find_region(address, words * sizeof(uint32_t));
+    if (!region || (address % sizeof(uint32_t))) return PFC_ERROR_DATA;
+
+    for (uint32_t i = 0; i < words; i++)
+    {
+        if (!flash.powered) return PFC_ERROR_HAL;
+        if (flash_error()) return PFC_ERROR_HAL;
+        uint32_t offset = flash_offset(region, address) + i * sizeof(uint32_t);
+        uint32_t word;
+        memcpy(&word, &memory[offset], sizeof(word));
+        if (word != 0xFFFFFFFFU) flash.errors++;
+
+        uint32_t value = data[i];
+        if (flash_power_cut()) value |= ~FLASH_HALF_WORD_MASK;
+        word &= value;
+        memcpy(&memory[offset], &word, sizeof(word));
+        flash.words++;
+        flash_busy(HOST_FLASH_PROGRAM_TIME);
+    }
+    return flash.powered ? PFC_SUCCESS : PFC_ERROR_HAL;
+}
+
+/*
+ * @brief Program a half word to the erased flash memory (the bits can be only cleared)
+ *
+ * @param address The address (aligned to a half word)
+ * @param data The data
+ *
+ * @return The status of the operation
+ */
+status_t flash_program_halfword(uint32_t address, uint16_t data)
+{
+    flash_check_erased();
+    const flash_region_t* region = flash_find_region(address, sizeof(uint16_t));
+    if (!region || (address % sizeof(uint16_t))) return PFC_ERROR_DATA;
+    if (!flash.powered) return PFC_ERROR_HAL;
+    if (flash_error()) return PFC_ERROR_HAL;
+
+    uint32_t offset = flash_offset(region, address);
+    uint16_t half_word;
+    memcpy(&half_word, &memory[offset], sizeof(half_word));
+    /* The bits already programmed can be cleared again (the EEPROM page state), but not set */
+    if ((half_word & data) != data) flash.errors++;
+
+    uint16_t value = data;
+    if (flash_power_cut()) value |= (uint16_t)~FLASH_BYTE_MASK;
+    half_word &= value;
+    memcpy(&memory[offset], &half_word, sizeof(half_word));
+    flash.half_words++;
+    flash_busy(HOST_FLASH_PROGRAM_TIME);
+    return flash.powered ? PFC_SUCCESS : PFC_ERROR_HAL;
+}
+
+/*
+ * @brief Read the flash memory
+ *
+ * @param address The address
+ * @param[out] data The buffer
+ * @param size The size of the data [bytes]
+ *
+ * @return The status of the operation
+ */
+status_t flash_read(uint32_t address, void* data, uint32_t size)
+{
+    ARGUMENT_ASSERT(data);
+    flash_check_erased();
+    const flash_region_t* region = flash_find_region(address, size);
+    if (!region) return PFC_ERROR_DATA;
+    memcpy(data, &memory[flash_offset(region, address)], size);
+    flash.read_bytes += size;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Erase the emulated flash memory and clear the counters
+ */
+void host_flash_erase_all(void)
+{
+    memory_erased = 0;
+    flash_check_erased();
+    memset(&flash, 0, sizeof(flash));
+    flash.powered = 1;
+    operations_to_cut = 0;
+    operations_to_error = 0;
+    stall = 0;
+}
+
+/*
+ * @brief Schedule a power cut: the operation is done partially, the next ones fail until the power is restored
+ * @note A word is programmed partially (the lower half word), a half word - the lower byte,
+ * a sector is erased partially (the first half)
+ *
+ * @param operations The number of the operations (a program or a sector erase) before the cut, 0 - no cuts
+ */
+void host_flash_set_power_cut(uint32_t operations)
+{
+    operations_to_cut = operations;
+}
+
+/*
+ * @brief Schedule an error: the operation fails (as a programming or a protection error), the memory is not changed
+ * and the power is kept
+ *
+ * @param operations The number of the operations (a program or a sector erase) before the error, 0 - no errors
+ */
+void host_flash_set_error(uint32_t operations)
+{
+    operations_to_error = operations;
+}
+
+/*
+ * @brief Restore the power of the emulated flash memory (the restart)
+ */
+void host_flash_power_on(void)
+{
+    flash.powered = 1;
+    operations_to_cut = 0;
+    operations_to_error = 0;
+}
+
+/*
+ * @brief Count the time of the operations as the stall of the code fetch (taken by host_flash_take_stall)
+ *
+ * @param enabled 1 - the operations stall the main loop, 0 - the time is counted in the state only (the default)
+ */
+void host_flash_set_stall(uint8_t enabled)
+{
+    stall_enabled = enabled;
+    stall = 0;
+}
+
+/*
+ * @brief Take the time of the flash memory operations since the last call (the code fetch is stalled)
+ *
+ * @return The time [s]
+ */
+double host_flash_take_stall(void)
+{
+    double time = stall;
+    stall = 0;
+    return time;
+}
+
+/*
+ * @brief Get the time of the flash memory operations since the last take (the time is kept)
+ *
+ * @return The time [s]
+ */
+double host_flash_get_stall(void)
+{
+    return stall;
+}
+
+/*
+ * @brief Get the state of the emulated flash memory
+ *
+ * @param[out] state The state
+ */
+void host_flash_get_state(host_flash_state_t* state)
+{
+    if (!state) return;
+    *state = flash;
+}
+/** @} */
@@ -0,0 +1,179 @@
+/**
+ * @file gpio_host.c
+ * @author Stanislav Karpikov
+ * @brief Host port: GPIO
+ */
+
+/** @addtogroup sim_port
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/gpio.h"
+#include "host_bsp.h"
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static host_gpio_state_t gpio = {0}; /**< The emulated outputs */
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Switch off the main relay output
+ *
+ * @return The status of the operation
+ */
+status_t gpio_main_relay_switch_off(void)
+{
+    gpio.main_relay = 0;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch on the main relay output
+ *
+ * @return The status of the operation
+ */
+status_t gpio_main_relay_switch_on(void)
+{
+    gpio.main_relay = 1;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch off the preload relay output
+ *
+ * @return The status of the operation
+ */
+status_t gpio_preload_relay_switch_off(void)
+{
+    gpio.preload_relay = 0;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch on the preload relay output
+ *
+ * @return The status of the operation
+ */
+status_t gpio_preload_relay_switch_on(void)
+{
+    gpio.preload_relay = 1;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch on the ventilators output
+ *
+ * @return The status of the operation
+ */
+status_t gpio_ventilators_switch_on(void)
+{
+    gpio.ventilators = 1;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch off the ventilators output
+ *
+ * @return The status of the operation
+ */
+status_t gpio_ventilators_switch_off(void)
+{
+    gpio.ventilators = 0;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch on the PWM test output
+ *
+ * @return The status of the operation
+ */
+status_t gpio_pwm_test_on(void)
+{
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch off the PWM test output
+ *
+ * @return The status of the operation
+ */
+status_t gpio_pwm_test_off(void)
+{
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch on the error LED
+ *
+ * @return The status of the operation
+ */
+status_t gpio_error_led_on(void)
+{
+    gpio.error_led = 1;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch on the status LED
+ *
+ * @return The status of the operation
+ */
+status_t gpio_status_led_on(void)
+{
+    gpio.status_led = 1;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch off the error LED
+ *
+ * @return The status of the operation
+ */
+status_t gpio_error_led_off(void)
+{
+    gpio.error_led = 0;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Switch off the status LED
+ *
+ * @return The status of the operation
+ */
+status_t gpio_status_led_off(void)
+{
+    gpio.status_led = 0;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Init the GPIO module
+ *
+ * @return The status of the operation
+ */
+status_t gpio_init(void)
+{
+    host_gpio_state_t initial = {0};
+    gpio = initial;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Get the state of the emulated outputs
+ *
+ * @param[out] state The state of the outputs
+ */
+void host_gpio_get_state(host_gpio_state_t* state)
+{
+    if (state) *state = gpio;
+}
+/** @} */
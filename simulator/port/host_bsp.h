@@ -0,0 +1,241 @@
+/**
+ * @file host_bsp.h
+ * @author Stanislav Karpikov
+ * @brief Host port: access to the emulated peripherals (header)
+ */
+
+#ifndef _HOST_BSP_H
+#define _HOST_BSP_H
+
+/** @addtogroup sim_port
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/bsp.h"
+#include "BSP/debug.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC DEFINES
+--------------------------------------------------------------*/
+
+#define HOST_TIMER_SYNC_CLOCK (100000000UL) /**< The clock of the syncronisation timer [Hz] */
+#define HOST_CORE_CLOCK       (216000000UL) /**< The clock of the core (the cycles counter) [Hz] */
+#define HOST_CPU_SCALE        (20.0)        /**< The code of the main loop on the core is slower than on the host (approximate) */
+#define HOST_EEPROM_PAGES_NUM (2U)          /**< The number of the EEPROM pages (sectors) */
+
+#define HOST_FLASH_PROGRAM_TIME       (16e-6) /**< The time to program a word or a half word (typical, x32 parallelism) [s] */
+#define HOST_FLASH_EEPROM_ERASE_TIME  (0.25)  /**< The time to erase an EEPROM page: a 16 KB sector (typical) [s] */
+#define HOST_FLASH_JOURNAL_ERASE_TIME (1.0)   /**< The time to erase a journal sector: a 128 KB sector (typical) [s] */
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** The state of the emulated outputs */
+typedef struct
+{
+    uint8_t main_relay;    /**< The main relay is switched on */
+    uint8_t preload_relay; /**< The preload relay is switched on */
+    uint8_t ventilators;   /**< The ventilators are switched on */
+    uint8_t error_led;     /**< The error LED is switched on */
+    uint8_t status_led;    /**< The status LED is switched on */
+} host_gpio_state_t;
+
+/** The state of the emulated PWM timer */
+typedef struct
+{
+    uint8_t enabled;     /**< The outputs are enabled (MOE is set) */
+    uint32_t ccr[3];     /**< CCR1..CCR3 register contents */
+    uint32_t sync_arr;   /**< ARR register of the syncronisation timer */
+    uint8_t sync_active; /**< The syncronisation timer is started */
+} host_timer_state_t;
+
+/** The state of the emulated flash memory (the EEPROM pages and the journal sectors) */
+typedef struct
+{
+    uint32_t erases[JOURNAL_SECTORS_NUM];          /**< The number of the erases of every journal sector */
+    uint32_t eeprom_erases[HOST_EEPROM_PAGES_NUM]; /**< The number of the erases of every EEPROM page */
+    uint32_t words;                                /**< The number of the programmed words */
+    uint32_t half_words;                           /**< The number of the programmed half words */
+    uint32_t errors;                               /**< The number of the words programmed over the not erased data (the half words: setting the bits) */
+    uint32_t read_bytes;                           /**< The number of the bytes read */
+    uint32_t failures;                             /**< The number of the operations failed by the injected errors */
+    double busy_time;                              /**< The time of the erases and the programming [s] */
+    uint8_t powered;                               /**< The flash memory is powered (cleared by a power cut) */
+} host_flash_state_t;
+
+/**
+ * @brief The monitor of the interface UART: called for every block when it has been transmitted
+ *
+ * @param data The data block pointer
+ * @param length The size of the data block
+ */
+typedef void (*host_uart_monitor_t)(const uint8_t* data, uint32_t length);
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Emulate a finished ADC DMA transfer: write the data and call the callbacks
+ *
+ * @param codes ADC codes for all the physical channels
+ *
+ * @return The status of the operation
+ */
+status_t host_adc_convert(const uint16_t* codes);
+
+/**
+ * @brief Get the state of the emulated outputs
+ *
+ * @param[out] state The state of the outputs
+ */
+void host_gpio_get_state(host_gpio_state_t* state);
+
+/**
+ * @brief Get the state of the emulated timers
+ *
+ * @param[out] state The state of the timers
+ */
+void host_timer_get_state(host_timer_state_t* state);
+
+/**
+ * @brief Get the ADC sampling period defined by the syncronisation timer
+ *
+ * @return The sampling period [s]
+ */
+double host_timer_get_sample_period(void);
+
+/**
+ * @brief Put data to the interface UART receiver
+ *
+ * @param data The data block pointer
+ * @param length The size of the data block
+ *
+ * @return The status of the operation
+ */
+status_t host_uart_receive(const uint8_t* data, uint32_t length);
+
+/**
+ * @brief Get the number of bytes transmitted to the interface UART
+ *
+ * @return The number of bytes
+ */
+uint32_t host_uart_get_transmitted(void);
+
+/**
+ * @brief Set the line of the interface UART
+ *
+ * @param baudrate The baudrate, 0 - the data is transmitted at once
+ * @param blocking 1 - the transmission waits for the end (as the blocking HAL call), 0 - the DMA transmission
+ */
+void host_uart_set_line(uint32_t baudrate, uint8_t blocking);
+
+/**
+ * @brief Emulate the line: transmit the queued blocks (the DMA transmission)
+ *
+ * @param dt The time step [s]
+ */
+void host_uart_step(double dt);
+
+/**
+ * @brief Set the monitor of the transmitted blocks (the panel receiver)
+ *
+ * @param monitor The monitor, NULL - no monitor
+ */
+void host_uart_set_monitor(host_uart_monitor_t monitor);
+
+/**
+ * @brief Take the time spent in the blocking transmissions since the last call
+ *
+ * @return The time [s]
+ */
+double host_uart_take_stall(void);
+
+/**
+ * @brief Get the time spent in the blocking transmissions since the last take (the time is kept)
+ *
+ * @return The time [s]
+ */
+double host_uart_get_stall(void);
+
+/**
+ * @brief Advance the model time of the cycles counter
+ *
+ * @param dt The time step [s]
+ */
+void host_system_step(double dt);
+
+/**
+ * @brief Start a pass of the main loop: the cycles counter counts the code of the main loop
+ */
+void host_system_loop_begin(void);
+
+/**
+ * @brief End a pass of the main loop: the code of the pass delays the counter of the next passes until the model time
+ * passes it
+ */
+void host_system_loop_end(void);
+
+/**
+ * @brief Erase the emulated flash memory and clear the counters
+ */
+void host_flash_erase_all(void);
+
+/**
+ * @brief Schedule a power cut: the operation is done partially, the next ones fail until the power is restored
+ * @note A word is programmed partially (the lower half word), a half word - the lower byte,
+ * a sector is erased partially (the first half)
+ *
+ * @param operations The number of the operations (a program or a sector erase) before the cut, 0 - no cuts
+ */
+void host_flash_set_power_cut(uint32_t operations);
+
+/**
+ * @brief Schedule an error: the operation fails (as a programming or a protection error), the memory is not changed
+ * and the power is kept
+ *
+ * @param operations The number of the operations (a program or a sector erase) before the error, 0 - no errors
+ */
+void host_flash_set_error(uint32_t operations);
+
+/**
+ * @brief Restore the power of the emulated flash memory (the restart)
+ */
+void host_flash_power_on(void);
+
+/**
+ * @brief Count the time of the operations as the stall of the code fetch (taken by host_flash_take_stall)
+ *
+ * @param enabled 1 - the operations stall the main loop, 0 - the time is counted in the state only (the default)
+ */
+void host_flash_set_stall(uint8_t enabled);
+
+/**
+ * @brief Take the time of the flash memory operations since the last call (the code fetch is stalled)
+ *
+ * @return The time [s]
+ */
+double host_flash_take_stall(void);
+
+/**
+ * @brief Get the time of the flash memory operations since the last take (the time is kept)
+ *
+ * @return The time [s]
+ */
+double host_flash_get_stall(void);
+
+/**
+ * @brief Get the state of the emulated flash memory
+ *
+ * @param[out] state The state
+ */
+void host_flash_get_state(host_flash_state_t* state);
+
+/** @} */
+#endif /* _HOST_BSP_H */
@@ -0,0 +1,29 @@
+/**
+ * @file host_port.h
+ * @author Stanislav Karpikov
+ * @brief Host port: compiler intrinsics used by the firmware sources
+ *
+ * @note The file is force-included into every firmware source file compiled for the host
+ */
+
+#ifndef _HOST_PORT_H
+#define _HOST_PORT_H
+
+/** @addtogroup sim_port
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       PUBLIC MACRO
+--------------------------------------------------------------*/
+
+/* The firmware runs as a single thread on the host, interrupts are called synchronously */
+#define __disable_irq() ((void)0) /**< Disable interrupts (ARMCC intrinsic) */
+#define __enable_irq()  ((void)0) /**< Enable interrupts (ARMCC intrinsic) */
+
+#define __dmb(option)       __sync_synchronize()    /**< Data memory barrier (ARMCC intrinsic) */
+#define __ldrex(ptr)        (*(ptr))                /**< Load exclusive (ARMCC intrinsic) */
+#define __strex(value, ptr) ((*(ptr) = (value)), 0) /**< Store exclusive, 0 - success (ARMCC intrinsic) */
+
+/** @} */
+#endif /* _HOST_PORT_H */
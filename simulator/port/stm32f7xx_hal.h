@@ -0,0 +1,24 @@
+/**
+ * @file stm32f7xx_hal.h
+ * @author Stanislav Karpikov
+ * @brief Host port: placeholder for the STM32 HAL header
+ *
+ * @note The firmware modules compiled for the host do not use the HAL directly,
+ * the BSP is replaced with the host implementation
+ */
+
+#ifndef _STM32F7XX_HAL_H
+#define _STM32F7XX_HAL_H
+
+/** @addtogroup sim_port
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "stdint.h"
+
+/** @} */
+#endif /* _STM32F7XX_HAL_H */
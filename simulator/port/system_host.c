@@ -0,0 +1,204 @@
+/**
+ * @file system_host.c
+ * @author Stanislav Karpikov
+ * @brief Host port: system tools
+ */
+
+/** @addtogroup sim_port
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/system.h"
+#include "BSP/iwdg.h"
+#include "BSP/dma.h"
+#include "host_bsp.h"
+#include "time.h"
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static uint64_t current_time = 0; /**< Time accumulator variable, 64-bit Unix timestamp (with ms) */
+static double model_time = 0;     /**< The model time of the cycles counter [s] */
+static double loop_busy = 0;      /**< The model time of the main loop code not passed yet [s] */
+static clock_t loop_start = -1;   /**< The host CPU time of the start of the main loop pass (-1 out of the pass) */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Get the model time of the main loop code run in the current pass: the host CPU time scaled to the core
+ *
+ * @return The time [s]
+ */
+static double host_system_loop_time(void)
+{
+    return (double)(clock() - loop_start) / CLOCKS_PER_SEC * HOST_CPU_SCALE;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Increment the time tick
+ */
+void system_increment_time(void)
+{
+    current_time++;
+}
+
+/*
+ * @brief Set the local time
+ *
+ * @param time 64-bit Unix timestamp (with ms)
+ */
+void system_set_time(uint64_t time)
+{
+    current_time = time;
+}
+
+/*
+ * @brief Get the local time
+ *
+ * @return 64-bit Unix timestamp (with ms)
+ */
+uint64_t system_get_time(void)
+{
+    return current_time;
+}
+
+/*
+ * @brief Get the milliseconds counter (wraps in 49 days)
+ *
+ * @return The counter value [ms]
+ */
+uint32_t system_get_ticks(void)
+{
+    return (uint32_t)current_time;
+}
+
+/*
+ * @brief Get the cycles counter of the core (wraps in 19 s at 216 MHz)
+ * @note The blocking transmissions and the flash memory operations are counted as the time of the main loop. The code
+ * of the main loop takes the host CPU time scaled to the core: the counter of a pass runs ahead of the model time until
+ * the model time passes the code, the interrupts read the model time
+ *
+ * @return The counter value [cycles]
+ */
+uint32_t system_get_cycles(void)
+{
+    double time = model_time + host_uart_get_stall() + host_flash_get_stall();
+    if (loop_start != (clock_t)-1) time += loop_busy + host_system_loop_time();
+    return (uint32_t)(uint64_t)(time * HOST_CORE_CLOCK);
+}
+
+/*
+ * @brief Get the frequency of the cycles counter
+ *
+ * @return The frequency [Hz]
+ */
+uint32_t system_get_cycles_frequency(void)
+{
+    return HOST_CORE_CLOCK;
+}
+
+/*
+ * @brief Advance the model time of the cycles counter
+ *
+ * @param dt The time step [s]
+ */
+void host_system_step(double dt)
+{
+    model_time += dt;
+    loop_busy = (loop_busy > dt) ? loop_busy - dt : 0;
+}
+
+/*
+ * @brief Start a pass of the main loop: the cycles counter counts the code of the main loop
+ */
+void host_system_loop_begin(void)
+{
+    loop_start = clock();
+}
+
+/*
+ * @brief End a pass of the main loop: the code of the pass delays the counter of the next passes until the model time
+ * passes it
+ */
+void host_system_loop_end(void)
+{
+    loop_busy += host_system_loop_time();
+    loop_start = -1;
+}
+
+/*
+ * @brief Delay in ticks
+ * @note The model time is not advanced: the plant is disconnected during the delay
+ *
+ * @param delay_ticks The number of ticks to wait
+ *
+ * @return The status of the operation
+ */
+status_t system_delay_ticks(uint32_t delay_ticks)
+{
+    current_time += delay_ticks;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Reset of all peripherals, Initializes the Flash interface and the Systick
+ *
+ * @param The status of the operation
+ */
+status_t system_init(void)
+{
+    current_time = 0;
+    model_time = 0;
+    loop_busy = 0;
+    loop_start = -1;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Init the watchdog
+ *
+ * @return The status of the operation
+ */
+status_t iwdg_init(void)
+{
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Init the DMA module
+ *
+ * @return The status of the operation
+ */
+status_t dma_init(void)
+{
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief  This function is executed in case of error occurrence.
+ */
+void error_handler(void)
+{
+}
+
+/*
+ * @brief Check if the debug session is enabled (a debugger is connected)
+ *
+ * @retval false A debug session is never enabled on the host
+ */
+bool is_debug_session(void)
+{
+    return false;
+}
+/** @} */
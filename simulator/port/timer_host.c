@@ -0,0 +1,138 @@
+/**
+ * @file timer_host.c
+ * @author Stanislav Karpikov
+ * @brief Host port: Timer
+ */
+
+/** @addtogroup sim_port
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/timer.h"
+#include "host_bsp.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define TIMER_SYNC_PERIOD (15625UL) /**< Syncronisation timer period value */
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static host_timer_state_t timer = {0, {0, 0, 0}, TIMER_SYNC_PERIOD, 0}; /**< The emulated timers */
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Set PWM values
+ *
+ * @param ccr1 Timer CCR1 register contents
+ * @param ccr2 Timer CCR2 register contents
+ * @param ccr3 Timer CCR3 register contents
+ *
+ * @return The status of the operation
+ */
+status_t timer_write_pwm(uint32_t ccr1, uint32_t ccr2, uint32_t ccr3)
+{
+    timer.ccr[0] = ccr1;
+    timer.ccr[1] = ccr2;
+    timer.ccr[2] = ccr3;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Change syncronisation timer period
+ *
+ * @param arr The new value of the ARR register
+ *
+ * @return The status of the operation
+ */
+status_t timer_correct_period(uint32_t arr)
+{
+    timer.sync_arr = arr;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Enable PWM (after disabling)
+ *
+ * @return The status of the operation
+ */
+status_t timer_restore_pwm(void)
+{
+    timer.enabled = 1;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Disable PWM
+ *
+ * @return The status of the operation
+ */
+status_t timer_disable_pwm(void)
+{
+    timer.enabled = 0;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Force the PWM outputs to the inactive state immediately (the software break event)
+ *
+ * @return The status of the operation
+ */
+status_t timer_trip_pwm(void)
+{
+    timer.enabled = 0;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Start timer for the ADC module
+ *
+ * @return The status of the operation
+ */
+status_t timer_start_adc_timer(void)
+{
+    timer.sync_active = 1;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Init the timer module
+ *
+ * @return The status of the operation
+ */
+status_t timer_init(void)
+{
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Get the state of the emulated timers
+ *
+ * @param[out] state The state of the timers
+ */
+void host_timer_get_state(host_timer_state_t* state)
+{
+    if (state) *state = timer;
+}
+
+/*
+ * @brief Get the ADC sampling period defined by the syncronisation timer
+ *
+ * @return The sampling period [s]
+ */
+double host_timer_get_sample_period(void)
+{
+    /* The counter runs from 0 to ARR inclusive */
+    return (double)(timer.sync_arr + 1) / (double)HOST_TIMER_SYNC_CLOCK;
+}
+/** @} */
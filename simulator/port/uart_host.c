@@ -0,0 +1,270 @@
+/**
+ * @file uart_host.c
+ * @author Stanislav Karpikov
+ * @brief Host port: UART
+ */
+
+/** @addtogroup sim_port
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/uart.h"
+#include "host_bsp.h"
+#include "stddef.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define RX_BUFFER_SIZE  (0x400U) /**< The size of the receiver buffer (should be a power of 2) */
+#define UART_FRAME_BITS (10U)    /**< The bits of a transmitted byte: the start bit, 8 data bits, the stop bit */
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static uint8_t rx_buffer[RX_BUFFER_SIZE]; /**< The receiver buffer */
+static uint32_t rx_in = 0;               /**< The write position in the receiver buffer */
+static uint32_t rx_out = 0;              /**< The read position in the receiver buffer */
+static uint32_t tx_count = 0;            /**< The number of bytes transmitted */
+
+static uint32_t tx_baudrate = 0;                             /**< The line baudrate, 0 - the data is transmitted at once */
+static uint8_t tx_blocking = 0;                              /**< The transmission waits for the end (as the blocking HAL call) */
+static double tx_stall = 0;                                  /**< The time spent in the blocking transmissions [s] */
+static uint32_t tx_queue[UART_INTERFACE_TX_QUEUE_SIZE];      /**< The lengths of the queued blocks */
+static const uint8_t* tx_data[UART_INTERFACE_TX_QUEUE_SIZE]; /**< The queued blocks */
+static host_uart_monitor_t tx_monitor = NULL;                /**< The monitor of the transmitted blocks */
+static uint32_t tx_head = 0;                                 /**< The number of the blocks queued */
+static uint32_t tx_tail = 0;                                 /**< The number of the blocks transmitted */
+static double tx_elapsed = 0;                                /**< The time of the block being transmitted [s] */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Get the time to transmit a block over the line
+ *
+ * @param length The size of the block
+ *
+ * @return The time [s]
+ */
+static double host_uart_line_time(uint32_t length)
+{
+    if (!tx_baudrate) return 0;
+    return (double)length * UART_FRAME_BITS / tx_baudrate;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Transmit data to the interface UART
+ *
+ * @param data The data block pointer
+ * @param length The size of the data block
+ *
+ * @return The status of the operation
+ */
+status_t uart_interface_transmit(uint8_t* data, uint32_t length)
+{
+    ARGUMENT_ASSERT(data);
+    if (tx_blocking)
+    {
+        tx_stall += host_uart_line_time(length);
+        tx_count += length;
+        if (tx_monitor) tx_monitor(data, length);
+        return PFC_SUCCESS;
+    }
+    if (tx_head - tx_tail >= UART_INTERFACE_TX_QUEUE_SIZE) return PFC_NULL;
+    tx_queue[tx_head % UART_INTERFACE_TX_QUEUE_SIZE] = length;
+    tx_data[tx_head % UART_INTERFACE_TX_QUEUE_SIZE] = data;
+    tx_head++;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Check if a block can be queued to transmit (the back-pressure)
+ *
+ * @return PFC_SUCCESS if a block can be queued, PFC_NULL if the queue is full
+ */
+status_t uart_interface_tx_ready(void)
+{
+    if (!tx_blocking && tx_head - tx_tail >= UART_INTERFACE_TX_QUEUE_SIZE) return PFC_NULL;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Transmit data to the debug UART
+ *
+ * @param data The data block pointer
+ * @param length The size of the data block
+ *
+ * @return The status of the operation
+ */
+status_t uart_debug_transmit(uint8_t* data, uint32_t length)
+{
+    ARGUMENT_ASSERT(data);
+    /* The debug output is not simulated */
+    (void)length;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief USART interface Initialization Function
+ *
+ * @return The status of the operation
+ */
+status_t uart_init(void)
+{
+    rx_in = 0;
+    rx_out = 0;
+    tx_count = 0;
+    tx_head = 0;
+    tx_tail = 0;
+    tx_elapsed = 0;
+    tx_stall = 0;
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Init receiving process
+ *
+ * @return The status of the operation
+ */
+status_t uart_interface_rx_init(void)
+{
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Get the received data: the oldest contiguous span of the bytes not read yet
+ * @note The span is kept until it is released with uart_interface_rx_release
+ *
+ * @param[out] data The span
+ * @param[out] length The size of the span
+ *
+ * @return The status of the operation: PFC_NULL if no data
+ */
+status_t uart_interface_get_data(const uint8_t** data, uint32_t* length)
+{
+    ARGUMENT_ASSERT(data);
+    ARGUMENT_ASSERT(length);
+    if (rx_in == rx_out) return PFC_NULL;
+    *data = &rx_buffer[rx_out];
+    *length = (rx_in > rx_out) ? (rx_in - rx_out) : (RX_BUFFER_SIZE - rx_out);
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Release the bytes read from the span
+ *
+ * @param length The number of the bytes read
+ */
+void uart_interface_rx_release(uint32_t length)
+{
+    rx_out = (rx_out + length) & (RX_BUFFER_SIZE - 1);
+}
+
+/*
+ * @brief Put data to the interface UART receiver
+ *
+ * @param data The data block pointer
+ * @param length The size of the data block
+ *
+ * @return The status of the operation
+ */
+status_t host_uart_receive(const uint8_t* data, uint32_t length)
+{
+    ARGUMENT_ASSERT(data);
+    for (uint32_t i = 0; i < length; i++)
+    {
+        uint32_t next = (rx_in + 1) & (RX_BUFFER_SIZE - 1);
+        if (next == rx_out) return PFC_WARNING;
+        rx_buffer[rx_in] = data[i];
+        rx_in = next;
+    }
+    return PFC_SUCCESS;
+}
+
+/*
+ * @brief Get the number of bytes transmitted to the interface UART
+ *
+ * @return The number of bytes
+ */
+uint32_t host_uart_get_transmitted(void)
+{
+    return tx_count;
+}
+
+/*
+ * @brief Set the line of the interface UART
+ *
+ * @param baudrate The baudrate, 0 - the data is transmitted at once
+ * @param blocking 1 - the transmission waits for the end (as the blocking HAL call), 0 - the DMA transmission
+ */
+void host_uart_set_line(uint32_t baudrate, uint8_t blocking)
+{
+    tx_baudrate = baudrate;
+    tx_blocking = blocking;
+}
+
+/*
+ * @brief Emulate the line: transmit the queued blocks (the DMA transmission)
+ *
+ * @param dt The time step [s]
+ */
+void host_uart_step(double dt)
+{
+    tx_elapsed += dt;
+    while (tx_tail != tx_head)
+    {
+        uint32_t length = tx_queue[tx_tail % UART_INTERFACE_TX_QUEUE_SIZE];
+        double line_time = host_uart_line_time(length);
+        if (tx_elapsed < line_time) return;
+        tx_elapsed -= line_time;
+        tx_count += length;
+        /* The block is kept by the protocol until the transmission is complete */
+        if (tx_monitor) tx_monitor(tx_data[tx_tail % UART_INTERFACE_TX_QUEUE_SIZE], length);
+        tx_tail++;
+    }
+    tx_elapsed = 0;
+}
+
+/*
+ * @brief Set the monitor of the transmitted blocks (the panel receiver)
+ *
+ * @param monitor The monitor, NULL - no monitor
+ */
+void host_uart_set_monitor(host_uart_monitor_t monitor)
+{
+    tx_monitor = monitor;
+}
+
+/*
+ * @brief Take the time spent in the blocking transmissions since the last call
+ *
+ * @return The time [s]
+ */
+double host_uart_take_stall(void)
+{
+    double stall = tx_stall;
+    tx_stall = 0;
+    return stall;
+}
+
+/*
+ * @brief Get the time spent in the blocking transmissions since the last take (the time is kept)
+ *
+ * @return The time [s]
+ */
+double host_uart_get_stall(void)
+{
+    return tx_stall;
+}
+/** @} */
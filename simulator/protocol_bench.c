@@ -0,0 +1,267 @@
+/**
+ * @file protocol_bench.c
+ * @author Stanislav Karpikov
+ * @brief Panel protocol benchmark: the parsing throughput of the received requests, the requests batched in a frame
+ */
+
+/** @addtogroup sim_protocol_bench
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "protocol_bench.h"
+
+#include "BSP/uart.h"
+#include "command_processor.h"
+#include "crc.h"
+#include "host_bsp.h"
+#include "string.h"
+#include "time.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define PROTOCOL_BENCH_START_BYTE  (0x55U) /**< The start byte of a packet */
+#define PROTOCOL_BENCH_FRAME_BYTE  (0x56U) /**< The start byte of a frame */
+#define PROTOCOL_BENCH_STOP_BYTE   (0x77U) /**< The stop byte of a packet */
+#define PROTOCOL_BENCH_SERVICE     (3U)    /**< The bytes after the data: the CRC and the stop byte */
+#define PROTOCOL_BENCH_FILLS       (3U)    /**< The number of the packet sets in the receiver at once */
+#define PROTOCOL_BENCH_COMMAND     (PFC_COMMAND_COUNT) /**< The test command: an unknown one is not answered */
+#define PROTOCOL_BENCH_SEQUENCE    (0xA5C3U) /**< The sequence number of the test frame */
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+/** The data sizes of the test packets: a settings write, an events request, a short command */
+static const uint8_t protocol_bench_sizes[] = {MAXIMUM_PACKET_LENGTH - 2 * MINIMUM_PACKET_LENGTH, 64, 8, 0};
+
+/** The commands of the batch: the connection test and the panel polls, the last one is unknown (an error is expected) */
+static const uint8_t protocol_bench_batch[] = {PFC_COMMAND_TEST, PFC_COMMAND_GET_VERSION_INFO, PFC_COMMAND_GET_WORK_STATE,
+                                               PFC_COMMAND_GET_ADC_ACTIVE, PFC_COMMAND_GET_NET_PARAMS, PFC_COMMAND_COUNT};
+
+static uint8_t protocol_bench_answer[MAXIMUM_FRAME_LENGTH]; /**< The last answer transmitted */
+static uint32_t protocol_bench_answer_length = 0;           /**< The length of the last answer */
+static uint32_t protocol_bench_answers = 0;                 /**< The number of the answers transmitted */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Fill a test packet with the data
+ *
+ * @param command The command
+ * @param size The size of the data
+ * @param[out] packet The packet
+ *
+ * @return The size of the packet
+ */
+static uint32_t protocol_bench_packet(uint8_t command, uint8_t size, uint8_t* packet)
+{
+    uint8_t len = MINIMUM_PACKET_LENGTH + size;
+
+    packet[0] = PROTOCOL_BENCH_START_BYTE;
+    packet[1] = 0;
+    packet[2] = len;
+    packet[3] = command;
+    for (uint8_t i = 0; i < size; i++) packet[MINIMUM_PACKET_LENGTH + i] = (uint8_t)(i * 7U + size);
+    uint16_t crc = crc16(packet + 1, len - 1);
+    packet[len] = crc & 0xFF;
+    packet[len + 1] = crc >> 8;
+    packet[len + 2] = PROTOCOL_BENCH_STOP_BYTE;
+    return len + PROTOCOL_BENCH_SERVICE;
+}
+
+/**
+ * @brief Check if the received data is left
+ *
+ * @return 1 if the data is left
+ */
+static int protocol_bench_pending(void)
+{
+    const uint8_t* data;
+    uint32_t length;
+    return uart_interface_get_data(&data, &length) == PFC_SUCCESS;
+}
+
+/**
+ * @brief Keep the transmitted answer (the panel receiver)
+ *
+ * @param data The data block pointer
+ * @param length The size of the data block
+ */
+static void protocol_bench_monitor(const uint8_t* data, uint32_t length)
+{
+    if (length > sizeof(protocol_bench_answer)) length = sizeof(protocol_bench_answer);
+    memcpy(protocol_bench_answer, data, length);
+    protocol_bench_answer_length = length;
+    protocol_bench_answers++;
+}
+
+/**
+ * @brief Process the received request, take the answer
+ *
+ * @param request The request
+ * @param length The size of the request
+ *
+ * @return The number of the answers
+ */
+static uint32_t protocol_bench_exchange(const uint8_t* request, uint32_t length)
+{
+    protocol_bench_answers = 0;
+    if (host_uart_receive(request, length) != PFC_SUCCESS) return 0;
+    while (protocol_bench_pending()) protocol_work();
+    host_uart_step(0);
+    return protocol_bench_answers;
+}
+
+/**
+ * @brief Check the answer frame: the framing, the sequence number and a record per command
+ *
+ * @param sequence The sequence number of the request
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if the answer is wrong
+ */
+static status_t protocol_bench_check_frame(uint16_t sequence)
+{
+    const uint8_t* frame = protocol_bench_answer;
+    uint32_t len = frame[2] | (frame[3] << 8);
+    if (protocol_bench_answer_length != FRAME_SERVICE_LENGTH + len) return PFC_ERROR_DATA;
+    if (frame[0] != PROTOCOL_BENCH_FRAME_BYTE || frame[FRAME_HEADER_LENGTH + len + 2] != PROTOCOL_BENCH_STOP_BYTE) return PFC_ERROR_DATA;
+    if ((frame[4] | (frame[5] << 8)) != sequence || frame[1] != 0) return PFC_ERROR_DATA;
+    uint16_t crc = crc16(frame + 1, FRAME_HEADER_LENGTH - 1 + len);
+    if ((frame[FRAME_HEADER_LENGTH + len] | (frame[FRAME_HEADER_LENGTH + len + 1] << 8)) != crc) return PFC_ERROR_DATA;
+
+    uint32_t offset = FRAME_HEADER_LENGTH;
+    for (uint32_t i = 0; i < sizeof(protocol_bench_batch); i++)
+    {
+        struct frame_record_s record;
+        if (offset + sizeof(record) > FRAME_HEADER_LENGTH + len) return PFC_ERROR_DATA;
+        memcpy(&record, frame + offset, sizeof(record));
+        if (record.command != protocol_bench_batch[i]) return PFC_ERROR_DATA;
+        /* Only the unknown command is answered with the error */
+        if (record.status.fields.error != (record.command >= PFC_COMMAND_COUNT)) return PFC_ERROR_DATA;
+        offset += sizeof(record) + record.len;
+    }
+    if (offset != FRAME_HEADER_LENGTH + len) return PFC_ERROR_DATA;
+    return PFC_SUCCESS;
+}
+
+/**
+ * @brief Send the batch commands as the packets and in a frame, compare the traffic
+ *
+ * @param[out] result The results
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if an answer is wrong
+ */
+static status_t protocol_bench_frame(protocol_bench_result_t* result)
+{
+    static uint8_t request[MAXIMUM_FRAME_LENGTH];
+
+    host_uart_set_monitor(protocol_bench_monitor);
+    for (uint32_t i = 0; i < sizeof(protocol_bench_batch); i++)
+    {
+        uint32_t length = protocol_bench_packet(protocol_bench_batch[i], 0, request);
+        uint32_t transmitted = host_uart_get_transmitted();
+        /* The unknown command is ignored in the packets */
+        uint32_t answers = protocol_bench_exchange(request, length);
+        if (answers != (protocol_bench_batch[i] < PFC_COMMAND_COUNT)) return PFC_ERROR_DATA;
+        result->packet_exchanges += answers;
+        result->packet_bytes += length + host_uart_get_transmitted() - transmitted;
+    }
+
+    uint16_t len = 0;
+    for (uint32_t i = 0; i < sizeof(protocol_bench_batch); i++)
+    {
+        struct frame_record_s record = {0};
+        record.command = protocol_bench_batch[i];
+        memcpy(request + FRAME_HEADER_LENGTH + len, &record, sizeof(record));
+        len += sizeof(record);
+    }
+    request[0] = PROTOCOL_BENCH_FRAME_BYTE;
+    request[1] = 0;
+    request[2] = len & 0xFF;
+    request[3] = len >> 8;
+    request[4] = PROTOCOL_BENCH_SEQUENCE & 0xFF;
+    request[5] = PROTOCOL_BENCH_SEQUENCE >> 8;
+    uint16_t crc = crc16(request + 1, FRAME_HEADER_LENGTH - 1 + len);
+    request[FRAME_HEADER_LENGTH + len] = crc & 0xFF;
+    request[FRAME_HEADER_LENGTH + len + 1] = crc >> 8;
+    request[FRAME_HEADER_LENGTH + len + 2] = PROTOCOL_BENCH_STOP_BYTE;
+
+    uint32_t transmitted = host_uart_get_transmitted();
+    uint32_t answers = protocol_bench_exchange(request, FRAME_SERVICE_LENGTH + len);
+    host_uart_set_monitor(NULL);
+    if (answers != 1 || protocol_bench_check_frame(PROTOCOL_BENCH_SEQUENCE) != PFC_SUCCESS) return PFC_ERROR_DATA;
+    result->frame_commands = sizeof(protocol_bench_batch);
+    result->frame_bytes = FRAME_SERVICE_LENGTH + len + host_uart_get_transmitted() - transmitted;
+    return PFC_SUCCESS;
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Parse the test requests of different lengths received by the interface UART and measure the time,
+ * then send the batch commands as the packets and in a frame
+ * @note The firmware protocol is initialized: the function should be called once per process
+ *
+ * @param rounds The number of the receiver fillings
+ * @param[out] result The results
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if a packet has not been parsed or an answer is wrong
+ */
+status_t protocol_bench_run(uint32_t rounds, protocol_bench_result_t* result)
+{
+    ARGUMENT_ASSERT(result);
+
+    static uint8_t packets[sizeof(protocol_bench_sizes)][MAXIMUM_PACKET_LENGTH];
+    uint32_t lengths[sizeof(protocol_bench_sizes)];
+    uint32_t set_length = 0;
+    for (uint32_t i = 0; i < sizeof(protocol_bench_sizes); i++)
+    {
+        lengths[i] = protocol_bench_packet(PROTOCOL_BENCH_COMMAND, protocol_bench_sizes[i], packets[i]);
+        set_length += lengths[i];
+    }
+
+    memset(result, 0, sizeof(protocol_bench_result_t));
+    uart_init();
+    host_uart_set_line(0, 0);
+    status_t status = protocol_hw_init();
+    if (status != PFC_SUCCESS) return status;
+
+    clock_t parse_time = 0;
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        for (uint32_t fill = 0; fill < PROTOCOL_BENCH_FILLS; fill++)
+        {
+            for (uint32_t i = 0; i < sizeof(protocol_bench_sizes); i++)
+            {
+                if (host_uart_receive(packets[i], lengths[i]) != PFC_SUCCESS) return PFC_ERROR_DATA;
+            }
+        }
+
+        /* A call parses a packet */
+        uint32_t packets_parsed = 0;
+        clock_t start = clock();
+        while (protocol_bench_pending())
+        {
+            protocol_work();
+            packets_parsed++;
+        }
+        parse_time += clock() - start;
+
+        if (packets_parsed != PROTOCOL_BENCH_FILLS * sizeof(protocol_bench_sizes)) return PFC_ERROR_DATA;
+        result->packets += packets_parsed;
+        result->bytes += PROTOCOL_BENCH_FILLS * set_length;
+    }
+    result->time = (double)parse_time / CLOCKS_PER_SEC;
+    return protocol_bench_frame(result);
+}
+/** @} */
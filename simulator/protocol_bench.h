@@ -0,0 +1,55 @@
+/**
+ * @file protocol_bench.h
+ * @author Stanislav Karpikov
+ * @brief Panel protocol benchmark: the parsing throughput of the received requests, the requests batched in a frame (header)
+ */
+
+#ifndef _PROTOCOL_BENCH_H
+#define _PROTOCOL_BENCH_H
+
+/** @addtogroup sim_protocol_bench
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/debug.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** Protocol benchmark results */
+typedef struct
+{
+    uint32_t packets; /**< The number of the packets parsed */
+    uint32_t bytes;   /**< The number of the bytes parsed */
+    double time;      /**< The time of the parsing (the receiver filling is excluded) [s] */
+
+    uint32_t frame_commands;   /**< The number of the commands of the batch */
+    uint32_t packet_exchanges; /**< The number of the exchanges to run the batch as the packets (the unknown command is ignored) */
+    uint32_t packet_bytes;     /**< The traffic of the batch as the packets: the requests and the answers */
+    uint32_t frame_bytes;      /**< The traffic of the batch in a frame: the request and the answer */
+} protocol_bench_result_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Parse the test requests of different lengths received by the interface UART and measure the time,
+ * then send the batch commands as the packets and in a frame
+ * @note The firmware protocol is initialized: the function should be called once per process
+ *
+ * @param rounds The number of the receiver fillings
+ * @param[out] result The results
+ *
+ * @return The status of the operation: PFC_ERROR_DATA if a packet has not been parsed or an answer is wrong
+ */
+status_t protocol_bench_run(uint32_t rounds, protocol_bench_result_t* result);
+
+/** @} */
+#endif /* _PROTOCOL_BENCH_H */
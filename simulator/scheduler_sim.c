@@ -0,0 +1,153 @@
+/**
+ * @file scheduler_sim.c
+ * @author Stanislav Karpikov
+ * @brief Scheduler simulation: the tasks take the model time, an interrupt releases a task during the others
+ */
+
+/** @addtogroup sim_scheduler
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "scheduler_sim.h"
+
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define SCHEDULER_SIM_CLOCK     (1000000U) /**< The clock of the model time (a cycle is a microsecond) [Hz] */
+#define SCHEDULER_SIM_INTERRUPT (1000U)    /**< The period of the interrupt releasing the event task [us] */
+#define SCHEDULER_SIM_IDLE      (10U)      /**< The time of a pass without the tasks [us] */
+#define SCHEDULER_SIM_PERIOD    (500U)     /**< The period of the periodic task [us] */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS PROTOTYPES
+--------------------------------------------------------------*/
+
+static void scheduler_sim_event(void);
+static void scheduler_sim_background(void);
+static void scheduler_sim_periodic(void);
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+/** The tasks: the event task waits for the background one, the background one ends after its deadline */
+static const scheduler_sim_task_t sim_tasks[SCHEDULER_SIM_TASKS_NUM] = {
+    {"event", 200U, {scheduler_sim_event, SCHEDULER_TASK_EVENT, 0, 0, 400U}},
+    {"background", 700U, {scheduler_sim_background, SCHEDULER_TASK_BACKGROUND, 1, 0, 500U}},
+    {"periodic", 50U, {scheduler_sim_periodic, SCHEDULER_TASK_PERIODIC, 2, SCHEDULER_SIM_PERIOD, 500U}},
+};
+
+static scheduler_t sim_scheduler;       /**< The scheduler */
+static uint32_t sim_time = 0;           /**< The model time [us] */
+static uint32_t sim_next_interrupt = 0; /**< The model time of the next interrupt [us] */
+static uint32_t sim_interrupts = 0;     /**< The number of the interrupts */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief The clock of the scheduler: the model time
+ *
+ * @return The counter value [cycles]
+ */
+static uint32_t scheduler_sim_clock(void)
+{
+    return sim_time;
+}
+
+/**
+ * @brief Pass the model time, the interrupts release the event task at their time
+ *
+ * @param time The time to pass [us]
+ */
+static void scheduler_sim_spend(uint32_t time)
+{
+    uint32_t end = sim_time + time;
+    while ((int32_t)(end - sim_next_interrupt) >= 0)
+    {
+        sim_time = sim_next_interrupt;
+        scheduler_release(&sim_scheduler, 0);
+        sim_next_interrupt += SCHEDULER_SIM_INTERRUPT;
+        sim_interrupts++;
+    }
+    sim_time = end;
+}
+
+/**
+ * @brief The event task
+ */
+static void scheduler_sim_event(void)
+{
+    scheduler_sim_spend(sim_tasks[0].exec);
+}
+
+/**
+ * @brief The background task
+ */
+static void scheduler_sim_background(void)
+{
+    scheduler_sim_spend(sim_tasks[1].exec);
+}
+
+/**
+ * @brief The periodic task
+ */
+static void scheduler_sim_periodic(void)
+{
+    scheduler_sim_spend(sim_tasks[2].exec);
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Run the scheduler with the clock of the model time: every task takes its time, the interrupt releases the
+ * event task during the other tasks, the background task runs longer than its deadline and delays the periodic one
+ *
+ * @param time The model time of the run [us]
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t scheduler_sim_run(uint32_t time, scheduler_sim_result_t* result)
+{
+    ARGUMENT_ASSERT(result);
+
+    memset(result, 0, sizeof(scheduler_sim_result_t));
+    result->tasks = sim_tasks;
+    sim_time = 0;
+    sim_next_interrupt = SCHEDULER_SIM_INTERRUPT;
+    sim_interrupts = 0;
+
+    status_t status = scheduler_init(&sim_scheduler, scheduler_sim_clock, SCHEDULER_SIM_CLOCK);
+    for (uint8_t i = 0; i < SCHEDULER_SIM_TASKS_NUM && status == PFC_SUCCESS; i++)
+    {
+        status = scheduler_add(&sim_scheduler, &sim_tasks[i].config);
+    }
+    if (status != PFC_SUCCESS) return status;
+
+    while (sim_time < time)
+    {
+        if (!scheduler_run(&sim_scheduler)) scheduler_sim_spend(SCHEDULER_SIM_IDLE);
+        result->passes++;
+    }
+
+    result->interrupts = sim_interrupts;
+    for (uint8_t i = 0; i < SCHEDULER_SIM_TASKS_NUM; i++)
+    {
+        status = scheduler_get_stats(&sim_scheduler, i, &result->stats[i]);
+        if (status != PFC_SUCCESS) return status;
+    }
+    return PFC_SUCCESS;
+}
+
+/** @} */
@@ -0,0 +1,64 @@
+/**
+ * @file scheduler_sim.h
+ * @author Stanislav Karpikov
+ * @brief Scheduler simulation: the tasks take the model time, an interrupt releases a task during the others (header)
+ */
+
+#ifndef _SCHEDULER_SIM_H
+#define _SCHEDULER_SIM_H
+
+/** @addtogroup sim_scheduler
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "scheduler.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC DEFINES
+--------------------------------------------------------------*/
+
+#define SCHEDULER_SIM_TASKS_NUM (3U) /**< The tasks: the event one, the background one and the periodic one */
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** A simulated task */
+typedef struct
+{
+    const char* name;               /**< The name of the task */
+    uint32_t exec;                  /**< The model time of a run [us] */
+    scheduler_task_config_t config; /**< The configuration of the task */
+} scheduler_sim_task_t;
+
+/** Scheduler simulation results */
+typedef struct
+{
+    uint32_t passes;                                         /**< The number of the passes of the main loop */
+    uint32_t interrupts;                                     /**< The number of the releases by the interrupt */
+    const scheduler_sim_task_t* tasks;                       /**< The configuration of the tasks */
+    struct scheduler_stats_s stats[SCHEDULER_SIM_TASKS_NUM]; /**< The statistics of the tasks */
+} scheduler_sim_result_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Run the scheduler with the clock of the model time: every task takes its time, the interrupt releases the
+ * event task during the other tasks, the background task runs longer than its deadline and delays the periodic one
+ *
+ * @param time The model time of the run [us]
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t scheduler_sim_run(uint32_t time, scheduler_sim_result_t* result);
+
+/** @} */
+#endif /* _SCHEDULER_SIM_H */
@@ -0,0 +1,790 @@
+/**
+ * @file sim.c
+ * @author Stanislav Karpikov
+ * @brief Closed-loop simulation: the firmware control code against the plant model
+ */
+
+/** @addtogroup sim_loop
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "sim.h"
+
+#include "BSP/adc.h"
+#include "BSP/dma.h"
+#include "BSP/gpio.h"
+#include "BSP/iwdg.h"
+#include "BSP/system.h"
+#include "BSP/timer.h"
+#include "BSP/uart.h"
+#include "adc_logic.h"
+#include "capture.h"
+#include "command_processor.h"
+#include "crc.h"
+#include "events.h"
+#include "events_process.h"
+#include "host_bsp.h"
+#include "journal.h"
+#include "math.h"
+#include "settings.h"
+#include "string.h"
+#include "tasks.h"
+#include "telemetry.h"
+#include "time.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define DEFAULT_UCAP_KP        (0.1f)   /**< Default configuration: the capacitors charge PID proportional coefficient */
+#define DEFAULT_UCAP_KI        (5e-5f)  /**< Default configuration: the capacitors charge PID integral coefficient */
+#define DEFAULT_UCAP_PRECHARGE (500.0f) /**< Default configuration: the precharge level, close to the rectified grid voltage [V] */
+#define DEFAULT_I_MAX_RMS      (60.0f)  /**< Default configuration: maximum current (RMS), the plant is rated for the 20 Ohm load [A] */
+#define DEFAULT_I_MAX_PEAK     (100.0f) /**< Default configuration: maximum current (peak) [A] */
+#define DEFAULT_START_TIMEOUT  (10.0f)  /**< Default configuration: the maximum time to reach the work state [s] */
+#define DEFAULT_CHARGE_TIME    (1.0f)   /**< Default configuration: the charge time [s] */
+#define DEFAULT_LOAD_TIME      (1.0f)   /**< Default configuration: the time with the load [s] */
+#define DEFAULT_FAULT_TIME     (0.5f)   /**< Default configuration: the fault injection time (from the work state) [s] */
+
+#define ADC_CODE_MAX           (4095U) /**< The maximum ADC code (12 bit) */
+#define FAULT_OBSERVATION_TIME (0.1f)  /**< The time to run after the fault injection [s] */
+#define FAULT_I_RMS_EXCESS     (1.1f)  /**< The injected DC current relative to the RMS protection level */
+#define FAULT_UCAP_EXCESS      (50.0f) /**< The injected capacitor voltage deviation from the protection level [V] */
+
+#define PANEL_START_BYTE   (0x55U) /**< The panel requests: the start byte */
+#define PANEL_STOP_BYTE    (0x77U) /**< The panel requests: the stop byte */
+#define PANEL_RENEW_PERIOD (1.0)   /**< The period of the telemetry subscription renewal [s] */
+#define PANEL_OSCILLOGS    (10U)   /**< The number of the oscillogram channels shown by the panel */
+#define PANEL_PAGE_PERIOD  (0.3)   /**< The period of the main page poll (the terminal timers) [s] */
+#define PANEL_PERIODS_KEPT (16U)   /**< The number of the last periods with the publication time kept (the age of the values) */
+#define PANEL_READ_PASSES  (4U)    /**< The main loop passes to answer a request after the run */
+#define PANEL_EVENTS_READS (16U)   /**< The maximum number of the events requests after the run */
+
+#define SYSTICK_PERIOD     (1e-3) /**< The system time tick [s] */
+
+/*--------------------------------------------------------------
+                       PRIVATE TYPES
+--------------------------------------------------------------*/
+
+/** The main page poll of the panel in progress */
+typedef struct
+{
+    uint8_t sent;     /**< The number of the requests sent, 0 - no poll */
+    uint8_t received; /**< The number of the answers received */
+    uint32_t period;  /**< The period of the values of the last request */
+    uint32_t oldest;  /**< The oldest period of the values received */
+    uint32_t newest;  /**< The newest period of the values received */
+} sim_page_poll_t;
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static sim_result_t* panel_result = NULL; /**< The results to count the data received by the panel */
+static uint32_t panel_sequence = 0;       /**< The number of the last telemetry push received by the panel */
+
+/** The main page requests of the terminal (a request per value group) */
+static const uint8_t panel_page_commands[] = {PFC_COMMAND_GET_ADC_ACTIVE, PFC_COMMAND_GET_ADC_ACTIVE_RAW, PFC_COMMAND_GET_NET_PARAMS,
+                                              PFC_COMMAND_GET_WORK_STATE};
+
+static sim_page_t panel_page = SIM_PAGE_NONE;           /**< The main page poll */
+static sim_page_poll_t panel_poll;                      /**< The main page poll in progress */
+static double panel_time = 0;                           /**< The model time (the panel receiver) [s] */
+static double panel_page_age = 0;                       /**< The sum of the ages of the oldest values of the polls [s] */
+static double panel_period_time[PANEL_PERIODS_KEPT];    /**< The publication times of the last periods [s] */
+static uint8_t panel_save_answered = 0;                 /**< The answer to the settings save has been received */
+static uint32_t panel_events_next = 0;                  /**< The sequence number of the next event to read */
+static uint32_t panel_events_last = 0;                  /**< The sequence number of the last event in the device */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Start the firmware: the same sequence as in the main function
+ */
+static void sim_firmware_start(void)
+{
+    system_init();
+
+    settings_read();
+
+    gpio_init();
+    dma_init();
+    adc_init();
+    timer_init();
+    uart_init();
+    iwdg_init();
+
+    capture_start();
+    journal_start();
+
+    /* The start is out of the model time (the storage is read and formatted before the PWM is started) */
+    host_flash_take_stall();
+
+    pfc_init();
+
+    system_delay_ticks(STARTUP_TIMEOUT);
+
+    tasks_init();
+
+    adc_logic_start();
+
+    protocol_hw_init();
+
+    gpio_status_led_on();
+}
+
+/**
+ * @brief Run one iteration of the firmware main loop
+ */
+static void sim_firmware_loop(void)
+{
+    host_system_loop_begin();
+    tasks_run();
+    host_system_loop_end();
+}
+
+/**
+ * @brief Emulate the panel: send a request to the interface UART
+ *
+ * @param command The command
+ * @param data The data of the request
+ * @param size The size of the data
+ *
+ * @return The size of the packet
+ */
+static uint32_t sim_panel_send(uint8_t command, const void* data, uint8_t size)
+{
+    uint8_t packet[MAXIMUM_PACKET_LENGTH] = {0};
+    uint8_t len = MINIMUM_PACKET_LENGTH + size;
+
+    packet[0] = PANEL_START_BYTE;
+    packet[2] = len;
+    packet[3] = command;
+    memcpy(packet + MINIMUM_PACKET_LENGTH, data, size);
+    uint16_t crc = crc16(packet + 1, len - 1);
+    packet[len] = crc & 0xFF;
+    packet[len + 1] = crc >> 8;
+    packet[len + 2] = PANEL_STOP_BYTE;
+    host_uart_receive(packet, len + 3);
+    return len + 3;
+}
+
+/**
+ * @brief Emulate the panel: send the oscillogram request to the interface UART
+ */
+static void sim_panel_request(void)
+{
+    struct command_get_oscillog req = {0};
+    sim_panel_send(PFC_COMMAND_GET_OSCILLOG, &req, sizeof(req));
+}
+
+/**
+ * @brief Emulate the panel: subscribe to all the telemetry (all the oscillogram channels) or renew the subscription
+ *
+ * @param decimation The push is made every decimation periods
+ */
+static void sim_panel_subscribe(uint8_t decimation)
+{
+    struct command_subscribe req = {0};
+    req.groups = TELEMETRY_GROUPS_ALL;
+    req.oscillogs = (1U << PANEL_OSCILLOGS) - 1;
+    req.decimation = decimation;
+    sim_panel_send(PFC_COMMAND_SUBSCRIBE, &req, sizeof(req));
+}
+
+/**
+ * @brief Emulate the panel: trigger a waveform capture
+ *
+ * @param post_samples The post-trigger window [samples]
+ */
+static void sim_panel_capture(uint16_t post_samples)
+{
+    struct command_set_capture req = {0};
+    req.triggers = CAPTURE_TRIGGER_PROTECTION | CAPTURE_TRIGGER_COMMAND;
+    req.post_samples = post_samples;
+    req.trigger = 1;
+    sim_panel_send(PFC_COMMAND_SET_CAPTURE, &req, sizeof(req));
+}
+
+/**
+ * @brief Emulate the panel: read the statistics of the main loop tasks after the run
+ * @note The line is not modelled: the queued answers are transmitted at once
+ */
+static void sim_panel_read_scheduler(void)
+{
+    struct command_get_scheduler_stats req = {0};
+    host_uart_set_line(0, 0);
+    host_uart_step(0);
+    sim_panel_send(PFC_COMMAND_GET_SCHEDULER_STATS, &req, sizeof(req));
+    for (uint32_t i = 0; i < PANEL_READ_PASSES; i++)
+    {
+        protocol_work();
+        host_uart_step(0);
+    }
+    host_uart_take_stall();
+}
+
+/**
+ * @brief Emulate the panel: save the settings (the switch command)
+ */
+static void sim_panel_save_settings(void)
+{
+    struct command_switch_on_off req = {0};
+    req.command = COMMAND_SETTINGS_SAVE;
+    sim_panel_send(PFC_COMMAND_SWITCH_ON_OFF, &req, sizeof(req));
+}
+
+/**
+ * @brief Emulate the panel: read all the events after the run
+ * @note The line is not modelled: the queued answers are transmitted at once
+ */
+static void sim_panel_read_events(void)
+{
+    panel_events_next = 1;
+    panel_events_last = 0;
+    host_uart_set_line(0, 0);
+    for (uint32_t n = 0; n < PANEL_EVENTS_READS && panel_events_next > panel_events_last; n++)
+    {
+        struct command_get_events req = {0};
+        req.sequence = panel_events_next;
+        host_uart_step(0);
+        sim_panel_send(PFC_COMMAND_GET_EVENTS, &req, sizeof(req));
+        for (uint32_t i = 0; i < PANEL_READ_PASSES; i++)
+        {
+            protocol_work();
+            host_uart_step(0);
+        }
+        if (panel_events_next == req.sequence) break;
+    }
+    host_uart_take_stall();
+}
+
+/**
+ * @brief Check the settings stored in the EEPROM (the records of all the sections) against the current ones
+ *
+ * @return 1 if the stored settings match
+ */
+static uint8_t sim_check_stored_settings(void)
+{
+    settings_t current;
+    memset(&current, 0, sizeof(current));
+    current.calibrations = settings_get_calibrations();
+    current.filters = settings_get_filters();
+    current.pwm = settings_get_pwm();
+    current.protection = settings_get_protection();
+    current.capacitors = settings_get_capacitors();
+
+    settings_t stored;
+    if (settings_read_stored(&stored) != PFC_SUCCESS) return 0;
+    return !memcmp(&stored, &current, sizeof(settings_t));
+}
+
+/**
+ * @brief Get the number of the requests of a main page poll
+ *
+ * @param page The main page poll
+ *
+ * @return The number of the requests
+ */
+static uint8_t sim_panel_page_requests(sim_page_t page)
+{
+    return (page == SIM_PAGE_BUNDLE) ? 1 : sizeof(panel_page_commands);
+}
+
+/**
+ * @brief Emulate the panel: send the next request of the main page poll
+ */
+static void sim_panel_page_request(void)
+{
+    uint32_t length;
+    if (panel_page == SIM_PAGE_BUNDLE)
+    {
+        struct command_get_bundle req = {0};
+        req.sections = BUNDLE_SECTIONS_ALL;
+        req.currentTime = system_get_time();
+        length = sim_panel_send(PFC_COMMAND_GET_BUNDLE, &req, sizeof(req));
+    }
+    else if (panel_page_commands[panel_poll.sent] == PFC_COMMAND_GET_WORK_STATE)
+    {
+        struct command_get_work_state req = {0};
+        req.currentTime = system_get_time();
+        length = sim_panel_send(PFC_COMMAND_GET_WORK_STATE, &req, sizeof(req));
+    }
+    else
+    {
+        /* The requests of the values hold a dummy byte */
+        struct command_get_adc_active req = {0};
+        length = sim_panel_send(panel_page_commands[panel_poll.sent], &req, sizeof(req));
+    }
+    /* The request is answered before the next period is published (the main loop handles the requests first) */
+    panel_poll.period = adc_get_periods();
+    panel_poll.sent++;
+    panel_result->requests++;
+    panel_result->page_exchanges++;
+    panel_result->page_bytes += length;
+}
+
+/**
+ * @brief Emulate the panel: take an answer of the main page poll, the age of the values at the end of the poll
+ *
+ * @param command The command of the answer
+ * @param payload The data of the answer
+ * @param size The size of the data
+ */
+static void sim_panel_page_answer(uint8_t command, const uint8_t* payload, uint32_t size)
+{
+    uint32_t period = panel_poll.period;
+    if (!panel_poll.sent || panel_poll.received >= panel_poll.sent)
+    {
+        panel_result->page_errors++;
+        return;
+    }
+    if (panel_page == SIM_PAGE_BUNDLE)
+    {
+        struct answer_get_bundle header;
+        uint32_t sections_size = sizeof(struct answer_get_adc_active) + sizeof(struct answer_get_adc_active_raw) +
+                                 sizeof(struct answer_get_net_params) + sizeof(struct answer_get_work_state);
+        memcpy(&header, payload, (size < sizeof(header)) ? size : sizeof(header));
+        /* All the values of the bundle are of the period in the header */
+        if (size != sizeof(header) + sections_size || header.sections != BUNDLE_SECTIONS_ALL || header.period < period)
+        {
+            panel_result->page_errors++;
+        }
+        period = header.period;
+    }
+    else if (command != panel_page_commands[panel_poll.received])
+    {
+        panel_result->page_errors++;
+    }
+
+    if (!panel_poll.received || period < panel_poll.oldest) panel_poll.oldest = period;
+    if (!panel_poll.received || period > panel_poll.newest) panel_poll.newest = period;
+    panel_poll.received++;
+    if (panel_poll.received < sim_panel_page_requests(panel_page)) return;
+
+    panel_page_age += panel_time - panel_period_time[panel_poll.oldest % PANEL_PERIODS_KEPT];
+    if (panel_poll.newest - panel_poll.oldest > panel_result->page_spread) panel_result->page_spread = panel_poll.newest - panel_poll.oldest;
+    panel_result->page_polls++;
+    memset(&panel_poll, 0, sizeof(panel_poll));
+}
+
+/**
+ * @brief Emulate the panel: count the data of a packet received from the interface UART
+ *
+ * @param data The packet
+ * @param length The size of the packet
+ */
+static void sim_panel_receive(const uint8_t* data, uint32_t length)
+{
+    if (!panel_result || length < MINIMUM_PACKET_LENGTH + 3) return;
+
+    const uint8_t* payload = data + MINIMUM_PACKET_LENGTH;
+    switch (data[3])
+    {
+        case PFC_COMMAND_GET_OSCILLOG:
+            panel_result->oscillogs++;
+            break;
+        case PFC_COMMAND_GET_ADC_ACTIVE:
+        case PFC_COMMAND_GET_ADC_ACTIVE_RAW:
+        case PFC_COMMAND_GET_NET_PARAMS:
+        case PFC_COMMAND_GET_WORK_STATE:
+        case PFC_COMMAND_GET_BUNDLE:
+            panel_result->page_bytes += length;
+            sim_panel_page_answer(data[3], payload, data[2] - MINIMUM_PACKET_LENGTH);
+            break;
+        case PFC_COMMAND_GET_SCHEDULER_STATS:
+        {
+            struct answer_get_scheduler_stats answer;
+            memcpy(&answer, payload, sizeof(answer));
+            panel_result->period_jitter = answer.tasks[TASK_PERIOD].jitter_max * 1e-6f;
+            panel_result->period_overrun = answer.tasks[TASK_PERIOD].overruns;
+            panel_result->period_missed = answer.tasks[TASK_PERIOD].missed;
+            panel_result->protocol_exec = answer.tasks[TASK_PROTOCOL].exec_max * 1e-6f;
+            panel_result->settings_exec = answer.tasks[TASK_SETTINGS].exec_max * 1e-6f;
+            break;
+        }
+        case PFC_COMMAND_SWITCH_ON_OFF:
+            panel_save_answered = 1;
+            break;
+        case PFC_COMMAND_GET_EVENTS:
+        {
+            struct answer_get_events answer;
+            memcpy(&answer, payload, sizeof(answer));
+            panel_events_last = answer.last_sequence;
+            for (uint16_t i = 0; i < answer.num && i < MAX_NUM_TRANSFERED_EVENTS; i++)
+            {
+                const struct event_record_s* event = &answer.events[i];
+                if (event->type == (EVENT_TYPE_EVENT | (SUB_EVENT_TYPE_EVENT_SETTINGS_SAVED << 16)))
+                {
+                    panel_result->settings_saved = event->info;
+                    panel_result->settings_time = event->value * 1e-3f;
+                }
+                panel_events_next = event->sequence + 1;
+            }
+            break;
+        }
+        case PFC_COMMAND_TELEMETRY:
+        {
+            struct answer_telemetry header;
+            memcpy(&header, payload, sizeof(header));
+            if (panel_sequence && header.sequence != panel_sequence + 1) panel_result->pushes_lost += header.sequence - panel_sequence - 1;
+            panel_sequence = header.sequence;
+            panel_result->pushes++;
+            if (header.groups & TELEMETRY_GROUP_OSCILLOG) panel_result->oscillogs++;
+            if (header.groups & TELEMETRY_GROUP_ADC_ACTIVE) panel_result->values++;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Apply the settings the panel would send before the start
+ *
+ * @param config The configuration
+ */
+static void sim_apply_settings(const sim_config_t* config)
+{
+    settings_calibrations_t calibrations;
+    plant_get_calibrations(&calibrations);
+    settings_set_calibrations(calibrations);
+
+    settings_capacitors_t capacitors = settings_get_capacitors();
+    capacitors.ctrl_Ucap_Kp = config->ucap_kp;
+    capacitors.ctrl_Ucap_Ki = config->ucap_ki;
+    capacitors.Ucap_precharge = config->ucap_precharge;
+    settings_set_capacitors(capacitors);
+
+    settings_protection_t protection = settings_get_protection();
+    protection.I_max_rms = config->i_max_rms;
+    protection.I_max_peak = config->i_max_peak;
+    settings_set_protection(protection);
+}
+
+/**
+ * @brief Convert a value to an ADC code with the plant calibrations
+ *
+ * @param calibrations The calibrations
+ * @param channel The channel
+ * @param value The value
+ *
+ * @return The saturated ADC code
+ */
+static uint16_t sim_code(const settings_calibrations_t* calibrations, int channel, float value)
+{
+    float code = value / calibrations->calibration[channel] + calibrations->offset[channel];
+    if (code < 0) return 0;
+    if (code > ADC_CODE_MAX) return ADC_CODE_MAX;
+    return (uint16_t)code;
+}
+
+/**
+ * @brief Replace the measured values with the fault ones
+ *
+ * @param fault The fault
+ * @param plant The plant
+ * @param[in,out] codes ADC codes for all the physical channels
+ */
+static void sim_inject_fault(sim_fault_t fault, const plant_t* plant, uint16_t* codes)
+{
+    settings_calibrations_t calibrations;
+    settings_protection_t protection = settings_get_protection();
+    plant_get_calibrations(&calibrations);
+
+    switch (fault)
+    {
+        case SIM_FAULT_I_MAX_PEAK:
+            codes[ADC_I_A] = ADC_CODE_MAX;
+            break;
+        case SIM_FAULT_I_MAX_RMS:
+            codes[ADC_I_A] = sim_code(&calibrations, ADC_I_A, plant->i[PFC_ACHAN] + protection.I_max_rms * FAULT_I_RMS_EXCESS);
+            break;
+        case SIM_FAULT_UCAP_MAX:
+            codes[ADC_UCAP] = sim_code(&calibrations, ADC_UCAP, protection.Ucap_max + FAULT_UCAP_EXCESS);
+            break;
+        case SIM_FAULT_UCAP_MIN:
+            codes[ADC_UCAP] = sim_code(&calibrations, ADC_UCAP, protection.Ucap_min - FAULT_UCAP_EXCESS);
+            break;
+        case SIM_FAULT_U_MIN:
+            codes[ADC_U_A] = sim_code(&calibrations, ADC_U_A, 0);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Read the plant inputs from the emulated peripherals
+ *
+ * @param load_on The load is connected
+ * @param[out] inputs The plant inputs
+ */
+static void sim_read_outputs(uint8_t load_on, plant_inputs_t* inputs)
+{
+    host_gpio_state_t gpio;
+    host_timer_state_t timer;
+    host_gpio_get_state(&gpio);
+    host_timer_get_state(&timer);
+
+    inputs->main_relay = gpio.main_relay;
+    inputs->preload_relay = gpio.preload_relay;
+    inputs->pwm_on = timer.enabled;
+    inputs->load_on = load_on;
+    for (uint32_t k = 0; k < PFC_NCHAN; k++)
+    {
+        /* PWM mode 1: the upper switch is on while the counter is below CCR */
+        float duty = (float)timer.ccr[k] / (float)PWM_PERIOD;
+        if (duty > 1.0f) duty = 1.0f;
+        inputs->duty[k] = duty;
+    }
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Fill the configuration with the README scenario: charge for 1 s, then connect the 20 Ohm load for 1 s
+ *
+ * @param[out] config The configuration
+ */
+void sim_default_config(sim_config_t* config)
+{
+    if (!config) return;
+    memset(config, 0, sizeof(sim_config_t));
+    plant_default_params(&config->plant);
+    config->ucap_kp = DEFAULT_UCAP_KP;
+    config->ucap_ki = DEFAULT_UCAP_KI;
+    config->ucap_precharge = DEFAULT_UCAP_PRECHARGE;
+    config->i_max_rms = DEFAULT_I_MAX_RMS;
+    config->i_max_peak = DEFAULT_I_MAX_PEAK;
+    config->start_timeout = DEFAULT_START_TIMEOUT;
+    config->charge_time = DEFAULT_CHARGE_TIME;
+    config->load_time = DEFAULT_LOAD_TIME;
+    config->fault_time = DEFAULT_FAULT_TIME;
+    config->baudrate = USART_INTERFACE_BAUDRATE;
+}
+
+/*
+ * @brief Get the name of a fault
+ *
+ * @param fault The fault
+ *
+ * @return The name
+ */
+const char* sim_fault_name(sim_fault_t fault)
+{
+    static const char* names[SIM_FAULT_COUNT] = {"none", "i-max-peak", "i-max-rms", "ucap-max", "ucap-min", "u-min"};
+    if (fault >= SIM_FAULT_COUNT) return "-";
+    return names[fault];
+}
+
+/*
+ * @brief Run the firmware against the plant: start, charge and load step
+ * @note The firmware uses the global state, so the function can be called once per process
+ *
+ * @param config The configuration
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t sim_run(const sim_config_t* config, sim_result_t* result)
+{
+    ARGUMENT_ASSERT(config);
+    ARGUMENT_ASSERT(result);
+
+    plant_t plant;
+    status_t status = plant_init(&plant, &config->plant);
+    if (status != PFC_SUCCESS) return status;
+
+    memset(result, 0, sizeof(sim_result_t));
+    result->work_time = -1;
+    result->trip_samples = -1;
+
+    host_flash_set_stall(config->flash_timing);
+    sim_firmware_start();
+    sim_apply_settings(config);
+    host_uart_set_line(config->baudrate, config->uart_blocking);
+    panel_result = result;
+    panel_sequence = 0;
+    panel_page = config->page_poll;
+    memset(&panel_poll, 0, sizeof(panel_poll));
+    panel_page_age = 0;
+    host_uart_set_monitor(sim_panel_receive);
+    panel_save_answered = 0;
+
+    double end_time = config->start_timeout;
+    double load_time = 0;
+    double fault_time = 0;
+    uint32_t fault_sample = 0;
+    uint8_t fault_on = 0;
+    double tick_accumulator = 0;
+    uint8_t load_on = 0;
+    pfc_state_t last_state = pfc_get_state();
+    double next_request = config->panel_period;
+    double next_renew = 0;
+    double next_page = PANEL_PAGE_PERIOD;
+    uint32_t last_period = adc_get_periods();
+    double loop_wait = 0;
+    double loop_time = 0;
+    uint8_t save_sent = 0;
+    clock_t wall_start = clock();
+
+    if (config->trace) fprintf(config->trace, "time,state,ucap,ucap_measured,u_a,i_a,i_b,i_c,pwm,load\n");
+
+    while (plant.time < end_time)
+    {
+        uint16_t codes[ADC_CHANNEL_NUMBER];
+        plant_sample(&plant, codes);
+        if (!fault_on && config->fault != SIM_FAULT_NONE && result->work_time >= 0 && plant.time >= fault_time)
+        {
+            fault_on = 1;
+            fault_sample = result->samples;
+            fault_time = plant.time;
+            end_time = plant.time + FAULT_OBSERVATION_TIME;
+        }
+        if (fault_on) sim_inject_fault(config->fault, &plant, codes);
+        host_adc_convert(codes);
+
+        if (config->panel_period > 0 && plant.time >= next_request)
+        {
+            sim_panel_request();
+            result->requests++;
+            next_request += config->panel_period;
+        }
+        if (config->telemetry_decimation && plant.time >= next_renew)
+        {
+            sim_panel_subscribe(config->telemetry_decimation);
+            result->requests++;
+            next_renew += PANEL_RENEW_PERIOD;
+        }
+        if (config->page_poll != SIM_PAGE_NONE && plant.time >= next_page)
+        {
+            /* A poll is skipped if the previous one is not complete (as the terminal queue) */
+            if (!panel_poll.sent) sim_panel_page_request();
+            next_page += PANEL_PAGE_PERIOD;
+        }
+        /* The next request of the poll is sent after the answer (the half-duplex line) */
+        if (panel_poll.sent && panel_poll.received == panel_poll.sent && panel_poll.sent < sim_panel_page_requests(panel_page))
+        {
+            sim_panel_page_request();
+        }
+
+        /* The main loop waits for the end of the blocking transmissions and the flash memory operations, the interrupts
+         * are served */
+        if (loop_wait <= 0)
+        {
+            sim_firmware_loop();
+            if (plant.time - loop_time > result->loop_stall_max) result->loop_stall_max = (float)(plant.time - loop_time);
+            loop_time = plant.time;
+            loop_wait = host_uart_take_stall() + host_flash_take_stall();
+
+            /* The publication times of the periods: the age of the values received by the panel */
+            uint32_t period = adc_get_periods();
+            if (period != last_period) panel_period_time[period % PANEL_PERIODS_KEPT] = plant.time;
+            last_period = period;
+        }
+
+        pfc_state_t state = pfc_get_state();
+        if (state != last_state && state == PFC_STATE_FAULTBLOCK) result->faults++;
+        last_state = state;
+
+        /* Emulate the panel: start the PFC and keep the charge on */
+        if (state == PFC_STATE_STOP && result->faults == 0)
+        {
+            /* The settings are saved in the stop state only, the panel starts after the answer */
+            if (config->settings_save && !save_sent)
+            {
+                sim_panel_save_settings();
+                save_sent = 1;
+            }
+            if (!config->settings_save || panel_save_answered) pfc_apply_command(COMMAND_WORK_ON, 0);
+        }
+        if (state == PFC_STATE_WORK && result->work_time < 0)
+        {
+            result->work_time = (float)plant.time;
+            load_time = plant.time + config->charge_time;
+            end_time = load_time + config->load_time;
+            fault_time = plant.time + config->fault_time;
+        }
+        if (state == PFC_STATE_WORK || state == PFC_STATE_CHARGE)
+        {
+            /* The charge command restarts the charge timeout */
+            pfc_apply_command(COMMAND_CHARGE_ON, 0);
+        }
+
+        if (result->work_time >= 0)
+        {
+            if (!load_on && plant.time >= load_time)
+            {
+                load_on = 1;
+                result->ucap_before_load = plant.ucap;
+                result->ucap_min_load = plant.ucap;
+                if (config->capture_load) sim_panel_capture(config->capture_load);
+            }
+            if (!load_on && plant.ucap > result->ucap_max_charge) result->ucap_max_charge = plant.ucap;
+            if (load_on && plant.ucap < result->ucap_min_load) result->ucap_min_load = plant.ucap;
+            for (uint32_t k = 0; k < PFC_NCHAN; k++)
+            {
+                if (fabsf(plant.i[k]) > result->i_peak) result->i_peak = fabsf(plant.i[k]);
+            }
+        }
+
+        plant_inputs_t inputs;
+        sim_read_outputs(load_on, &inputs);
+
+        /* The trip latency: the injection sample is counted as zero */
+        if (fault_on && result->trip_samples < 0 && !inputs.pwm_on)
+        {
+            result->trip_samples = (int32_t)(result->samples - fault_sample);
+            result->trip_time = (float)(plant.time - fault_time);
+        }
+
+        if (config->trace && (result->samples % ADC_VAL_NUM) == 0)
+        {
+            fprintf(config->trace, "%.4f,%d,%.2f,%.2f,%.2f,%.3f,%.3f,%.3f,%d,%d\n",
+                    plant.time, state, plant.ucap, adc_get_cap_voltage(), plant.u[PFC_ACHAN],
+                    plant.i[PFC_ACHAN], plant.i[PFC_BCHAN], plant.i[PFC_CCHAN], inputs.pwm_on, load_on);
+        }
+
+        double dt = host_timer_get_sample_period();
+        plant_step(&plant, &inputs, dt);
+        panel_time = plant.time + dt;
+        host_uart_step(dt);
+        loop_wait -= dt;
+        result->samples++;
+
+        /* The system tick */
+        host_system_step(dt);
+        tick_accumulator += dt;
+        while (tick_accumulator >= SYSTICK_PERIOD)
+        {
+            system_increment_time();
+            tick_accumulator -= SYSTICK_PERIOD;
+        }
+    }
+
+    result->wall_time = (double)(clock() - wall_start) / CLOCKS_PER_SEC;
+    result->model_time = plant.time;
+    result->ucap_final = plant.ucap;
+    result->final_state = pfc_get_state();
+    result->tx_bytes = host_uart_get_transmitted();
+    result->page_age = result->page_polls ? (float)(panel_page_age / result->page_polls) : 0;
+    sim_panel_read_scheduler();
+    if (config->settings_save)
+    {
+        sim_panel_read_events();
+        result->settings_stored = sim_check_stored_settings();
+    }
+    host_uart_set_monitor(NULL);
+    panel_result = NULL;
+    return PFC_SUCCESS;
+}
+/** @} */
@@ -0,0 +1,143 @@
+/**
+ * @file sim.h
+ * @author Stanislav Karpikov
+ * @brief Closed-loop simulation: the firmware control code against the plant model (header)
+ */
+
+#ifndef _SIM_H
+#define _SIM_H
+
+/** @addtogroup sim_loop
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "plant.h"
+#include "pfc_logic.h"
+#include "stdint.h"
+#include "stdio.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** Faults injected into the measured signals (phase A or the DC-link) */
+typedef enum
+{
+    SIM_FAULT_NONE,       /**< No faults */
+    SIM_FAULT_I_MAX_PEAK, /**< The current is above the peak protection level (the ADC full scale) */
+    SIM_FAULT_I_MAX_RMS,  /**< The current has a DC offset above the RMS protection level */
+    SIM_FAULT_UCAP_MAX,   /**< The capacitor voltage is above the maximum */
+    SIM_FAULT_UCAP_MIN,   /**< The capacitor voltage is below the minimum */
+    SIM_FAULT_U_MIN,      /**< The grid voltage is lost */
+    SIM_FAULT_COUNT,      /**< The number of the faults */
+} sim_fault_t;
+
+/** The main page poll of the panel */
+typedef enum
+{
+    SIM_PAGE_NONE,     /**< No polls */
+    SIM_PAGE_REQUESTS, /**< A request per value group: the active values, the raw values, the network parameters, the state */
+    SIM_PAGE_BUNDLE,   /**< A bundle request of all the groups */
+} sim_page_t;
+
+/** Simulation configuration */
+typedef struct
+{
+    plant_params_t plant;  /**< The parameters of the plant */
+    float ucap_kp;         /**< The capacitors charge PID: the proportional coefficient */
+    float ucap_ki;         /**< The capacitors charge PID: the integral coefficient */
+    float ucap_precharge;  /**< The precharge level (capacitor voltage) [V] */
+    float i_max_rms;       /**< The protection level: maximum current (RMS) [A] */
+    float i_max_peak;      /**< The protection level: maximum current (peak) [A] */
+    float start_timeout;   /**< The maximum time to reach the work state [s] */
+    float charge_time;     /**< The time of the charge before the load is connected [s] */
+    float load_time;       /**< The time of the operation with the load [s] */
+    sim_fault_t fault;     /**< The fault to inject */
+    float fault_time;      /**< The time of the fault injection (from the work state, the charge) [s] */
+    FILE* trace;           /**< The file to write the trace (one line per period), can be NULL */
+    float panel_period;    /**< The period of the panel requests (the oscillogram), 0 - no requests [s] */
+    uint8_t telemetry_decimation; /**< The panel subscribes to the telemetry pushed every N periods, 0 - no subscription */
+    uint32_t baudrate;     /**< The baudrate of the interface UART, 0 - the answers are transmitted at once */
+    uint8_t uart_blocking; /**< The answers are transmitted with the blocking calls (the main loop waits for the end) */
+    uint16_t capture_load; /**< The panel triggers a capture at the load step with N post-trigger samples, 0 - no capture */
+    sim_page_t page_poll;  /**< The panel polls the main page values (a request after the answer to the previous one) */
+    uint8_t settings_save; /**< The panel saves the settings before the start (written during the charge) */
+    uint8_t flash_timing;  /**< The flash memory operations stall the main loop (the typical times of the erases and the programming) */
+} sim_config_t;
+
+/** Simulation results */
+typedef struct
+{
+    double model_time;       /**< The model time [s] */
+    double wall_time;        /**< The time spent by the host [s] */
+    float work_time;         /**< The model time when the work state was reached, negative if not reached [s] */
+    float ucap_before_load;  /**< The DC-link voltage before the load step [V] */
+    float ucap_max_charge;   /**< The maximum DC-link voltage during the charge [V] */
+    float ucap_min_load;     /**< The minimum DC-link voltage after the load step [V] */
+    float ucap_final;        /**< The DC-link voltage at the end [V] */
+    float i_peak;            /**< The peak phase current [A] */
+    uint32_t samples;        /**< The number of ADC samples processed */
+    uint32_t faults;         /**< The number of transitions to the fault state */
+    pfc_state_t final_state; /**< The PFC state at the end */
+    int32_t trip_samples;    /**< ADC samples from the fault injection to the PWM switch off, negative if not switched off */
+    float trip_time;         /**< The time from the fault injection to the PWM switch off [s] */
+    uint32_t requests;       /**< The number of the panel requests */
+    uint32_t tx_bytes;       /**< The number of the bytes transmitted to the panel */
+    float loop_stall_max;    /**< The maximum time between the main loop iterations [s] */
+    uint32_t oscillogs;      /**< The number of the oscillograms received by the panel */
+    uint32_t values;         /**< The number of the value sets (the active values) received by the panel */
+    uint32_t pushes;         /**< The number of the telemetry pushes received by the panel */
+    uint32_t pushes_lost;    /**< The number of the telemetry pushes lost (the gaps of the push numbers) */
+    uint32_t page_polls;     /**< The number of the main page polls completed */
+    uint32_t page_exchanges; /**< The number of the exchanges of the main page polls */
+    uint32_t page_bytes;     /**< The traffic of the main page polls: the requests and the answers */
+    float page_age;          /**< The mean age of the oldest main page value at the end of a poll (from the end of its period) [s] */
+    uint32_t page_spread;    /**< The maximum difference of the periods of the values of a main page poll */
+    uint32_t page_errors;    /**< The number of the wrong main page answers */
+    float period_jitter;     /**< The maximum delay of the period processing from the end of the period (read by the panel) [s] */
+    uint32_t period_overrun; /**< The number of the period processings ended after the deadline */
+    uint32_t period_missed;  /**< The number of the periods not processed */
+    float protocol_exec;     /**< The maximum execution time of the protocol task [s] */
+    float settings_exec;     /**< The maximum execution time of the settings task [s] */
+    uint32_t settings_saved; /**< The number of the save reported by the event (read by the panel), 0 - no event */
+    float settings_time;     /**< The time of the save reported by the event [s] */
+    uint8_t settings_stored; /**< The settings read back from the EEPROM match the current ones */
+} sim_result_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Fill the configuration with the README scenario: charge for 1 s, then connect the 20 Ohm load for 1 s
+ *
+ * @param[out] config The configuration
+ */
+void sim_default_config(sim_config_t* config);
+
+/**
+ * @brief Get the name of a fault
+ *
+ * @param fault The fault
+ *
+ * @return The name
+ */
+const char* sim_fault_name(sim_fault_t fault);
+
+/**
+ * @brief Run the firmware against the plant: start, charge and load step
+ * @note The firmware uses the global state, so the function can be called once per process
+ *
+ * @param config The configuration
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t sim_run(const sim_config_t* config, sim_result_t* result);
+
+/** @} */
+#endif /* _SIM_H */
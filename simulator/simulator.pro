@@ -0,0 +1,75 @@
+# The PFC closed-loop simulator: the firmware control code against the plant model
+# GCC/MinGW is required (the firmware headers are adapted with a forced include)
+
+CONFIG += console c++1z
+CONFIG -= qt app_bundle
+
+TARGET = pfc_simulator
+TEMPLATE = app
+
+FIRMWARE = $$PWD/../firmware
+
+DEFINES += STM32F723xx
+
+QMAKE_CFLAGS += -std=gnu11 -include $$PWD/port/host_port.h
+
+INCLUDEPATH += \
+    $$PWD \
+    $$PWD/port \
+    $$FIRMWARE/application \
+    $$FIRMWARE/hardware \
+    $$FIRMWARE/middleware/serial_interface \
+    $$FIRMWARE/middleware/eeprom \
+    $$FIRMWARE/Drivers
+
+SOURCES += \
+    main.c \
+    sim.c \
+    plant.c \
+    journal_sim.c \
+    protocol_bench.c \
+    crc_bench.c \
+    eeprom_bench.c \
+    storage_bench.c \
+    oscillog_bench.c \
+    scheduler_sim.c \
+    port/adc_host.c \
+    port/flash_host.c \
+    port/gpio_host.c \
+    port/system_host.c \
+    port/timer_host.c \
+    port/uart_host.c \
+    $$FIRMWARE/application/adc_logic.c \
+    $$FIRMWARE/application/adc_core.c \
+    $$FIRMWARE/application/capture.c \
+    $$FIRMWARE/application/pfc_logic.c \
+    $$FIRMWARE/application/events.c \
+    $$FIRMWARE/application/events_process.c \
+    $$FIRMWARE/application/rate_limiter.c \
+    $$FIRMWARE/application/telemetry.c \
+    $$FIRMWARE/application/oscillog_codec.c \
+    $$FIRMWARE/application/seqlock.c \
+    $$FIRMWARE/application/scheduler.c \
+    $$FIRMWARE/application/tasks.c \
+    $$FIRMWARE/application/settings.c \
+    $$FIRMWARE/application/journal.c \
+    $$FIRMWARE/application/command_processor.c \
+    $$FIRMWARE/middleware/serial_interface/protocol.c \
+    $$FIRMWARE/middleware/serial_interface/crc.c \
+    $$FIRMWARE/middleware/eeprom/eeprom_emulation.c
+
+HEADERS += \
+    sim.h \
+    plant.h \
+    journal_sim.h \
+    protocol_bench.h \
+    crc_bench.h \
+    eeprom_bench.h \
+    storage_bench.h \
+    oscillog_bench.h \
+    scheduler_sim.h \
+    port/host_bsp.h \
+    port/host_port.h \
+    port/stm32f7xx_hal.h
+
+LIBS += -lm
@@ -0,0 +1,279 @@
+/**
+ * @file storage_bench.c
+ * @author Stanislav Karpikov
+ * @brief Settings storage benchmark: the flash memory wear by the saves and the recovery after the power cuts
+ */
+
+/** @addtogroup sim_storage_bench
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "storage_bench.h"
+
+#include "BSP/bsp.h"
+#include "BSP/flash.h"
+#include "eeprom_emulation.h"
+#include "host_bsp.h"
+#include "settings.h"
+#include "string.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define STORAGE_BENCH_FIELDS     (sizeof(settings_t) / sizeof(uint32_t)) /**< The fields of the settings (32 bit each) */
+#define STORAGE_BENCH_RUNS_MAX   (1000U)       /**< The limit of the writer runs of a save */
+#define STORAGE_BENCH_CUT_PERIOD (100U)        /**< The mean number of the flash memory operations before an injection */
+#define STORAGE_BENCH_ERROR_RATE (4U)          /**< Every N-th injection (in average) is an error instead of a power cut */
+#define STORAGE_BENCH_SAVES_MAX  (100000U)     /**< The limit of the saves before an injection happens */
+#define STORAGE_BENCH_SEED       (0x9E3779B9U) /**< The initial value of the data generator */
+#define STORAGE_BENCH_RECEIVE    (0xEEEEU)     /**< The status of an EEPROM page receiving the data (a page transfer) */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Get the next pseudo-random number (xorshift)
+ *
+ * @param[in,out] state The generator state
+ *
+ * @return The number
+ */
+static uint32_t storage_bench_random(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief Get the current settings
+ *
+ * @param[out] settings The settings
+ */
+static void storage_bench_get(settings_t* settings)
+{
+    memset(settings, 0, sizeof(settings_t));
+    settings->calibrations = settings_get_calibrations();
+    settings->filters = settings_get_filters();
+    settings->pwm = settings_get_pwm();
+    settings->protection = settings_get_protection();
+    settings->capacitors = settings_get_capacitors();
+}
+
+/**
+ * @brief Set the current settings (as the panel)
+ *
+ * @param settings The settings
+ */
+static void storage_bench_set(const settings_t* settings)
+{
+    settings_set_calibrations(settings->calibrations);
+    settings_set_filters(settings->filters);
+    settings_set_pwm(settings->pwm);
+    settings_set_protection(settings->protection);
+    settings_set_capacitors(settings->capacitors);
+}
+
+/**
+ * @brief Change a random field of the settings and save them
+ *
+ * @param[in,out] random The generator state
+ * @param[out] previous The settings before the change
+ * @param[out] next The settings saved
+ */
+static void storage_bench_save(uint32_t* random, settings_t* previous, settings_t* next)
+{
+    storage_bench_get(previous);
+    *next = *previous;
+
+    uint32_t field = storage_bench_random(random) % STORAGE_BENCH_FIELDS;
+    uint32_t value = storage_bench_random(random);
+    memcpy((uint8_t*)next + field * sizeof(uint32_t), &value, sizeof(value));
+    storage_bench_set(next);
+    settings_save();
+}
+
+/**
+ * @brief Get the number of the EEPROM page erases
+ *
+ * @param state The state of the flash memory
+ *
+ * @return The number of the erases
+ */
+static uint32_t storage_bench_erases(const host_flash_state_t* state)
+{
+    uint32_t erases = 0;
+    for (uint32_t i = 0; i < HOST_EEPROM_PAGES_NUM; i++) erases += state->eeprom_erases[i];
+    return erases;
+}
+
+/**
+ * @brief Check if an EEPROM page is receiving the data: a page transfer is not complete
+ *
+ * @return 1 if a page is receiving the data
+ */
+static uint8_t storage_bench_in_transfer(void)
+{
+    for (uint32_t i = 0; i < HOST_EEPROM_PAGES_NUM; i++)
+    {
+        uint16_t status = 0;
+        flash_read(EEPROM_START_ADDRESS + i * EEPROM_PAGE_FULL_SIZE, &status, sizeof(status));
+        if (status == STORAGE_BENCH_RECEIVE) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Run the writer of the settings (the erases are allowed: the PWM is off) up to the end of the save
+ *
+ * @param[out] result The results: the longest runs (can be NULL)
+ *
+ * @return 1 if the save has ended (written or failed), 0 if the limit of the runs is reached
+ */
+static uint8_t storage_bench_finish(storage_bench_result_t* result)
+{
+    for (uint32_t run = 0; run < STORAGE_BENCH_RUNS_MAX; run++)
+    {
+        if (!settings_is_saving()) return 1;
+
+        host_flash_state_t before, after;
+        host_flash_get_state(&before);
+        settings_process(1);
+        host_flash_get_state(&after);
+        if (!result) continue;
+
+        double time = after.busy_time - before.busy_time;
+        if (storage_bench_erases(&after) != storage_bench_erases(&before))
+        {
+            if (time > result->transfer_time_max) result->transfer_time_max = time;
+        }
+        else if (time > result->run_time_max)
+        {
+            result->run_time_max = time;
+        }
+    }
+    return !settings_is_saving();
+}
+
+/**
+ * @brief Restart the firmware storage (the power is restored) and compare the settings loaded
+ *
+ * @param previous The settings before the interrupted save
+ * @param next The settings of the interrupted save
+ * @param[out] result The results
+ */
+static void storage_bench_restart(const settings_t* previous, const settings_t* next, storage_bench_result_t* result)
+{
+    host_flash_power_on();
+    eeprom_init();
+    settings_read();
+
+    settings_t loaded;
+    storage_bench_get(&loaded);
+    if (!memcmp(&loaded, next, sizeof(settings_t)))
+        result->loaded_new++;
+    else if (!memcmp(&loaded, previous, sizeof(settings_t)))
+        result->loaded_old++;
+    else
+        result->failures++;
+
+    /* The start saves the sections not stored: the storage is complete after */
+    settings_t stored;
+    if (!storage_bench_finish(NULL) || settings_read_stored(&stored) != PFC_SUCCESS || memcmp(&stored, &loaded, sizeof(settings_t)))
+    {
+        result->failures++;
+    }
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/*
+ * @brief Write the settings saves to the emulated flash memory and count the wear, then interrupt the saves with
+ * the power cuts and the errors at random operations, restart and check the settings loaded
+ *
+ * @param saves The number of the saves to count the wear
+ * @param rounds The number of the interrupted saves
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t storage_bench_run(uint32_t saves, uint32_t rounds, storage_bench_result_t* result)
+{
+    ARGUMENT_ASSERT(result);
+    memset(result, 0, sizeof(storage_bench_result_t));
+
+    /* The first start: the defaults are saved */
+    host_flash_erase_all();
+    if (eeprom_init() != EEPROM_OK) return PFC_ERROR_GENERIC;
+    settings_read();
+    if (!storage_bench_finish(NULL)) return PFC_ERROR_GENERIC;
+
+    /* The wear: a field is changed by every save (as the panel) */
+    uint32_t random = STORAGE_BENCH_SEED;
+    settings_t previous, next, stored;
+    host_flash_state_t start, state;
+    host_flash_get_state(&start);
+    for (uint32_t i = 0; i < saves; i++)
+    {
+        storage_bench_save(&random, &previous, &next);
+        if (!storage_bench_finish(result)) return PFC_ERROR_GENERIC;
+        if (memcmp(&previous, &next, sizeof(settings_t))) result->changed_bytes += sizeof(uint32_t);
+        result->saves++;
+    }
+    host_flash_get_state(&state);
+    result->erases = storage_bench_erases(&state) - storage_bench_erases(&start);
+    for (uint32_t i = 0; i < HOST_EEPROM_PAGES_NUM; i++)
+    {
+        uint32_t erases = state.eeprom_erases[i] - start.eeprom_erases[i];
+        if (erases > result->page_erases) result->page_erases = erases;
+    }
+    result->half_words = state.half_words - start.half_words;
+    result->busy_time = state.busy_time - start.busy_time;
+    if (settings_read_stored(&stored) != PFC_SUCCESS || memcmp(&stored, &next, sizeof(settings_t))) result->failures++;
+
+    /* The recovery: the saves go on up to the injection, the interrupted save is loaded either new or previous */
+    while (result->rounds < rounds)
+    {
+        uint32_t operation = 1 + storage_bench_random(&random) % (2 * STORAGE_BENCH_CUT_PERIOD);
+        uint8_t error = (storage_bench_random(&random) % STORAGE_BENCH_ERROR_RATE) == 0;
+        if (error)
+            host_flash_set_error(operation);
+        else
+            host_flash_set_power_cut(operation);
+
+        host_flash_get_state(&start);
+        uint8_t injected = 0;
+        for (uint32_t i = 0; i < STORAGE_BENCH_SAVES_MAX && !injected; i++)
+        {
+            host_flash_state_t before;
+            host_flash_get_state(&before);
+            storage_bench_save(&random, &previous, &next);
+            if (!storage_bench_finish(NULL)) return PFC_ERROR_GENERIC;
+
+            host_flash_get_state(&state);
+            injected = !state.powered || state.failures != before.failures;
+            if (injected && storage_bench_in_transfer()) result->transfers++;
+        }
+        if (!injected) return PFC_ERROR_GENERIC;
+
+        if (state.powered)
+            result->errors++;
+        else
+            result->cuts++;
+        result->rounds++;
+        storage_bench_restart(&previous, &next, result);
+    }
+    return PFC_SUCCESS;
+}
+/** @} */
@@ -0,0 +1,62 @@
+/**
+ * @file storage_bench.h
+ * @author Stanislav Karpikov
+ * @brief Settings storage benchmark: the flash memory wear by the saves and the recovery after the power cuts (header)
+ */
+
+#ifndef _STORAGE_BENCH_H
+#define _STORAGE_BENCH_H
+
+/** @addtogroup sim_storage_bench
+ * @{
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "BSP/debug.h"
+#include "stdint.h"
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** Settings storage benchmark results */
+typedef struct
+{
+    uint32_t saves;           /**< The number of the saves written (a changed field per save) */
+    uint32_t erases;          /**< The number of the EEPROM page erases by the saves */
+    uint32_t page_erases;     /**< The number of the erases of the most worn page by the saves */
+    uint32_t half_words;      /**< The number of the half words programmed by the saves */
+    uint32_t changed_bytes;   /**< The number of the bytes of the settings changed by the saves */
+    double busy_time;         /**< The time of the flash memory operations of the saves [s] */
+    double run_time_max;      /**< The longest flash memory time of a writer run without a page transfer [s] */
+    double transfer_time_max; /**< The longest flash memory time of a writer run with a page transfer [s] */
+    uint32_t rounds;          /**< The number of the saves interrupted by a power cut or a flash memory error */
+    uint32_t cuts;            /**< The number of the power cuts */
+    uint32_t errors;          /**< The number of the flash memory errors */
+    uint32_t transfers;       /**< The number of the interrupted saves with a page transfer */
+    uint32_t loaded_new;      /**< The restarts with the new settings loaded */
+    uint32_t loaded_old;      /**< The restarts with the previous settings loaded */
+    uint32_t failures;        /**< The restarts with the settings neither new nor previous, the saves not stored after a restart */
+} storage_bench_result_t;
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Write the settings saves to the emulated flash memory and count the wear, then interrupt the saves with
+ * the power cuts and the errors at random operations, restart and check the settings loaded
+ *
+ * @param saves The number of the saves to count the wear
+ * @param rounds The number of the interrupted saves
+ * @param[out] result The results
+ *
+ * @return The status of the operation
+ */
+status_t storage_bench_run(uint32_t saves, uint32_t rounds, storage_bench_result_t* result);
+
+/** @} */
+#endif /* _STORAGE_BENCH_H */
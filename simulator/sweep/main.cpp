@@ -0,0 +1,251 @@
+/**
+ * @file main.cpp
+ * @author Stanislav Karpikov
+ * @brief The controller parameters sweep: runs the control core instances in parallel and prints the table of results
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "sweep_point.h"
+#include "thread_pool.h"
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define DEFAULT_KP             (0.1f)   /**< Default axis: the capacitors charge PID proportional coefficient */
+#define DEFAULT_KI             (5e-5f)  /**< Default axis: the capacitors charge PID integral coefficient */
+#define DEFAULT_PID_LEAKAGE    (1.0f)   /**< Default axis: the leakage coefficient for the PID controller */
+#define DEFAULT_GLOBAL_LEAKAGE (0.995f) /**< Default axis: the leakage coefficient for the current controller */
+
+/*--------------------------------------------------------------
+                       PRIVATE TYPES
+--------------------------------------------------------------*/
+
+/** A sweep axis: the values of a parameter */
+struct Axis
+{
+    const char* name;          /**< The option name */
+    float SweepPoint::*field;  /**< The parameter of the point */
+    std::vector<float> values; /**< The values */
+    const char* comment;       /**< The option description */
+};
+
+/** A scenario option with a float value */
+struct Option
+{
+    const char* name;    /**< The option name */
+    float* value;        /**< The value to fill */
+    const char* comment; /**< The option description */
+};
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Parse the values of an axis: "value", "value,value,..." or "from:to:count"
+ *
+ * @param text The text
+ * @param[out] values The values
+ *
+ * @return true if the values are correct
+ */
+static bool parseAxis(const char* text, std::vector<float>& values)
+{
+    values.clear();
+    float from, to;
+    int count;
+    char tail;
+    if (sscanf(text, "%f:%f:%d%c", &from, &to, &count, &tail) == 3)
+    {
+        if (count < 1) return false;
+        for (int i = 0; i < count; i++)
+        {
+            values.push_back((count == 1) ? from : from + (to - from) * i / (count - 1));
+        }
+        return true;
+    }
+
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        std::string item = list.substr(start, end - start);
+        char* item_end = nullptr;
+        float value = strtof(item.c_str(), &item_end);
+        if (item.empty() || *item_end != '\0') return false;
+        values.push_back(value);
+        start = end + 1;
+    }
+    return !values.empty();
+}
+
+/**
+ * @brief Print the usage information
+ *
+ * @param axes The sweep axes
+ * @param options The scenario options
+ */
+static void printUsage(const std::vector<Axis>& axes, const std::vector<Option>& options)
+{
+    printf("Usage: pfc_sweep [--threads N] [AXIS VALUES]... [OPTION VALUE]...\n");
+    printf("  VALUES: \"value\", \"value,value,...\" or \"from:to:count\"; all the combinations are simulated\n");
+    printf("  --%-24s %s\n", "threads", "The number of the worker threads (default - the number of the host cores)");
+    for (const auto& axis : axes)
+    {
+        printf("  --%-24s %s\n", axis.name, axis.comment);
+    }
+    for (const auto& option : options)
+    {
+        printf("  --%-24s %s\n", option.name, option.comment);
+    }
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief The sweep entry point
+ *
+ * @param argc The number of arguments
+ * @param argv Arguments
+ *
+ * @return The exit code
+ */
+int main(int argc, char* argv[])
+{
+    SweepScenario scenario;
+    sweepDefaultScenario(scenario);
+
+    std::vector<Axis> axes = {
+        {"kp", &SweepPoint::kp, {DEFAULT_KP}, "The capacitors charge PID: proportional coefficient"},
+        {"ki", &SweepPoint::ki, {DEFAULT_KI}, "The capacitors charge PID: integral coefficient"},
+        {"k-i", &SweepPoint::k_i, {0}, "Current filter coefficient (K_I)"},
+        {"k-u", &SweepPoint::k_u, {0}, "Voltage filter coefficient (K_U)"},
+        {"k-ucap", &SweepPoint::k_ucap, {0}, "Capacitor voltage filter coefficient (K_Ucap)"},
+        {"pid-leakage", &SweepPoint::pid_leakage, {DEFAULT_PID_LEAKAGE}, "The leakage coefficient for the PID controller"},
+        {"leakage", &SweepPoint::global_leakage, {DEFAULT_GLOBAL_LEAKAGE}, "The leakage coefficient for the current controller"},
+    };
+
+    float substeps = (float)scenario.plant.substeps;
+    std::vector<Option> options = {
+        {"charge-time", &scenario.charge_time, "The charge time before the load step [s]"},
+        {"load-time", &scenario.load_time, "The time with the load [s]"},
+        {"ucap-nominal", &scenario.ucap_nominal, "The capacitors nominal voltage [V]"},
+        {"i-max-rms", &scenario.i_max_rms, "The protection level: maximum current (RMS) [A]"},
+        {"grid-voltage", &scenario.plant.grid_voltage, "Grid phase voltage (RMS) [V]"},
+        {"grid-frequency", &scenario.plant.grid_frequency, "Grid frequency [Hz]"},
+        {"harmonic-5", &scenario.plant.harmonic_5, "The 5th harmonic (relative)"},
+        {"harmonic-7", &scenario.plant.harmonic_7, "The 7th harmonic (relative)"},
+        {"inductance", &scenario.plant.inductance, "Boost inductance [H]"},
+        {"capacitance", &scenario.plant.capacitance, "DC-link capacitance [F]"},
+        {"load", &scenario.plant.load_resistance, "Switched load [Ohm]"},
+        {"noise", &scenario.plant.noise, "Measurement noise [ADC codes]"},
+        {"substeps", &substeps, "Integration steps per ADC sample"},
+    };
+    unsigned threads = 0;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        bool found = false;
+        if (!strncmp(argv[arg], "--", 2) && arg + 1 < argc)
+        {
+            const char* name = argv[arg] + 2;
+            const char* value = argv[arg + 1];
+            if (!strcmp(name, "threads"))
+            {
+                threads = (unsigned)atoi(value);
+                found = true;
+            }
+            for (auto& axis : axes)
+            {
+                if (strcmp(name, axis.name)) continue;
+                found = parseAxis(value, axis.values);
+            }
+            for (auto& option : options)
+            {
+                if (strcmp(name, option.name)) continue;
+                *option.value = (float)atof(value);
+                found = true;
+            }
+            arg++;
+        }
+        if (!found)
+        {
+            printUsage(axes, options);
+            return 2;
+        }
+    }
+    scenario.plant.substeps = (uint32_t)substeps;
+
+    /* All the combinations, the first axis changes the slowest */
+    std::vector<SweepPoint> points(1, SweepPoint());
+    for (const auto& axis : axes)
+    {
+        std::vector<SweepPoint> expanded;
+        for (const auto& point : points)
+        {
+            for (float value : axis.values)
+            {
+                SweepPoint next = point;
+                next.*axis.field = value;
+                expanded.push_back(next);
+            }
+        }
+        points.swap(expanded);
+    }
+
+    std::vector<SweepResult> results(points.size());
+    auto start = std::chrono::steady_clock::now();
+    unsigned workers;
+    {
+        ThreadPool pool(threads);
+        workers = pool.size();
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            pool.submit([&scenario, &points, &results, i] { results[i] = sweepRunPoint(scenario, points[i]); });
+        }
+        pool.wait();
+    }
+    double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%5s %10s %10s %6s %6s %6s %8s %8s %9s %9s %7s %8s %8s %10s %7s\n",
+           "point", "kp", "ki", "k_i", "k_u", "k_ucap", "pid_leak", "leakage",
+           "settle_s", "overshoot", "thd_%", "ucap_min", "ucap_end", "trip", "trip_s");
+    double model_time = 0;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        const SweepPoint& p = points[i];
+        const SweepResult& r = results[i];
+        model_time += r.model_time;
+        printf("%5u %10.4g %10.4g %6.3f %6.3f %6.3f %8.5f %8.5f ",
+               (unsigned)i, p.kp, p.ki, p.k_i, p.k_u, p.k_ucap, p.pid_leakage, p.global_leakage);
+        if (r.trip != SWEEP_TRIP_NONE)
+        {
+            printf("%9s %9s %7s %8s %8s %10s %7.3f\n", "-", "-", "-", "-", "-", sweepTripName(r.trip), r.trip_time);
+            continue;
+        }
+        if (r.settling_time >= 0)
+            printf("%9.3f ", r.settling_time);
+        else
+            printf("%9s ", "-");
+        printf("%9.2f %7.2f %8.1f %8.1f %10s %7s\n", r.overshoot, r.thd, r.ucap_min_load, r.ucap_final, "-", "-");
+    }
+
+    fprintf(stderr, "Points: %u, threads: %u, host time: %.3f s, model time: %.1f s, real-time factor: %.1f\n",
+            (unsigned)points.size(), workers, wall_time, model_time, (wall_time > 0) ? model_time / wall_time : 0);
+    return 0;
+}
@@ -0,0 +1,39 @@
+# The controller parameters sweep: control core instances against the plant model on a work-stealing thread pool
+# GCC/MinGW is required (the firmware headers are adapted with a forced include)
+
+CONFIG += console c++1z thread
+CONFIG -= qt app_bundle
+
+TARGET = pfc_sweep
+TEMPLATE = app
+
+SIMULATOR = $$PWD/..
+FIRMWARE = $$PWD/../../firmware
+
+DEFINES += STM32F723xx
+
+QMAKE_CFLAGS += -std=gnu11 -include $$SIMULATOR/port/host_port.h
+QMAKE_CXXFLAGS += -include $$SIMULATOR/port/host_port.h
+
+INCLUDEPATH += \
+    $$PWD \
+    $$SIMULATOR \
+    $$SIMULATOR/port \
+    $$FIRMWARE/application \
+    $$FIRMWARE/hardware \
+    $$FIRMWARE/Drivers
+
+SOURCES += \
+    main.cpp \
+    sweep_point.cpp \
+    thread_pool.cpp \
+    $$SIMULATOR/plant.c \
+    $$FIRMWARE/application/adc_core.c
+
+HEADERS += \
+    sweep_point.h \
+    thread_pool.h \
+    $$SIMULATOR/plant.h \
+    $$FIRMWARE/application/adc_core.h
+
+LIBS += -lm
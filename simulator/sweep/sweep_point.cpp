@@ -0,0 +1,237 @@
+/**
+ * @file sweep_point.cpp
+ * @author Stanislav Karpikov
+ * @brief One point of the controller parameters sweep: an instance of the control core against the plant
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "sweep_point.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+extern "C" {
+#include "adc_core.h"
+}
+
+/*--------------------------------------------------------------
+                       DEFINES
+--------------------------------------------------------------*/
+
+#define SAMPLING_TIMER_CLOCK   (100000000.0) /**< The clock of the sampling timer (the same as the host timer) [Hz] */
+#define SAMPLING_TIMER_INITIAL (15625U)      /**< The initial period of the sampling timer (50 Hz) */
+#define UCAP_MAX_TICKS         (3U)          /**< The samples above the maximum before the trip (as in the firmware) */
+#define THD_HARMONICS          (40U)         /**< The harmonics to calculate the THD */
+
+#define DEFAULT_UCAP_NOMINAL (750.0f) /**< Default scenario: nominal capacitor voltage [V] */
+#define DEFAULT_UCAP_MAX     (800.0f) /**< Default scenario: maximum capacitor voltage [V] */
+#define DEFAULT_UCAP_MIN     (200.0f) /**< Default scenario: minimum capacitor voltage [V] */
+#define DEFAULT_I_MAX_RMS    (60.0f)  /**< Default scenario: maximum current (RMS) [A] */
+#define DEFAULT_SETTLE_BAND  (0.02f)  /**< Default scenario: the settling band (relative) */
+#define DEFAULT_SYNC_TIME    (0.5f)   /**< Default scenario: the grid synchronisation time [s] */
+#define DEFAULT_CHARGE_TIME  (1.0f)   /**< Default scenario: the charge time [s] */
+#define DEFAULT_LOAD_TIME    (1.0f)   /**< Default scenario: the time with the load [s] */
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Calculate the total harmonic distortion of a period
+ *
+ * @param period The signal (one period)
+ *
+ * @return THD [%]
+ */
+static float sweepThd(const float* period)
+{
+    double fundamental = 0;
+    double harmonics = 0;
+    for (unsigned h = 1; h <= THD_HARMONICS; h++)
+    {
+        double re = 0, im = 0;
+        for (unsigned k = 0; k < ADC_VAL_NUM; k++)
+        {
+            double angle = 2.0 * M_PI * h * k / ADC_VAL_NUM;
+            re += period[k] * cos(angle);
+            im += period[k] * sin(angle);
+        }
+        double amplitude2 = re * re + im * im;
+        if (h == 1)
+            fundamental = amplitude2;
+        else
+            harmonics += amplitude2;
+    }
+    if (fundamental <= 0) return 0;
+    return (float)(100.0 * sqrt(harmonics / fundamental));
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Fill the scenario with the default values: the README charge and the load step
+ *
+ * @param[out] scenario The scenario
+ */
+void sweepDefaultScenario(SweepScenario& scenario)
+{
+    plant_default_params(&scenario.plant);
+    scenario.ucap_nominal = DEFAULT_UCAP_NOMINAL;
+    scenario.ucap_max = DEFAULT_UCAP_MAX;
+    scenario.ucap_min = DEFAULT_UCAP_MIN;
+    scenario.i_max_rms = DEFAULT_I_MAX_RMS;
+    scenario.settle_band = DEFAULT_SETTLE_BAND;
+    scenario.sync_time = DEFAULT_SYNC_TIME;
+    scenario.charge_time = DEFAULT_CHARGE_TIME;
+    scenario.load_time = DEFAULT_LOAD_TIME;
+}
+
+/**
+ * @brief Run the scenario for a point
+ *
+ * @note The capacitors are precharged to the rectified voltage, the main relay is on.
+ * The PWM is started after the synchronisation time, the load is connected after the charge time.
+ * The run is stopped at the first protection trip (as the firmware goes to the fault state).
+ *
+ * @param scenario The scenario
+ * @param point The controller parameters
+ *
+ * @return The results
+ */
+SweepResult sweepRunPoint(const SweepScenario& scenario, const SweepPoint& point)
+{
+    SweepResult result = {-1.0f, 0, 0, 0, 0, SWEEP_TRIP_NONE, 0, 0};
+
+    plant_t plant;
+    if (plant_init(&plant, &scenario.plant) != PFC_SUCCESS) return result;
+    plant.ucap = scenario.plant.grid_voltage * sqrtf(6.0f);
+
+    adc_core_params_t params;
+    adc_core_default_params(&params);
+    plant_get_calibrations(&params.calibrations);
+    params.filters.K_I = point.k_i;
+    params.filters.K_U = point.k_u;
+    params.filters.K_Ucap = point.k_ucap;
+    params.capacitors.Ucap_nominal = scenario.ucap_nominal;
+    params.capacitors.ctrl_Ucap_Kp = point.kp;
+    params.capacitors.ctrl_Ucap_Ki = point.ki;
+    params.pid_leakage = point.pid_leakage;
+    params.global_leakage = point.global_leakage;
+
+    /* The instance is too large for the worker stack */
+    std::unique_ptr<adc_core_t> core(new adc_core_t);
+    adc_core_init(core.get(), &params);
+
+    plant_inputs_t inputs = {1, 0, 0, {0.5f, 0.5f, 0.5f}, 0};
+    double pwm_start = scenario.sync_time;
+    double load_start = pwm_start + scenario.charge_time;
+    double end = load_start + scenario.load_time;
+    double dt = (SAMPLING_TIMER_INITIAL + 1) / SAMPLING_TIMER_CLOCK;
+    float band = scenario.ucap_nominal * scenario.settle_band;
+    float ucap_max_charge = 0;
+    double last_outside = 0;
+    unsigned ucap_max_ticks = 0;
+    float current[ADC_VAL_NUM] = {0};
+    float current_period[ADC_VAL_NUM] = {0};
+
+    result.ucap_min_load = plant.ucap;
+
+    while (plant.time < end)
+    {
+        uint16_t codes[ADC_CHANNEL_NUMBER];
+        plant_sample(&plant, codes);
+        adc_core_convert(core.get(), codes);
+
+        double t = plant.time - pwm_start;
+        if (!inputs.pwm_on && t >= 0)
+        {
+            adc_core_clear_accumulators(core.get());
+            inputs.pwm_on = 1;
+        }
+        inputs.load_on = plant.time >= load_start;
+
+        /* The same checks as in the firmware (events_check_ud) */
+        if (inputs.pwm_on)
+        {
+            float ucap = core->values[ADC_UCAP];
+            ucap_max_ticks = (ucap > scenario.ucap_max) ? ucap_max_ticks + 1 : 0;
+            if (ucap_max_ticks > UCAP_MAX_TICKS) result.trip = SWEEP_TRIP_UCAP_MAX;
+            if (ucap < scenario.ucap_min) result.trip = SWEEP_TRIP_UCAP_MIN;
+        }
+
+        current[core->symbol] = plant.i[PFC_ACHAN];
+        if (adc_core_control(core.get(), inputs.pwm_on))
+        {
+            for (unsigned k = 0; k < PFC_NCHAN; k++)
+            {
+                float duty = (float)core->ccr[k] / (float)PWM_PERIOD;
+                inputs.duty[k] = (duty > 1.0f) ? 1.0f : duty;
+            }
+        }
+
+        if (core->new_period)
+        {
+            adc_core_process_measurements(core.get());
+            dt = (adc_core_process_period(core.get()) + 1) / SAMPLING_TIMER_CLOCK;
+            if (inputs.load_on) std::copy(current, current + ADC_VAL_NUM, current_period);
+
+            /* The same checks as in the firmware (events_check_rms_overcurrent) */
+            for (unsigned k = 0; k < PFC_NCHAN && inputs.pwm_on; k++)
+            {
+                if (core->adc.active[ADC_I_A + k] > scenario.i_max_rms) result.trip = SWEEP_TRIP_I_MAX_RMS;
+            }
+        }
+
+        if (result.trip != SWEEP_TRIP_NONE)
+        {
+            result.trip_time = (float)t;
+            break;
+        }
+
+        if (inputs.pwm_on && !inputs.load_on)
+        {
+            if (plant.ucap > ucap_max_charge) ucap_max_charge = plant.ucap;
+            if (fabsf(plant.ucap - scenario.ucap_nominal) > band) last_outside = t;
+        }
+        if (inputs.load_on && plant.ucap < result.ucap_min_load) result.ucap_min_load = plant.ucap;
+
+        plant_step(&plant, &inputs, dt);
+    }
+
+    result.model_time = plant.time;
+    result.ucap_final = plant.ucap;
+    if (result.trip != SWEEP_TRIP_NONE) return result;
+
+    if (last_outside < scenario.charge_time - dt) result.settling_time = (float)last_outside;
+    result.overshoot = std::fmax(0.0f, (ucap_max_charge - scenario.ucap_nominal) / scenario.ucap_nominal * 100.0f);
+    result.thd = sweepThd(current_period);
+    return result;
+}
+
+/**
+ * @brief Get the name of a trip
+ *
+ * @param trip The trip
+ *
+ * @return The name
+ */
+const char* sweepTripName(SweepTrip trip)
+{
+    switch (trip)
+    {
+        case SWEEP_TRIP_UCAP_MAX:
+            return "UCAP_MAX";
+        case SWEEP_TRIP_UCAP_MIN:
+            return "UCAP_MIN";
+        case SWEEP_TRIP_I_MAX_RMS:
+            return "I_MAX_RMS";
+        default:
+            return "-";
+    }
+}
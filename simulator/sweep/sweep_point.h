@@ -0,0 +1,80 @@
+/**
+ * @file sweep_point.h
+ * @author Stanislav Karpikov
+ * @brief One point of the controller parameters sweep: an instance of the control core against the plant (header)
+ */
+
+#ifndef __SWEEP_POINT_H
+#define __SWEEP_POINT_H
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include <cstdint>
+
+extern "C" {
+#include "plant.h"
+}
+
+/*--------------------------------------------------------------
+                       PUBLIC TYPES
+--------------------------------------------------------------*/
+
+/** Controller parameters of a sweep point */
+struct SweepPoint
+{
+    float kp;             /**< The capacitors charge PID: proportional coefficient */
+    float ki;             /**< The capacitors charge PID: integral coefficient */
+    float k_i;            /**< Current filter coefficient */
+    float k_u;            /**< Voltage filter coefficient */
+    float k_ucap;         /**< Capacitor voltage filter coefficient */
+    float pid_leakage;    /**< The leakage coefficient for the PID controller */
+    float global_leakage; /**< The leakage coefficient for the current controller accumulators */
+};
+
+/** Scenario of a sweep point: the same for all the points */
+struct SweepScenario
+{
+    plant_params_t plant; /**< The parameters of the plant */
+    float ucap_nominal;   /**< The capacitors nominal voltage [V] */
+    float ucap_max;       /**< Protection: maximum capacitor voltage [V] */
+    float ucap_min;       /**< Protection: minimum capacitor voltage [V] */
+    float i_max_rms;      /**< Protection: maximum current (RMS) [A] */
+    float settle_band;    /**< The band around the nominal voltage for the settling time (relative) */
+    float sync_time;      /**< The time with the PWM off (the grid synchronisation) [s] */
+    float charge_time;    /**< The charge time before the load is connected [s] */
+    float load_time;      /**< The time with the load [s] */
+};
+
+/** Protection trips */
+enum SweepTrip
+{
+    SWEEP_TRIP_NONE,      /**< No trips */
+    SWEEP_TRIP_UCAP_MAX,  /**< The capacitor voltage is above the maximum */
+    SWEEP_TRIP_UCAP_MIN,  /**< The capacitor voltage is below the minimum */
+    SWEEP_TRIP_I_MAX_RMS, /**< The current is above the maximum (RMS) */
+};
+
+/** Results of a sweep point */
+struct SweepResult
+{
+    float settling_time; /**< The time to enter the band around the nominal voltage (and stay there), negative if not settled [s] */
+    float overshoot;     /**< The capacitor voltage overshoot during the charge [%] */
+    float thd;           /**< The total harmonic distortion of the phase A current with the load [%] */
+    float ucap_min_load; /**< The minimum capacitor voltage after the load step [V] */
+    float ucap_final;    /**< The capacitor voltage at the end [V] */
+    SweepTrip trip;      /**< The first protection trip */
+    float trip_time;     /**< The time of the trip (from the PWM start) [s] */
+    double model_time;   /**< The model time [s] */
+};
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+void sweepDefaultScenario(SweepScenario& scenario);
+SweepResult sweepRunPoint(const SweepScenario& scenario, const SweepPoint& point);
+const char* sweepTripName(SweepTrip trip);
+
+#endif /* __SWEEP_POINT_H */
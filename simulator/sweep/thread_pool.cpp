@@ -0,0 +1,174 @@
+/**
+ * @file thread_pool.cpp
+ * @author Stanislav Karpikov
+ * @brief Work-stealing thread pool
+ */
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include "thread_pool.h"
+
+/*--------------------------------------------------------------
+                       PRIVATE DATA
+--------------------------------------------------------------*/
+
+static thread_local ThreadPool* current_pool = nullptr; /**< The pool of the current worker thread */
+static thread_local unsigned current_index = 0;         /**< The index of the current worker thread */
+
+/*--------------------------------------------------------------
+                       PUBLIC FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief Start the workers
+ *
+ * @param threads The number of the workers, 0 - the number of the host cores
+ */
+ThreadPool::ThreadPool(unsigned threads) : _next(0), _queued(0), _pending(0), _stop(false)
+{
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    for (unsigned i = 0; i < threads; i++)
+    {
+        _queues.emplace_back(new Queue);
+    }
+    for (unsigned i = 0; i < threads; i++)
+    {
+        _workers.emplace_back(&ThreadPool::worker, this, i);
+    }
+}
+
+/**
+ * @brief Finish the submitted tasks and stop the workers
+ */
+ThreadPool::~ThreadPool(void)
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Add a task
+ *
+ * @param task The task
+ */
+void ThreadPool::submit(task_t task)
+{
+    unsigned index = (current_pool == this) ? current_index : (_next++ % _queues.size());
+
+    _pending++;
+    {
+        std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+        _queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queued++;
+    }
+    _wake.notify_one();
+}
+
+/**
+ * @brief Wait for all the submitted tasks to finish
+ */
+void ThreadPool::wait(void)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _pending == 0; });
+}
+
+/**
+ * @brief Get the number of the workers
+ *
+ * @return The number of the workers
+ */
+unsigned ThreadPool::size(void) const
+{
+    return (unsigned)_workers.size();
+}
+
+/*--------------------------------------------------------------
+                       PRIVATE FUNCTIONS
+--------------------------------------------------------------*/
+
+/**
+ * @brief The worker thread
+ *
+ * @param index The index of the worker
+ */
+void ThreadPool::worker(unsigned index)
+{
+    current_pool = this;
+    current_index = index;
+
+    while (true)
+    {
+        task_t task;
+        if (pop(index, task) || steal(index, task))
+        {
+            _queued--;
+            task();
+            if (--_pending == 0)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _done.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_stop) return;
+        _wake.wait(lock, [this] { return _stop || _queued > 0; });
+    }
+}
+
+/**
+ * @brief Take a task from the own queue (LIFO, the data is still in the cache)
+ *
+ * @param index The index of the worker
+ * @param[out] task The task
+ *
+ * @return true if a task has been taken
+ */
+bool ThreadPool::pop(unsigned index, task_t& task)
+{
+    Queue& queue = *_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+/**
+ * @brief Steal a task from the other workers (FIFO, the oldest task)
+ *
+ * @param index The index of the worker
+ * @param[out] task The task
+ *
+ * @return true if a task has been stolen
+ */
+bool ThreadPool::steal(unsigned index, task_t& task)
+{
+    for (unsigned i = 1; i < _queues.size(); i++)
+    {
+        Queue& queue = *_queues[(index + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
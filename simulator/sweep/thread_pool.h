@@ -0,0 +1,82 @@
+/**
+ * @file thread_pool.h
+ * @author Stanislav Karpikov
+ * @brief Work-stealing thread pool (header)
+ */
+
+#ifndef __THREAD_POOL_H
+#define __THREAD_POOL_H
+
+/*--------------------------------------------------------------
+                       INCLUDES
+--------------------------------------------------------------*/
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*--------------------------------------------------------------
+                       CLASSES
+--------------------------------------------------------------*/
+
+/**
+ * @brief The pool of worker threads with a task queue per worker
+ *
+ * @note A worker takes the tasks from the back of its own queue, an idle worker steals from the front of the others.
+ * The tasks submitted from a worker go to the queue of this worker.
+ */
+class ThreadPool
+{
+    /*--------------------------------------------------------------
+                           PRIVATE DATA
+    --------------------------------------------------------------*/
+public:
+    typedef std::function<void(void)> task_t;
+
+private:
+    /** Task queue of a worker */
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<task_t> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<unsigned> _next;    /**< The queue for the next external task (round-robin) */
+    std::atomic<unsigned> _queued;  /**< The tasks in the queues */
+    std::atomic<unsigned> _pending; /**< The tasks not finished yet */
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    bool _stop;
+
+    /*--------------------------------------------------------------
+                           PUBLIC FUNCTIONS
+    --------------------------------------------------------------*/
+public:
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool(void);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(task_t task);
+    void wait(void);
+    unsigned size(void) const;
+
+    /*--------------------------------------------------------------
+                           PRIVATE FUNCTIONS
+    --------------------------------------------------------------*/
+private:
+    void worker(unsigned index);
+    bool pop(unsigned index, task_t& task);
+    bool steal(unsigned index, task_t& task);
+};
+
+#endif /* __THREAD_POOL_H */
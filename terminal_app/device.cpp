@@ -10,6 +10,8 @@
 
 #include "device.h"
 #include <QDebug>
+#include <algorithm>
+#include <cstring>
 #include "interface_messaging.h"
 
 /*--------------------------------------------------------------
@@ -29,7 +31,12 @@ using namespace InterfaceMessaging;
 PFC::PFC(void)
     : _interface(new PFCSerialInterface(Q_NULLPTR)),
       _handlers(enum_int(InterfaceCommands::PFC_COMMAND_COUNT)),
-      _thread(new QThread())
+      _thread(new QThread()),
+      _telemetry_sequence(0),
+      _oscillog_pending(false),
+      _oscillog_snapshot(0),
+      _oscillog_channels(0),
+      _oscillog_samples(0)
 {
     /* Translate interface link signals to the upper level */
     connect(_interface, &PFCSerialInterface::connected, this, &PFC::interfaceConnected);
@@ -40,6 +47,8 @@ PFC::PFC(void)
     connect(_thread, &QThread::finished, _thread, &QThread::deleteLater);
     connect(_thread, &QThread::started, _interface, &PFCSerialInterface::run);
     connect(_interface, &PFCSerialInterface::informConnectionChanged, this, &PFC::connectionChanged);
+    _interface->setPushCommand(static_cast<uint8_t>(enum_int(InterfaceCommands::PFC_COMMAND_TELEMETRY)));
+    connect(_interface, &PFCSerialInterface::pushReceived, this, &PFC::protocolTelemetry);
     _thread->start();
 
     /* Initialize protocol handlers */
@@ -54,14 +63,20 @@ PFC::PFC(void)
         std::bind(&PFC::protocolGetADCActiveRAW, this, std::placeholders::_1);
     _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_OSCILLOG)] =
         std::bind(&PFC::protocolGetOscillog, this, std::placeholders::_1);
+    _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_OSCILLOG_BULK)] =
+        std::bind(&PFC::protocolGetOscillogBulk, this, std::placeholders::_1);
     _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_NET_PARAMS)] =
         std::bind(&PFC::protocolGetNetParams, this, std::placeholders::_1);
     _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_WORK_STATE)] =
         std::bind(&PFC::protocolGetWorkState, this, std::placeholders::_1);
+    _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_BUNDLE)] =
+        std::bind(&PFC::protocolGetBundle, this, std::placeholders::_1);
     _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_VERSION_INFO)] =
         std::bind(&PFC::protocolGetVersionInfo, this, std::placeholders::_1);
     _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_EVENTS)] =
         std::bind(&PFC::protocolGetEvents, this, std::placeholders::_1);
+    _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_STATE_TRACE)] =
+        std::bind(&PFC::protocolGetStateTrace, this, std::placeholders::_1);
 
     _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_SETTINGS_CALIBRATIONS)] =
         std::bind(&PFC::protocolGetSettingsCalibrations, this, std::placeholders::_1);
@@ -81,6 +96,9 @@ PFC::PFC(void)
     _handlers[enum_int(InterfaceCommands::PFC_COMMAND_SET_SETTINGS_FILTERS)] =
         std::bind(&PFC::protocolSetSettingsFilters, this, std::placeholders::_1);
 
+    _handlers[enum_int(InterfaceCommands::PFC_COMMAND_SUBSCRIBE)] =
+        std::bind(&PFC::protocolSubscribe, this, std::placeholders::_1);
+
     connect(_interface, &PFCSerialInterface::message, this, &PFC::message);
 
     message(MESSAGE_TYPE_GENERAL, MESSAGE_NORMAL, MESSAGE_TARGET_DEBUG, "Поток АДФ запущен");
@@ -131,12 +149,18 @@ void PFC::updateWorkState(uint64_t currentTime)
     req.currentTime = currentTime;
     endRequest(req, InterfaceCommands::PFC_COMMAND_GET_WORK_STATE, sizeof(req));
 }
-void PFC::updateEvents(uint64_t afterIndex)
+void PFC::updateEvents(uint32_t sequence)
 {
     command_get_events req;
-    req.after_index = afterIndex;
+    req.sequence = sequence;
     endRequest(req, InterfaceCommands::PFC_COMMAND_GET_EVENTS, sizeof(req));
 }
+void PFC::updateStateTrace(uint32_t afterIndex)
+{
+    command_get_state_trace req;
+    req.after_index = afterIndex;
+    endRequest(req, InterfaceCommands::PFC_COMMAND_GET_STATE_TRACE, sizeof(req));
+}
 void PFC::updateVersionInfo(void)
 {
     command_get_version_info req;
@@ -153,11 +177,55 @@ void PFC::updateOscillog(OscillogCnannel channel)
     req.num = static_cast<decltype(req.num)>(enum_int(channel));
     endRequest(req, InterfaceCommands::PFC_COMMAND_GET_OSCILLOG, sizeof(req));
 }
+void PFC::updateOscillogs(uint16_t channels)
+{
+    if (!channels) return;
+
+    /* The chunks of a snapshot are batched in the frames, the 8-bit oscillograms are polled without them */
+    if (_interface->protocolVersion() < 2)
+    {
+        for (int channel = 0; channel < OSC_CHANNEL_NUMBER; channel++)
+        {
+            if (channels & (1U << channel)) updateOscillog(static_cast<OscillogCnannel>(channel));
+        }
+        return;
+    }
+
+    /* A new snapshot is taken after the last one has been received (or its answers have been lost) */
+    if (_oscillog_pending && !_oscillog_timer.hasExpired(OSCILLOG_BULK_TIMEOUT_MS)) return;
+    _oscillog_pending = true;
+    _oscillog_snapshot = 0;
+    _oscillog_timer.start();
+
+    command_get_oscillog_bulk req;
+    req.channels = channels;
+    req.snapshot = 0;
+    req.offset = 0;
+    endRequest(req, InterfaceCommands::PFC_COMMAND_GET_OSCILLOG_BULK, sizeof(req));
+}
 void PFC::updateNetParams(void)
 {
     command_get_net_params req;
     endRequest(req, InterfaceCommands::PFC_COMMAND_GET_NET_PARAMS, sizeof(req));
 }
+void PFC::updateValues(uint8_t sections, uint64_t currentTime)
+{
+    if (!sections) return;
+
+    /* The values of a period are taken at once, the firmware without the frames is polled by the separate requests */
+    if (_interface->protocolVersion() >= 2)
+    {
+        command_get_bundle req;
+        req.sections = sections;
+        req.currentTime = currentTime;
+        endRequest(req, InterfaceCommands::PFC_COMMAND_GET_BUNDLE, sizeof(req));
+        return;
+    }
+    if (sections & BUNDLE_SECTION_ADC_ACTIVE) updateNetVoltage();
+    if (sections & BUNDLE_SECTION_ADC_ACTIVE_RAW) updateNetVoltageRAW();
+    if (sections & BUNDLE_SECTION_NET_PARAMS) updateNetParams();
+    if (sections & BUNDLE_SECTION_WORK_STATE) updateWorkState(currentTime);
+}
 void PFC::updateSettingsCalibrations(void)
 {
     command_get_settings_calibrations req;
@@ -178,6 +246,15 @@ void PFC::updateSettingsFilters(void)
     command_get_settings_filters req;
     endRequest(req, InterfaceCommands::PFC_COMMAND_GET_SETTINGS_FILTERS, sizeof(req));
 }
+void PFC::subscribeTelemetry(uint8_t groups, uint16_t oscillogs, uint8_t decimation)
+{
+    command_subscribe req;
+    req.groups = groups;
+    req.oscillogs = oscillogs;
+    req.decimation = decimation;
+    req.timeout = TELEMETRY_TIMEOUT_MS;
+    endRequest(req, InterfaceCommands::PFC_COMMAND_SUBSCRIBE, sizeof(req));
+}
 
 /*--------------------------------------------------------------
          PUBLIC CLASS FUNCTIONS::PARAMETERS WRITE
@@ -361,6 +438,22 @@ void PFC::protocolGetEvents(package_general* package)
     emit setEvents(ev);
 }
 
+void PFC::protocolGetStateTrace(package_general* package)
+{
+    auto answer = static_cast<answer_get_state_trace*>(package);
+    if (answer->num == 0) return;
+    if (answer->num > MAX_NUM_TRANSFERED_TRANSITIONS)
+    {
+        return;
+    }
+    std::list<Trace::TransitionRecord> transitions;
+    for (int i = 0; i < answer->num; i++)
+    {
+        transitions.push_back(answer->transitions[i]);
+    }
+    emit setStateTrace(answer->first_index, transitions);
+}
+
 void PFC::protocolGetVersionInfo(package_general* package)
 {
     auto answer = static_cast<answer_get_version_info*>(package);
@@ -434,6 +527,100 @@ void PFC::protocolGetOscillog(package_general* package)
     setOscillog(static_cast<OscillogCnannel>(answer->ch), yval);
 }
 
+void PFC::protocolGetOscillogBulk(package_general* package)
+{
+    auto answer = static_cast<answer_get_oscillog_bulk*>(package);
+    if (!_oscillog_pending) return;
+    if (!answer->len || answer->len > OSCILLOG_CHUNK_SIZE)
+    {
+        /* The snapshot has been replaced: the next update takes a new one */
+        _oscillog_pending = false;
+        return;
+    }
+
+    if (!_oscillog_snapshot)
+    {
+        if (answer->offset != 0) return;
+        _oscillog_snapshot = answer->snapshot;
+        _oscillog_channels = answer->channels;
+        _oscillog_samples = answer->samples;
+        _oscillog_bulk.assign(answer->size, 0);
+        _oscillog_chunks.assign((answer->size + OSCILLOG_CHUNK_SIZE - 1) / OSCILLOG_CHUNK_SIZE, false);
+
+        /* The rest of the snapshot is requested at once: the requests are batched in the frames */
+        for (uint32_t offset = OSCILLOG_CHUNK_SIZE; offset < answer->size; offset += OSCILLOG_CHUNK_SIZE)
+        {
+            command_get_oscillog_bulk req;
+            req.channels = answer->channels;
+            req.snapshot = answer->snapshot;
+            req.offset = static_cast<uint16_t>(offset);
+            endRequest(req, InterfaceCommands::PFC_COMMAND_GET_OSCILLOG_BULK, sizeof(req));
+        }
+    }
+    if (answer->snapshot != _oscillog_snapshot || answer->offset % OSCILLOG_CHUNK_SIZE ||
+        answer->offset + answer->len > _oscillog_bulk.size())
+    {
+        return;
+    }
+
+    std::copy(answer->data, answer->data + answer->len, _oscillog_bulk.begin() + answer->offset);
+    _oscillog_chunks[answer->offset / OSCILLOG_CHUNK_SIZE] = true;
+    if (std::all_of(_oscillog_chunks.begin(), _oscillog_chunks.end(), [](bool received) { return received; }))
+    {
+        _oscillog_pending = false;
+        decodeOscillogBulk();
+    }
+}
+
+void PFC::decodeOscillogBulk(void)
+{
+    size_t offset = 0;
+    for (int channel = 0; channel < OSC_CHANNEL_NUMBER; channel++)
+    {
+        if (!(_oscillog_channels & (1U << channel))) continue;
+
+        std::vector<double> values(_oscillog_samples);
+        size_t size = decodeOscillogChannel(&_oscillog_bulk[offset], _oscillog_bulk.size() - offset, values);
+        if (!size)
+        {
+            message(MESSAGE_TYPE_CONNECTION, MESSAGE_NORMAL, MESSAGE_TARGET_DEBUG, "Неверные данные осциллограммы");
+            return;
+        }
+        offset += size;
+        setOscillog(static_cast<OscillogCnannel>(channel), values);
+    }
+}
+
+size_t PFC::decodeOscillogChannel(const uint8_t* data, size_t size, std::vector<double> &values)
+{
+    /* The scale, then the residuals of the second order prediction as the zig-zag varints (see oscillog_codec.h) */
+    float scale;
+    if (size < sizeof(scale)) return 0;
+    memcpy(&scale, data, sizeof(scale));
+
+    size_t length = sizeof(scale);
+    std::vector<int32_t> samples(values.size());
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        uint32_t value = 0;
+        uint8_t byte;
+        int count = 0;
+        do
+        {
+            if (length >= size || count >= OSCILLOG_RESIDUAL_MAX) return 0;
+            byte = data[length++];
+            value |= static_cast<uint32_t>(byte & 0x7F) << (7 * count++);
+        } while (byte & 0x80);
+
+        int32_t residual = static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+        int32_t predicted = (i == 0) ? 0 : (i == 1) ? samples[0] : 2 * samples[i - 1] - samples[i - 2];
+        samples[i] = predicted + residual;
+        if (samples[i] > INT16_MAX || samples[i] < INT16_MIN) return 0;
+        values[i] = samples[i] * static_cast<double>(scale);
+    }
+    return length;
+}
+
 void PFC::protocolGetNetParams(package_general* package)
 {
     auto answer = static_cast<answer_get_net_params*>(package);
@@ -452,6 +639,42 @@ void PFC::protocolGetNetParams(package_general* package)
                       answer->U_phase_C);
 }
 
+void PFC::protocolGetBundle(package_general* package)
+{
+    auto answer = static_cast<answer_get_bundle*>(package);
+
+    /* The sections are the answers of the separate requests, in the order of the bits */
+    uint8_t* data = reinterpret_cast<uint8_t*>(answer) + sizeof(answer_get_bundle);
+    for (uint32_t section = 1; section & BUNDLE_SECTIONS_ALL; section <<= 1)
+    {
+        if (!(answer->sections & section)) continue;
+
+        size_t size;
+        package_handler handler;
+        switch (section)
+        {
+            case BUNDLE_SECTION_ADC_ACTIVE:
+                size = sizeof(answer_get_adc_active);
+                handler = _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_ADC_ACTIVE)];
+                break;
+            case BUNDLE_SECTION_ADC_ACTIVE_RAW:
+                size = sizeof(answer_get_adc_active_raw);
+                handler = _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_ADC_ACTIVE_RAW)];
+                break;
+            case BUNDLE_SECTION_NET_PARAMS:
+                size = sizeof(answer_get_net_params);
+                handler = _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_NET_PARAMS)];
+                break;
+            default:
+                size = sizeof(answer_get_work_state);
+                handler = _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_WORK_STATE)];
+                break;
+        }
+        handler(reinterpret_cast<package_general*>(data));
+        data += size;
+    }
+}
+
 void PFC::protocolGetSettingsCalibrations(package_general* package)
 {
     auto answer = static_cast<answer_get_settings_calibrations*>(package);
@@ -527,6 +750,61 @@ void PFC::protocolSetSettingsCapacitors(package_general* package)
     ansSettingsCapacitors(true);
 }
 
+void PFC::protocolSubscribe(package_general* package)
+{
+    auto answer = static_cast<answer_subscribe*>(package);
+    /* The pushes sent before the answer may be received later */
+    if (answer->sequence > _telemetry_sequence) _telemetry_sequence = answer->sequence;
+    emit setTelemetrySubscribed(answer->result != 0);
+}
+
+void PFC::protocolTelemetry(std::vector<uint8_t> data)
+{
+    if (data.size() < sizeof(answer_telemetry)) return;
+    auto header = reinterpret_cast<answer_telemetry*>(&data[0]);
+
+    uint32_t lost = 0;
+    if (_telemetry_sequence && header->sequence > _telemetry_sequence + 1) lost = header->sequence - _telemetry_sequence - 1;
+    if (header->sequence > _telemetry_sequence) _telemetry_sequence = header->sequence;
+
+    /* The blocks are the answers of the requests, in the order of the groups */
+    size_t offset = sizeof(answer_telemetry);
+    for (uint32_t group = 1; group & TELEMETRY_GROUPS_ALL; group <<= 1)
+    {
+        if (!(header->groups & group)) continue;
+
+        size_t size;
+        package_handler handler;
+        switch (group)
+        {
+            case TELEMETRY_GROUP_ADC_ACTIVE:
+                size = sizeof(answer_get_adc_active);
+                handler = _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_ADC_ACTIVE)];
+                break;
+            case TELEMETRY_GROUP_NET_PARAMS:
+                size = sizeof(answer_get_net_params);
+                handler = _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_NET_PARAMS)];
+                break;
+            case TELEMETRY_GROUP_WORK_STATE:
+                size = sizeof(answer_get_work_state);
+                handler = _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_WORK_STATE)];
+                break;
+            default:
+                size = sizeof(answer_get_oscillog);
+                handler = _handlers[enum_int(InterfaceCommands::PFC_COMMAND_GET_OSCILLOG)];
+                break;
+        }
+        if (offset + size > data.size())
+        {
+            message(MESSAGE_TYPE_CONNECTION, MESSAGE_NORMAL, MESSAGE_TARGET_DEBUG, "Неверный размер телеметрии");
+            break;
+        }
+        handler(reinterpret_cast<package_general*>(&data[offset]));
+        offset += size;
+    }
+    emit telemetryReceived(lost);
+}
+
 void PFC::connectionChanged(bool connected)
 {
     emit setConnection(connected);
@@ -6,6 +6,7 @@
 --------------------------------------------------------------*/
 
 #include <QtCore/QtGlobal>
+#include <QElapsedTimer>
 #include "serial/deviceserialinterface.h"
 #include "device_definition.h"
 #include "device_interface_commands.h"
@@ -28,6 +29,14 @@ private:
     PFCSerialInterface* _interface;
     std::vector<package_handler> _handlers;
     QThread* _thread;
+    uint32_t _telemetry_sequence; /**< The number of the last telemetry push received, 0 - none */
+    bool _oscillog_pending;             /**< The oscillogram snapshot transfer is running */
+    uint16_t _oscillog_snapshot;        /**< The number of the snapshot being received, 0 - the first chunk is expected */
+    uint16_t _oscillog_channels;        /**< The channels of the snapshot (a mask) */
+    uint16_t _oscillog_samples;         /**< The number of the samples of a channel */
+    std::vector<uint8_t> _oscillog_bulk; /**< The encoded snapshot */
+    std::vector<bool> _oscillog_chunks; /**< The chunks of the snapshot received */
+    QElapsedTimer _oscillog_timer;      /**< The time of the snapshot transfer (the lost answers are not reported) */
 
     /*--------------------------------------------------------------
                            PUBLIC FUNCTIONS
@@ -76,6 +85,7 @@ signals:
                           float ADC_EMS_I);
     void setWorkState(uint32_t state, uint32_t ch_a, uint32_t ch_b, uint32_t ch_c);
     void setEvents(std::list<PFCconfig::Events::EventRecord> ev);
+    void setStateTrace(uint32_t first_index, std::list<PFCconfig::Trace::TransitionRecord> transitions);
     void setSwitchOnOff(uint32_t result);
     void setVersionInfo(
             uint32_t major,
@@ -89,6 +99,8 @@ signals:
             uint32_t minute,
             uint32_t second);
     void setConnection(bool connected);
+    void setTelemetrySubscribed(bool result);
+    void telemetryReceived(uint32_t lost);
     void setNetParams(float period_fact,
                     float U0Hz_A,
                     float U0Hz_B,
@@ -155,15 +167,19 @@ public slots:
 
     void updateNetVoltage(void);
     void updateWorkState(uint64_t currentTime);
-    void updateEvents(uint64_t afterIndex);
+    void updateEvents(uint32_t sequence);
+    void updateStateTrace(uint32_t afterIndex);
     void updateVersionInfo(void);
     void updateNetVoltageRAW(void);
     void updateOscillog(PFCconfig::Interface::OscillogCnannel channel);
+    void updateOscillogs(uint16_t channels);
     void updateNetParams(void);
+    void updateValues(uint8_t sections, uint64_t currentTime);
     void updateSettingsCalibrations(void);
     void updateSettingsProtection(void);
     void updateSettingsCapacitors(void);
     void updateSettingsFilters(void);
+    void subscribeTelemetry(uint8_t groups, uint16_t oscillogs, uint8_t decimation);
 
     /*--------------------------------------------------------------
              PUBLIC CLASS FUNCTIONS::PARAMETERS WRITE
@@ -206,9 +222,12 @@ private slots:
     void protocolGetADCActiveRAW(package_general* package);
     void protocolGetWorkState(package_general* package);
     void protocolGetEvents(package_general* package);
+    void protocolGetStateTrace(package_general* package);
     void protocolGetVersionInfo(package_general* package);
     void protocolGetOscillog(package_general* package);
+    void protocolGetOscillogBulk(package_general* package);
     void protocolGetNetParams(package_general* package);
+    void protocolGetBundle(package_general* package);
     void protocolGetSettingsCalibrations(package_general* package);
     void protocolGetSettingsProtection(package_general* package);
     void protocolGetSettingsCapacitors(package_general* package);
@@ -217,6 +236,8 @@ private slots:
     void protocolSetSettingsProtection(package_general* package);
     void protocolSetSettingsFilters(package_general* package);
     void protocolSetSettingsCapacitors(package_general* package);
+    void protocolSubscribe(package_general* package);
+    void protocolTelemetry(std::vector<uint8_t> data);
 
 private:
     void getAnswer(bool is_timeout, InterfacePackage *pc);
@@ -228,6 +249,8 @@ private:
             float offset,
             std::vector<float> &out);
     void protocolUnknownCommand(package_general* answer);
+    void decodeOscillogBulk(void);
+    static size_t decodeOscillogChannel(const uint8_t* data, size_t size, std::vector<double> &values);
     void endRequest(package_general &req, PFCconfig::Interface::InterfaceCommands command, uint32_t packet_size, DeviceSerialMessage::MessagePriority priority = DeviceSerialMessage::MessagePriority::NORMAL);
 
 };
@@ -76,13 +76,13 @@ namespace PFCconfig {
         /** The structure to store an event */
         struct EventRecord
         {
+            uint32_t sequence; /**< The sequence number of the event (from 1) */
             uint64_t unix_time_s_ms;
 
             uint32_t type;
             uint32_t info;
             float value;
         };
-        auto const TIME_MAX_VALUE = 4133894400000ULL; /**< Maximum time constant (used to exclude wrong packets) */
 
         /** Event types: main */
         enum class EventType
@@ -117,6 +117,16 @@ namespace PFCconfig {
             SUB_EVENT_TYPE_PROTECTION_IGBT,
         };
 
+        /** Event types: other events */
+        enum class SubEventEvent
+        {
+            SUB_EVENT_TYPE_EVENT_SUPPRESSED,      /**< Repeated protection events have been suppressed (info: the subevent << 16 | the channel, value: the count) */
+            SUB_EVENT_TYPE_EVENT_SETTINGS_SAVED,  /**< The settings have been written to the flash memory (info: the number of the save, value: the time [ms]) */
+            SUB_EVENT_TYPE_EVENT_SETTINGS_FAILED, /**< The settings have not been written: a flash memory error (info: the number of the save) */
+            SUB_EVENT_TYPE_EVENT_ADC_FAILED,        /**< The ADC DMA conversion has not been started, the fault state (info: the status) */
+            SUB_EVENT_TYPE_EVENT_SETTINGS_DEFERRED  /**< The settings have not been written: the PWM has been on until the deadline of the page transfer (info: the number of the save, value: the time [ms]) */
+        };
+
         /** Protection event types */
         enum class ProtectionActions
         {
@@ -126,6 +136,28 @@ namespace PFCconfig {
         };
     }
 
+    namespace Trace {
+        /** The structure to store a state transition */
+        struct TransitionRecord
+        {
+            uint32_t period;
+            uint32_t duration;
+            uint8_t from;
+            uint8_t to;
+            uint8_t cause;
+            uint8_t reserved;
+        };
+
+        /** The cause of a state transition */
+        enum class TransitionCause
+        {
+            PFC_TRANSITION_GUARD,   /**< The guard condition of the state is met */
+            PFC_TRANSITION_COMMAND, /**< A command from the panel */
+            PFC_TRANSITION_TIMEOUT, /**< The state timeout has expired */
+            PFC_TRANSITION_FAULT,   /**< A protection event */
+        };
+    }
+
     namespace Interface {
 
         enum OscillogCnannel{
@@ -143,11 +175,42 @@ namespace PFCconfig {
         };
 
         auto const OSCILLOG_TRANSFER_SIZE = 128; /**< The size of an oscillogram */
+        auto const OSCILLOG_CHUNK_SIZE = 192;    /**< The maximum size of the encoded oscillogram snapshot in an answer */
+        auto const OSCILLOG_RESIDUAL_MAX = 3;    /**< The maximum size of an encoded sample (a zig-zag varint) */
+        auto const OSCILLOG_BULK_TIMEOUT_MS = 1000; /**< The snapshot transfer is started again after the time (an answer is lost) */
         auto const MAX_EVENTS_PACKET_SIZE = 150; /**< The maximum size of the packet that can be occupied by events */
 
         /** The maximum number of events that can be transferred */
         auto const MAX_NUM_TRANSFERED_EVENTS = (MAX_EVENTS_PACKET_SIZE / (sizeof(Events::EventRecord)));
 
+        auto const MAX_TRACE_PACKET_SIZE = 192; /**< The maximum size of the packet that can be occupied by state transitions */
+
+        /** The maximum number of state transitions that can be transferred */
+        auto const MAX_NUM_TRANSFERED_TRANSITIONS = (MAX_TRACE_PACKET_SIZE / (sizeof(Trace::TransitionRecord)));
+
+        /** Telemetry groups (a mask): the blocks of a push follow the header in the order of the bits */
+        enum TelemetryGroup
+        {
+            TELEMETRY_GROUP_ADC_ACTIVE = (1U << 0), /**< The active values (as answer_get_adc_active) */
+            TELEMETRY_GROUP_NET_PARAMS = (1U << 1), /**< The network parameters (as answer_get_net_params) */
+            TELEMETRY_GROUP_WORK_STATE = (1U << 2), /**< The work state (as answer_get_work_state) */
+            TELEMETRY_GROUP_OSCILLOG = (1U << 3),   /**< An oscillogram, the subscribed channels in turn (as answer_get_oscillog) */
+            TELEMETRY_GROUPS_ALL = 0x0F             /**< All the groups */
+        };
+
+        /** Bundle sections (a mask): the sections of the answer follow the header in the order of the bits */
+        enum BundleSection
+        {
+            BUNDLE_SECTION_ADC_ACTIVE = (1U << 0),     /**< The active values (as answer_get_adc_active) */
+            BUNDLE_SECTION_ADC_ACTIVE_RAW = (1U << 1), /**< The active values without the calibrations (as answer_get_adc_active_raw) */
+            BUNDLE_SECTION_NET_PARAMS = (1U << 2),     /**< The network parameters (as answer_get_net_params) */
+            BUNDLE_SECTION_WORK_STATE = (1U << 3),     /**< The work state (as answer_get_work_state) */
+            BUNDLE_SECTIONS_ALL = 0x0F                 /**< All the sections */
+        };
+
+        auto const TELEMETRY_RENEW_MS = 1000;   /**< The period of the subscription renewal [ms] */
+        auto const TELEMETRY_TIMEOUT_MS = 3000; /**< The subscription time without a renewal [ms] */
+
         /** PFC commands fromt the panel */
         enum class PFCCommands
         {
@@ -185,6 +248,19 @@ namespace PFCconfig {
 
             PFC_COMMAND_GET_VERSION_INFO, /**< Get firmware info */
             PFC_COMMAND_GET_EVENTS,       /**< Get events */
+            PFC_COMMAND_GET_STATE_TRACE,  /**< Get the state transitions trace */
+
+            PFC_COMMAND_SET_CAPTURE,      /**< Set the waveform capture triggers, trigger a capture */
+            PFC_COMMAND_GET_CAPTURES,     /**< Get the list of the waveform captures */
+            PFC_COMMAND_GET_CAPTURE_DATA, /**< Get the samples of a waveform capture */
+
+            PFC_COMMAND_SUBSCRIBE, /**< Subscribe to the telemetry */
+            PFC_COMMAND_TELEMETRY, /**< The telemetry push (sent by the firmware only) */
+
+            PFC_COMMAND_GET_OSCILLOG_BULK, /**< Get the oscillogram channels of a period in the full resolution */
+            PFC_COMMAND_GET_BUNDLE,        /**< Get the live values of a period at once (the sections of a mask) */
+
+            PFC_COMMAND_GET_SCHEDULER_STATS, /**< Get the jitter and the overruns of the main loop tasks, the cycles of the control interrupt */
 
             PFC_COMMAND_COUNT /**< The length of the structure */
         };
@@ -308,16 +308,89 @@ struct _FW_PACKED answer_get_net_params: public answer_general
 /** Command: Get events */
 struct _FW_PACKED command_get_events: public command_general
 {
-    uint64_t after_index;
+    uint32_t sequence; /**< The sequence number of the first event to get */
 };
 
 /** Answer: Get events */
 struct _FW_PACKED answer_get_events: public answer_general
 {
+    uint32_t last_sequence; /**< The sequence number of the last event in the device */
     uint16_t num;
     PFCconfig::Events::EventRecord events[PFCconfig::Interface::MAX_NUM_TRANSFERED_EVENTS];
 };
 
+/** Command: Get the state transitions trace */
+struct _FW_PACKED command_get_state_trace: public command_general
+{
+    uint32_t after_index;
+};
+
+/** Answer: Get the state transitions trace */
+struct _FW_PACKED answer_get_state_trace: public answer_general
+{
+    uint32_t first_index;
+    uint32_t total;
+    uint16_t num;
+    PFCconfig::Trace::TransitionRecord transitions[PFCconfig::Interface::MAX_NUM_TRANSFERED_TRANSITIONS];
+};
+
+/** Command: Subscribe to the telemetry (renew the subscription, cancel it) */
+struct _FW_PACKED command_subscribe: public command_general
+{
+    uint8_t groups;     /**< The groups (TelemetryGroup mask), 0 - cancel the subscription */
+    uint16_t oscillogs; /**< The oscillogram channels (a mask) for TELEMETRY_GROUP_OSCILLOG */
+    uint8_t decimation; /**< The push is made every decimation periods of the network */
+    uint16_t timeout;   /**< The subscription time without a renewal [ms], 0 - the default time */
+};
+
+/** Answer: Subscribe to the telemetry */
+struct _FW_PACKED answer_subscribe: public answer_general
+{
+    uint8_t result;    /**< 1 - the subscription has been applied, 0 - wrong parameters */
+    uint32_t sequence; /**< The number of the last push packet */
+};
+
+/** Push: Telemetry (the blocks of the groups follow the header in the order of the bits) */
+struct _FW_PACKED answer_telemetry: public answer_general
+{
+    uint32_t sequence; /**< The number of the push packet (incremented for every packet) */
+    uint8_t groups;    /**< The groups in the packet (TelemetryGroup mask) */
+};
+
+/** Command: Get the oscillogram channels of a period in the full resolution (the encoded snapshot by chunks) */
+struct _FW_PACKED command_get_oscillog_bulk: public command_general
+{
+    uint16_t channels; /**< The channels of a new snapshot (a mask) */
+    uint16_t snapshot; /**< The number of the snapshot, 0 - take a new snapshot */
+    uint16_t offset;   /**< The offset of the chunk in the encoded snapshot */
+};
+
+/** Answer: Get the oscillogram channels of a period in the full resolution (the data is sent up to the length of the chunk) */
+struct _FW_PACKED answer_get_oscillog_bulk: public answer_general
+{
+    uint16_t snapshot; /**< The number of the snapshot: all the chunks of a snapshot are of the same period */
+    uint16_t channels; /**< The channels of the snapshot (a mask) */
+    uint16_t samples;  /**< The number of the samples of a channel */
+    uint16_t size;     /**< The size of the encoded snapshot */
+    uint16_t offset;   /**< The offset of the chunk */
+    uint8_t len;       /**< The size of the chunk, 0 - the snapshot has been replaced or the offset is at the end */
+    uint8_t data[PFCconfig::Interface::OSCILLOG_CHUNK_SIZE];
+};
+
+/** Command: Get the live values of a period at once (the sections replace the separate requests) */
+struct _FW_PACKED command_get_bundle: public command_general
+{
+    uint8_t sections;     /**< The sections (BundleSection mask) */
+    uint64_t currentTime; /**< The time of the panel, set with BUNDLE_SECTION_WORK_STATE (as command_get_work_state) */
+};
+
+/** Answer: Get the live values of a period at once (the sections follow the header in the order of the bits) */
+struct _FW_PACKED answer_get_bundle: public answer_general
+{
+    uint32_t period;  /**< The number of the period of the values (incremented for every period) */
+    uint8_t sections; /**< The sections in the answer (BundleSection mask) */
+};
+
 #pragma pack(pop)
 
 #endif // DEVICE_INTERFACE_COMMANDS_H
@@ -36,6 +36,7 @@ using namespace PFCconfig;
 using namespace PFCconfig::ADC;
 using namespace PFCconfig::Interface;
 using namespace PFCconfig::Events;
+using namespace PFCconfig::Trace;
 using namespace InterfaceDefinitions;
 using namespace InterfaceMessaging;
 
@@ -67,7 +68,10 @@ MainWindow::MainWindow(QWidget* parent)
       _page_oscillog(_ui, _pfc_settings, _pfc),
       _page_main(_ui, _pfc_settings, _pfc),
       _last_index_events(0),
+      _last_index_trace(0),
       _port_settings(new SettingsDialog),
+      _telemetry_supported(true),
+      _telemetry_pending(false),
       _connected(false),
       _btns_edit()
 {
@@ -106,6 +110,8 @@ MainWindow::MainWindow(QWidget* parent)
     connect(_pfc, &PFC::interfaceDisconnected, this, &MainWindow::deviceDisconnected);
 
     connect(_pfc, &PFC::setConnection, this, &MainWindow::setConnection);
+    connect(_pfc, &PFC::setTelemetrySubscribed, this, &MainWindow::setTelemetrySubscribed);
+    connect(_pfc, &PFC::telemetryReceived, this, &MainWindow::telemetryReceived);
 
     connect(_pfc, &PFC::setNetVoltage, this, &MainWindow::setNetVoltage);
     connect(_pfc, &PFC::setSwitchOnOff, this, &MainWindow::setSwitchOnOff);
@@ -113,6 +119,7 @@ MainWindow::MainWindow(QWidget* parent)
     connect(_pfc, &PFC::setNetParams, this, &MainWindow::setNetParams);
 
     connect(_pfc, &PFC::setEvents, this, &MainWindow::setEvents);
+    connect(_pfc, &PFC::setStateTrace, this, &MainWindow::setStateTrace);
 
     connect(_pfc, &PFC::message, this, &MainWindow::message);
 
@@ -130,15 +137,13 @@ MainWindow::MainWindow(QWidget* parent)
     connect(_pfc, &PFC::ansSettingsCapacitors,
             this, &MainWindow::ansSettingsCapacitors);
 
-    connect(this, &MainWindow::updateNetVoltage,
-            _pfc, &PFC::updateNetVoltage);
-    connect(this, &MainWindow::updateNetVoltageRAW,
-            _pfc, &PFC::updateNetVoltageRAW);
-    connect(this, &MainWindow::updateNetParams,
-            _pfc, &PFC::updateNetParams);
+    connect(this, &MainWindow::subscribeTelemetry,
+            _pfc, &PFC::subscribeTelemetry);
 
     connect(this, &MainWindow::updateEvents,
             _pfc, &PFC::updateEvents);
+    connect(this, &MainWindow::updateStateTrace,
+            _pfc, &PFC::updateStateTrace);
 
     connect(this, &MainWindow::updateSettingsCalibrations,
             _pfc, &PFC::updateSettingsCalibrations);
@@ -157,10 +162,6 @@ MainWindow::MainWindow(QWidget* parent)
     connect(this, &MainWindow::writeSwitchOnOff,
             _pfc, &PFC::writeSwitchOnOff);
 
-    connect(&_timer_voltage, &QTimer::timeout,
-            this, &MainWindow::timerupdateNetVoltage);
-    connect(&_timer_raw, &QTimer::timeout,
-            this, &MainWindow::timerupdateNetVoltageRaw);
     connect(&_timer_oscillog, &QTimer::timeout,
             this, &MainWindow::timerOscillog);
     connect(&_timer_settings_calibrations, &QTimer::timeout,
@@ -171,14 +172,14 @@ MainWindow::MainWindow(QWidget* parent)
             this, &MainWindow::timerSettingsProtection);
     connect(&_timer_settings_filters, &QTimer::timeout,
             this, &MainWindow::timerSettingsFilters);
-    connect(&_timer_main_params, &QTimer::timeout,
-            this, &MainWindow::timerNetParams);
     connect(&_timer_state, &QTimer::timeout,
             this, &MainWindow::timerWorkState);
     connect(&_timer_version, &QTimer::timeout,
             this, &MainWindow::timerVersion);
     connect(&_timer_events, &QTimer::timeout,
             this, &MainWindow::timerEvents);
+    connect(&_timer_telemetry, &QTimer::timeout,
+            this, &MainWindow::timerTelemetry);
 
     /* Init window pages */
     _page_main.pageMainInit();
@@ -189,6 +190,7 @@ MainWindow::MainWindow(QWidget* parent)
     _page_filters.pageSettingsFiltersInit();
 
     _timer_events.start(EVENTS_TIMER_TIMEOUT);
+    _timer_telemetry.start(TIMEOUT_RENEW_TELEMETRY);
 
     _ui->listLog->setItemDelegate(new HtmlDelegate);
 }
@@ -218,28 +220,77 @@ std::string MainWindow::stringWithColor(std::string str, std::string color)
     return ret_str;
 }
 
+std::string MainWindow::stateString(uint32_t state)
+{
+    switch (static_cast<PFCstate>(state))
+    {
+        case PFCstate::PFC_STATE_INIT:
+            return STRING_PFC_STATE_INIT;
+        case PFCstate::PFC_STATE_STOP:
+            return STRING_PFC_STATE_STOP;
+        case PFCstate::PFC_STATE_SYNC:
+            return STRING_PFC_STATE_SYNC;
+        case PFCstate::PFC_STATE_PRECHARGE_PREPARE:
+            return STRING_PFC_STATE_PRECHARGE_PREPARE;
+        case PFCstate::PFC_STATE_PRECHARGE:
+            return STRING_PFC_STATE_PRECHARGE;
+        case PFCstate::PFC_STATE_MAIN:
+            return STRING_PFC_STATE_MAIN;
+        case PFCstate::PFC_STATE_PRECHARGE_DISABLE:
+            return STRING_PFC_STATE_PRECHARGE_DISABLE;
+        case PFCstate::PFC_STATE_WORK:
+            return STRING_PFC_STATE_WORK;
+        case PFCstate::PFC_STATE_CHARGE:
+            return STRING_PFC_STATE_CHARGE;
+        case PFCstate::PFC_STATE_TEST:
+            return STRING_PFC_STATE_TEST;
+        case PFCstate::PFC_STATE_STOPPING:
+            return STRING_PFC_STATE_STOPPING;
+        case PFCstate::PFC_STATE_FAULTBLOCK:
+            return stringWithColor(STRING_PFC_STATE_FAULTBLOCK, DARK_RED);
+        default:
+            return STRING_PFC_STATE_UNKNOWN;
+    }
+}
+
 void MainWindow::setConnection(bool connected)
 {
     _connected = connected;
     if (!_connected)
     {
         _last_index_events = 0;
+        _last_index_trace = 0;
+        /* The values are polled until the subscription is renewed */
+        _telemetry_last.invalidate();
     }
 }
 
-void MainWindow::filterApply(float &A, float B)
+bool MainWindow::telemetryActive(void) const
 {
-    A = A * FCOEFF + B * (1 - FCOEFF);
+    return _telemetry_last.isValid() && _telemetry_last.elapsed() < TELEMETRY_TIMEOUT_MS;
 }
 
-void MainWindow::timerupdateNetVoltage(void)
+void MainWindow::setTelemetrySubscribed(bool result)
 {
-    if (_connected) emit updateNetVoltage();
+    _telemetry_pending = false;
+    if (!result) _telemetry_supported = false;
 }
-void MainWindow::timerupdateNetVoltageRaw(void)
+
+void MainWindow::telemetryReceived(uint32_t lost)
 {
-    if (_connected) emit updateNetVoltageRAW();
+    _telemetry_last.start();
+    if (lost)
+    {
+        message(MESSAGE_TYPE_CONNECTION, MESSAGE_NORMAL, MESSAGE_TARGET_DEBUG,
+                QString("Telemetry pushes lost: %1").arg(lost).toStdString());
+    }
 }
+
+void MainWindow::filterApply(float &A, float B)
+{
+    A = A * FCOEFF + B * (1 - FCOEFF);
+}
+
 void MainWindow::timerSettingsCapacitors(void)
 {
     if (_connected) emit updateSettingsCapacitors();
@@ -260,12 +311,16 @@ void MainWindow::timerSettingsCalibrations(void)
 void MainWindow::timerEvents(void)
 {
     if (_connected) emit updateEvents(_last_index_events);
+    if (_connected) emit updateStateTrace(_last_index_trace);
 }
 
 void MainWindow::timerWorkState(void)
 {
-    /* Frequent update */
-    if (_connected) _page_main.update();
+    /* Frequent update: the values of a period are requested together, the pushed ones are skipped */
+    if (!_connected) return;
+    uint8_t sections = BUNDLE_SECTION_ADC_ACTIVE_RAW;
+    if (!telemetryActive()) sections |= BUNDLE_SECTION_ADC_ACTIVE | BUNDLE_SECTION_NET_PARAMS;
+    _page_main.update(sections);
 }
 
 void MainWindow::timerVersion(void)
@@ -274,21 +329,39 @@ void MainWindow::timerVersion(void)
     _page_main.update();
 }
 
-void MainWindow::timerNetParams(void)
+void MainWindow::timerOscillog(void)
 {
-    if (_connected) emit updateNetParams();
+    if (!_connected) return;
+    if (telemetryActive())
+    {
+        /* The channels are pushed, only the graphs visibility is updated */
+        _page_oscillog.update(false);
+        return;
+    }
+    _page_oscillog.update();
 }
 
-void MainWindow::timerOscillog(void)
+void MainWindow::timerTelemetry(void)
 {
-    if (_connected) _page_oscillog.update();
+    /* The firmware without the telemetry ignores the subscription: the values are polled until the reconnection */
+    if (_telemetry_pending) _telemetry_supported = false;
+    if (!_connected || !_telemetry_supported) return;
+
+    /* The groups of the shown pages (the timers are started while the pages are shown) */
+    uint8_t groups = 0;
+    uint16_t oscillogs = 0;
+    if (_timer_state.isActive()) groups |= TELEMETRY_GROUP_ADC_ACTIVE | TELEMETRY_GROUP_NET_PARAMS;
+    if (_timer_oscillog.isActive()) oscillogs = _page_oscillog.channelMask();
+    if (oscillogs) groups |= TELEMETRY_GROUP_OSCILLOG;
+
+    /* No groups: the subscription is cancelled */
+    if (!groups && !telemetryActive()) return;
+    _telemetry_pending = true;
+    emit subscribeTelemetry(groups, oscillogs, oscillogs ? TELEMETRY_DECIMATION_OSCILLOG : TELEMETRY_DECIMATION_VALUES);
 }
 
 bool MainWindow::eventFilter(QObject* object, QEvent* event)
 {
-    setFilter(event, object, _ui->groupNetworkParameters, &_timer_main_params, TIMEOUT_UPDATE_MAIN_PARAMS);
-    setFilter(event, object, _ui->groupNetworkParameters, &_timer_voltage, TIMEOUT_UPDATE_VOLTAGES);
-    setFilter(event, object, _ui->groupNetworkParameters, &_timer_raw, TIMEOUT_UPDATE_ADC_RAW);
     setFilter(event, object, _ui->groupNetworkParameters, &_timer_state, TIMEOUT_UPDATE_STATE);
     setFilter(event, object, _ui->groupState, &_timer_version, TIMEOUT_UPDATE_VERSION);
     setFilter(event, object, _ui->OscillogPlot, &_timer_oscillog, TIMEOUT_UPDATE_OSCILLOG);
@@ -301,6 +374,8 @@ bool MainWindow::eventFilter(QObject* object, QEvent* event)
 
 void MainWindow::deviceConnected(void)
 {
+    _telemetry_supported = true;
+    _telemetry_pending = false;
     _ui->actionConnect->setEnabled(false);
     _ui->actionDisconnect->setEnabled(true);
     _ui->actionConfigure->setEnabled(false);
@@ -317,14 +392,15 @@ void MainWindow::setEvents(std::list<EventRecord> ev)
 {
     foreach (EventRecord event, ev)
     {
-        if (event.unix_time_s_ms >= _last_index_events)
-        {
-            _last_index_events = event.unix_time_s_ms + 1;
-        }
-        if (_last_index_events > TIME_MAX_VALUE)
+        /* The events are overwritten in the device if they are not read in time */
+        if (_last_index_events != 0 && event.sequence > _last_index_events)
         {
-            _last_index_events = 0;
+            std::stringstream lost_stream;
+            lost_stream << "Events lost: " << (event.sequence - _last_index_events);
+            message(MESSAGE_TYPE_STATE, MESSAGE_NORMAL, MESSAGE_TARGET_DEBUG, lost_stream.str());
         }
+        /* The sequence numbers are restarted with the device */
+        _last_index_events = event.sequence + 1;
         char Phases[3] = {'A', 'B', 'C'};
         std::string ADCchannels[] = {
             "ADC_UD",
@@ -344,7 +420,8 @@ void MainWindow::setEvents(std::list<EventRecord> ev)
         };
         std::stringstream message_stream;
         message_stream << std::fixed << std::setprecision(2);
-        SubEventPower subtype = static_cast<SubEventPower>((event.type >> 16) & 0xFFFF);
+        uint32_t subtype_raw = (event.type >> 16) & 0xFFFF;
+        SubEventPower subtype = static_cast<SubEventPower>(subtype_raw);
 
         QDateTime timestamp;
         timestamp.setTime_t(static_cast<uint>(event.unix_time_s_ms / 1000));
@@ -373,46 +450,16 @@ void MainWindow::setEvents(std::list<EventRecord> ev)
                 break;
             case EventType::EVENT_TYPE_CHANGESTATE:
                 message_stream << stringWithColor(" - State - ", DARK_GREEN);
-                switch (static_cast<PFCstate>(subtype))
+                message_stream << stateString(subtype_raw);
+                switch (static_cast<TransitionCause>(static_cast<uint32_t>(event.value)))
                 {
-                    case PFCstate::PFC_STATE_INIT:
-                        message_stream << STRING_PFC_STATE_INIT;
+                    case TransitionCause::PFC_TRANSITION_TIMEOUT:
+                        message_stream << " (timeout in the state: " << stateString(event.info) << ")";
                         break;
-                    case PFCstate::PFC_STATE_STOP:
-                        message_stream << STRING_PFC_STATE_STOP;
-                        break;
-                    case PFCstate::PFC_STATE_SYNC:
-                        message_stream << STRING_PFC_STATE_SYNC;
-                        break;
-                    case PFCstate::PFC_STATE_PRECHARGE_PREPARE:
-                        message_stream << STRING_PFC_STATE_PRECHARGE_PREPARE;
-                        break;
-                    case PFCstate::PFC_STATE_PRECHARGE:
-                        message_stream << STRING_PFC_STATE_PRECHARGE;
-                        break;
-                    case PFCstate::PFC_STATE_MAIN:
-                        message_stream << STRING_PFC_STATE_MAIN;
-                        break;
-                    case PFCstate::PFC_STATE_PRECHARGE_DISABLE:
-                        message_stream << STRING_PFC_STATE_PRECHARGE_DISABLE;
-                        break;
-                    case PFCstate::PFC_STATE_WORK:
-                        message_stream << STRING_PFC_STATE_WORK;
-                        break;
-                    case PFCstate::PFC_STATE_CHARGE:
-                        message_stream << STRING_PFC_STATE_CHARGE;
-                        break;
-                    case PFCstate::PFC_STATE_TEST:
-                        message_stream << STRING_PFC_STATE_TEST;
-                        break;
-                    case PFCstate::PFC_STATE_STOPPING:
-                        message_stream << STRING_PFC_STATE_STOPPING;
-                        break;
-                    case PFCstate::PFC_STATE_FAULTBLOCK:
-                        message_stream << stringWithColor(STRING_PFC_STATE_FAULTBLOCK, DARK_RED);
+                    case TransitionCause::PFC_TRANSITION_FAULT:
+                        message_stream << " (protection)";
                         break;
                     default:
-                        message_stream << STRING_PFC_STATE_UNKNOWN;
                         break;
                 }
                 break;
@@ -477,6 +524,32 @@ void MainWindow::setEvents(std::list<EventRecord> ev)
                 break;
             case EventType::EVENT_TYPE_EVENT:
                 message_stream << " - Event ";
+                switch (static_cast<SubEventEvent>(subtype_raw))
+                {
+                    case SubEventEvent::SUB_EVENT_TYPE_EVENT_SUPPRESSED:
+                        message_stream << "- Repeated protection events suppressed (protection ";
+                        message_stream << (event.info >> 16) << ", channel " << (event.info & 0xFFFF) << "): ";
+                        message_stream << std::setprecision(0) << event.value;
+                        break;
+                    case SubEventEvent::SUB_EVENT_TYPE_EVENT_SETTINGS_SAVED:
+                        message_stream << "- Settings saved (#" << event.info << ", ";
+                        message_stream << std::setprecision(0) << event.value << " ms)";
+                        break;
+                    case SubEventEvent::SUB_EVENT_TYPE_EVENT_SETTINGS_FAILED:
+                        message_stream << stringWithColor("- Settings save failed ", DARK_RED);
+                        message_stream << "(#" << event.info << ")";
+                        break;
+                    case SubEventEvent::SUB_EVENT_TYPE_EVENT_SETTINGS_DEFERRED:
+                        message_stream << stringWithColor("- Settings save failed, the PWM is on ", DARK_RED);
+                        message_stream << "(#" << event.info << ", " << std::setprecision(0) << event.value << " ms)";
+                        break;
+                    case SubEventEvent::SUB_EVENT_TYPE_EVENT_ADC_FAILED:
+                        message_stream << stringWithColor("- ADC start failed ", DARK_RED);
+                        message_stream << "(status " << static_cast<int32_t>(event.info) << ")";
+                        break;
+                    default:
+                        break;
+                }
                 break;
         }
 
@@ -485,6 +558,24 @@ void MainWindow::setEvents(std::list<EventRecord> ev)
     }
 }
 
+void MainWindow::setStateTrace(uint32_t first_index, std::list<TransitionRecord> transitions)
+{
+    const std::string causes[] = {"guard", "command", "timeout", "fault"};
+    const auto causes_count = sizeof(causes) / sizeof(causes[0]);
+    uint32_t index = first_index;
+    foreach (TransitionRecord transition, transitions)
+    {
+        std::stringstream message_stream;
+        message_stream << "#" << index << " period " << transition.period << ": ";
+        message_stream << stateString(transition.from) << " -> " << stateString(transition.to);
+        message_stream << " (" << ((transition.cause < causes_count) ? causes[transition.cause] : "-") << ")";
+        message_stream << " after " << transition.duration << " periods";
+        message(MESSAGE_TYPE_STATE, MESSAGE_NORMAL, MESSAGE_TARGET_DEBUG, message_stream.str());
+        index++;
+    }
+    _last_index_trace = index;
+}
+
 void MainWindow::message(uint8_t type, uint8_t level, uint8_t target, std::string message)
 {
     std::string prefix;
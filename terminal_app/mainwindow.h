@@ -20,6 +20,7 @@
 #include <QMainWindow>
 #include <QtSerialPort/QSerialPort>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <device.h>
 #include <QThread>
 #include <QSignalSpy>
@@ -66,9 +67,6 @@ public:
 private:
     static constexpr auto FCOEFF = 0.9f;
 
-    static constexpr auto TIMEOUT_UPDATE_MAIN_PARAMS = static_cast<std::chrono::milliseconds>(300);
-    static constexpr auto TIMEOUT_UPDATE_VOLTAGES = static_cast<std::chrono::milliseconds>(300);
-    static constexpr auto TIMEOUT_UPDATE_ADC_RAW = static_cast<std::chrono::milliseconds>(300);
     static constexpr auto TIMEOUT_UPDATE_STATE = static_cast<std::chrono::milliseconds>(300);
     static constexpr auto TIMEOUT_UPDATE_VERSION = static_cast<std::chrono::milliseconds>(3000);
     static constexpr auto TIMEOUT_UPDATE_OSCILLOG = static_cast<std::chrono::milliseconds>(54);
@@ -76,6 +74,9 @@ private:
     static constexpr auto TIMEOUT_UPDATE_SETTINGS_CAPACITORS = static_cast<std::chrono::milliseconds>(300);
     static constexpr auto TIMEOUT_UPDATE_SETTINGS_PROTECTION = static_cast<std::chrono::milliseconds>(300);
     static constexpr auto TIMEOUT_UPDATE_SETTINGS_FILTERS = static_cast<std::chrono::milliseconds>(300);
+    static constexpr auto TIMEOUT_RENEW_TELEMETRY = static_cast<std::chrono::milliseconds>(PFCconfig::Interface::TELEMETRY_RENEW_MS);
+    static constexpr uint8_t TELEMETRY_DECIMATION_OSCILLOG = 3; /**< The push period with the oscillograms shown (as the oscillogram polling) [periods] */
+    static constexpr uint8_t TELEMETRY_DECIMATION_VALUES = 15;  /**< The push period with the values only (as the values polling) [periods] */
 
     const static auto EVENTS_TIMER_TIMEOUT = 1000;    
     const static auto UD_MAX_VALUE = 500;
@@ -147,13 +148,11 @@ private:
     PageMain _page_main;
 
     std::list<QPushButton*> _buttons_edit;
-    uint64_t _last_index_events;
+    uint32_t _last_index_events;
+    uint32_t _last_index_trace;
 
     SettingsDialog *_port_settings;
-    QTimer _timer_main_params;
-    QTimer _timer_raw;
     QTimer _timer_state;
-    QTimer _timer_voltage;
     QTimer _timer_version;
     QTimer _timer_oscillog;
     QTimer _timer_events;
@@ -161,6 +160,10 @@ private:
     QTimer _timer_settings_capacitors;
     QTimer _timer_settings_protection;
     QTimer _timer_settings_filters;
+    QTimer _timer_telemetry;
+    QElapsedTimer _telemetry_last; /**< The time of the last telemetry push (the values are polled without the pushes) */
+    bool _telemetry_supported;     /**< The device answers the subscription (cleared for the firmware without the telemetry) */
+    bool _telemetry_pending;       /**< The subscription is not answered yet */
     bool _connected;
 
     std::vector<QPushButton*> _btns_edit;
@@ -179,7 +182,9 @@ private:
     void initInterfaceConnections(void);
     void filterApply(float &A, float B);
     void setFilter(QEvent* event, QObject* object, QWidget* ui_obj, QTimer* obj, std::chrono::milliseconds timeout);
+    bool telemetryActive(void) const;
     std::string stringWithColor(std::string str, std::string color);
+    std::string stateString(uint32_t state);
     void tableSettingsCalibrationsSetAutoSettings(void);
     float CALC_AUTO_COEF(PFCconfig::ADC::ADCchannel CALIB, float NOW, float NOMINAL);
 
@@ -250,6 +255,7 @@ public slots:
 
     void setSwitchOnOff(uint32_t result);
     void setEvents(std::list<PFCconfig::Events::EventRecord> ev);
+    void setStateTrace(uint32_t first_index, std::list<PFCconfig::Trace::TransitionRecord> transitions);
 
 
     void setNetParams(float period_fact,
@@ -290,19 +296,19 @@ public slots:
     void ansSettingsCalibrations(bool writed);
     void ansSettingsProtection(bool writed);
     void ansSettingsCapacitors(bool writed);
+    void setTelemetrySubscribed(bool result);
+    void telemetryReceived(uint32_t lost);
 
     /* Timer events callbacks */
     void timerOscillog();
-    void timerNetParams();
     void timerWorkState();
     void timerVersion();
     void timerSettingsCalibrations();
     void timerSettingsCapacitors();
     void timerSettingsProtection();
     void timerSettingsFilters();
-    void timerupdateNetVoltage();
-    void timerupdateNetVoltageRaw();
     void timerEvents();
+    void timerTelemetry();
 
     /* Other functions */
 
@@ -310,13 +316,12 @@ public slots:
     void tableSettingsProtectionChanged(int row, int col);
 
 signals:
-    void updateNetVoltage();
-    void updateNetVoltageRAW();
-    void updateNetParams();
-    void updateEvents(uint64_t afterIndex);
+    void updateEvents(uint32_t sequence);
+    void updateStateTrace(uint32_t afterIndex);
     void updateSettingsCalibrations();
     void updateSettingsProtection();
     void updateSettingsCapacitors();
+    void subscribeTelemetry(uint8_t groups, uint16_t oscillogs, uint8_t decimation);
 
     void writeSettingsCalibrations(
             std::vector<float> calibration,
@@ -44,17 +44,17 @@ void PageMain::pageMainInit(void)
 {
     connect(_pfc, &PFC::setVersionInfo, this, &PageMain::setVersionInfo);
     connect(_pfc, &PFC::setWorkState, this, &PageMain::setWorkState);
-    connect(this, &PageMain::updateWorkState,
-         _pfc, &PFC::updateWorkState);
+    connect(this, &PageMain::updateValues,
+         _pfc, &PFC::updateValues);
     connect(this, &PageMain::updateVersionInfo,
          _pfc, &PFC::updateVersionInfo);
     _ui->radioConnection->setDisabled(true);
 }
 
-void PageMain::update(void)
+void PageMain::update(uint8_t sections)
 {
     _ui->radioConnection->setDisabled(true);
-    emit updateWorkState(static_cast<uint64_t>(QDateTime::currentMSecsSinceEpoch()));
+    emit updateValues(sections | BUNDLE_SECTION_WORK_STATE, static_cast<uint64_t>(QDateTime::currentMSecsSinceEpoch()));
     emit updateVersionInfo();
 }
 
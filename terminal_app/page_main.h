@@ -19,7 +19,7 @@ public:
     explicit PageMain(Ui::MainWindow *ui, PFCconfig::PFCsettings *pfc_settings, PFC *pfc);
     virtual ~PageMain(void);
     void pageMainInit(void);
-    void update(void);
+    void update(uint8_t sections = PFCconfig::Interface::BUNDLE_SECTION_WORK_STATE);
 
 public slots:
     void setWorkState(uint32_t state, uint32_t ch_a, uint32_t ch_b, uint32_t ch_c);
@@ -38,7 +38,7 @@ public slots:
     void updateCheckboxVal(QCheckBox* checkbox, bool value);
 
 signals:
-    void updateWorkState(uint64_t currentTime);
+    void updateValues(uint8_t sections, uint64_t currentTime);
     void updateVersionInfo();
 };
 
@@ -35,8 +35,8 @@ PageOscillog::~PageOscillog(void)
 void PageOscillog::pageOscillogInit(void)
 {
     connect(_pfc, &PFC::setOscillog, this, &PageOscillog::setOscillog);
-    connect(this, &PageOscillog::updateOscillog,
-            _pfc, &PFC::updateOscillog);
+    connect(this, &PageOscillog::updateOscillogs,
+            _pfc, &PFC::updateOscillogs);
     connect(_ui->buttonAutoConfigOsc, &QPushButton::clicked, this, &PageOscillog::buttonAutoConfigOscClicked);
 
     _oscillog_array[OscillogCnannel::OSC_U_A] = DiagramOscillogChannels::OSCILLOG_U_A;
@@ -165,21 +165,32 @@ void PageOscillog::setOscillog(OscillogCnannel channel, std::vector<double> data
     }
 }
 
-void PageOscillog::update(void)
+uint16_t PageOscillog::channelMask(void) const
 {
-    if (_ui->checkOscIa->isChecked()) emit updateOscillog(OscillogCnannel::OSC_I_A);
-    if (_ui->checkOscIb->isChecked()) emit updateOscillog(OscillogCnannel::OSC_I_B);
-    if (_ui->checkOscIc->isChecked()) emit updateOscillog(OscillogCnannel::OSC_I_C);
-
-    if (_ui->checkOscUa->isChecked()) emit updateOscillog(OscillogCnannel::OSC_U_A);
-    if (_ui->checkOscUb->isChecked()) emit updateOscillog(OscillogCnannel::OSC_U_B);
-    if (_ui->checkOscUc->isChecked()) emit updateOscillog(OscillogCnannel::OSC_U_C);
-
-    if (_ui->checkOscUd->isChecked()) emit updateOscillog(OscillogCnannel::OSC_UD);
+    const std::pair<QCheckBox*, OscillogCnannel> checks[] = {
+        {_ui->checkOscIa, OscillogCnannel::OSC_I_A},
+        {_ui->checkOscIb, OscillogCnannel::OSC_I_B},
+        {_ui->checkOscIc, OscillogCnannel::OSC_I_C},
+        {_ui->checkOscUa, OscillogCnannel::OSC_U_A},
+        {_ui->checkOscUb, OscillogCnannel::OSC_U_B},
+        {_ui->checkOscUc, OscillogCnannel::OSC_U_C},
+        {_ui->checkOscUd, OscillogCnannel::OSC_UD},
+        {_ui->checkOscICompA, OscillogCnannel::OSC_COMP_A},
+        {_ui->checkOscICompB, OscillogCnannel::OSC_COMP_B},
+        {_ui->checkOscICompC, OscillogCnannel::OSC_COMP_C},
+    };
+    uint16_t mask = 0;
+    for (auto &check : checks)
+    {
+        if (check.first->isChecked()) mask |= static_cast<uint16_t>(1U << check.second);
+    }
+    return mask;
+}
 
-    if (_ui->checkOscICompA->isChecked()) emit updateOscillog(OscillogCnannel::OSC_COMP_A);
-    if (_ui->checkOscICompB->isChecked()) emit updateOscillog(OscillogCnannel::OSC_COMP_B);
-    if (_ui->checkOscICompC->isChecked()) emit updateOscillog(OscillogCnannel::OSC_COMP_C);
+void PageOscillog::update(bool request)
+{
+    /* The channels are not requested while they are pushed */
+    if (request) emit updateOscillogs(channelMask());
 
     _ui->OscillogPlot->graph(static_cast<int>(DiagramOscillogChannels::OSCILLOG_I_A))->setVisible(_ui->checkOscIa->isChecked());
     _ui->OscillogPlot->graph(static_cast<int>(DiagramOscillogChannels::OSCILLOG_I_B))->setVisible(_ui->checkOscIb->isChecked());
@@ -42,6 +42,7 @@ public:
     explicit PageOscillog(Ui::MainWindow *ui, PFCconfig::PFCsettings *pfc_settings, PFC *pfc);
     virtual ~PageOscillog(void);
     void pageOscillogInit(void);
+    uint16_t channelMask(void) const;
 
 private slots:
     void xAxisRangeChanged( QCPRange newRange ,QCPRange oldRange);
@@ -50,10 +51,10 @@ private slots:
 public slots:
     void buttonAutoConfigOscClicked();
     void setOscillog(PFCconfig::Interface::OscillogCnannel channel, std::vector<double> data);
-    void update(void);
+    void update(bool request = true);
 
 signals:
-    void updateOscillog(PFCconfig::Interface::OscillogCnannel channel);
+    void updateOscillogs(uint16_t channels);
 };
 
 #endif // PAGE_OSCILLOG_H
@@ -1,11 +1,17 @@
 #ifndef CRC_H_
-#define CRC_H
+#define CRC_H_
 
-#include <vector>
-#include <QtGlobal>
-#define CRC16_INITIAL_VALUE 0x1D0F
+#include <cstddef>
+#include <cstdint>
 
-uint16_t crc16(uint8_t *pcBlock, uint8_t len);
-uint16_t crc16(const std::vector<uint8_t> &block);
+/**
+ * @brief Calculate CRC16 (CRC16-CCITT, the table shared with the firmware)
+ *
+ * @param block The pointer to the data block
+ * @param len The size of the data block
+ *
+ * @return The CRC of the block
+ */
+uint16_t crc16(const uint8_t *block, size_t len);
 
 #endif /* CRC_H_ */
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include "deviceserialinterface.h"
 #include "interface_messaging.h"
 #include <queue>
@@ -68,6 +69,7 @@ void PFCSerialInterface::ConnectTo(
     {
         message(MESSAGE_TYPE_CONNECTION, MESSAGE_NORMAL, MESSAGE_TARGET_ALL,
                 (QString("Port %1 opened: %2").arg(name).arg(QString::number(baudRate))).toStdString());
+        negotiate();
         emit connected();
     }
     else
@@ -78,6 +80,8 @@ void PFCSerialInterface::ConnectTo(
 }
 void PFCSerialInterface::disconnectFromDevice()
 {
+    _readBuffer.clear();
+    _protocolVersion = 1;
     if (_serial->isOpen())
     {
         _serial->close();
@@ -109,12 +113,77 @@ void PFCSerialInterface::handleError(QSerialPort::SerialPortError err)
     }
     //Disconnect();
 }
+void PFCSerialInterface::negotiate()
+{
+    /* The test is sent as a package: the old firmware does not answer it, the package framing is kept */
+    _protocolVersion = 1;
+    DeviceSerialMessage test;
+    test.fill(DeviceSerialMessage::MessagePriority::HIGH, DeviceSerialMessage::Sender::GUI, TEST_COMMAND,
+              std::vector<uint8_t>(1, PROTOCOL_VERSION));
+    readPushes();
+    if (serialWrite(test.toBuffer()) < 0) return;
+
+    DeviceSerialMessage *answer = serialReadPackage(READ_TIMEOUT_MS);
+    if (answer && answer->command() == TEST_COMMAND && !answer->error() && answer->dataLength() >= 5 &&
+        answer->data(0) >= PROTOCOL_VERSION)
+    {
+        _protocolVersion = PROTOCOL_VERSION;
+        _frameSize = std::min<unsigned int>(answer->data(1) | (answer->data(2) << 8), FRAME_SIZE_MAX);
+    }
+    delete answer;
+    message(MESSAGE_TYPE_CONNECTION, MESSAGE_NORMAL, MESSAGE_TARGET_DEBUG,
+            (QString("Protocol version %1").arg(_protocolVersion.load())).toStdString());
+}
+
+bool PFCSerialInterface::dispatchPush(DeviceSerialMessage *package)
+{
+    if (_pushCommand < 0 || package->command() != _pushCommand) return false;
+
+    emit pushReceived(package->data());
+    delete package;
+    return true;
+}
+
+void PFCSerialInterface::readPushes()
+{
+    /* The data is read by the answer reader while a request is served */
+    if (_waitingAnswer) return;
+
+    QByteArray portion = _serial->readAll();
+    copy(portion.begin(), portion.end(), back_inserter(_readBuffer));
+
+    try
+    {
+        DeviceSerialMessage *package;
+        std::vector<DeviceSerialMessage *> records;
+        uint16_t sequence;
+        while (DeviceSerialMessage::popFromBuffer(_readBuffer, package, records, sequence))
+        {
+            if (package && dispatchPush(package)) continue;
+
+            /* An answer after its timeout */
+            message(MESSAGE_TYPE_CONNECTION, MESSAGE_WARNING, MESSAGE_TARGET_DEBUG,
+                    "Late answer dropped");
+            delete package;
+            for (auto record : records) delete record;
+            records.clear();
+        }
+    }
+    catch (ProtocolException &e)
+    {
+        message(MESSAGE_TYPE_CONNECTION, MESSAGE_ERROR, MESSAGE_TARGET_DEBUG,
+                (QString("Exception %1")
+                    .arg(e.what())).toStdString());
+    }
+    if (_readBuffer.size() > READ_BUFFER_MAX) _readBuffer.clear();
+}
+
 DeviceSerialMessage *PFCSerialInterface::serialReadPackage(int timeout)
 {
     QElapsedTimer timer;
-    vector<uint8_t> readBuf;
 
     timer.start();
+    _waitingAnswer = true;
 
     try
     {
@@ -129,10 +198,14 @@ DeviceSerialMessage *PFCSerialInterface::serialReadPackage(int timeout)
                             std::vector<uint8_t>(
                                 portion.begin(), portion.end()))))).toStdString());
 
-                readBuf.reserve(readBuf.size() + portion.size());
-                copy(portion.begin(), portion.end(), back_inserter(readBuf));
+                _readBuffer.reserve(_readBuffer.size() + portion.size());
+                copy(portion.begin(), portion.end(), back_inserter(_readBuffer));
 
-                DeviceSerialMessage *response = DeviceSerialMessage::popFromBuffer(readBuf);
+                /* The pushes may come before the answer */
+                DeviceSerialMessage *response;
+                while ((response = DeviceSerialMessage::popFromBuffer(_readBuffer)) && dispatchPush(response))
+                {
+                }
 
                 if (response)
                 {
@@ -142,8 +215,10 @@ DeviceSerialMessage *PFCSerialInterface::serialReadPackage(int timeout)
                                 "Connection restored");
                     }
                     noError = 1;
+                    _waitingAnswer = false;
                     return response;
                 }
+                if (_readBuffer.size() > READ_BUFFER_MAX) _readBuffer.clear();
             }
             _serial->waitForReadyRead(timeout - timer.elapsed());
         }
@@ -157,9 +232,79 @@ DeviceSerialMessage *PFCSerialInterface::serialReadPackage(int timeout)
                     .arg(e.what())).toStdString());
     }
 
+    _waitingAnswer = false;
     return Q_NULLPTR;
 }
 
+bool PFCSerialInterface::serialReadFrame(uint16_t sequence, std::vector<DeviceSerialMessage *> &records, int timeout)
+{
+    QElapsedTimer timer;
+
+    timer.start();
+    _waitingAnswer = true;
+
+    try
+    {
+        while (timer.elapsed() < timeout)
+        {
+            QByteArray portion = _serial->readAll();
+
+            if (portion.size())
+            {
+                message(MESSAGE_TYPE_CONNECTION, MESSAGE_NORMAL, MESSAGE_TARGET_NONE,
+                        (QString("GET : ").append(QString::fromStdString(hex_dump(
+                            std::vector<uint8_t>(
+                                portion.begin(), portion.end()))))).toStdString());
+
+                _readBuffer.reserve(_readBuffer.size() + portion.size());
+                copy(portion.begin(), portion.end(), back_inserter(_readBuffer));
+
+                DeviceSerialMessage *package;
+                uint16_t received;
+                while (DeviceSerialMessage::popFromBuffer(_readBuffer, package, records, received))
+                {
+                    if (package)
+                    {
+                        /* The pushes come as the packages */
+                        if (!dispatchPush(package)) delete package;
+                        continue;
+                    }
+                    if (received == sequence)
+                    {
+                        if (noError == 0)
+                        {
+                            message(MESSAGE_TYPE_CONNECTION, MESSAGE_NORMAL, MESSAGE_TARGET_ALL,
+                                    "Connection restored");
+                        }
+                        noError = 1;
+                        _waitingAnswer = false;
+                        return true;
+                    }
+
+                    /* The answer to a frame after its timeout */
+                    message(MESSAGE_TYPE_CONNECTION, MESSAGE_WARNING, MESSAGE_TARGET_DEBUG,
+                            "Stale frame dropped");
+                    for (auto record : records) delete record;
+                    records.clear();
+                }
+                if (_readBuffer.size() > READ_BUFFER_MAX) _readBuffer.clear();
+            }
+            _serial->waitForReadyRead(timeout - timer.elapsed());
+        }
+        message(MESSAGE_TYPE_CONNECTION, MESSAGE_WARNING, MESSAGE_TARGET_DEBUG,
+                "Timeout waiting for the answer");
+    }
+    catch (ProtocolException &e)
+    {
+        message(MESSAGE_TYPE_CONNECTION, MESSAGE_ERROR, MESSAGE_TARGET_DEBUG,
+                (QString("Exception %1")
+                    .arg(e.what())).toStdString());
+    }
+
+    _waitingAnswer = false;
+    return false;
+}
+
 void PFCSerialInterface::run()
 {
     {  // Locking in the RAII style
@@ -177,6 +322,8 @@ void PFCSerialInterface::run()
             this, &PFCSerialInterface::handleError);
     connect(this, &PFCSerialInterface::couldWrite,
             this, &PFCSerialInterface::sendQueue, Qt::QueuedConnection);
+    connect(_serial, &QSerialPort::readyRead,
+            this, &PFCSerialInterface::readPushes);
 }
 
 int PFCSerialInterface::serialWrite(const vector<uint8_t> &dataToWrite)
@@ -227,21 +374,41 @@ std::string PFCSerialInterface::hex_dump(const std::vector<uint8_t> &buf)
 
 void PFCSerialInterface::sendQueue()
 {
-    int written;
-    InterfacePackage *pc = Q_NULLPTR;
+    std::vector<InterfacePackage *> packages;
+    std::vector<const DeviceSerialMessage *> batch;
 
     {  // Locking in the RAII style
         QMutexLocker locker(&sendQueueMutex);
 
         if (_queue.empty())
             return;
-        else
+
+        /* The packages are batched in a frame by the priority while the frame fits the device */
+        size_t packages_max = (_protocolVersion >= 2) ? FRAME_PACKAGES_MAX : 1;
+        while (!_queue.empty() && packages.size() < packages_max)
         {
-            pc = _queue.top();
+            InterfacePackage *pc = _queue.top();
+            batch.push_back(pc->package_to_send);
+            if (packages.size() && DeviceSerialMessage::frameLength(batch) > _frameSize) break;
+            packages.push_back(pc);
             _queue.pop();
         }
     }
 
+    /* The pushes received before the request are dispatched, the late answers are not taken for this one */
+    readPushes();
+
+    if (_protocolVersion >= 2)
+        sendFrame(packages);
+    else
+        sendPackage(packages.front());
+
+    if (!_queue.empty()) emit couldWrite(); /* TODO: Check if this is redundant */
+}
+
+void PFCSerialInterface::sendPackage(InterfacePackage *pc)
+{
+    int written;
     const vector<uint8_t> &dataToWrite = pc->package_to_send->toBuffer();
 
     written = serialWrite(dataToWrite);
@@ -276,8 +443,59 @@ void PFCSerialInterface::sendQueue()
         pc->finishProcessing(true);
         emit informConnectionChanged(false);
     }
+}
 
-    if (!_queue.empty()) emit couldWrite(); /* TODO: Check if this is redundant */
+void PFCSerialInterface::sendFrame(const std::vector<InterfacePackage *> &packages)
+{
+    std::vector<const DeviceSerialMessage *> batch;
+    for (auto pc : packages) batch.push_back(pc->package_to_send);
+
+    const vector<uint8_t> &dataToWrite = DeviceSerialMessage::frameToBuffer(batch, ++_sequence);
+
+    if (serialWrite(dataToWrite) < 0)
+    {
+        for (auto pc : packages) pc->finishProcessing(true);
+        emit informConnectionChanged(false);
+        return;
+    }
+    message(MESSAGE_TYPE_CONNECTION, MESSAGE_NORMAL, MESSAGE_TARGET_NONE,
+            (QString("SENT: ").append(QString::fromStdString(hex_dump(dataToWrite)))).toStdString());
+
+    std::vector<DeviceSerialMessage *> records;
+    if (!serialReadFrame(_sequence, records, READ_TIMEOUT_MS))
+    {
+        message(MESSAGE_TYPE_CONNECTION, MESSAGE_ERROR, MESSAGE_TARGET_DEBUG,
+                "Timeout is esceeded!");
+        for (auto pc : packages) pc->finishProcessing(true);
+        emit informConnectionChanged(false);
+        return;
+    }
+    emit informConnectionChanged(true);
+
+    /* The answers are in the order of the packages, the packages without an answer have not been run by the device
+       (the device runs at least the first one: no answers is an error of the frame) */
+    for (size_t i = 0; i < packages.size(); i++)
+    {
+        InterfacePackage *pc = packages[i];
+        if (records.empty())
+        {
+            pc->finishProcessing(true);
+            continue;
+        }
+        if (i >= records.size())
+        {
+            QMutexLocker locker(&sendQueueMutex);
+            _queue.push(pc);
+            continue;
+        }
+
+        delete pc->package_read;
+        pc->package_read = records[i];
+        message(MESSAGE_TYPE_CONNECTION, MESSAGE_NORMAL, MESSAGE_TARGET_NONE,
+                (QString("RECEIVED: ").append(QString::fromStdString(hex_dump(pc->package_read->data())))).toStdString());
+        pc->finishProcessing(pc->package_read->command() != pc->package_to_send->command());
+    }
+    for (size_t i = packages.size(); i < records.size(); i++) delete records[i];
 }
 
 void PFCSerialInterface::connectionHasChanged(bool connected)
@@ -285,6 +503,16 @@ void PFCSerialInterface::connectionHasChanged(bool connected)
     _connected = connected;
 }
 
+void PFCSerialInterface::setPushCommand(uint8_t command)
+{
+    _pushCommand = command;
+}
+
+int PFCSerialInterface::protocolVersion(void) const
+{
+    return _protocolVersion;
+}
+
 void PFCSerialInterface::enqueueCommand(InterfacePackage *pc)
 {
     //if (!_connected){
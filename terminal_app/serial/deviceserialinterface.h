@@ -11,6 +11,7 @@
 #include <QSerialPort>
 #include <functional>
 #include <map>
+#include <atomic>
 
 class QSerialPort;
 class QTimer;
@@ -28,12 +29,16 @@ class PFCSerialInterface : public QObject
     virtual ~PFCSerialInterface();
 
     void enqueueCommand(InterfacePackage *pc);
+    void setPushCommand(uint8_t command);
+    int protocolVersion(void) const;
     std::string hex_dump(const std::vector<uint8_t> &buf);
 
    protected:
     int serialWrite(const std::vector<uint8_t> &dataToWrite);
 
     DeviceSerialMessage *serialReadPackage(int timeout);
+
+    bool serialReadFrame(uint16_t sequence, std::vector<DeviceSerialMessage *> &records, int timeout);
    public slots:
     void ConnectTo(
         QString name,
@@ -50,6 +55,7 @@ class PFCSerialInterface : public QObject
 
    private slots:
     void sendQueue();
+    void readPushes();
     void handleError(QSerialPort::SerialPortError err);
     void connectionHasChanged(bool connected);
 
@@ -59,8 +65,14 @@ class PFCSerialInterface : public QObject
     void disconnected();
     void informConnectionChanged(bool connected);
     void message(uint8_t type, uint8_t level, uint8_t target, std::string message);
+    void pushReceived(std::vector<uint8_t> data);  //!< A package sent by the device without a request
 
    private:
+    bool dispatchPush(DeviceSerialMessage *package);
+    void negotiate();
+    void sendPackage(InterfacePackage *pc);
+    void sendFrame(const std::vector<InterfacePackage *> &packages);
+
     QSerialPort *_serial;  //!< Объект для работы с последовательным портом
     struct CustomCompare
     {
@@ -81,7 +93,18 @@ class PFCSerialInterface : public QObject
    private:
     bool _connected = false;
     int noError = 1;
+    std::vector<uint8_t> _readBuffer;  //!< The received data not parsed yet (kept between the answers)
+    bool _waitingAnswer = false;       //!< An answer is being read (the pushes are dispatched by the reader)
+    int _pushCommand = -1;             //!< The command of the pushed packages, -1 - no pushes
+    std::atomic<int> _protocolVersion{1}; //!< The framing of the device: 1 - a package per request, 2 - the frames (read by the GUI)
+    unsigned int _frameSize = 0;       //!< The maximum length of a frame accepted by the device
+    uint16_t _sequence = 0;            //!< The sequence number of the last frame sent
     static const int SEND_QUEUE_LEN_MAX = 50;
+    static const int PROTOCOL_VERSION = 2;             //!< The latest framing supported
+    static const uint8_t TEST_COMMAND = 0;             //!< The connection test: the framing is negotiated
+    static const unsigned int FRAME_SIZE_MAX = 512;    //!< The maximum length of a frame sent
+    static const size_t FRAME_PACKAGES_MAX = 8;        //!< The maximum number of the packages batched in a frame
+    static const size_t READ_BUFFER_MAX = 4096;  //!< The received data without a package is dropped above the size
     static const int READ_TIMEOUT_MS = 500;  //!< таймаут ожидания на чтения в миллисекундах
 };
 
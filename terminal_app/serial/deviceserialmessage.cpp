@@ -152,22 +152,77 @@ void DeviceSerialMessage::setCrc(const uint16_t crc)
     _crc = crc;
 }
 
-std::vector<uint8_t> DeviceSerialMessage::toBuffer() const
+uint8_t DeviceSerialMessage::status() const
 {
-    vector<uint8_t> raw_data;
-    raw_data.push_back(START_BYTE);
-
     uint8_t status = 0;
     if (sender() == Sender::GUI) status |= 0x01;
     if (error()) status |= 0x02;
     if (crcError()) status |= 0x04;
-    raw_data.push_back(status);
+    return status;
+}
+
+void DeviceSerialMessage::setStatus(uint8_t status)
+{
+    setSender(status & 0x01 ? Sender::GUI : Sender::PFC);
+    setError(status & 0x02 ? true : false);
+    setCrcError(status & 0x04 ? true : false);
+}
+
+std::vector<uint8_t> DeviceSerialMessage::toBuffer() const
+{
+    vector<uint8_t> raw_data;
+    raw_data.push_back(START_BYTE);
+    raw_data.push_back(status());
 
     raw_data.push_back(_data.size() + 4);
     raw_data.push_back(command());
     copy(_data.begin(), _data.end(), back_inserter(raw_data));
 
-    uint16_t crc = crc16(vector<uint8_t>(raw_data.begin() + 1, raw_data.end()));
+    uint16_t crc = crc16(raw_data.data() + 1, raw_data.size() - 1);
+    raw_data.push_back(crc & 0xFF);
+    raw_data.push_back((crc >> 8) & 0xFF);
+    raw_data.push_back(STOP_BYTE);
+
+    return raw_data;
+}
+
+std::vector<uint8_t> DeviceSerialMessage::toRecord() const
+{
+    vector<uint8_t> raw_data;
+    raw_data.push_back(command());
+    raw_data.push_back(status());
+    raw_data.push_back(_data.size() & 0xFF);
+    raw_data.push_back((_data.size() >> 8) & 0xFF);
+    copy(_data.begin(), _data.end(), back_inserter(raw_data));
+    return raw_data;
+}
+
+unsigned int DeviceSerialMessage::frameLength(const std::vector<const DeviceSerialMessage *> &packages)
+{
+    unsigned int length = FRAME_SERVICE_LEN;
+    for (auto package : packages) length += RECORD_HEADER_LEN + package->dataLength();
+    return length;
+}
+
+std::vector<uint8_t> DeviceSerialMessage::frameToBuffer(const std::vector<const DeviceSerialMessage *> &packages, uint16_t sequence)
+{
+    vector<uint8_t> records;
+    for (auto package : packages)
+    {
+        const vector<uint8_t> &record = package->toRecord();
+        copy(record.begin(), record.end(), back_inserter(records));
+    }
+
+    vector<uint8_t> raw_data;
+    raw_data.push_back(FRAME_START_BYTE);
+    raw_data.push_back(0x01);  // Sent by the GUI
+    raw_data.push_back(records.size() & 0xFF);
+    raw_data.push_back((records.size() >> 8) & 0xFF);
+    raw_data.push_back(sequence & 0xFF);
+    raw_data.push_back((sequence >> 8) & 0xFF);
+    copy(records.begin(), records.end(), back_inserter(raw_data));
+
+    uint16_t crc = crc16(raw_data.data() + 1, raw_data.size() - 1);
     raw_data.push_back(crc & 0xFF);
     raw_data.push_back((crc >> 8) & 0xFF);
     raw_data.push_back(STOP_BYTE);
@@ -177,8 +232,62 @@ std::vector<uint8_t> DeviceSerialMessage::toBuffer() const
 
 DeviceSerialMessage *DeviceSerialMessage::popFromBuffer(std::vector<uint8_t> &data)
 {
+    DeviceSerialMessage *package = Q_NULLPTR;
+    std::vector<DeviceSerialMessage *> records;
+    uint16_t sequence;
+
+    /* The frames are not expected by the caller: dropped */
+    while (popFromBuffer(data, package, records, sequence) && !package)
+    {
+        for (auto record : records) delete record;
+        records.clear();
+    }
+    return package;
+}
+
+bool DeviceSerialMessage::popFromBuffer(std::vector<uint8_t> &data, DeviceSerialMessage *&package,
+                                        std::vector<DeviceSerialMessage *> &records, uint16_t &sequence)
+{
+    package = Q_NULLPTR;
     for (uint i = 0; i < data.size(); i++)
     {
+        if (data[i] == FRAME_START_BYTE)
+        {
+            uint start_pos = i;
+
+            if (start_pos + FRAME_HEADER_LEN > data.size())
+                break;  // incomplete frame header
+
+            uint frame_len = data[start_pos + 2] | (data[start_pos + 3] << 8);
+            if (start_pos + FRAME_SERVICE_LEN + frame_len > data.size())
+                break;  // incomplete frame
+
+            uint crc_pos = start_pos + FRAME_HEADER_LEN + frame_len;
+            if (data[crc_pos + 2] != STOP_BYTE)
+                continue;  // no magic stop byte at the end of the frame
+
+            uint16_t crc = data[crc_pos] | (data[crc_pos + 1] << 8);
+            if (crc != crc16(data.data() + start_pos + 1, FRAME_HEADER_LEN - 1 + frame_len))
+                continue;  // crc mismatch
+
+            /* The records are cut at the first malformed one */
+            uint pos = start_pos + FRAME_HEADER_LEN;
+            while (pos + RECORD_HEADER_LEN <= crc_pos)
+            {
+                uint record_len = data[pos + 2] | (data[pos + 3] << 8);
+                if (pos + RECORD_HEADER_LEN + record_len > crc_pos) break;
+
+                DeviceSerialMessage *p = new DeviceSerialMessage();
+                p->setCommand(data[pos]);
+                p->setStatus(data[pos + 1]);
+                p->appendData(vector<uint8_t>(data.begin() + pos + RECORD_HEADER_LEN, data.begin() + pos + RECORD_HEADER_LEN + record_len));
+                records.push_back(p);
+                pos += RECORD_HEADER_LEN + record_len;
+            }
+            sequence = data[start_pos + 4] | (data[start_pos + 5] << 8);
+            data.erase(data.begin(), data.begin() + crc_pos + 3);
+            return true;
+        }
         if (data[i] == START_BYTE)
         {
             uint start_pos = i;
@@ -189,8 +298,8 @@ DeviceSerialMessage *DeviceSerialMessage::popFromBuffer(std::vector<uint8_t> &da
             int status = data[start_pos + 1];
             int package_len = data[start_pos + 2];
 
-            if (start_pos + HEADER_LEN + package_len > data.size())
-                break;  // incomplete package
+            if (start_pos + HEADER_LEN + package_len >= data.size())
+                break;  // incomplete package (the stop byte is not received)
 
             uint8_t command = data[start_pos + 3];
             uint16_t crc = data[start_pos + HEADER_LEN + package_len - 2];
@@ -200,8 +309,7 @@ DeviceSerialMessage *DeviceSerialMessage::popFromBuffer(std::vector<uint8_t> &da
             if (stop_byte != STOP_BYTE)
                 continue;  // no magic stop byte at the end of the package - this is not a valid package.
 
-            uint16_t crccalc = crc16(vector<uint8_t>(data.begin() + start_pos + 1,
-                                                           data.begin() + start_pos + HEADER_LEN + package_len - 2));
+            uint16_t crccalc = crc16(data.data() + start_pos + 1, HEADER_LEN + package_len - 3);
 
             if (crc != crccalc)
             {
@@ -210,15 +318,14 @@ DeviceSerialMessage *DeviceSerialMessage::popFromBuffer(std::vector<uint8_t> &da
             DeviceSerialMessage *p = new DeviceSerialMessage();
             p->setCommand(command);
             p->setCrc(crc);
-            p->setSender(status & 0x01 ? Sender::GUI : Sender::PFC);
-            p->setError(status & 0x02 ? true : false);
-            p->setCrcError(status & 0x04 ? true : false);
+            p->setStatus(status);
             p->appendData(vector<uint8_t>(data.begin() + start_pos + HEADER_LEN + 1, data.begin() + start_pos + HEADER_LEN + package_len - 2));
-            data.erase(data.begin(), data.begin() + HEADER_LEN + package_len);
+            data.erase(data.begin(), data.begin() + start_pos + HEADER_LEN + package_len + 1);
 
-            return p;
+            package = p;
+            return true;
         }
     }
 
-    return Q_NULLPTR;
+    return false;
 }
@@ -13,6 +13,10 @@ class DeviceSerialMessage
      const static auto MAX_LENGTH = 256;
      const static auto START_BYTE = 0x55;
      const static auto STOP_BYTE  = 0x77;
+     const static auto FRAME_START_BYTE = 0x56;   //!< The start byte of a frame (the protocol version 2)
+     const static auto FRAME_HEADER_LEN = 6;      //!< Start, status, length (2 bytes), sequence (2 bytes)
+     const static auto FRAME_SERVICE_LEN = 9;     //!< The header, the CRC and the stop byte
+     const static auto RECORD_HEADER_LEN = 4;     //!< Command, status, length (2 bytes)
 
    public:
      enum class Sender
@@ -84,9 +88,22 @@ class DeviceSerialMessage
         uint8_t comm,
         const std::vector<uint8_t> &data);
 
+    uint8_t status(void) const;
+
+    void setStatus(uint8_t status);
+
+    std::vector<uint8_t> toRecord(void) const;
+
    public:
     static DeviceSerialMessage *popFromBuffer(std::vector<uint8_t> &data);
 
+    static std::vector<uint8_t> frameToBuffer(const std::vector<const DeviceSerialMessage *> &packages, uint16_t sequence);
+
+    static bool popFromBuffer(std::vector<uint8_t> &data, DeviceSerialMessage *&package,
+                              std::vector<DeviceSerialMessage *> &records, uint16_t &sequence);
+
+    static unsigned int frameLength(const std::vector<const DeviceSerialMessage *> &packages);
+
    private:
     std::vector<uint8_t> _data;
     Sender _sender;
@@ -5,6 +5,9 @@ CONFIG+=c++1z
 TARGET = terminal
 TEMPLATE = app
 
+# The CRC table is shared with the firmware
+INCLUDEPATH += $$PWD/../firmware/middleware/serial_interface
+
 SOURCES += \
     main.cpp \
     mainwindow.cpp \